@@ -0,0 +1,37 @@
+/**
+ * @file AngleMath.h
+ * @brief Fixed-point angle helpers in millidegrees.
+ *
+ * This file declares wrap-aware angle arithmetic. Everything is
+ * integer-only so it can run inside the control loop.
+ *
+ * @author Aaron
+ * @date Oct 17, 2026
+ */
+
+#ifndef INC_ANGLEMATH_H_
+#define INC_ANGLEMATH_H_
+
+#include <stdint.h>
+
+#define ANGLE_FULL   360000 ///< One full turn (millidegrees)
+#define ANGLE_HALF   180000 ///< Half a turn (millidegrees)
+
+/**
+ * @brief Wraps an angle into [0, 360000).
+ *
+ * @param a Angle in millidegrees, any range.
+ * @return Equivalent heading in [0, 360000).
+ */
+int32_t angle_Wrap360(int32_t a);
+
+/**
+ * @brief Shortest signed difference a - b.
+ *
+ * @param a Angle in millidegrees, any range.
+ * @param b Angle in millidegrees, any range.
+ * @return a - b wrapped to (-180000, 180000].
+ */
+int32_t angle_Diff(int32_t a, int32_t b);
+
+#endif /* INC_ANGLEMATH_H_ */
@@ -0,0 +1,77 @@
+/**
+ * @file AttEKF.h
+ * @brief Quaternion extended Kalman filter with gyro-bias states.
+ *
+ * An alternative to the BNO055's own fusion: seven states (attitude
+ * quaternion and three gyro biases), propagated with the raw gyro and
+ * corrected with the gravity direction from the accelerometer and the
+ * tilt-compensated heading from the magnetometer. Single precision
+ * throughout for the F411 FPU.
+ *
+ * Body frame: x forward, y right, z down. Euler angles are ZYX (yaw, then
+ * pitch, then roll), the same convention as roll_true/pitch_true/yaw_true.
+ *
+ * @author Aaron
+ * @date Oct 17, 2026
+ */
+
+#ifndef INC_ATTEKF_H_
+#define INC_ATTEKF_H_
+
+#include <stdint.h>
+
+#define EKF_STATES       7          ///< q0 q1 q2 q3 bx by bz
+#define EKF_GYRO_NOISE   0.005f     ///< Gyro noise density (rad/s/sqrt(Hz))
+#define EKF_BIAS_WALK    0.0002f    ///< Bias random walk (rad/s/sqrt(s))
+#define EKF_ACC_NOISE    0.05f      ///< Gravity direction noise (unit vector, 1 sigma)
+#define EKF_MAG_NOISE    0.05f      ///< Heading noise (rad, 1 sigma)
+#define EKF_ACC_GATE     0.15f      ///< Skip the accel update if |a| is off 1 g by more than this fraction
+#define EKF_GRAVITY      9.80665f   ///< m/s^2
+
+/**
+ * @brief Filter state and covariance.
+ */
+typedef struct {
+    float q[4];                          ///< Body-to-earth quaternion, w x y z
+    float b[3];                          ///< Gyro bias (rad/s)
+    float P[EKF_STATES][EKF_STATES];     ///< Covariance
+    int ready;                           ///< Set by AttEKF_Start()
+} AttEKF;
+
+/**
+ * @brief Starts the filter at the attitude the accelerometer and magnetometer give.
+ *
+ * @param acc Specific force, body frame (any unit).
+ * @param mag Magnetic field, body frame (any unit).
+ */
+void AttEKF_Start(AttEKF *f, const float acc[3], const float mag[3]);
+
+/**
+ * @brief Propagates the state and covariance over dt with a gyro sample.
+ *
+ * @param gyro Body rates (rad/s).
+ * @param dt Time since the last call (s).
+ */
+void AttEKF_Predict(AttEKF *f, const float gyro[3], float dt);
+
+/**
+ * @brief Corrects roll and pitch with the measured gravity direction.
+ *
+ * @param acc Specific force, body frame (m/s^2).
+ * @return 1 if applied, 0 if gated out (manoeuvring).
+ */
+int AttEKF_UpdateAccel(AttEKF *f, const float acc[3]);
+
+/**
+ * @brief Corrects yaw with the tilt-compensated magnetic heading.
+ *
+ * @param mag Magnetic field, body frame (any unit).
+ */
+void AttEKF_UpdateMag(AttEKF *f, const float mag[3]);
+
+/**
+ * @brief Euler angles in millidegrees: roll/pitch ±180000, yaw 0..360000.
+ */
+void AttEKF_Euler(const AttEKF *f, int32_t *roll, int32_t *pitch, int32_t *yaw);
+
+#endif /* INC_ATTEKF_H_ */
@@ -16,25 +16,80 @@
 #include "main.h" ///< Include for STM32 HAL types and definitions
 
 /**
- * @brief Initializes the BNO055 sensor in NDOF mode.
+ * @brief BNO055 bring-up phases used by BNO_InitStep().
+ */
+typedef enum {
+    BNO_RESET = 0, ///< Pulse the reset pin
+    BNO_BOOT,      ///< Waiting for the sensor to boot
+    BNO_PROBE,     ///< Reset I2C and check the chip ID
+    BNO_CONFIG,    ///< Enter CONFIG mode
+    BNO_NDOF,      ///< Enter NDOF fusion mode
+    BNO_CALIB,     ///< Waiting for full system calibration
+    BNO_READY      ///< Calibrated, ready for BNO_Read()
+} BNOInitState;
+
+/**
+ * @brief Initializes the BNO055 sensor in NDOF mode (blocking).
  */
 void BNO_Init(void);
 
+/**
+ * @brief Advances the non-blocking BNO055 bring-up.
+ *
+ * @return true once the sensor is calibrated and ready.
+ */
+int BNO_InitStep(void);
+
 /**
  * @brief Reads Euler angles from the BNO055 sensor.
  *
+ * With attSource set to ATT_SOURCE_EKF the angles come from AttEKF running
+ * on the raw sensor registers instead of the BNO055's own fusion.
+ *
  * @param roll Pointer to variable storing the roll angle.
  * @param pitch Pointer to variable storing the pitch angle.
  * @param yaw Pointer to variable storing the yaw angle.
  */
 void BNO_Read(int32_t *roll, int32_t *pitch, int32_t *yaw);
 
+/**
+ * @brief Reads the gyro rates on every call and the Euler angles at the
+ *        fusion rate, for the rate-mode and LQR controllers.
+ *
+ * @param roll Roll angle (millidegrees), read every RATE_EULER_DIV calls and
+ *             propagated on the gyro in between.
+ * @param pitch Pitch angle (millidegrees), same.
+ * @param yaw Yaw angle (millidegrees), same.
+ * @param rollRate Roll rate (millidegrees/s), body frame.
+ * @param pitchRate Pitch rate (millidegrees/s), body frame.
+ * @param yawRate Yaw rate (millidegrees/s), body frame.
+ */
+void BNO_ReadRates(int32_t *roll, int32_t *pitch, int32_t *yaw,
+                   int32_t *rollRate, int32_t *pitchRate, int32_t *yawRate);
+
+/**
+ * @brief Converts a raw register burst (BNO055_ACC_DATA onwards) to body-frame
+ *        SI units: accel m/s^2, mag uT, gyro rad/s.
+ *
+ * @param raw BNO_RAW_LEN bytes as read from BNO055_ACC_DATA.
+ */
+void BNO_RawToBody(const uint8_t *raw, float acc[3], float mag[3], float gyro[3]);
+
 #define BNO055_I2C_ADDR       (0x28 << 1) ///< 7-bit I2C address shifted for STM32 HAL
 #define BNO055_OPR_MODE_ADDR  0x3D        ///< Operation mode register
 #define BNO055_EULER_LSB      0x1A        ///< Start of Euler angle registers
+#define BNO055_ACC_DATA       0x08        ///< Start of the accel, mag and gyro data registers
+#define BNO055_GYR_DATA       0x14        ///< Start of the gyro data registers
+#define BNO_RAW_LEN           18          ///< Accel, mag and gyro in one burst
+#define ATT_SOURCE_BNO        0           ///< Attitude from the BNO055 fusion
+#define ATT_SOURCE_EKF        1           ///< Attitude from AttEKF on the raw sensors
+#define EKF_CORR_DIV          10          ///< Reads between accel/mag corrections (the BNO055 refreshes at 100 Hz)
+#define RATE_EULER_DIV        10          ///< BNO_ReadRates() calls per Euler read
 #define BNO055_CALIB_STAT     0x35        ///< Calibration status register
-#define MAX_SAMPLES           5000        ///< Maximum samples for blackbox logging
-#define blackboxFreq          2           ///< Logging frequency (Hz)
+#define BNO_BOOT_MS           1000        ///< Boot time after a reset pulse (ms)
+#define BNO_MODE_MS           25          ///< Settling time after a mode change (ms)
+#define BNO_CALIB_POLL_MS     100         ///< Calibration status poll period (ms)
+#define MAX_SAMPLES           4000        ///< Maximum samples for blackbox logging
 #define true 1                           ///< Boolean true
 #define false 0                          ///< Boolean false
 
@@ -45,17 +100,23 @@ extern uint8_t ndof_buf;
 
 /**
  * @struct IMUSample
- * @brief Structure holding IMU roll/pitch data and their setpoints.
+ * @brief Structure holding IMU roll/pitch data, their setpoints and pack voltage.
  */
 typedef struct {
     int32_t pitch;     ///< Measured pitch
     int32_t roll;      ///< Measured roll
     int32_t pitchSet;  ///< Desired pitch
     int32_t rollSet;   ///< Desired roll
+    int32_t vbat;      ///< Filtered pack voltage (mV)
 } IMUSample;
 
 extern IMUSample blackbox[MAX_SAMPLES]; ///< Flight data buffer
 extern uint16_t sample_index;           ///< Index for blackbox samples
 extern int counter;                     ///< Sample counter or general use variable
+extern int blackboxFreq;                ///< Reads between logged samples (stored parameter)
+extern BNOInitState bnoState;           ///< Current bring-up phase
+extern int attSource;                   ///< ATT_SOURCE_BNO or ATT_SOURCE_EKF (stored parameter)
+extern uint32_t ekfCycles;              ///< Cycles the last EKF step took (predict plus any correction)
+extern uint32_t ekfCyclesMax;           ///< Longest EKF step since boot
 
 #endif /* INC_BNO055_H_ */
@@ -0,0 +1,50 @@
+/**
+ * @file Battery.h
+ * @brief Battery pack voltage/current sensing through ADC1 and DMA.
+ *
+ * This file declares the functions used to sample the flight pack,
+ * filter the readings and compensate motor commands for voltage sag.
+ *
+ * @author Aaron
+ * @date Oct 17, 2026
+ */
+
+#ifndef INC_BATTERY_H_
+#define INC_BATTERY_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Starts ADC1 in continuous scan mode with circular DMA into the sample ring.
+ */
+void Battery_Init(void);
+
+/**
+ * @brief Filters the latest DMA samples into batt_mV and batt_mA.
+ *
+ * Call once per control loop before update_Motors().
+ */
+void Battery_Update(void);
+
+/**
+ * @brief Scales a motor compare value to hold thrust constant as the pack sags.
+ *
+ * @param cmd Compare value (ESC_CMD_MIN to ESC_CMD_MAX).
+ * @return Compensated compare value, not yet clamped.
+ */
+int32_t Battery_Compensate(int32_t cmd);
+
+#define BATT_VREF_MV        3300 ///< ADC reference voltage (mV)
+#define BATT_DIV_NUM        11   ///< Pack divider ratio numerator (10k over 1k)
+#define BATT_DIV_DEN        1    ///< Pack divider ratio denominator
+#define BATT_NOMINAL_MV     11100 ///< Pack voltage the gains were tuned at (3S nominal)
+#define BATT_MIN_MV         9000  ///< Below this the compensation stops growing
+#define BATT_CURRENT_SENSE  0    ///< Set to 1 when a current sensor is wired to PA4
+#define BATT_MA_PER_MV      10   ///< Current sensor scale (mA per mV at the ADC pin)
+#define BATT_RING_LEN       32   ///< DMA samples kept per channel
+#define BATT_FILTER_SHIFT   3    ///< IIR low-pass weight (1/8 per update)
+
+extern int32_t batt_mV; ///< Filtered pack voltage (mV), 0 until the first update
+extern int32_t batt_mA; ///< Filtered pack current (mA), 0 when not wired
+
+#endif /* INC_BATTERY_H_ */
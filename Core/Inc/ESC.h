@@ -30,6 +30,54 @@ void update_Motors(void);
  */
 void armESC(void);
 
+/**
+ * @brief Starts the non-blocking ESC arming sequence.
+ */
+void ESC_ArmStart(void);
+
+/**
+ * @brief Advances the ESC arming sequence; call every main loop iteration.
+ *
+ * @return true once the pilot has completed arming.
+ */
+int ESC_ArmStep(void);
+
+/**
+ * @brief Maps a linear thrust command onto a motor's compare value.
+ *
+ * Motor thrust is roughly quadratic in PWM, so the mixer output is treated as
+ * a thrust demand and passed through the motor's calibrated thrust curve.
+ *
+ * @param motor Motor index (0 = A, 1 = B, 2 = C, 3 = D).
+ * @param cmd   Mixer output in compare counts (ESC_CMD_MIN to ESC_CMD_MAX).
+ * @return Linearized compare value for TIM3.
+ */
+int32_t linearize_Thrust(int motor, int32_t cmd);
+
+#define ESC_CMD_MIN        960 ///< Compare value for 0% throttle (1 ms pulse)
+#define ESC_CMD_MAX        1700 ///< Highest compare value the mixer may command
+#define THRUST_LUT_POINTS  17   ///< Breakpoints per thrust curve (16 equal thrust steps)
+#ifndef THRUST_LUT_ENABLED
+#define THRUST_LUT_ENABLED 0    ///< Set to 1 once thrustLUT (ESC.c) holds thrust stand measurements
+#endif
+#ifndef THRUST_LUT_IDEAL
+#define THRUST_LUT_IDEAL   0    ///< 1: ideal quadratic rows instead of identity (Tools/build/lutbench only)
+#endif
+#define ESC_ARM_BLINK_MS   125  ///< Status LED toggle period while arming (ms)
+
+#define GAIN_SCHED_POINTS  9    ///< Breakpoints over effort_set 0...1024
+#define GAIN_SCHED_SHIFT   7    ///< log2 of the effort between breakpoints (128)
+#define GAIN_SCHED_TUNED   512  ///< Effort the stored gains were tuned at (scale 100%)
+#define GAIN_SCHED_LOW     170  ///< Roll/pitch gain at zero effort, % of the stored gains
+#define GAIN_SCHED_HIGH    75   ///< Roll/pitch gain at effort 1024, %
+#define GAIN_SCHED_VBAT    0    ///< Set to 1 to also schedule over batt_mV
+#define GAIN_SCHED_VBAT_MIN 9000 ///< Pack voltage at the first voltage breakpoint (mV)
+#define GAIN_SCHED_VBAT_SHIFT 9  ///< log2 of the mV between voltage breakpoints (512)
+#define GAIN_SCHED_ONE     256  ///< Scale factor 1.0 (Q8)
+
+extern int gainSched;       ///< Apply the gain schedule (stored parameter)
+extern int32_t gainScale;   ///< Roll/pitch scale used on the last update (Q8)
+
 #define true 1  ///< Definition for boolean true
 #define false 0 ///< Definition for boolean false
 
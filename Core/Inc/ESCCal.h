@@ -0,0 +1,53 @@
+/**
+ * @file ESCCal.h
+ * @brief Guided, non-blocking ESC/motor spin-up calibration.
+ *
+ * This file declares the calibration state machine that sweeps each motor
+ * in turn and records the compare value where it starts spinning.
+ *
+ * @author Aaron
+ * @date Oct 17, 2026
+ */
+
+#ifndef INC_ESCCAL_H_
+#define INC_ESCCAL_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Calibration phases.
+ */
+typedef enum {
+    CAL_IDLE = 0,  ///< Not running
+    CAL_ARMING,    ///< Holding minimum throttle so the ESCs arm
+    CAL_SWEEP,     ///< Ramping one motor until spin-up is detected
+    CAL_SPINDOWN,  ///< Motor back at minimum, waiting before the next one
+    CAL_DONE       ///< All motors measured, offsets applied
+} CalState;
+
+/**
+ * @brief Starts a calibration run from the arming phase.
+ */
+void ESCCal_Start(void);
+
+/**
+ * @brief Advances the calibration; call every main loop iteration.
+ *
+ * @param confirm Non-zero when the pilot confirms the motor is spinning.
+ * @return true once the run is finished (CAL_DONE) or aborted by a missed
+ *         loop deadline.
+ */
+int ESCCal_Step(int confirm);
+
+#define CAL_ENTRY_HOLD_MS 2000 ///< Pitch back + roll right hold before ENTER starts a run (ms)
+#define CAL_ARM_MS       3000 ///< Minimum-throttle hold before sweeping (ms)
+#define CAL_STEP_MS      40   ///< Time per compare count during the sweep (ms)
+#define CAL_SPINDOWN_MS  1500 ///< Pause between motors (ms)
+#define CAL_SWEEP_LIMIT  1300 ///< Give up on a motor above this compare value
+#define CAL_SPINUP_MA    300  ///< Current rise that counts as spin-up (with current sensing)
+#define CAL_CONFIRM_LAG_MS 400 ///< Pilot reaction time taken off a confirmed reading (ms)
+
+extern CalState calState;    ///< Current calibration phase
+extern int32_t calOffset[4]; ///< Measured spin-up compare values A..D (0 = not found)
+
+#endif /* INC_ESCCAL_H_ */
@@ -0,0 +1,128 @@
+/**
+ * @file FastIO.h
+ * @brief Register-level fast path for the hot I2C, TIM and UART operations.
+ *
+ * The flight loop's peripheral calls go through here: the BNO055 burst read
+ * on I2C1, the four TIM3 motor compares and the USART1 DMA kicks of the fast
+ * channel. With FAST_IO_LL set they are done with the LL inline register
+ * accessors, without the HAL's handle locking, state machine and
+ * HAL_GetTick() timeouts; build with -DFAST_IO_LL=0 to go through the HAL
+ * calls instead (e.g. to compare timing or to rule the fast path out).
+ * Host builds always use the HAL calls, which Tools/Sim/Sim.c stands in for.
+ *
+ * FastIO_Bench() times both versions of the I2C read and the compare writes
+ * on the running board, and the TX kick of the version built in, and prints
+ * the comparison on the fast channel. It blocks and rewrites the motor
+ * compares, so it is only built in with -DFASTIO_BENCH=1, on a bench build.
+ *
+ * @author Aaron
+ * @date Oct 17, 2026
+ */
+
+#ifndef INC_FASTIO_H_
+#define INC_FASTIO_H_
+
+#include <stdint.h>
+#include "stm32f4xx_hal.h"
+
+#ifndef FAST_IO_LL
+#define FAST_IO_LL 1 ///< 1: register-level I2C1 reads, TIM3 compares and USART1 kicks
+#endif
+
+#if FAST_IO_LL && defined(__arm__)
+#define FAST_IO_USE_LL 1
+#include "stm32f4xx_ll_tim.h"
+#else
+#define FAST_IO_USE_LL 0 ///< Host builds and FAST_IO_LL=0: HAL calls
+#endif
+
+#ifndef FASTIO_BENCH
+#define FASTIO_BENCH 0 ///< 1: build FastIO_Bench() and run it with every dump
+#endif
+
+#define FASTIO_I2C_TIMEOUT_US 1000 ///< Longest wait for one I2C event before the LL read gives up
+#define FASTIO_BENCH_RUNS     16   ///< Repetitions per operation in FastIO_Bench()
+
+extern TIM_HandleTypeDef htim3;
+
+/**
+ * @brief Cycle statistics of one timed operation.
+ */
+typedef struct {
+    uint32_t last;
+    uint32_t min;
+    uint32_t max;
+    uint32_t count;
+} FastIOCycles;
+
+extern FastIOCycles fastIoTxKick;     ///< FastIO_TxStart() cost, in the version built in
+extern uint32_t fastIoI2CFallbacks;   ///< LL reads that failed and were retried through the HAL
+
+/**
+ * @brief Points DMA2 Stream7 at USART1 for the LL TX kicks; call after the MX_ inits.
+ *
+ * Does nothing with FAST_IO_LL=0.
+ */
+void FastIO_Init(void);
+
+/**
+ * @brief Reads len bytes from register reg of an I2C1 device (HAL_I2C_Mem_Read() equivalent).
+ *
+ * @param devAddr Shifted 7-bit address, as for the HAL
+ * @param reg     First register
+ * @param buf     Destination
+ * @param len     Bytes; reads under 3 bytes always go through the HAL
+ *
+ * @return HAL_OK, or the HAL's status after the LL read failed and it retried
+ */
+HAL_StatusTypeDef FastIO_I2CRead(uint16_t devAddr, uint8_t reg, uint8_t *buf, uint16_t len);
+
+/**
+ * @brief Starts a USART1 DMA transfer; only call when FastIO_TxBusy() is false.
+ */
+void FastIO_TxStart(const uint8_t *data, uint16_t len);
+
+/**
+ * @brief True while a FastIO_TxStart() transfer is in progress.
+ */
+int FastIO_TxBusy(void);
+
+/**
+ * @brief DMA2 Stream7 interrupt hook.
+ *
+ * @return 1 if the LL path owns the stream and has finished the transfer
+ *         (the caller then starts the next one and skips the HAL handler),
+ *         0 with FAST_IO_LL=0
+ */
+int FastIO_TxIRQ(void);
+
+#if FASTIO_BENCH
+/**
+ * @brief Times both I2C read and compare versions, prints the results on the fast channel. Blocking.
+ *
+ * Reads the BNO055 Euler registers and writes the current motor compares
+ * back, up to FASTIO_BENCH_RUNS HAL reads with a 100 ms timeout each. Only
+ * for a bench build with the props off.
+ */
+void FastIO_Bench(void);
+#endif
+
+/**
+ * @brief Writes the four TIM3 motor compares (A to D on channels 1 to 4).
+ */
+static inline void FastIO_SetMotors(uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+#if FAST_IO_USE_LL
+    LL_TIM_OC_SetCompareCH1(TIM3, a);
+    LL_TIM_OC_SetCompareCH2(TIM3, b);
+    LL_TIM_OC_SetCompareCH3(TIM3, c);
+    LL_TIM_OC_SetCompareCH4(TIM3, d);
+#else
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_1, a);
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_2, b);
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_3, c);
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_4, d);
+#endif
+}
+
+#endif /* INC_FASTIO_H_ */
@@ -0,0 +1,60 @@
+/**
+ * @file FastLink.h
+ * @brief High-speed DMA output on USART1 for dumps and telemetry.
+ *
+ * USART1 runs at FAST_BAUD to the ST-Link virtual COM port (or any 3.3 V
+ * serial adapter on PA9/PA10). Output is queued in a ring and sent in DMA
+ * chunks, so bulk data never shares the 9600 baud HC-05 control link and
+ * queuing never waits for the wire.
+ *
+ * @author Aaron
+ * @date Oct 17, 2026
+ */
+
+#ifndef INC_FASTLINK_H_
+#define INC_FASTLINK_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Queues data if all of it fits; never blocks.
+ *
+ * @return 1 if queued, 0 if dropped (counted in fastDropped).
+ */
+int FastLink_Send(const void *data, uint16_t len);
+
+/**
+ * @brief Queues data, waiting for ring space as needed.
+ */
+void FastLink_SendWait(const void *data, uint16_t len);
+
+/**
+ * @brief Ring space left (bytes).
+ */
+uint32_t FastLink_Free(void);
+
+/**
+ * @brief Starts the next DMA chunk when the UART is idle.
+ *
+ * Call every main loop iteration and from HAL_UART_TxCpltCallback() for
+ * USART1.
+ */
+void FastLink_Service(void);
+
+/**
+ * @brief Queues a telemetry line every FAST_TELEM_MS; call every flight loop.
+ *
+ * Format: T,ms,roll,pitch,yaw,roll_set,pitch_set,effort_set,batt_mV,A,B,C,D
+ * (angles in millidegrees, A-D the TIM3 compares).
+ */
+void FastLink_Telemetry(void);
+
+#define FAST_BAUD      921600 ///< USART1 rate; 0.5% off at the 50 MHz APB2 clock
+#define FAST_RING      4096   ///< Queue size (bytes, power of two)
+#define FAST_CHUNK     512    ///< Largest single DMA transfer (bytes)
+#define FAST_TELEM_MS  20     ///< Telemetry period (ms)
+
+extern uint32_t fastTxBytes;  ///< Bytes handed to the DMA since boot
+extern uint32_t fastDropped;  ///< Messages dropped because the ring was full
+
+#endif /* INC_FASTLINK_H_ */
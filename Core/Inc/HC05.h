@@ -30,9 +30,39 @@ void processInput(char *charBuf, int32_t *roll, int32_t *pitch, int32_t *yaw, in
 /**
  * @brief Outputs the blackbox flight data via UART.
  *
- * This function is used for offline analysis or debugging.
+ * This function is used for offline analysis or debugging. Blocking.
  */
 void dumpBlackbox(void);
+
+/**
+ * @brief Starts a background blackbox download of the samples recorded so far.
+ *
+ * @param fromStart true for every sample, false to resume after the last download.
+ */
+void HC05_DumpStart(int fromStart);
+
+/**
+ * @brief Queues the next bounded slice of a background download; non-blocking.
+ *
+ * @return true when no download is running.
+ */
+int HC05_DumpStep(void);
+
+#define BB_SLICE_LINES 4   ///< Most samples queued per HC05_DumpStep() call
+#define BB_RESERVE     256 ///< Ring space (bytes) a download leaves for telemetry
+
+/**
+ * @brief Starts/keeps DMA reception running; non-blocking.
+ *
+ * @param rxBuf Buffer for DMA reception.
+ * @param len Frame length to receive.
+ * @return true once a valid control frame has been received.
+ */
+int HC05_LinkStep(uint8_t *rxBuf, uint16_t len);
+
+extern int goodBTcount; ///< Valid control frames received
+extern int btBaud;      ///< HC-05 UART baud rate
+extern int linkMavlink; ///< true when the link speaks MAVLink v2
 void configure_HC05();
 
 #endif /* INC_HC05_H_ */
@@ -0,0 +1,40 @@
+/**
+ * @file LQR.h
+ * @brief LQR state-feedback controller, an alternative to the per-axis PID.
+ *
+ * One gain matrix maps the full state (angle errors, body rates and error
+ * integrals of all three axes) straight to the four motor offsets, so the
+ * shared motors are allocated jointly instead of by three independent
+ * loops and a fixed mixer. The matrix is computed offline from the plant
+ * model by Tools/Sim/lqrgen and compiled in from LQRGains.h.
+ *
+ * @author Aaron
+ * @date Oct 17, 2026
+ */
+
+#ifndef INC_LQR_H_
+#define INC_LQR_H_
+
+#include <stdint.h>
+#include "LQRGains.h"
+
+/**
+ * @brief Computes the motor offsets from the current state.
+ *
+ * Uses roll_error, pitch_error and yaw_error as update_Motors() set them
+ * (actual minus setpoint), roll_rate, pitch_rate and yaw_rate from
+ * BNO_ReadRates(), and steps the error integrals with the same scaling and
+ * max_integral clamp as the PID. Also sets roll_effort, pitch_effort and
+ * yaw_effort to the equivalent per-axis efforts, for anti-windup and
+ * telemetry.
+ *
+ * @param[out] u Compare-count offsets for motors A to D, added to the base throttle.
+ */
+void LQR_Control(int32_t u[LQR_INPUTS]);
+
+#define CTRL_LAW_PID  0  ///< Per-axis PID and the X mixer
+#define CTRL_LAW_LQR  1  ///< LQR state feedback (angle mode only)
+
+extern int ctrlLaw;  ///< CTRL_LAW_PID or CTRL_LAW_LQR (stored parameter)
+
+#endif /* INC_LQR_H_ */
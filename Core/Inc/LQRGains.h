@@ -0,0 +1,35 @@
+/**
+ * @file LQRGains.h
+ * @brief LQR state-feedback gains for LQR.c, generated by Tools/Sim/lqrgen.
+ *
+ * Do not edit; rerun lqrgen after changing the plant model or weights.
+ * Weights (largest expected value): angle 2.0 deg, rate 30 deg/s,
+ * integral 0.50 deg s, yaw 10.0 deg, motor offset 100 counts.
+ * Plant: t_max 8.00 N, arm 0.120 m, Ixx 0.0080, Iyy 0.0080, Izz 0.0150 kg m^2.
+ * Linearized at effort 500: 0.00686 N per count (thrust exponent 2.0,
+ * lut_exp 1.0); other throttles see a different loop gain.
+ * Riccati iteration converged in 3797 steps at 1000 Hz.
+ *
+ * Row m is motor m (A, B, C, D); columns are the roll, pitch and yaw
+ * errors (mdeg), the body rates (mdeg/s) and the error integrals
+ * (mdeg s, as update_Motors() accumulates them). Offset in compare
+ * counts = -(row . x) >> LQR_K_SHIFT.
+ */
+
+#ifndef INC_LQRGAINS_H_
+#define INC_LQRGAINS_H_
+
+#include <stdint.h>
+
+#define LQR_STATES  9  ///< Errors, rates, integrals
+#define LQR_INPUTS  4  ///< Motors A to D
+#define LQR_K_SHIFT 16 ///< Gains are Q16
+
+static const int32_t lqrK[LQR_INPUTS][LQR_STATES] = {
+    {2178, 2178, -897, 164, 164, -241, 6416, 6416, -1307}, ///< Motor A
+    {2178, -2178, 897, 164, -164, 241, 6416, -6416, 1307}, ///< Motor B
+    {-2178, -2178, -897, -164, -164, -241, -6416, -6416, -1307}, ///< Motor C
+    {-2178, 2178, 897, -164, 164, 241, -6416, 6416, 1307}, ///< Motor D
+};
+
+#endif /* INC_LQRGAINS_H_ */
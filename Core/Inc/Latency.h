@@ -0,0 +1,70 @@
+/**
+ * @file Latency.h
+ * @brief Stick-to-motor latency probes carried on the control link.
+ *
+ * The ground station tags a control frame with a non-zero 16-bit stamp. The
+ * drone times that frame from reception to parsing, to the update_Motors()
+ * call that first uses it, to the TIM3 update that latches the new compare
+ * values into the PWM outputs, and echoes the stamp back with the result.
+ *
+ * @author Aaron
+ * @date Oct 17, 2026
+ */
+
+#ifndef INC_LATENCY_H_
+#define INC_LATENCY_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Latency stages of one probe.
+ */
+typedef enum {
+    LAT_RX_PARSE = 0,    ///< Frame received to setpoints written
+    LAT_PARSE_APPLY = 1, ///< Setpoints written to compares written by update_Motors()
+    LAT_APPLY_LATCH = 2, ///< Compares written to the TIM3 update that loads them
+    LAT_TOTAL = 3,       ///< Frame received to PWM change
+    LAT_STAGES
+} LatencyStage;
+
+/**
+ * @brief Notes the arrival time of the frame(s) about to be parsed.
+ *
+ * Call at the top of the link receive callback.
+ */
+void Latency_FrameIn(void);
+
+/**
+ * @brief Starts a probe once a frame's setpoints are written.
+ *
+ * @param stamp Echo stamp from the frame; 0 means the frame is not a probe.
+ */
+void Latency_Parsed(uint16_t stamp);
+
+/**
+ * @brief Claims a parsed probe for this control step; call at the top of update_Motors().
+ */
+void Latency_ApplyStart(void);
+
+/**
+ * @brief Completes the claimed probe; call after the TIM3 compares are written.
+ */
+void Latency_Applied(void);
+
+/**
+ * @brief Prints the histogram on the USART1 fast channel as '#' comment lines. Blocking.
+ *
+ * On the CSV link it also prints a one-line summary on the HC-05 link,
+ * since the fast channel only reaches the ST-Link side.
+ */
+void Latency_Dump(void);
+
+#define LAT_BINS    24    ///< Histogram bins; the last one also counts anything longer
+#define LAT_BIN_US  1000  ///< Histogram bin width (us)
+
+extern uint32_t latHist[LAT_BINS];          ///< Total latency histogram
+extern uint32_t latProbes;                  ///< Probes completed since boot
+extern uint16_t latStamp;                   ///< Stamp of the last completed probe
+extern uint32_t latStageUs[LAT_STAGES];     ///< Stage times of the last completed probe (us)
+
+#endif /* INC_LATENCY_H_ */
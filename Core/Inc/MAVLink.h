@@ -0,0 +1,71 @@
+/**
+ * @file MAVLink.h
+ * @brief Minimal MAVLink v2 telemetry and command link over the HC-05.
+ *
+ * Covers HEARTBEAT, ATTITUDE, MEMINFO, RC_CHANNELS_OVERRIDE, the PARAM_*
+ * protocol, latency reports in DEBUG_FLOAT_ARRAY and blackbox download
+ * with the LOG_* protocol.
+ * Frames are packed and parsed in place in static buffers.
+ *
+ * @author Aaron
+ * @date Oct 17, 2026
+ */
+
+#ifndef INC_MAVLINK_H_
+#define INC_MAVLINK_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Feeds newly received link bytes to the frame parser.
+ *
+ * @param buf DMA receive buffer.
+ * @param end Number of valid bytes in buf (Size from the RX event callback).
+ *
+ * Call from HAL_UARTEx_RxEventCallback(). Only bytes not already seen since
+ * the reception was started are parsed.
+ */
+void MAV_Receive(const uint8_t *buf, uint16_t end);
+
+/**
+ * @brief Sends at most one queued or periodic frame; call every loop.
+ *
+ * Parameter replies go first, then HEARTBEAT and MEMINFO (1 Hz), the log
+ * list entry and requested LOG_DATA, latency reports (MAV_LATENCY_MS) and
+ * ATTITUDE (MAV_ATTITUDE_MS; ahead of LOG_DATA only while flying). Stored parameter writes requested by PARAM_SET are
+ * applied here, outside interrupt context, and only while not flying.
+ */
+void MAV_Service(void);
+
+#define MAV_STX             0xFD  ///< MAVLink v2 start byte
+#define MAV_HEADER_LEN      10    ///< STX through msgid
+#define MAV_FRAME_MAX       280   ///< Header + 255 payload + CRC + signature
+#define MAV_SYSID           1     ///< Our system ID
+#define MAV_COMPID          1     ///< MAV_COMP_ID_AUTOPILOT1
+#define MAV_HEARTBEAT_MS    1000  ///< HEARTBEAT period (ms)
+#define MAV_ATTITUDE_MS     100   ///< ATTITUDE period (ms); ~400 B/s at 9600 baud
+#define MAV_LATENCY_MS      5000  ///< Shortest latency report period (ms); frames run to ~130 B
+#define MAV_LOG_ID          1     ///< The blackbox is the one log on offer
+#define MAV_LOG_CHUNK       90    ///< LOG_DATA payload bytes
+#define MAV_LOG_QUEUE       4     ///< LOG_REQUEST_DATA ranges queued (power of two)
+
+#define MAV_MSG_HEARTBEAT            0
+#define MAV_MSG_PARAM_REQUEST_READ   20
+#define MAV_MSG_PARAM_REQUEST_LIST   21
+#define MAV_MSG_PARAM_VALUE          22
+#define MAV_MSG_PARAM_SET            23
+#define MAV_MSG_ATTITUDE             30
+#define MAV_MSG_RC_CHANNELS_OVERRIDE 70
+#define MAV_MSG_LOG_REQUEST_LIST     117
+#define MAV_MSG_LOG_ENTRY            118
+#define MAV_MSG_LOG_REQUEST_DATA     119
+#define MAV_MSG_LOG_DATA             120
+#define MAV_MSG_LOG_REQUEST_END      122
+#define MAV_MSG_MEMINFO              152
+#define MAV_MSG_DEBUG_FLOAT_ARRAY    350
+
+extern uint32_t mavRxGood;  ///< Frames received with a good CRC
+extern uint32_t mavRxBad;   ///< Frames dropped (CRC, unknown ID or flags)
+extern uint32_t mavLogSent; ///< LOG_DATA frames sent since boot
+
+#endif /* INC_MAVLINK_H_ */
@@ -0,0 +1,32 @@
+/**
+ * @file MainLoop.h
+ * @brief Flight state machine, one main loop iteration per call.
+ *
+ * This file declares the bring-up / disarmed / flying / dump / calibration
+ * state machine that main() runs forever, so the SITL build on the host
+ * runs the same code.
+ *
+ * @author Aaron
+ * @date Oct 17, 2026
+ */
+
+#ifndef INC_MAINLOOP_H_
+#define INC_MAINLOOP_H_
+
+#include <stdint.h>
+
+#define BT_MSG_LEN 37 ///< Fixed CSV frame length on the HC-05 link, terminator included
+
+/**
+ * @brief Runs one pass of the main loop: watchdog check-in, link service
+ *        and the current state (0 bring-up, 1 disarmed, 2 flying,
+ *        3 blackbox dump, 4 motor calibration).
+ */
+void MainLoop_Step(void);
+
+extern uint8_t BT_RxBuf[BT_MSG_LEN]; ///< USART2 reception buffer (DMA target)
+extern int escArming;                ///< ESC arming sequence in progress
+extern int escArmed;                 ///< ESC arming sequence completed
+extern uint32_t armableTick;         ///< HAL tick when the IMU and BT link were both ready (time-to-armable)
+
+#endif /* INC_MAINLOOP_H_ */
@@ -0,0 +1,94 @@
+/**
+ * @file Params.h
+ * @brief Persistent key/value parameter store in flash sectors 6 and 7.
+ *
+ * This file declares the parameter keys and the functions used to load
+ * tunables into RAM at boot and to save changes to flash.
+ *
+ * @author Aaron
+ * @date Oct 17, 2026
+ */
+
+#ifndef INC_PARAMS_H_
+#define INC_PARAMS_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Parameter keys. Values are stored in flash, so never renumber them;
+ *        append new keys before PARAM_COUNT.
+ */
+typedef enum {
+    PARAM_KP_ROLL = 0,
+    PARAM_KI_ROLL = 1,
+    PARAM_KD_ROLL = 2,
+    PARAM_KP_PITCH = 3,
+    PARAM_KI_PITCH = 4,
+    PARAM_KD_PITCH = 5,
+    PARAM_KP_YAW = 6,
+    PARAM_KI_YAW = 7,
+    PARAM_KD_YAW = 8,
+    PARAM_K_EFFORT = 9,
+    PARAM_MAX_INTEGRAL = 10,
+    PARAM_MOTA_OFFSET = 11,
+    PARAM_MOTB_OFFSET = 12,
+    PARAM_MOTC_OFFSET = 13,
+    PARAM_MOTD_OFFSET = 14,
+    PARAM_BLACKBOX_FREQ = 15,
+    PARAM_EFFORT_RATE = 16,
+    PARAM_BT_BAUD = 17,
+    PARAM_LINK_MAVLINK = 18,
+    PARAM_ATT_SOURCE = 19,
+    PARAM_FLIGHT_MODE = 20,
+    PARAM_RATE_MAX = 21,
+    PARAM_RATE_YAW_MAX = 22,
+    PARAM_RATE_EXPO = 23,
+    PARAM_KP_RATE = 24,
+    PARAM_KI_RATE = 25,
+    PARAM_KD_RATE = 26,
+    PARAM_KP_RATE_YAW = 27,
+    PARAM_KI_RATE_YAW = 28,
+    PARAM_GAIN_SCHED = 29,
+    PARAM_CTRL_LAW = 30,
+    PARAM_COUNT
+} ParamKey;
+
+/**
+ * @brief Loads the newest stored value of every parameter into its RAM variable.
+ *
+ * Parameters never saved keep their C initializer. Never writes flash.
+ */
+void Param_Load(void);
+
+/**
+ * @brief Sets a parameter in RAM and appends it to flash.
+ *
+ * @param key Parameter to change.
+ * @param value New value.
+ * @return 0 on success, -1 on a bad key or flash error.
+ *
+ * @warning May erase a flash sector (compaction), which stalls the CPU for
+ *          about a second. Only call while disarmed.
+ */
+int Param_Set(ParamKey key, int32_t value);
+
+/**
+ * @brief Current RAM value of a parameter.
+ */
+int32_t Param_Get(ParamKey key);
+
+/**
+ * @brief Short name of a parameter (at most 16 characters), NULL for a bad key.
+ */
+const char *Param_Name(ParamKey key);
+
+#define PARAM_VERSION      1          ///< Layout version; a mismatch ignores the stored values
+#define PARAM_SECTOR_A     6          ///< First flash sector of the pair
+#define PARAM_SECTOR_B     7          ///< Second flash sector of the pair
+#define PARAM_ADDR_A       0x08040000 ///< Start of sector 6
+#define PARAM_ADDR_B       0x08060000 ///< Start of sector 7
+#define PARAM_MAX_RECORDS  2048       ///< Record slots used per sector (bounds the boot scan)
+
+extern uint32_t paramLoadUs; ///< Time the last Param_Load() took (µs)
+
+#endif /* INC_PARAMS_H_ */
@@ -0,0 +1,35 @@
+/**
+ * @file RamFunc.h
+ * @brief Build-time placement of the hot control path in SRAM.
+ *
+ * Functions marked RAMFUNC are linked into the .RamFunc section, which the
+ * startup code copies from flash to SRAM with .data, so they run without
+ * flash wait states or ART cache misses. Build with -DCTRL_IN_RAM=0 to
+ * leave everything in flash (e.g. to compare timing or save RAM).
+ *
+ * @author Aaron
+ * @date Oct 17, 2026
+ */
+
+#ifndef INC_RAMFUNC_H_
+#define INC_RAMFUNC_H_
+
+#include <stdint.h>
+
+#ifndef CTRL_IN_RAM
+#define CTRL_IN_RAM 1 ///< 1: control step and ISRs run from SRAM
+#endif
+
+#if CTRL_IN_RAM && defined(__arm__)
+#define RAMFUNC __attribute__((section(".RamFunc"), noinline)) ///< Run this function from SRAM
+#else
+#define RAMFUNC ///< Host builds and CTRL_IN_RAM=0: stays in .text
+#endif
+
+extern uint32_t ctrlCycles;    ///< CPU cycles of the last update_Motors() call
+extern uint32_t ctrlCyclesMax; ///< Worst update_Motors() time since boot (cycles)
+
+extern uint8_t _sramfunc[];     ///< Start of the SRAM code copy (linker script)
+extern uint8_t _eramfunc[];     ///< End of the SRAM code copy (linker script)
+
+#endif /* INC_RAMFUNC_H_ */
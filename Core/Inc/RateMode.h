@@ -0,0 +1,56 @@
+/**
+ * @file RateMode.h
+ * @brief Rate (acro) flight mode: stick expo curves and rate setpoints.
+ *
+ * In rate mode the sticks command body rates instead of angles, and
+ * update_Motors() closes the loop on the gyro (BNO_ReadRates()) rather than
+ * on the fused Euler angles. Releasing the sticks holds the current
+ * attitude instead of levelling.
+ *
+ * @author Aaron
+ * @date Oct 17, 2026
+ */
+
+#ifndef INC_RATEMODE_H_
+#define INC_RATEMODE_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Shapes a stick deflection through the expo curve.
+ *
+ * out = x * (1 - e) + x^3 * e, with x the deflection as a fraction of full
+ * stick and e = rateExpo / 100. Expo 0 is linear; higher values soften the
+ * centre for fine control and keep the full rate at the ends.
+ *
+ * @param stick Deflection, ±RATE_STICK_MAX (clamped).
+ * @param maxDps Rate at full deflection (deg/s).
+ * @return Rate setpoint (millidegrees/s).
+ */
+int32_t Rate_Expo(int32_t stick, int32_t maxDps);
+
+/**
+ * @brief Sets roll_rate_set, pitch_rate_set and yaw_rate_set from the sticks.
+ *
+ * Called by both link parsers on every frame, whatever flightMode is, so
+ * switching modes never starts from a stale setpoint.
+ *
+ * Signs follow the angle-mode setpoints: a positive stick commands the
+ * rate that moves roll_true/pitch_true/yaw_true towards a positive setpoint.
+ *
+ * @param roll Roll stick, ±RATE_STICK_MAX.
+ * @param pitch Pitch stick, ±RATE_STICK_MAX.
+ * @param yaw Yaw stick, ±RATE_STICK_MAX.
+ */
+void Rate_Sticks(int32_t roll, int32_t pitch, int32_t yaw);
+
+#define FLIGHT_MODE_ANGLE  0     ///< Sticks command angles (±20°), self-levelling
+#define FLIGHT_MODE_RATE   1     ///< Sticks command body rates through the expo curve
+#define RATE_STICK_MAX     1000  ///< Full stick deflection
+
+extern int flightMode;  ///< FLIGHT_MODE_ANGLE or FLIGHT_MODE_RATE (stored parameter)
+extern int rateMax;     ///< Roll/pitch rate at full stick, deg/s (stored parameter)
+extern int rateYawMax;  ///< Yaw rate at full stick, deg/s (stored parameter)
+extern int rateExpo;    ///< Expo, 0 (linear) to 100 (cubic) (stored parameter)
+
+#endif /* INC_RATEMODE_H_ */
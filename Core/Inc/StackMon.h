@@ -0,0 +1,72 @@
+/**
+ * @file StackMon.h
+ * @brief Stack painting and high-water marks for the main loop and ISRs.
+ *
+ * The free RAM between the heap and the stack is filled with a known
+ * pattern at boot; the lowest overwritten word is the deepest the stack has
+ * ever reached, from any context. StackMon_Mark() calls at interrupt entry
+ * and in the deepest routines additionally record how deep each context was
+ * seen, to show who is responsible for the peak.
+ *
+ * @author Aaron
+ * @date Oct 17, 2026
+ */
+
+#ifndef INC_STACKMON_H_
+#define INC_STACKMON_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Execution contexts tracked separately. All share the one MSP stack.
+ */
+typedef enum {
+    STACK_CTX_MAIN = 0,    ///< Main loop
+    STACK_CTX_SYSTICK = 1, ///< SysTick (HAL tick)
+    STACK_CTX_LINK_RX = 2, ///< USART2 / DMA1 Stream5 handlers and RX callbacks
+    STACK_CTX_CONSOLE = 3, ///< USART1 and its TX DMA (DMA2 Stream7)
+    STACK_CTX_COUNT
+} StackCtx;
+
+/**
+ * @brief Paints the unused stack; call first thing in main().
+ */
+void StackMon_Paint(void);
+
+/**
+ * @brief Deepest stack use since boot from any context (bytes, exact).
+ *
+ * Scans the painted area, so it costs roughly one cycle per free byte / 4;
+ * call it at a low rate.
+ */
+uint32_t StackMon_Peak(void);
+
+/**
+ * @brief Bytes neither the heap nor the stack has ever touched.
+ */
+uint32_t StackMon_Free(void);
+
+/**
+ * @brief Current end of the newlib heap, rounded up to a word.
+ */
+uintptr_t StackMon_HeapEnd(void);
+
+/**
+ * @brief Deepest stack position observed at a StackMon_Mark() for a context (bytes).
+ */
+uint32_t StackMon_CtxPeak(StackCtx ctx);
+
+extern uintptr_t stackMinSP[STACK_CTX_COUNT]; ///< Lowest frame address seen per context
+
+/**
+ * @brief Records the current stack depth for a context. Cheap enough for ISRs.
+ */
+static inline void StackMon_Mark(StackCtx ctx)
+{
+    uintptr_t sp = (uintptr_t)__builtin_frame_address(0);
+    if (sp < stackMinSP[ctx]) stackMinSP[ctx] = sp;
+}
+
+#define STACK_PAINT 0xC0DEC0DEU ///< Fill pattern for unused stack
+
+#endif /* INC_STACKMON_H_ */
@@ -0,0 +1,96 @@
+/**
+ * @file Trace.h
+ * @brief Begin/end event trace of the hot paths with cycle-counter timestamps.
+ *
+ * Events go into a RAM ring that always holds the most recent TRACE_EVENTS.
+ * Recording one costs a few instructions and no I/O, so the timing under
+ * study is left alone. Trace_Dump() prints the ring on the USART1 fast channel;
+ * Tools/trace2json turns the capture into Chrome trace / Perfetto JSON.
+ *
+ * @author Aaron
+ * @date Oct 17, 2026
+ */
+
+#ifndef INC_TRACE_H_
+#define INC_TRACE_H_
+
+#include <stdint.h>
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1 ///< Set to 0 to compile every trace point out
+#endif
+
+#define TRACE_EVENTS 2048 ///< Ring size (power of two, 8 bytes each)
+
+/**
+ * @brief Traced spans: identifier and the name shown in the timeline.
+ */
+#define TRACE_IDS(X) \
+    X(TRACE_CONTROL,    "update_Motors") \
+    X(TRACE_BNO_READ,   "BNO_Read") \
+    X(TRACE_BATTERY,    "Battery_Update") \
+    X(TRACE_MAV,        "MAV_Service") \
+    X(TRACE_BLACKBOX,   "HC05_DumpStep") \
+    X(TRACE_LINK_DMA,   "DMA1_Stream5_IRQHandler") \
+    X(TRACE_LINK_UART,  "USART2_IRQHandler") \
+    X(TRACE_LINK_FRAME, "HAL_UART_RxCpltCallback") \
+    X(TRACE_LINK_EVENT, "HAL_UARTEx_RxEventCallback")
+
+typedef enum {
+#define TRACE_ENUM(id, name) id,
+    TRACE_IDS(TRACE_ENUM)
+#undef TRACE_ENUM
+    TRACE_ID_COUNT
+} TraceId;
+
+/**
+ * @brief One ring entry.
+ */
+typedef struct {
+    uint32_t cycles; ///< DWT->CYCCNT when recorded
+    uint8_t id;      ///< TraceId
+    uint8_t phase;   ///< 'B' (begin) or 'E' (end)
+    uint8_t ctx;     ///< IPSR: 0 = main loop, otherwise the exception number
+    uint8_t pad;
+} TraceEvent;
+
+/**
+ * @brief Prints the ring on the fast channel (oldest first) and starts a new one.
+ *
+ * Blocking. Recording is paused for the duration so the dump itself does
+ * not show up in the next capture.
+ */
+void Trace_Dump(void);
+
+extern TraceEvent traceRing[TRACE_EVENTS];
+extern volatile uint32_t traceHead; ///< Events recorded since the last dump (index of the next one)
+extern volatile int traceOn;        ///< Recording enabled
+
+#if TRACE_ENABLED && defined(__arm__)
+#include "stm32f4xx_hal.h"
+
+/**
+ * @brief Records one event. Safe from any priority: the slot is claimed atomically.
+ */
+static inline void Trace_Event(TraceId id, uint8_t phase)
+{
+    if (traceOn) {
+        TraceEvent *e = &traceRing[__atomic_fetch_add(&traceHead, 1, __ATOMIC_RELAXED) & (TRACE_EVENTS - 1)];
+        e->cycles = DWT->CYCCNT;
+        e->id = (uint8_t)id;
+        e->phase = phase;
+        e->ctx = (uint8_t)__get_IPSR();
+    }
+}
+#else
+static inline void Trace_Event(TraceId id, uint8_t phase)
+{
+    (void)id;
+    (void)phase;
+}
+#endif
+
+#define Trace_Begin(id) Trace_Event((id), 'B')
+#define Trace_End(id)   Trace_Event((id), 'E')
+
+#endif /* INC_TRACE_H_ */
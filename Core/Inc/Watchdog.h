@@ -0,0 +1,54 @@
+/**
+ * @file Watchdog.h
+ * @brief Main loop deadline monitor backed by the independent watchdog.
+ *
+ * The main loop checks in once per iteration. While flying, SysTick drives
+ * the motors to minimum as soon as a check-in is WDG_DEADLINE_MS late, and
+ * keeps them there until the loop is back on time and the throttle is at
+ * zero. The IWDG resets the MCU if the loop stops checking in altogether.
+ *
+ * @author Aaron
+ * @date Oct 17, 2026
+ */
+
+#ifndef INC_WATCHDOG_H_
+#define INC_WATCHDOG_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Starts the IWDG and records whether it caused the last reset.
+ *
+ * Call once after the peripherals are initialized. The IWDG cannot be
+ * stopped again.
+ */
+void Watchdog_Init(void);
+
+/**
+ * @brief Main loop check-in; refreshes the IWDG and times the iteration.
+ *
+ * @param flying true in the flight state: arms the deadline and collects the
+ *               loop statistics. Pass false from other states and from long
+ *               blocking transfers.
+ */
+void Watchdog_Kick(int flying);
+
+/**
+ * @brief Deadline check; call from the SysTick handler.
+ */
+void Watchdog_Tick(void);
+
+#define WDG_LOOP_US      2000  ///< Flight loop budget; longer iterations count as overruns (us)
+#define WDG_DEADLINE_MS  20    ///< Check-in this late while flying forces the safe state (ms)
+#define WDG_RECOVER_MS   500   ///< Loop must be on time this long before the safe state can clear (ms)
+#define WDG_IWDG_PR      5     ///< IWDG prescaler /128: 250 Hz from the 32 kHz LSI
+#define WDG_IWDG_RLR     1000  ///< IWDG reload: 4 s nominal, 2.7 s at the fastest LSI; covers a 128 KB sector erase
+
+extern volatile int wdgSafe;      ///< Motors held at minimum after a missed deadline
+extern uint32_t wdgTrips;         ///< Missed deadlines since boot
+extern int wdgReset;              ///< true if the last reset came from the IWDG
+extern uint32_t loopUs;           ///< Last flight loop iteration (us)
+extern uint32_t loopUsMax;        ///< Worst flight loop iteration since boot (us)
+extern uint32_t loopOverruns;     ///< Flight loop iterations longer than WDG_LOOP_US
+
+#endif /* INC_WATCHDOG_H_ */
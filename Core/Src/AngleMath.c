@@ -0,0 +1,45 @@
+/**
+  ******************************************************************************
+  * @file    AngleMath.c
+  * @author  Aaron Lubinsky
+  * @brief   Wrap-aware heading arithmetic in millidegrees
+  * @version 1.0
+  * @date    2026
+  *
+  * @details All angles are int32_t millidegrees, the same unit BNO_Read() and
+  *          processInput() use. Headings live in [0, 360000); differences are
+  *          always taken the short way round so crossing north does not
+  *          produce a 360 degree error spike.
+  *
+  *          Both functions are exact for every int32_t input;
+  *          Tools/build/anglecheck sweeps them against libm.
+  *
+  ******************************************************************************
+  */
+
+#include "AngleMath.h"
+#include "RamFunc.h"
+
+/**
+ * @brief Wraps an angle into [0, 360000)
+ */
+RAMFUNC int32_t angle_Wrap360(int32_t a)
+{
+    a %= ANGLE_FULL;
+    if (a < 0) a += ANGLE_FULL;
+    return a;
+}
+
+/**
+ * @brief Shortest signed difference a - b, wrapped to (-180000, 180000]
+ *
+ * @details Both angles are wrapped before subtracting, so a - b cannot
+ *          overflow however far apart the inputs are.
+ */
+RAMFUNC int32_t angle_Diff(int32_t a, int32_t b)
+{
+    int32_t d = angle_Wrap360(a) - angle_Wrap360(b); // (-360000, 360000)
+    if (d > ANGLE_HALF) d -= ANGLE_FULL;
+    else if (d <= -ANGLE_HALF) d += ANGLE_FULL;
+    return d;
+}
@@ -0,0 +1,293 @@
+/**
+  ******************************************************************************
+  * @file    AttEKF.c
+  * @author  Aaron Lubinsky
+  * @brief   Quaternion EKF attitude estimator with gyro-bias states
+  * @version 1.0
+  * @date    2026
+  *
+  * @details State x = [q0 q1 q2 q3 bx by bz]: the body-to-earth quaternion
+  *          and the gyro bias. The gyro drives the prediction,
+  *
+  *            q' = q + dt/2 * Omega(w - b) * q,   b' = b
+  *
+  *          with the Jacobian written out by hand (A = I + dt/2 Omega,
+  *          B = -dt/2 Xi(q)) so the covariance update touches only the
+  *          blocks that are not identity. Two corrections follow:
+  *
+  *          - Accelerometer: the measured specific force, normalised, against
+  *            the gravity direction the quaternion predicts (3 rows). Skipped
+  *            while |a| is more than EKF_ACC_GATE away from 1 g, so
+  *            sustained manoeuvres do not drag the horizon.
+  *          - Magnetometer: only the heading. The field is rotated into the
+  *            earth frame with the current estimate; its horizontal angle is
+  *            the yaw error (1 row), so a disturbed field can never tilt the
+  *            horizon through the update.
+  *
+  *          Biases become observable through these corrections: x/y through
+  *          gravity, z through the heading. After each step the quaternion
+  *          is renormalised and P made symmetric again.
+  *
+  *          Cost on the F411 with the FPU: roughly 2500 cycles for a predict
+  *          and 3000 for the accelerometer update; BNO055.c measures it
+  *          (ekfCycles).
+  *
+  ******************************************************************************
+  ==============================================================================
+                        ##### How to use this driver #####
+  ==============================================================================
+  1. Call AttEKF_Start() with the first accelerometer and magnetometer sample
+  2. Call AttEKF_Predict() with every gyro sample and the time since the last
+  3. Call AttEKF_UpdateAccel() / AttEKF_UpdateMag() as often as fresh samples
+     allow (the BNO055 refreshes them at 100 Hz)
+  4. Read the attitude with AttEKF_Euler()
+
+  @note Sensor vectors are in the body frame: x forward, y right, z down
+  @note Tools/build/ekfbench compares it with the BNO055 fusion output
+  */
+
+#include "AttEKF.h"
+#include "RamFunc.h"
+#include <math.h>
+#include <string.h>
+
+#define N EKF_STATES
+
+/**
+ * @brief Keeps the covariance symmetric against rounding
+ */
+static void AttEKF_Symmetrize(AttEKF *f)
+{
+    for (int i = 0; i < N; i++) {
+        for (int j = i + 1; j < N; j++) {
+            float m = 0.5f * (f->P[i][j] + f->P[j][i]);
+            f->P[i][j] = m;
+            f->P[j][i] = m;
+        }
+    }
+}
+
+static void AttEKF_Normalize(AttEKF *f)
+{
+    float n = sqrtf(f->q[0] * f->q[0] + f->q[1] * f->q[1] + f->q[2] * f->q[2] + f->q[3] * f->q[3]);
+
+    for (int i = 0; i < 4; i++) f->q[i] /= n;
+}
+
+/**
+ * @brief Rotates a body vector into the earth frame with the current estimate
+ */
+static void AttEKF_ToEarth(const AttEKF *f, const float v[3], float out[3])
+{
+    float w = f->q[0], x = f->q[1], y = f->q[2], z = f->q[3];
+
+    out[0] = (w * w + x * x - y * y - z * z) * v[0] + 2.0f * (x * y - w * z) * v[1] + 2.0f * (x * z + w * y) * v[2];
+    out[1] = 2.0f * (x * y + w * z) * v[0] + (w * w - x * x + y * y - z * z) * v[1] + 2.0f * (y * z - w * x) * v[2];
+    out[2] = 2.0f * (x * z - w * y) * v[0] + 2.0f * (y * z + w * x) * v[1] + (w * w - x * x - y * y + z * z) * v[2];
+}
+
+void AttEKF_Start(AttEKF *f, const float acc[3], const float mag[3])
+{
+    float roll = atan2f(-acc[1], -acc[2]);
+    float pitch = atan2f(acc[0], sqrtf(acc[1] * acc[1] + acc[2] * acc[2]));
+    float sr = sinf(roll), cr = cosf(roll), sp = sinf(pitch), cp = cosf(pitch);
+    float mx = mag[0] * cp + mag[1] * sr * sp + mag[2] * cr * sp; // Field levelled
+    float my = mag[1] * cr - mag[2] * sr;
+    float yaw = atan2f(-my, mx);
+    float c1 = cosf(0.5f * roll), s1 = sinf(0.5f * roll);
+    float c2 = cosf(0.5f * pitch), s2 = sinf(0.5f * pitch);
+    float c3 = cosf(0.5f * yaw), s3 = sinf(0.5f * yaw);
+
+    f->q[0] = c1 * c2 * c3 + s1 * s2 * s3;
+    f->q[1] = s1 * c2 * c3 - c1 * s2 * s3;
+    f->q[2] = c1 * s2 * c3 + s1 * c2 * s3;
+    f->q[3] = c1 * c2 * s3 - s1 * s2 * c3;
+    f->b[0] = f->b[1] = f->b[2] = 0.0f;
+
+    memset(f->P, 0, sizeof(f->P));
+    for (int i = 0; i < 4; i++) f->P[i][i] = 1e-3f;
+    for (int i = 4; i < N; i++) f->P[i][i] = 4e-4f; // (0.02 rad/s)^2, about 1 deg/s
+    f->ready = 1;
+}
+
+RAMFUNC void AttEKF_Predict(AttEKF *f, const float gyro[3], float dt)
+{
+    float w = f->q[0], x = f->q[1], y = f->q[2], z = f->q[3];
+    float wx = gyro[0] - f->b[0], wy = gyro[1] - f->b[1], wz = gyro[2] - f->b[2];
+    float h = 0.5f * dt;
+    float A[4][4] = {
+        {1.0f,     -h * wx,  -h * wy,  -h * wz},
+        {h * wx,    1.0f,     h * wz,  -h * wy},
+        {h * wy,   -h * wz,   1.0f,     h * wx},
+        {h * wz,    h * wy,  -h * wx,   1.0f},
+    };
+    float B[4][3] = { // -dt/2 * Xi(q)
+        { h * x,  h * y,  h * z},
+        {-h * w,  h * z, -h * y},
+        {-h * z, -h * w,  h * x},
+        { h * y, -h * x, -h * w},
+    };
+    float M[N][N];
+    float qn = 0.25f * dt * EKF_GYRO_NOISE * EKF_GYRO_NOISE;
+    float bn = EKF_BIAS_WALK * EKF_BIAS_WALK * dt;
+
+    /* ===== STATE ===== */
+    for (int i = 0; i < 4; i++) {
+        f->q[i] = A[i][0] * w + A[i][1] * x + A[i][2] * y + A[i][3] * z;
+    }
+
+    /* ===== COVARIANCE: P = F P F' + Q, F = [A B; 0 I] ===== */
+    for (int j = 0; j < N; j++) {
+        for (int i = 0; i < 4; i++) {
+            M[i][j] = A[i][0] * f->P[0][j] + A[i][1] * f->P[1][j] + A[i][2] * f->P[2][j] + A[i][3] * f->P[3][j]
+                    + B[i][0] * f->P[4][j] + B[i][1] * f->P[5][j] + B[i][2] * f->P[6][j];
+        }
+        for (int i = 4; i < N; i++) M[i][j] = f->P[i][j];
+    }
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < 4; j++) {
+            f->P[i][j] = M[i][0] * A[j][0] + M[i][1] * A[j][1] + M[i][2] * A[j][2] + M[i][3] * A[j][3]
+                       + M[i][4] * B[j][0] + M[i][5] * B[j][1] + M[i][6] * B[j][2];
+        }
+        for (int j = 4; j < N; j++) f->P[i][j] = M[i][j];
+    }
+
+    // Gyro noise enters through Xi(q): Xi Xi' = I - q q' for a unit quaternion
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            f->P[i][j] += qn * ((i == j ? 1.0f : 0.0f) - f->q[i] * f->q[j]);
+        }
+    }
+    for (int i = 4; i < N; i++) f->P[i][i] += bn;
+
+    AttEKF_Normalize(f);
+    AttEKF_Symmetrize(f);
+}
+
+/**
+ * @brief Applies a correction: x += K y, P -= K (P H')', with K = P H' S^-1
+ *
+ * @param PHt P H' for the m measurement rows
+ * @param Si  S^-1 (m x m, row-major)
+ */
+static void AttEKF_Correct(AttEKF *f, float PHt[N][3], const float *Si, const float *y, int m)
+{
+    float K[N][3];
+
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < m; j++) {
+            K[i][j] = 0.0f;
+            for (int k = 0; k < m; k++) K[i][j] += PHt[i][k] * Si[k * m + j];
+        }
+    }
+    for (int i = 0; i < N; i++) {
+        float dx = 0.0f;
+        for (int k = 0; k < m; k++) dx += K[i][k] * y[k];
+        if (i < 4) f->q[i] += dx; else f->b[i - 4] += dx;
+        for (int j = 0; j < N; j++) {
+            float d = 0.0f;
+            for (int k = 0; k < m; k++) d += K[i][k] * PHt[j][k];
+            f->P[i][j] -= d;
+        }
+    }
+    AttEKF_Normalize(f);
+    AttEKF_Symmetrize(f);
+}
+
+RAMFUNC int AttEKF_UpdateAccel(AttEKF *f, const float acc[3])
+{
+    float w = f->q[0], x = f->q[1], y = f->q[2], z = f->q[3];
+    float n = sqrtf(acc[0] * acc[0] + acc[1] * acc[1] + acc[2] * acc[2]);
+    float H[3][4] = { // d(-gravity direction)/dq
+        { 2.0f * y, -2.0f * z,  2.0f * w, -2.0f * x},
+        {-2.0f * x, -2.0f * w, -2.0f * z, -2.0f * y},
+        {-2.0f * w,  2.0f * x,  2.0f * y, -2.0f * z},
+    };
+    float PHt[N][3], S[3][3], Si[9], r[3], det;
+
+    if (fabsf(n - EKF_GRAVITY) > EKF_ACC_GATE * EKF_GRAVITY) {
+        return 0;
+    }
+
+    // Innovation: measured minus predicted direction of the specific force
+    r[0] = acc[0] / n + 2.0f * (x * z - w * y);
+    r[1] = acc[1] / n + 2.0f * (y * z + w * x);
+    r[2] = acc[2] / n + (w * w - x * x - y * y + z * z);
+
+    for (int i = 0; i < N; i++) {
+        for (int k = 0; k < 3; k++) {
+            PHt[i][k] = f->P[i][0] * H[k][0] + f->P[i][1] * H[k][1] + f->P[i][2] * H[k][2] + f->P[i][3] * H[k][3];
+        }
+    }
+    for (int a = 0; a < 3; a++) {
+        for (int b = 0; b < 3; b++) {
+            S[a][b] = H[a][0] * PHt[0][b] + H[a][1] * PHt[1][b] + H[a][2] * PHt[2][b] + H[a][3] * PHt[3][b];
+        }
+        S[a][a] += EKF_ACC_NOISE * EKF_ACC_NOISE;
+    }
+
+    /* ===== 3x3 INVERSE (adjugate) ===== */
+    Si[0] = S[1][1] * S[2][2] - S[1][2] * S[2][1];
+    Si[1] = S[0][2] * S[2][1] - S[0][1] * S[2][2];
+    Si[2] = S[0][1] * S[1][2] - S[0][2] * S[1][1];
+    Si[3] = S[1][2] * S[2][0] - S[1][0] * S[2][2];
+    Si[4] = S[0][0] * S[2][2] - S[0][2] * S[2][0];
+    Si[5] = S[0][2] * S[1][0] - S[0][0] * S[1][2];
+    Si[6] = S[1][0] * S[2][1] - S[1][1] * S[2][0];
+    Si[7] = S[0][1] * S[2][0] - S[0][0] * S[2][1];
+    Si[8] = S[0][0] * S[1][1] - S[0][1] * S[1][0];
+    det = S[0][0] * Si[0] + S[0][1] * Si[3] + S[0][2] * Si[6];
+    if (fabsf(det) < 1e-20f) {
+        return 0;
+    }
+    for (int i = 0; i < 9; i++) Si[i] /= det;
+
+    AttEKF_Correct(f, PHt, Si, r, 3);
+    return 1;
+}
+
+RAMFUNC void AttEKF_UpdateMag(AttEKF *f, const float mag[3])
+{
+    float w = f->q[0], x = f->q[1], y = f->q[2], z = f->q[3];
+    float num = 2.0f * (x * y + w * z);
+    float den = w * w + x * x - y * y - z * z;
+    float d2 = num * num + den * den;
+    float H[4], PHt[N][3], m[3], S, Si, r;
+
+    AttEKF_ToEarth(f, mag, m);
+    if (m[0] * m[0] + m[1] * m[1] < 1e-12f || d2 < 1e-12f) {
+        return; // No horizontal field, or pointing straight up/down
+    }
+    r = -atan2f(m[1], m[0]); // Heading error: the levelled field should point north
+
+    // d(yaw)/dq, yaw = atan2(num, den)
+    H[0] = 2.0f * (den * z - num * w) / d2;
+    H[1] = 2.0f * (den * y - num * x) / d2;
+    H[2] = 2.0f * (den * x + num * y) / d2;
+    H[3] = 2.0f * (den * w + num * z) / d2;
+
+    for (int i = 0; i < N; i++) {
+        PHt[i][0] = f->P[i][0] * H[0] + f->P[i][1] * H[1] + f->P[i][2] * H[2] + f->P[i][3] * H[3];
+    }
+    S = H[0] * PHt[0][0] + H[1] * PHt[1][0] + H[2] * PHt[2][0] + H[3] * PHt[3][0] + EKF_MAG_NOISE * EKF_MAG_NOISE;
+    Si = 1.0f / S;
+
+    AttEKF_Correct(f, PHt, &Si, &r, 1);
+}
+
+void AttEKF_Euler(const AttEKF *f, int32_t *roll, int32_t *pitch, int32_t *yaw)
+{
+    const float radToMdeg = 180000.0f / 3.14159265f;
+    float w = f->q[0], x = f->q[1], y = f->q[2], z = f->q[3];
+    float s = 2.0f * (w * y - x * z);
+    float psi;
+
+    if (s > 1.0f) s = 1.0f;
+    if (s < -1.0f) s = -1.0f;
+
+    *roll = (int32_t)(atan2f(2.0f * (y * z + w * x), w * w - x * x - y * y + z * z) * radToMdeg);
+    *pitch = (int32_t)(asinf(s) * radToMdeg);
+    psi = atan2f(2.0f * (x * y + w * z), w * w + x * x - y * y - z * z) * radToMdeg;
+    if (psi < 0.0f) psi += 360000.0f;
+    *yaw = (int32_t)psi;
+}
@@ -22,8 +22,12 @@
   1. Ensure I2C1 peripheral is properly configured and initialized
   2. Connect BNO055 reset pin to GPIOB Pin 14
   3. Connect status LED to GPIOA Pin 0 for calibration indication
-  4. Call BNO_Init() to initialize and calibrate the IMU
-  5. Call BNO_Read() periodically to get current orientation data
+  4. Call BNO_InitStep() every loop until it returns true (or BNO_Init() to block)
+  5. Call BNO_Read() periodically to get current orientation data; set
+     attSource (ATT_SOURCE parameter) to ATT_SOURCE_EKF to estimate it with
+     AttEKF.c from the raw sensors instead of using the BNO055 fusion.
+     In rate mode or under the LQR controller call BNO_ReadRates() instead,
+     which adds the gyro rates
   6. Access blackbox[] array for flight data analysis
 
   @warning Ensure proper I2C pull-up resistors are installed
@@ -32,6 +36,13 @@
 
 #include "BNO055.h"
 #include "stm32f4xx_hal.h"   // Needed for HAL types
+#include "Battery.h"
+#include "RamFunc.h"
+#include "StackMon.h"
+#include "Trace.h"
+#include "AttEKF.h"
+#include "AngleMath.h"
+#include "FastIO.h"
 
 /* External I2C Handle */
 extern I2C_HandleTypeDef hi2c1; ///< I2C1 handle for BNO055 communication
@@ -45,80 +56,266 @@ extern int32_t pitch_set;        ///< Roll setpoint (desired roll angle)
 IMUSample blackbox[MAX_SAMPLES]; ///< Flight data buffer for post-flight analysis
 uint16_t sample_index = 0;       ///< Current index in blackbox buffer
 int counter = 0;                 ///< Counter for blackbox data sampling
+int blackboxFreq = 2;            ///< Reads between logged samples
+
+/* Attitude Source */
+int attSource = ATT_SOURCE_BNO;  ///< Stored parameter ATT_SOURCE
+uint32_t ekfCycles = 0;          ///< Cycles of the last EKF step
+uint32_t ekfCyclesMax = 0;       ///< Longest EKF step
+static AttEKF ekf;               ///< Filter state when attSource is ATT_SOURCE_EKF
+static int ekfReads = 0;         ///< Reads since the last correction
+static uint8_t rawRegs[BNO_RAW_LEN]; ///< Last accel, mag and gyro registers
+static int rateReads = RATE_EULER_DIV - 1; ///< BNO_ReadRates() calls since the last Euler read (first call reads)
+
+/* Bring-up State */
+BNOInitState bnoState = BNO_RESET; ///< Current bring-up phase
+static uint32_t bnoTick;           ///< HAL tick when the current phase started
 
 /**
- * @brief Initializes the BNO055 IMU sensor
+ * @brief Advances the BNO055 bring-up by at most one step
  *
- * @details This function performs a complete initialization sequence:
- *          1. Verifies I2C communication with the BNO055
- *          2. Resets the sensor and I2C interface if needed
- *          3. Configures the sensor to NDOF (Nine Degrees of Freedom) mode
- *          4. Waits for full system calibration before returning
+ * @return true once the sensor is in NDOF mode and fully calibrated
  *
- * The function implements robust error handling with automatic retry logic.
- * It toggles the hardware reset pin and reinitializes I2C if communication fails.
+ * @details Non-blocking version of the original init sequence:
+ *          1. BNO_RESET / BNO_BOOT: toggle the reset pin, wait for the boot
+ *          2. BNO_PROBE: reset I2C1 and read the chip ID (0xA0), else retry
+ *          3. BNO_CONFIG / BNO_NDOF: CONFIG mode, then NDOF fusion mode
+ *          4. BNO_CALIB: poll the calibration register until system bits = 0b11
+ *
+ * Each phase waits by comparing HAL_GetTick() instead of HAL_Delay(), so the
+ * main loop keeps servicing the BT link and ESC arming meanwhile.
  *
  * @note NDOF mode provides absolute orientation by fusing all 9 sensor axes
  * @note Calibration can take 30-60 seconds depending on movement patterns
- * @note Red LED (PA0) remains on during calibration process
+ * @note Red LED (PA0) stays on while calibrating
  *
- * @warning This function blocks until calibration is complete
  * @warning Ensure sensor is moved through various orientations for proper calibration
  *
- * @see BNO_Read()
+ * @see BNO_Init()
  */
-void BNO_Init(){
+int BNO_InitStep(void){
     uint8_t ndof_mode = 0x0C;      ///< NDOF operation mode value
     uint8_t config_mode = 0x00;    ///< Configuration mode value
-    uint8_t successfulRead = false; ///< Flag for successful I2C communication
     uint8_t sampleData = 0x00;     ///< Data read from chip ID register
-    int calibrated = false;        ///< Calibration completion flag
+    uint32_t now = HAL_GetTick();
 
+    switch (bnoState) {
     /* ===== COMMUNICATION VERIFICATION ===== */
-    while(successfulRead == false){
-        // Wait to verify IMU connection
+    case BNO_RESET:
         HAL_GPIO_TogglePin(GPIOB, GPIO_PIN_14); // Reset BNO055 via hardware pin
-        HAL_Delay(1000);                       // Wait for BNO055 boot sequence
+        bnoTick = now;
+        bnoState = BNO_BOOT;
+        break;
+
+    case BNO_BOOT:
+        if (now - bnoTick >= BNO_BOOT_MS) {     // Wait for BNO055 boot sequence
+            bnoState = BNO_PROBE;
+        }
+        break;
+
+    case BNO_PROBE:
         HAL_I2C_DeInit(&hi2c1);                // Reset I2C1 peripheral
         HAL_I2C_Init(&hi2c1);                  // Reinitialize I2C1
-
         if (hi2c1.State == HAL_I2C_STATE_READY) {
             // Once I2C is reset, attempt to read chip ID
             HAL_I2C_Mem_Read(&hi2c1, BNO055_I2C_ADDR, 0x00, 1, &sampleData, 1, 100);
         }
+        // Verify chip ID (should be 0xA0 for BNO055), otherwise reset and retry
+        bnoState = (sampleData == 0xa0) ? BNO_CONFIG : BNO_RESET;
+        break;
+
+    /* ===== MODE CONFIGURATION ===== */
+    case BNO_CONFIG:
+        // Set to CONFIG mode to allow register writes
+        HAL_I2C_Mem_Write(&hi2c1, BNO055_I2C_ADDR, BNO055_OPR_MODE_ADDR,
+                          I2C_MEMADD_SIZE_8BIT, &config_mode, 1, 100);
+        bnoTick = now;
+        bnoState = BNO_NDOF;
+        break;
 
-        // Verify chip ID (should be 0xA0 for BNO055)
-        if (sampleData == 0xa0){
-            successfulRead = true;
+    case BNO_NDOF:
+        if (now - bnoTick >= BNO_MODE_MS) {
+            // Set to NDOF mode for full sensor fusion
+            HAL_I2C_Mem_Write(&hi2c1, BNO055_I2C_ADDR, BNO055_OPR_MODE_ADDR,
+                              I2C_MEMADD_SIZE_8BIT, &ndof_mode, 1, 100);
+            bnoTick = now;
+            bnoState = BNO_CALIB;
+            HAL_GPIO_WritePin(GPIOA, GPIO_PIN_0, GPIO_PIN_SET);   // Red LED on during calibration
         }
+        break;
+
+    /* ===== CALIBRATION MONITORING ===== */
+    case BNO_CALIB:
+        if (now - bnoTick >= BNO_CALIB_POLL_MS) {
+            bnoTick = now;
+            // Read calibration status register
+            HAL_I2C_Mem_Read(&hi2c1, BNO055_I2C_ADDR, BNO055_CALIB_STAT, 1, &calibData, 1, 100);
+
+            // Check if system calibration is complete (bits 7:6 == 0b11)
+            if (((calibData >> 6) & 0x03) == 0x03){
+                HAL_GPIO_WritePin(GPIOA, GPIO_PIN_0, GPIO_PIN_RESET);   // Red LED off
+                bnoState = BNO_READY;
+            }
+        }
+        break;
+
+    case BNO_READY:
+    default:
+        return true;
     }
 
-    /* ===== MODE CONFIGURATION ===== */
-    // Set to CONFIG mode to allow register writes
-    HAL_I2C_Mem_Write(&hi2c1, BNO055_I2C_ADDR, BNO055_OPR_MODE_ADDR,
-                      I2C_MEMADD_SIZE_8BIT, &config_mode, 1, 100);
-    HAL_Delay(25);
+    return false;
+}
 
-    // Set to NDOF mode for full sensor fusion
-    HAL_I2C_Mem_Write(&hi2c1, BNO055_I2C_ADDR, BNO055_OPR_MODE_ADDR,
-                      I2C_MEMADD_SIZE_8BIT, &ndof_mode, 1, 100);
-    HAL_Delay(25);
+/**
+ * @brief Initializes the BNO055 IMU sensor, blocking until it is calibrated
+ *
+ * @details Runs BNO_InitStep() to completion. Use BNO_InitStep() directly
+ *          when other work has to continue during bring-up.
+ *
+ * @warning This function blocks until calibration is complete
+ *
+ * @see BNO_InitStep()
+ * @see BNO_Read()
+ */
+void BNO_Init(){
+    bnoState = BNO_RESET;
+    while (!BNO_InitStep()) {
+    }
+}
 
-    /* ===== CALIBRATION MONITORING ===== */
-    while(calibrated == false){
-        // Wait for IMU to calibrate
-        HAL_GPIO_WritePin(GPIOA, GPIO_PIN_0, GPIO_PIN_SET);   // Red LED on during calibration
+/**
+ * @brief Stores pitch, roll, their setpoints and pack voltage in the blackbox
+ *        every blackboxFreq reads
+ */
+RAMFUNC static void BNO_Log(const int32_t *roll, const int32_t *pitch)
+{
+    /* ===== FLIGHT DATA LOGGING ===== */
+    // Log data to blackbox at specified frequency
+    if (counter++ == blackboxFreq) {
+        if (sample_index < MAX_SAMPLES) {
+            blackbox[sample_index].pitch = *pitch;
+            blackbox[sample_index].roll  = *roll;
+            blackbox[sample_index].pitchSet = pitch_set;
+            blackbox[sample_index].rollSet  = roll_set;
+            blackbox[sample_index].vbat     = batt_mV;
+            sample_index++;
+        }
+        counter = 0;
+    }
+}
 
-        // Read calibration status register
-        HAL_I2C_Mem_Read(&hi2c1, BNO055_I2C_ADDR, BNO055_CALIB_STAT, 1, &calibData, 1, 100);
+/**
+ * @brief Converts the raw accel, mag and gyro registers to the AttEKF body frame
+ *
+ * @details Register units (UNIT_SEL at its reset value): accel 100 LSB per
+ *          m/s^2, mag 16 LSB per uT, gyro 16 LSB per deg/s. The chip's axes
+ *          (z up) map to the body frame as forward = chip Y, right = chip X,
+ *          down = -chip Z, which puts roll about the axis the BNO055 calls
+ *          roll, as BNO_Read() has always used it.
+ */
+RAMFUNC void BNO_RawToBody(const uint8_t *raw, float acc[3], float mag[3], float gyro[3])
+{
+    const float gyroScale = 3.14159265f / (180.0f * 16.0f);
+    float chip[9];
+
+    for (int i = 0; i < 9; i++) {
+        chip[i] = (float)(int16_t)((raw[2 * i + 1] << 8) | raw[2 * i]);
+    }
+    acc[0] = chip[1] / 100.0f;   acc[1] = chip[0] / 100.0f;   acc[2] = -chip[2] / 100.0f;
+    mag[0] = chip[4] / 16.0f;    mag[1] = chip[3] / 16.0f;    mag[2] = -chip[5] / 16.0f;
+    gyro[0] = chip[7] * gyroScale; gyro[1] = chip[6] * gyroScale; gyro[2] = -chip[8] * gyroScale;
+}
+
+/**
+ * @brief Time since the previous EKF step (s)
+ */
+static float BNO_Dt(void)
+{
+#ifdef __arm__
+    static uint32_t last = 0;
+    uint32_t now = DWT->CYCCNT;
+    float dt = (float)(now - last) / (float)SystemCoreClock;
 
-        // Check if system calibration is complete (bits 7:6 == 0b11)
-        if (((calibData >> 6) & 0x03) == 0x03){
-            calibrated = true;
+    last = now;
+    return (dt > 0.05f) ? 0.05f : dt; // First read, or after a pause
+#else
+    return 0.001f; // The host harnesses step 1 ms per read
+#endif
+}
+
+/**
+ * @brief One AttEKF step on a raw register burst
+ *
+ * @details Predicts on every read and corrects every EKF_CORR_DIV reads,
+ *          which matches the 100 Hz refresh of the BNO055 data registers
+ *          at the 1 kHz loop. Only correcting reads fetch all 18 bytes;
+ *          the others fetch the 6 gyro bytes, the same I2C time as the
+ *          Euler read. Starts the filter on the first read.
+ */
+RAMFUNC static void BNO_ReadEKF(int32_t *roll, int32_t *pitch, int32_t *yaw)
+{
+    float acc[3], mag[3], gyro[3];
+    int correct = !ekf.ready || ++ekfReads >= EKF_CORR_DIV;
+#ifdef __arm__
+    uint32_t start;
+#endif
+
+    if (correct) {
+        ekfReads = 0;
+        FastIO_I2CRead(BNO055_I2C_ADDR, BNO055_ACC_DATA, rawRegs, BNO_RAW_LEN);
+    } else {
+        FastIO_I2CRead(BNO055_I2C_ADDR, BNO055_GYR_DATA, &rawRegs[12], 6);
+    }
+#ifdef __arm__
+    start = DWT->CYCCNT; // Filter only, not the I2C transfer
+#endif
+    BNO_RawToBody(rawRegs, acc, mag, gyro);
+
+    if (!ekf.ready) {
+        AttEKF_Start(&ekf, acc, mag);
+        BNO_Dt();
+    } else {
+        AttEKF_Predict(&ekf, gyro, BNO_Dt());
+        if (correct) {
+            AttEKF_UpdateAccel(&ekf, acc);
+            AttEKF_UpdateMag(&ekf, mag);
         }
+    }
+    AttEKF_Euler(&ekf, roll, pitch, yaw);
 
-        HAL_GPIO_WritePin(GPIOA, GPIO_PIN_0, GPIO_PIN_RESET);   // Red LED off
+#ifdef __arm__
+    ekfCycles = DWT->CYCCNT - start;
+    if (ekfCycles > ekfCyclesMax) {
+        ekfCyclesMax = ekfCycles;
     }
+#endif
+}
+
+/**
+ * @brief Reads the Euler angle registers and converts them to millidegrees
+ */
+RAMFUNC static void BNO_ReadEuler(int32_t *roll, int32_t *pitch, int32_t *yaw)
+{
+    uint8_t eulerData[6];  ///< Raw Euler angle data buffer (6 bytes)
+    int32_t rawYaw16;      ///< Raw 16-bit yaw value
+    int32_t rawPitch16;    ///< Raw 16-bit pitch value
+    int32_t rawRoll16;     ///< Raw 16-bit roll value
+
+    /* ===== READ RAW EULER DATA ===== */
+    // Read 6 bytes starting from Euler LSB register
+    FastIO_I2CRead(BNO055_I2C_ADDR, BNO055_EULER_LSB, eulerData, 6);
+
+    /* ===== DATA CONVERSION ===== */
+    // Combine LSB and MSB bytes to form 16-bit signed values
+    rawYaw16   = (int16_t)((eulerData[1] << 8) | eulerData[0]);  // Bytes 0-1: Yaw
+    rawRoll16  = (int16_t)((eulerData[3] << 8) | eulerData[2]);  // Bytes 2-3: Roll
+    rawPitch16 = (int16_t)((eulerData[5] << 8) | eulerData[4]);  // Bytes 4-5: Pitch
+
+    // Convert from 1/16 degree resolution to millidegrees
+    *yaw   = ((int32_t)rawYaw16 * 1000) / 16;
+    *roll  = ((int32_t)rawRoll16 * 1000) / 16;
+    *pitch = ((int32_t)rawPitch16 * 1000) / 16;
 }
 
 /**
@@ -134,7 +331,7 @@ void BNO_Init(){
  *          the BNO055's native 1/16 degree resolution to millidegrees.
  *
  * Additionally, this function implements flight data logging by storing
- * pitch and roll data in the blackbox buffer at a configurable rate.
+ * pitch, roll and pack voltage in the blackbox buffer at a configurable rate.
  *
  * @note Euler angles are returned in millidegrees (1/1000 of a degree)
  * @note Yaw range: 0° to 360° (0 to 360000 millidegrees)
@@ -146,38 +343,80 @@ void BNO_Init(){
  *
  * @see BNO_Init()
  */
-void BNO_Read(int32_t *roll, int32_t *pitch, int32_t *yaw){
-    uint8_t eulerData[6];  ///< Raw Euler angle data buffer (6 bytes)
-    int32_t rawYaw16;      ///< Raw 16-bit yaw value
-    int32_t rawPitch16;    ///< Raw 16-bit pitch value
-    int32_t rawRoll16;     ///< Raw 16-bit roll value
+RAMFUNC void BNO_Read(int32_t *roll, int32_t *pitch, int32_t *yaw){
+    StackMon_Mark(STACK_CTX_MAIN);
+    Trace_Begin(TRACE_BNO_READ);
 
-    /* ===== READ RAW EULER DATA ===== */
-    // Read 6 bytes starting from Euler LSB register
-    HAL_I2C_Mem_Read(&hi2c1, BNO055_I2C_ADDR, BNO055_EULER_LSB,
-                     I2C_MEMADD_SIZE_8BIT, eulerData, 6, 100);
+    if (attSource == ATT_SOURCE_EKF) {
+        BNO_ReadEKF(roll, pitch, yaw);
+    } else {
+        BNO_ReadEuler(roll, pitch, yaw);
+    }
 
-    /* ===== DATA CONVERSION ===== */
-    // Combine LSB and MSB bytes to form 16-bit signed values
-    rawYaw16   = (int16_t)((eulerData[1] << 8) | eulerData[0]);  // Bytes 0-1: Yaw
-    rawRoll16  = (int16_t)((eulerData[3] << 8) | eulerData[2]);  // Bytes 2-3: Roll
-    rawPitch16 = (int16_t)((eulerData[5] << 8) | eulerData[4]);  // Bytes 4-5: Pitch
+    BNO_Log(roll, pitch);
+    Trace_End(TRACE_BNO_READ);
+}
 
-    // Convert from 1/16 degree resolution to millidegrees
-    *yaw   = ((int32_t)rawYaw16 * 1000) / 16;
-    *roll  = ((int32_t)rawRoll16 * 1000) / 16;
-    *pitch = ((int32_t)rawPitch16 * 1000) / 16;
+/**
+ * @brief Reads body rates for the rate controller, plus the Euler angles
+ *
+ * @param[out] roll      Roll angle (millidegrees), read every RATE_EULER_DIV calls, gyro-propagated between
+ * @param[out] pitch     Pitch angle (millidegrees), same
+ * @param[out] yaw       Yaw angle (millidegrees), same
+ * @param[out] rollRate  Roll rate (millidegrees/s)
+ * @param[out] pitchRate Pitch rate (millidegrees/s)
+ * @param[out] yawRate   Yaw rate (millidegrees/s)
+ *
+ * @details Fetches the 6 gyro bytes on every call, so a loop closed on the
+ *          rates pays the same I2C time as BNO_Read(). The Euler registers
+ *          only change at the 100 Hz fusion rate and are only used for
+ *          telemetry and the blackbox in rate mode, so they are read every
+ *          RATE_EULER_DIV calls and carried forward on the gyro in between,
+ *          which is good enough for the LQR controller's angle states too.
+ *          With attSource set to ATT_SOURCE_EKF the EKF's own gyro read is
+ *          reused, less its bias estimate, and the angles come from the
+ *          filter on every call.
+ *
+ *          Rates are in the body frame with the BNO_Read() sign conventions
+ *          (positive roll rate increases roll_true), 1/16 deg/s resolution.
+ */
+RAMFUNC void BNO_ReadRates(int32_t *roll, int32_t *pitch, int32_t *yaw,
+                           int32_t *rollRate, int32_t *pitchRate, int32_t *yawRate)
+{
+    StackMon_Mark(STACK_CTX_MAIN);
+    Trace_Begin(TRACE_BNO_READ);
 
-    /* ===== FLIGHT DATA LOGGING ===== */
-    // Log data to blackbox at specified frequency
-    if (counter++ == blackboxFreq) {
-        if (sample_index < MAX_SAMPLES) {
-            blackbox[sample_index].pitch = *pitch;
-            blackbox[sample_index].roll  = *roll;
-            blackbox[sample_index].pitchSet = pitch_set;
-            blackbox[sample_index].rollSet  = roll_set;
-            sample_index++;
+    if (attSource == ATT_SOURCE_EKF) {
+        float acc[3], mag[3], gyro[3];
+        const float toMdeg = 180000.0f / 3.14159265f;
+
+        BNO_ReadEKF(roll, pitch, yaw); // Reads the gyro on every call already
+        BNO_RawToBody(rawRegs, acc, mag, gyro);
+        *rollRate  = (int32_t)((gyro[0] - ekf.b[0]) * toMdeg);
+        *pitchRate = (int32_t)((gyro[1] - ekf.b[1]) * toMdeg);
+        *yawRate   = (int32_t)((gyro[2] - ekf.b[2]) * toMdeg);
+    } else {
+        const uint8_t *g = &rawRegs[12];
+
+        FastIO_I2CRead(BNO055_I2C_ADDR, BNO055_GYR_DATA, &rawRegs[12], 6);
+        float dt = BNO_Dt();
+
+        // Same axis mapping as BNO_RawToBody(); 16 LSB per deg/s
+        *rollRate  = (int32_t)(int16_t)((g[3] << 8) | g[2]) * 1000 / 16;   // Chip Y
+        *pitchRate = (int32_t)(int16_t)((g[1] << 8) | g[0]) * 1000 / 16;   // Chip X
+        *yawRate   = -(int32_t)(int16_t)((g[5] << 8) | g[4]) * 1000 / 16;  // -Chip Z
+
+        if (++rateReads >= RATE_EULER_DIV) {
+            rateReads = 0;
+            BNO_ReadEuler(roll, pitch, yaw);
+        } else {
+            // Carry the angles forward on the gyro between Euler reads (small-angle)
+            *roll += (int32_t)(*rollRate * dt);
+            *pitch += (int32_t)(*pitchRate * dt);
+            *yaw = angle_Wrap360(*yaw + (int32_t)(*yawRate * dt));
         }
-        counter = 0;
     }
+
+    BNO_Log(roll, pitch);
+    Trace_End(TRACE_BNO_READ);
 }
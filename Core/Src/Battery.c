@@ -0,0 +1,154 @@
+/**
+  ******************************************************************************
+  * @file    Battery.c
+  * @author  Aaron Lubinsky
+  * @brief   Battery pack sensing and motor voltage-sag compensation
+  * @version 1.0
+  * @date    2026
+  *
+  * @details ADC1 runs in continuous scan mode and DMA2 Stream0 copies every
+  *          conversion into a circular ring, so sampling costs the CPU nothing.
+  *          Battery_Update() averages the ring and low-pass filters the result;
+  *          Battery_Compensate() scales motor commands by nominal/actual voltage
+  *          so the same command gives the same thrust as the pack sags.
+  *
+  ******************************************************************************
+  ==============================================================================
+                        ##### How to use this driver #####
+  ==============================================================================
+  1. Wire the pack through a 10k/1k divider to PA5 (ADC1_IN5)
+  2. Optionally wire a current sensor output to PA4 (ADC1_IN4) and set
+     BATT_CURRENT_SENSE to 1
+  3. Call Battery_Init() once after the HAL peripherals are initialized
+  4. Call Battery_Update() every control loop, before update_Motors()
+
+  @note The HAL ADC driver is not part of this project, so ADC1 and DMA2 are
+        configured at register level
+  @warning Check BATT_DIV_NUM/BATT_DIV_DEN against the actual divider
+  */
+
+#include "Battery.h"
+#include "ESC.h"
+#include "RamFunc.h"
+#include "Trace.h"
+#include "stm32f4xx_hal.h"   // Needed for register definitions
+
+#if BATT_CURRENT_SENSE
+#define BATT_CHANNELS 2      ///< Voltage (IN5) then current (IN4)
+#else
+#define BATT_CHANNELS 1      ///< Voltage (IN5) only
+#endif
+
+/* Filtered Readings */
+int32_t batt_mV = 0; ///< Filtered pack voltage (mV)
+int32_t batt_mA = 0; ///< Filtered pack current (mA)
+
+/* Static Variables */
+static volatile uint16_t battRing[BATT_RING_LEN * BATT_CHANNELS]; ///< DMA target, interleaved by channel
+static int32_t battScale = 1024; ///< Compensation factor (Q10), 1024 = no change
+
+/**
+ * @brief Starts ADC1 scan conversions with circular DMA into battRing
+ *
+ * @details ADC clock is PCLK2/4 (12.5 MHz) with the longest sample time,
+ *          giving about 25 kS/s per channel, which is plenty for a pack
+ *          voltage and keeps the divider's source impedance harmless.
+ */
+void Battery_Init(void)
+{
+    /* ===== CLOCKS AND PINS ===== */
+    RCC->AHB1ENR |= RCC_AHB1ENR_GPIOAEN | RCC_AHB1ENR_DMA2EN;
+    RCC->APB2ENR |= RCC_APB2ENR_ADC1EN;
+    (void)RCC->APB2ENR; // Let the clock enable settle
+
+    GPIOA->MODER |= (3U << (5 * 2));     // PA5 analog
+#if BATT_CURRENT_SENSE
+    GPIOA->MODER |= (3U << (4 * 2));     // PA4 analog
+#endif
+
+    /* ===== DMA2 STREAM0 CHANNEL0 (ADC1) ===== */
+    DMA2_Stream0->CR = 0;
+    while (DMA2_Stream0->CR & DMA_SxCR_EN) {
+        // Wait for any previous transfer to stop
+    }
+    DMA2->LIFCR = 0x3DU; // Clear all Stream0 flags
+    DMA2_Stream0->PAR  = (uint32_t)(uintptr_t)&ADC1->DR;
+    DMA2_Stream0->M0AR = (uint32_t)(uintptr_t)battRing;
+    DMA2_Stream0->NDTR = BATT_RING_LEN * BATT_CHANNELS;
+    DMA2_Stream0->CR   = (0U << DMA_SxCR_CHSEL_Pos)  // Channel 0 = ADC1
+                       | DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0 // Half-words
+                       | DMA_SxCR_MINC | DMA_SxCR_CIRC;      // Low priority, no IRQ
+    DMA2_Stream0->CR  |= DMA_SxCR_EN;
+
+    /* ===== ADC1 CONTINUOUS SCAN ===== */
+    ADC->CCR   = (ADC->CCR & ~ADC_CCR_ADCPRE) | ADC_CCR_ADCPRE_0; // PCLK2 / 4
+    ADC1->CR1  = ADC_CR1_SCAN;
+    ADC1->SMPR2 = (7U << ADC_SMPR2_SMP5_Pos) | (7U << ADC_SMPR2_SMP4_Pos); // 480 cycles
+    ADC1->SQR1 = (BATT_CHANNELS - 1) << ADC_SQR1_L_Pos;
+    ADC1->SQR3 = 5U | (4U << 5);
+    ADC1->CR2  = ADC_CR2_ADON | ADC_CR2_CONT | ADC_CR2_DMA | ADC_CR2_DDS;
+    ADC1->CR2 |= ADC_CR2_SWSTART;
+}
+
+/**
+ * @brief Averages the DMA ring and low-pass filters voltage and current
+ *
+ * @details The ring average removes ADC noise and PWM ripple; the IIR stage
+ *          (weight 1/2^BATT_FILTER_SHIFT) keeps load transients from bouncing
+ *          the compensation. The first call seeds the filter directly.
+ */
+RAMFUNC void Battery_Update(void)
+{
+    uint32_t sumV = 0;
+    int32_t mV;
+#if BATT_CURRENT_SENSE
+    uint32_t sumI = 0;
+    int32_t mA;
+#endif
+
+    Trace_Begin(TRACE_BATTERY);
+    for (int i = 0; i < BATT_RING_LEN; i++) {
+        sumV += battRing[i * BATT_CHANNELS];
+#if BATT_CURRENT_SENSE
+        sumI += battRing[i * BATT_CHANNELS + 1];
+#endif
+    }
+
+    // Average counts -> pin millivolts -> pack millivolts
+    mV = (int32_t)((sumV / BATT_RING_LEN) * BATT_VREF_MV / 4095);
+    mV = mV * BATT_DIV_NUM / BATT_DIV_DEN;
+
+    if (batt_mV == 0) {
+        batt_mV = mV;
+    } else {
+        batt_mV += (mV - batt_mV) >> BATT_FILTER_SHIFT;
+    }
+
+#if BATT_CURRENT_SENSE
+    mA = (int32_t)((sumI / BATT_RING_LEN) * BATT_VREF_MV / 4095) * BATT_MA_PER_MV;
+    batt_mA += (mA - batt_mA) >> BATT_FILTER_SHIFT;
+#endif
+
+    /* ===== COMPENSATION FACTOR ===== */
+    // Thrust scales with (voltage * duty)^2, so duty must scale with nominal/actual
+    if (batt_mV < BATT_MIN_MV / 2) {
+        battScale = 1024; // No pack on the divider (bench power), don't compensate
+    } else if (batt_mV < BATT_MIN_MV) {
+        battScale = (BATT_NOMINAL_MV << 10) / BATT_MIN_MV;
+    } else {
+        battScale = (BATT_NOMINAL_MV << 10) / batt_mV;
+    }
+    Trace_End(TRACE_BATTERY);
+}
+
+/**
+ * @brief Scales the portion of a compare value above idle by the sag factor
+ *
+ * @param cmd Compare value after mixing and linearization
+ * @return Compensated compare value; caller applies the final clamp
+ */
+RAMFUNC int32_t Battery_Compensate(int32_t cmd)
+{
+    if (cmd <= ESC_CMD_MIN) return cmd;
+    return ESC_CMD_MIN + (((cmd - ESC_CMD_MIN) * battScale) >> 10);
+}
@@ -14,7 +14,8 @@
   ==============================================================================
                         ##### How to use this driver #####
   ==============================================================================
-  1. Call armESC() to initialize and arm all ESC motors
+  1. Call ESC_ArmStart() then ESC_ArmStep() every loop until it returns true
+     (or armESC() to block) to arm all ESC motors
   2. Call update_Motors() periodically to update motor speeds based on PID control
   3. Ensure all external variables (PID constants, setpoints, etc.) are properly configured
 
@@ -23,6 +24,16 @@
   */
 
 #include "ESC.h"
+#include "Battery.h"
+#include "AngleMath.h"
+#include "RamFunc.h"
+#include "StackMon.h"
+#include "Watchdog.h"
+#include "Trace.h"
+#include "Latency.h"
+#include "RateMode.h"
+#include "LQR.h"
+#include "FastIO.h"
 #include "stm32f4xx_hal.h"   // Needed for HAL types
 #include <stdint.h>
 #include <stdio.h>
@@ -46,6 +57,11 @@ extern int32_t Kd_pitch;  ///< Derivative gain for pitch control
 extern int32_t Kp_yaw;    ///< Proportional gain for yaw control
 extern int32_t Ki_yaw;    ///< Integral gain for yaw control
 extern int32_t Kd_yaw;    ///< Derivative gain for yaw control
+extern int32_t Kp_rate;     ///< Rate mode proportional gain, roll and pitch
+extern int32_t Ki_rate;     ///< Rate mode integral gain, roll and pitch
+extern int32_t Kd_rate;     ///< Rate mode derivative gain, roll and pitch
+extern int32_t Kp_rate_yaw; ///< Rate mode proportional gain, yaw
+extern int32_t Ki_rate_yaw; ///< Rate mode integral gain, yaw
 
 /* External PID State Variables */
 extern int32_t roll_set;        ///< Roll setpoint (desired roll angle)
@@ -69,6 +85,9 @@ extern int32_t yaw_integral;   ///< Yaw integral term accumulator
 extern int32_t yaw_derivative; ///< Yaw derivative term
 extern int32_t last_yaw_error; ///< Previous yaw error for derivative calculation
 
+extern int32_t roll_rate_set, pitch_rate_set, yaw_rate_set; ///< Rate setpoints (mdeg/s)
+extern int32_t roll_rate, pitch_rate, yaw_rate;             ///< Gyro rates (mdeg/s)
+
 extern int32_t roll_effort;  ///< Roll control output effort
 extern int32_t pitch_effort; ///< Pitch control output effort
 extern int32_t yaw_effort;   ///< Yaw control output effort
@@ -103,62 +122,277 @@ int D = 0; ///< Motor D PWM compare value
 
 int armCompare = 0;     ///< PWM compare value used during ESC arming sequence
 int max_integral = 100000; ///< Maximum integral windup limit
+int antiWindup = true;     ///< Stop integrating while the motors an axis drives are saturated
+int satMask = 0;           ///< Motors clipped on the last update (bit 0 = A ... bit 3 = D)
 
 /**
- * @brief Arms all ESC motors by sending initialization sequence
+ * @brief Per-motor thrust linearization curves
+ * @details Row n holds motor n's compare value at thrust fractions 0/16 ... 16/16
+ *          of full thrust. Entry 0 stays at ESC_CMD_MIN so a stopped motor stays
+ *          stopped. No thrust stand data exists yet, so the rows are the
+ *          identity (ESC_CMD_MIN to ESC_CMD_MAX in equal steps) and
+ *          THRUST_LUT_ENABLED is 0. Measure each motor's compare value at the
+ *          17 thrust fractions, replace its row, then enable the curve.
  *
- * @details This function sends the proper PWM signals to arm all four ESC motors.
- *          It starts PWM generation on all channels and sends a specific pulse width
- *          (approximately 1000μs) to arm the ESCs. The function continues until
- *          the roll_set value reaches a threshold, indicating the system is ready.
+ *          THRUST_LUT_IDEAL selects the inverse of the host simulator's
+ *          quadratic plant (1000 + 700 * sqrt(k/16)) instead; only
+ *          Tools/build/lutbench is built with it. The other host tools fly
+ *          the shipped configuration and model a calibrated curve with the
+ *          plant's lut_exp.
+ * @{
+ */
+#if THRUST_LUT_IDEAL
+static const int16_t thrustLUT[4][THRUST_LUT_POINTS] = {
+    {960, 1175, 1247, 1303, 1350, 1391, 1429, 1463, 1495, 1525, 1553, 1580, 1606, 1631, 1655, 1678, 1700}, ///< Motor A
+    {960, 1175, 1247, 1303, 1350, 1391, 1429, 1463, 1495, 1525, 1553, 1580, 1606, 1631, 1655, 1678, 1700}, ///< Motor B
+    {960, 1175, 1247, 1303, 1350, 1391, 1429, 1463, 1495, 1525, 1553, 1580, 1606, 1631, 1655, 1678, 1700}, ///< Motor C
+    {960, 1175, 1247, 1303, 1350, 1391, 1429, 1463, 1495, 1525, 1553, 1580, 1606, 1631, 1655, 1678, 1700}, ///< Motor D
+};
+#else
+static const int16_t thrustLUT[4][THRUST_LUT_POINTS] = {
+    {960, 1006, 1053, 1099, 1145, 1191, 1238, 1284, 1330, 1376, 1423, 1469, 1515, 1561, 1608, 1654, 1700}, ///< Motor A
+    {960, 1006, 1053, 1099, 1145, 1191, 1238, 1284, 1330, 1376, 1423, 1469, 1515, 1561, 1608, 1654, 1700}, ///< Motor B
+    {960, 1006, 1053, 1099, 1145, 1191, 1238, 1284, 1330, 1376, 1423, 1469, 1515, 1561, 1608, 1654, 1700}, ///< Motor C
+    {960, 1006, 1053, 1099, 1145, 1191, 1238, 1284, 1330, 1376, 1423, 1469, 1515, 1561, 1608, 1654, 1700}, ///< Motor D
+};
+#endif
+/** @} */
+
+/**
+ * @brief Gain schedule over effort_set, as a Q8 scale on the roll/pitch gains
+ * @details Entry n applies at effort n * 128. The compiler fills the table
+ *          from GAIN_SCHED_LOW, GAIN_SCHED_TUNED and GAIN_SCHED_HIGH (in
+ *          ESC.h): a straight line from LOW% at zero effort to 100% at the
+ *          tuning point, then on to HIGH% at 1024. More authority per count
+ *          at high throttle is what makes fixed gains ring up there and feel
+ *          soft near idle; replace the entries with per-throttle tuning
+ *          results to give the curve any other shape. The line is a guess
+ *          and untested on the airframe. In Tools/build/gainsched, on the
+ *          shipped build (no thrust curve) it cuts the ringing at effort
+ *          128 from 0.81 to 0.16 degrees with quadratic motors, but makes it
+ *          worse (1.93 to 2.31) if thrust is closer to cubic, and slows the
+ *          top end either way. The motors' real curve is unmeasured, so
+ *          gainSched defaults to off.
+ * @{
+ */
+#define GS_PCT(e) (((e) <= GAIN_SCHED_TUNED) \
+        ? GAIN_SCHED_LOW + (100 - GAIN_SCHED_LOW) * (e) / GAIN_SCHED_TUNED \
+        : 100 + (GAIN_SCHED_HIGH - 100) * ((e) - GAIN_SCHED_TUNED) / (1024 - GAIN_SCHED_TUNED))
+#define GS_Q8(e)  ((GS_PCT(e) * GAIN_SCHED_ONE + 50) / 100)
+
+static const int16_t gainSchedLUT[GAIN_SCHED_POINTS] = {
+    GS_Q8(0), GS_Q8(128), GS_Q8(256), GS_Q8(384), GS_Q8(512),
+    GS_Q8(640), GS_Q8(768), GS_Q8(896), GS_Q8(1024)
+};
+
+#if GAIN_SCHED_VBAT
+/**
+ * Entry n applies at GAIN_SCHED_VBAT_MIN + n * 512 mV (9.0 to 13.1 V).
+ * Battery_Compensate() already holds thrust per count roughly constant as
+ * the pack sags, so the default is flat; fill it from flights at several
+ * pack voltages if a residual trend shows up.
+ */
+static const int16_t gainSchedVbatLUT[GAIN_SCHED_POINTS] = {
+    GAIN_SCHED_ONE, GAIN_SCHED_ONE, GAIN_SCHED_ONE, GAIN_SCHED_ONE, GAIN_SCHED_ONE,
+    GAIN_SCHED_ONE, GAIN_SCHED_ONE, GAIN_SCHED_ONE, GAIN_SCHED_ONE
+};
+#endif
+/** @} */
+
+int gainSched = false;               ///< Stored parameter GAIN_SCHED; off until the table holds per-throttle tuning
+int32_t gainScale = GAIN_SCHED_ONE;  ///< Last roll/pitch scale (Q8)
+
+/**
+ * @brief Interpolates one schedule table
+ *
+ * @param lut Table of GAIN_SCHED_POINTS Q8 scales
+ * @param x   Position in breakpoint units << GAIN_SCHED_SHIFT (clamped)
+ * @return Q8 scale
+ *
+ * @details Breakpoints are a power of two apart, so this is a shift, a
+ *          mask, one multiply and a second shift.
+ */
+RAMFUNC static int32_t gainInterp(const int16_t *lut, int32_t x)
+{
+    int32_t idx, frac;
+
+    if (x < 0) x = 0;
+    if (x > ((GAIN_SCHED_POINTS - 1) << GAIN_SCHED_SHIFT) - 1) x = ((GAIN_SCHED_POINTS - 1) << GAIN_SCHED_SHIFT) - 1;
+
+    idx = x >> GAIN_SCHED_SHIFT;
+    frac = x & ((1 << GAIN_SCHED_SHIFT) - 1);
+    return lut[idx] + (((lut[idx + 1] - lut[idx]) * frac) >> GAIN_SCHED_SHIFT);
+}
+
+/**
+ * @brief Roll/pitch gain scale for the current throttle (and pack voltage)
+ *
+ * @return Q8 scale, GAIN_SCHED_ONE when scheduling is off
+ */
+RAMFUNC static int32_t gainSchedule(void)
+{
+    int32_t scale;
+
+    if (!gainSched) return GAIN_SCHED_ONE;
+
+    scale = gainInterp(gainSchedLUT, effort_set);
+#if GAIN_SCHED_VBAT
+    // The voltage table uses the same interpolation, with 512 mV steps rescaled to 128
+    scale = (scale * gainInterp(gainSchedVbatLUT,
+                                (batt_mV - GAIN_SCHED_VBAT_MIN) >> (GAIN_SCHED_VBAT_SHIFT - GAIN_SCHED_SHIFT))) >> 8;
+#endif
+    return scale;
+}
+
+/**
+ * @brief Maps a linear thrust command onto a motor's compare value
+ *
+ * @param motor Motor index (0 = A, 1 = B, 2 = C, 3 = D)
+ * @param cmd   Mixer output in compare counts, already clamped to the ESC range
+ * @return Compare value interpolated from the motor's thrust curve
+ *
+ * @details The command is converted to a 24.8 fixed-point position along the
+ *          16 thrust steps and linearly interpolated between the two
+ *          neighbouring breakpoints. One multiply, one divide and one shift.
+ */
+RAMFUNC int32_t linearize_Thrust(int motor, int32_t cmd)
+{
+    const int16_t *curve = thrustLUT[motor];
+    int32_t pos, idx, frac;
+
+    if (cmd <= ESC_CMD_MIN) return curve[0];
+    if (cmd >= ESC_CMD_MAX) return curve[THRUST_LUT_POINTS - 1];
+
+    // Position along the curve in 1/256ths of a breakpoint
+    pos  = ((cmd - ESC_CMD_MIN) * ((THRUST_LUT_POINTS - 1) << 8)) / (ESC_CMD_MAX - ESC_CMD_MIN);
+    idx  = pos >> 8;
+    frac = pos & 0xFF;
+
+    return curve[idx] + (((curve[idx + 1] - curve[idx]) * frac) >> 8);
+}
+
+/**
+ * @brief Tells whether an integrator step would push an axis deeper into saturation
+ *
+ * @param effort  Axis effort from this update (positive drives posMask motors)
+ * @param step    Amount just added to the axis integral
+ * @param posMask Motors raised by a positive effort
+ * @param negMask Motors raised by a negative effort
+ * @return true if the step should be undone
+ *
+ * @details Effort is the negative of the PID sum, so a positive integral step
+ *          lowers the effort. The step winds up when the motors the effort is
+ *          raising are already clipped and the step moves the effort the same way.
+ */
+RAMFUNC static int windingUp(int32_t effort, int32_t step, int posMask, int negMask)
+{
+    if (effort > 0) return (satMask & posMask) && (step < 0);
+    if (effort < 0) return (satMask & negMask) && (step > 0);
+    return false;
+}
+
+static uint32_t armTick; ///< HAL tick of the last arming LED toggle
+
+/**
+ * @brief Starts the ESC arming sequence without blocking
+ *
+ * @details Starts PWM generation on all channels and sets effort_set to full
+ *          so ESC_ArmStep() begins by sending the top of the throttle range.
  *
- * @note This function blocks execution until arming is complete
  * @warning Ensure motors are properly secured before calling this function
  *
- * @see update_Motors()
+ * @see ESC_ArmStep()
  */
-void armESC()
+void ESC_ArmStart(void)
 {
     effort_set = 1000;
 
-    while(roll_set < 10000){
-        // Start PWM generation on all timer channels
-        HAL_TIM_PWM_Start(&htim3, TIM_CHANNEL_1);
-        HAL_TIM_PWM_Start(&htim3, TIM_CHANNEL_2);
-        HAL_TIM_PWM_Start(&htim3, TIM_CHANNEL_3);
-        HAL_TIM_PWM_Start(&htim3, TIM_CHANNEL_4);
+    // Start PWM generation on all timer channels
+    HAL_TIM_PWM_Start(&htim3, TIM_CHANNEL_1);
+    HAL_TIM_PWM_Start(&htim3, TIM_CHANNEL_2);
+    HAL_TIM_PWM_Start(&htim3, TIM_CHANNEL_3);
+    HAL_TIM_PWM_Start(&htim3, TIM_CHANNEL_4);
 
-        // Calculate arming PWM value (approximately 1000μs pulse width)
-        armCompare = effort_set*4 - 2000;
+    armTick = HAL_GetTick();
+}
 
-        // Clamp arming value to safe range
-        if (armCompare < 960) armCompare = 960;
-        if (armCompare > 2000) armCompare = 2000;
+/**
+ * @brief Advances the ESC arming sequence by one loop iteration
+ *
+ * @return true once arming is complete
+ *
+ * @details Sends the arming pulse derived from effort_set (approximately
+ *          1000μs at zero effort) to all four ESCs, so the pilot can sweep the
+ *          throttle range with the triggers. Arming finishes when roll_set
+ *          reaches the threshold (roll stick right).
+ *
+ * @see ESC_ArmStart()
+ */
+int ESC_ArmStep(void)
+{
+    if (roll_set >= 10000) {
+        // Reset effort and compare values after arming
+        effort_set = 0;
+        armCompare = 0;
+        return true;
+    }
+
+    // Calculate arming PWM value (approximately 1000μs pulse width)
+    armCompare = effort_set*4 - 2000;
+
+    // Clamp arming value to safe range
+    if (armCompare < 960) armCompare = 960;
+    if (armCompare > 2000) armCompare = 2000;
 
-        // Set PWM compare values for all motors
-        __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_1, armCompare);
-        __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_2, armCompare);
-        __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_3, armCompare);
-        __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_4, armCompare);
+    // Set PWM compare values for all motors
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_1, armCompare);
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_2, armCompare);
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_3, armCompare);
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_4, armCompare);
 
-        // Toggle status LED during arming
+    // Toggle status LED during arming
+    if (HAL_GetTick() - armTick >= ESC_ARM_BLINK_MS) {
         HAL_GPIO_TogglePin(GPIOA, GPIO_PIN_0);
-        HAL_Delay(125);
+        armTick = HAL_GetTick();
     }
+    return false;
+}
 
-    // Reset effort and compare values after arming
-    effort_set = 0;
-    armCompare = 0;
+/**
+ * @brief Arms all ESC motors by sending initialization sequence
+ *
+ * @details Runs ESC_ArmStart()/ESC_ArmStep() to completion. The function
+ *          continues until the roll_set value reaches a threshold,
+ *          indicating the system is ready.
+ *
+ * @note This function blocks execution until arming is complete
+ * @warning Ensure motors are properly secured before calling this function
+ *
+ * @see update_Motors()
+ */
+void armESC()
+{
+    ESC_ArmStart();
+    while (!ESC_ArmStep()) {
+    }
 }
 
 /**
  * @brief Updates all motor speeds based on PID control calculations
  *
  * @details This function performs the main control loop operation:
- *          1. Calculates PID errors for roll, pitch, and yaw axes
- *          2. Computes PID control efforts for each axis
+ *          1. Calculates PID errors for roll, pitch, and yaw axes: angle
+ *             errors in angle mode, body-rate errors against the gyro in
+ *             rate mode (flightMode), each with its own gains
+ *          2. Computes PID control efforts for each axis, roll and pitch
+ *             scaled by the gain schedule for the current throttle, or with
+ *             ctrlLaw set to CTRL_LAW_LQR (angle mode), each motor's offset
+ *             from the LQR gain matrix (LQR_Control())
  *          3. Mixes control efforts to determine individual motor speeds
- *          4. Applies safety limits and updates PWM outputs
+ *          4. Applies safety limits and maps each motor through its thrust curve
+ *          5. Compensates for battery voltage sag
+ *          6. Undoes integrator steps that pushed a saturated axis further (anti-windup)
+ *          7. Updates PWM outputs
  *
  * The motor mixing follows a standard quadcopter X-configuration:
  * - Motor A (front-right): +pitch, -roll, -yaw
@@ -167,51 +401,93 @@ void armESC()
  * - Motor D (front-left): +pitch, +roll, +yaw
  *
  * @note PWM range: 960 (0% throttle) to 2000 (100% throttle)
- * @note For safety, maximum throttle is limited to 1500 (≈50%)
+ * @note For safety, each motor is clamped to ESC_CMD_MIN..ESC_CMD_MAX (960 to 1700, ≈71%)
  * @note Function should be called at regular intervals (typically 1kHz)
  *
  * @warning
  *
  * @see armESC()
  */
-void update_Motors()
+RAMFUNC void update_Motors()
 {
     // PWM Mapping: Compare 960 = 1ms (0%), Compare 2000 = 2ms (100%)
+    int32_t last_roll_integral = roll_integral;   // Restored if the step winds up
+    int32_t last_pitch_integral = pitch_integral;
+    int32_t last_yaw_integral = yaw_integral;
+    int stop = (stopFlag == true) || wdgSafe; // Throttle cut or missed loop deadline
+    int32_t kpRoll, kiRoll, kdRoll, kpPitch, kiPitch, kdPitch, kpYaw, kiYaw, kdYaw;
+    int lqr = (ctrlLaw == CTRL_LAW_LQR) && (flightMode == FLIGHT_MODE_ANGLE);
+    int32_t u[LQR_INPUTS];
+
+    StackMon_Mark(STACK_CTX_MAIN);
+    Trace_Begin(TRACE_CONTROL);
+    Latency_ApplyStart();
+
+    /* ===== ERRORS AND GAINS ===== */
+    if (flightMode == FLIGHT_MODE_RATE) {
+        // Rate mode: the same PID on body-rate errors, so the integrator
+        // holds attitude against disturbances once the sticks are centred
+        roll_error = roll_rate - roll_rate_set;
+        pitch_error = pitch_rate - pitch_rate_set;
+        yaw_error = yaw_rate - yaw_rate_set;
+        kpRoll = kpPitch = Kp_rate;
+        kiRoll = kiPitch = Ki_rate;
+        kdRoll = kdPitch = Kd_rate;
+        kpYaw = Kp_rate_yaw;
+        kiYaw = Ki_rate_yaw;
+        kdYaw = 0;
+    } else {
+        roll_error = -roll_set + roll_true;
+        pitch_error = -pitch_set + pitch_true;
+        yaw_error = angle_Diff(yaw_true, yaw_set); // Short way round, no spike crossing north
+        kpRoll = Kp_roll;   kiRoll = Ki_roll;   kdRoll = Kd_roll;
+        kpPitch = Kp_pitch; kiPitch = Ki_pitch; kdPitch = Kd_pitch;
+        kpYaw = Kp_yaw;     kiYaw = Ki_yaw;     kdYaw = Kd_yaw;
+    }
+
+    // Scaling the PID output is the same as scaling all three gains, in one multiply per axis
+    gainScale = gainSchedule();
 
-    /* ===== ROLL PID CALCULATION ===== */
-    roll_error = -roll_set + roll_true;
+    if (lqr) {
+        /* ===== LQR STATE FEEDBACK ===== */
+        LQR_Control(u);
+    } else {
+        /* ===== ROLL PID CALCULATION ===== */
 
-    roll_integral += roll_error/1000; //Wind up protection for integral
+        roll_integral += roll_error/1000; //Wind up protection for integral
         if (roll_integral > max_integral) {
             roll_integral = max_integral;
         } else if (roll_integral < -max_integral) {
             roll_integral = -max_integral;
         }
-    roll_integral += roll_error;
-    roll_derivative = roll_error - last_roll_error;
-    // TESTING ONLY - Roll effort disabled
-    roll_effort = -(Kp_roll * roll_error + Ki_roll * roll_integral + Kd_roll * roll_derivative) / PID_SCALE;
-    last_roll_error = roll_error;
-
-    /* ===== ROLL PID CALCULATION ===== */
-    pitch_error = -pitch_set + pitch_true;
-    pitch_integral += pitch_error/1000; //Wind up protection for integral
-    if (pitch_integral > max_integral) {
-        pitch_integral = max_integral;
-    } else if (pitch_integral < -max_integral) {
-        pitch_integral = -max_integral;
+        roll_derivative = roll_error - last_roll_error;
+        roll_effort = -(((kpRoll * roll_error + kiRoll * roll_integral + kdRoll * roll_derivative) / PID_SCALE) * gainScale >> 8);
+        last_roll_error = roll_error;
+
+        /* ===== PITCH PID CALCULATION ===== */
+        pitch_integral += pitch_error/1000; //Wind up protection for integral
+        if (pitch_integral > max_integral) {
+            pitch_integral = max_integral;
+        } else if (pitch_integral < -max_integral) {
+            pitch_integral = -max_integral;
+        }
+        pitch_derivative = pitch_error - last_pitch_error;
+        pitch_effort = -(((kpPitch * pitch_error + kiPitch * pitch_integral + kdPitch * pitch_derivative) / PID_SCALE) * gainScale >> 8);
+        last_pitch_error = pitch_error;
+
+        /* ===== YAW PID CALCULATION ===== */
+        // Same units and clamp as roll and pitch. Before anti-windup the yaw sum
+        // was the raw error, so a Ki_yaw tuned against that needs 1000x here
+        yaw_integral += yaw_error/1000;
+        if (yaw_integral > max_integral) {
+            yaw_integral = max_integral;
+        } else if (yaw_integral < -max_integral) {
+            yaw_integral = -max_integral;
+        }
+        yaw_derivative = yaw_error - last_yaw_error;
+        yaw_effort = -(kpYaw * yaw_error + kiYaw * yaw_integral + kdYaw * yaw_derivative) / PID_SCALE;
+        last_yaw_error = yaw_error;
     }
-    pitch_derivative = pitch_error - last_pitch_error;
-    pitch_effort = -(Kp_pitch * pitch_error + Ki_pitch * pitch_integral + Kd_pitch * pitch_derivative) / PID_SCALE;
-    last_pitch_error = pitch_error;
-
-    /* ===== YAW PID CALCULATION ===== */
-    yaw_error = -yaw_set + yaw_true;
-    yaw_integral += yaw_error;
-    yaw_derivative = yaw_error - last_yaw_error;
-    yaw_effort = -(Kp_yaw * yaw_error + Ki_yaw * yaw_integral + Kd_yaw * yaw_derivative) / PID_SCALE;
-    last_yaw_error = yaw_error;
-
 
     /* ===== BASE THROTTLE CALCULATION ===== */
     // Start with base throttle plus individual motor offsets
@@ -221,57 +497,101 @@ void update_Motors()
     D = effort_set * K_effort/PID_SCALE + motD_offset;
 
     /* ===== CONTROL MIXING ===== */
-    // Apply pitch control (affects front/rear motor pairs)
-    if (pitch_effort > 0) {
-        A += pitch_effort; // Front motors get more power
-        D += pitch_effort;
-    }
-    else if (pitch_effort < 0) {
-        B -= pitch_effort; // Rear motors get more power
-        C -= pitch_effort;
-    }
+    if (lqr) {
+        // The gain matrix already allocated every axis to every motor
+        A += u[0];
+        B += u[1];
+        C += u[2];
+        D += u[3];
+    } else {
+        // Apply pitch control (affects front/rear motor pairs)
+        if (pitch_effort > 0) {
+            A += pitch_effort; // Front motors get more power
+            D += pitch_effort;
+        }
+        else if (pitch_effort < 0) {
+            B -= pitch_effort; // Rear motors get more power
+            C -= pitch_effort;
+        }
 
-    // Apply roll control (affects left/right motor pairs)
-    if (roll_effort > 0) {
-        A += roll_effort; // Left motors get more power
-        B += roll_effort;
-    }
-    else if (roll_effort < 0) {
-        C -= roll_effort; // Right motors get more power
-        D -= roll_effort;
-    }
+        // Apply roll control (affects left/right motor pairs)
+        if (roll_effort > 0) {
+            A += roll_effort; // Left motors get more power
+            B += roll_effort;
+        }
+        else if (roll_effort < 0) {
+            C -= roll_effort; // Right motors get more power
+            D -= roll_effort;
+        }
 
-    // Apply yaw control (affects diagonal motor pairs)
-    if (yaw_effort > 0) {
-        B += yaw_effort; // CW motors get more power
-        D += yaw_effort;
-    }
-    else if (yaw_effort < 0) {
-        A -= yaw_effort; // CCW motors get more power
-        C -= yaw_effort;
+        // Apply yaw control (affects diagonal motor pairs)
+        if (yaw_effort > 0) {
+            B += yaw_effort; // CW motors get more power
+            D += yaw_effort;
+        }
+        else if (yaw_effort < 0) {
+            A -= yaw_effort; // CCW motors get more power
+            C -= yaw_effort;
+        }
     }
 
     /* ===== SAFETY LIMITS ===== */
-    // Clamp all motors between 960 (0%) and 1500 (≈50% for safety)
-    if ((A < 960) | (stopFlag == true)) A = 960;
-    if (A > 1600) A = 1700;
+    // Clamp all motors between 960 (0%) and 1700, remembering which ones clipped high
+    satMask = (A > ESC_CMD_MAX) | ((B > ESC_CMD_MAX) << 1) | ((C > ESC_CMD_MAX) << 2) | ((D > ESC_CMD_MAX) << 3);
 
-    if ((B < 960) | (stopFlag == true)) B = 960;
+    if ((A < 960) | stop) A = 960;
+    if (A > 1700) A = 1700;
+
+    if ((B < 960) | stop) B = 960;
     if (B > 1700) B = 1700;
 
-    if ((C < 960) | (stopFlag == true)) C = 960;
+    if ((C < 960) | stop) C = 960;
     if (C > 1700) C = 1700;
 
-    if ((D < 960) | (stopFlag == true)) D = 960;
+    if ((D < 960) | stop) D = 960;
     if (D > 1700) D = 1700;
 
     // Debug output (commented)
     //printf("%d,%d,%d,%d \r\n", pitch_true, 0, 0, 0);
 
+#if THRUST_LUT_ENABLED
+    /* ===== THRUST LINEARIZATION ===== */
+    // Mixer output is linear in thrust; map it through each motor's curve
+    A = linearize_Thrust(0, A);
+    B = linearize_Thrust(1, B);
+    C = linearize_Thrust(2, C);
+    D = linearize_Thrust(3, D);
+#endif
+
+    /* ===== VOLTAGE SAG COMPENSATION ===== */
+    // Same thrust at any pack voltage, then clamp again to the ESC range
+    A = Battery_Compensate(A);
+    B = Battery_Compensate(B);
+    C = Battery_Compensate(C);
+    D = Battery_Compensate(D);
+    if (A > ESC_CMD_MAX) { A = ESC_CMD_MAX; satMask |= 1 << 0; }
+    if (B > ESC_CMD_MAX) { B = ESC_CMD_MAX; satMask |= 1 << 1; }
+    if (C > ESC_CMD_MAX) { C = ESC_CMD_MAX; satMask |= 1 << 2; }
+    if (D > ESC_CMD_MAX) { D = ESC_CMD_MAX; satMask |= 1 << 3; }
+
+    /* ===== ANTI-WINDUP ===== */
+    // Conditional integration on the post-clamp result: keep the integral
+    // where it was when its step pushed a clipped axis further, and hold all
+    // integrators while the motors are stopped.
+    if (stop) {
+        roll_integral = last_roll_integral;
+        pitch_integral = last_pitch_integral;
+        yaw_integral = last_yaw_integral;
+    } else if (antiWindup) {
+        // Motor masks: A = bit 0, B = bit 1, C = bit 2, D = bit 3
+        if (windingUp(roll_effort, roll_integral - last_roll_integral, 0x3, 0xC)) roll_integral = last_roll_integral;
+        if (windingUp(pitch_effort, pitch_integral - last_pitch_integral, 0x9, 0x6)) pitch_integral = last_pitch_integral;
+        if (windingUp(yaw_effort, yaw_integral - last_yaw_integral, 0xA, 0x5)) yaw_integral = last_yaw_integral;
+    }
+
     /* ===== PWM OUTPUT UPDATE ===== */
     // Update timer compare registers to set motor speeds
-    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_1, A);
-    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_2, B);
-    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_3, C);
-    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_4, D);
+    FastIO_SetMotors(A, B, C, D);
+    Latency_Applied();
+    Trace_End(TRACE_CONTROL);
 }
@@ -0,0 +1,188 @@
+/**
+  ******************************************************************************
+  * @file    ESCCal.c
+  * @author  Aaron Lubinsky
+  * @brief   Guided ESC/motor spin-up calibration state machine
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Replaces the hard-coded 960 motor offsets with measured values.
+  *          Each motor is ramped one count at a time from ESC_CMD_MIN while
+  *          the others stay at minimum. Spin-up is taken either from the pilot
+  *          pressing ENTER or, with BATT_CURRENT_SENSE, from the pack current
+  *          rising CAL_SPINUP_MA above the idle baseline. The measured value
+  *          becomes that motor's offset in update_Motors().
+  *
+  *          Every call to ESCCal_Step() returns immediately, so the BT link
+  *          and everything else in the main loop keep running.
+  *
+  ******************************************************************************
+  ==============================================================================
+                        ##### How to use this driver #####
+  ==============================================================================
+  1. REMOVE THE PROPELLERS
+  2. From the disarmed state, call ESCCal_Start()
+  3. Call ESCCal_Step() every loop with the pilot's confirm input until it
+     returns true, with Watchdog_Kick(true) keeping the loop deadline armed
+  4. calOffset[] holds the results; motA_offset..motD_offset are updated
+     and saved to the parameter store
+
+  @warning Motors spin during calibration
+  */
+
+#include "ESCCal.h"
+#include "Params.h"
+#include "ESC.h"
+#include "Battery.h"
+#include "Watchdog.h"
+#include "stm32f4xx_hal.h"   // Needed for HAL types
+#include <stdio.h>
+#include <inttypes.h>
+
+/* External Timer Handle */
+extern TIM_HandleTypeDef htim3; ///< Timer handle for PWM generation (Timer 3)
+
+/* Calibration State */
+CalState calState = CAL_IDLE; ///< Current calibration phase
+int32_t calOffset[4];         ///< Measured spin-up compare values A..D
+
+static int calMotor;          ///< Motor being swept (0 = A ... 3 = D)
+static int32_t calCompare;    ///< Compare value on the motor being swept
+static uint32_t calTick;      ///< HAL tick when the current phase/step started
+static int32_t calBaseline;   ///< Idle pack current (mA)
+
+static const uint32_t calChannel[4] = {TIM_CHANNEL_1, TIM_CHANNEL_2, TIM_CHANNEL_3, TIM_CHANNEL_4};
+
+/**
+ * @brief Puts every motor at minimum throttle
+ */
+static void ESCCal_AllMin(void)
+{
+    for (int i = 0; i < 4; i++) {
+        __HAL_TIM_SET_COMPARE(&htim3, calChannel[i], ESC_CMD_MIN);
+    }
+}
+
+/**
+ * @brief Copies the measured values into the mixer offsets and saves them
+ *
+ * @details Motors where nothing was detected keep their previous offset.
+ */
+static void ESCCal_Apply(void)
+{
+    for (int i = 0; i < 4; i++) {
+        if (calOffset[i] > 0) Param_Set(PARAM_MOTA_OFFSET + i, calOffset[i]); // Survives a power cycle
+    }
+    printf("Cal done A=%" PRId32 " B=%" PRId32 " C=%" PRId32 " D=%" PRId32 "\r\n", calOffset[0], calOffset[1], calOffset[2], calOffset[3]);
+}
+
+/**
+ * @brief Starts a calibration run
+ *
+ * @details Starts PWM on all channels at minimum throttle; the ESCs arm while
+ *          CAL_ARMING holds it there.
+ */
+void ESCCal_Start(void)
+{
+    HAL_TIM_PWM_Start(&htim3, TIM_CHANNEL_1);
+    HAL_TIM_PWM_Start(&htim3, TIM_CHANNEL_2);
+    HAL_TIM_PWM_Start(&htim3, TIM_CHANNEL_3);
+    HAL_TIM_PWM_Start(&htim3, TIM_CHANNEL_4);
+    ESCCal_AllMin();
+
+    for (int i = 0; i < 4; i++) calOffset[i] = 0;
+    calMotor = 0;
+    calBaseline = 0;
+    calTick = HAL_GetTick();
+    calState = CAL_ARMING;
+}
+
+/**
+ * @brief Advances the calibration by at most one step
+ *
+ * @param confirm Non-zero when the pilot confirms the current motor spins
+ * @return true once all four motors have been swept, or the run was aborted
+ *
+ * @details Phases:
+ *          - CAL_ARMING: hold minimum for CAL_ARM_MS, sample idle current
+ *          - CAL_SWEEP: +1 count every CAL_STEP_MS until confirm, a current
+ *            rise, or CAL_SWEEP_LIMIT
+ *          - CAL_SPINDOWN: motor back at minimum for CAL_SPINDOWN_MS, then the
+ *            next motor, or CAL_DONE after motor D
+ *
+ *          A missed loop deadline (wdgSafe) ends the run at once with every
+ *          motor at minimum and the previous offsets kept.
+ */
+int ESCCal_Step(int confirm)
+{
+    uint32_t now = HAL_GetTick();
+    int detected;
+
+    if (wdgSafe && calState != CAL_IDLE) { // Missed loop deadline: stop here, keep the old offsets
+        ESCCal_AllMin();
+        calState = CAL_IDLE;
+        printf("Cal aborted: loop deadline missed\r\n");
+        return true;
+    }
+
+    switch (calState) {
+    case CAL_ARMING:
+        calBaseline = batt_mA;
+        HAL_GPIO_TogglePin(GPIOA, GPIO_PIN_0);
+        if (now - calTick >= CAL_ARM_MS) {
+            calCompare = ESC_CMD_MIN;
+            calTick = now;
+            calState = CAL_SWEEP;
+        }
+        break;
+
+    case CAL_SWEEP:
+        detected = confirm;
+#if BATT_CURRENT_SENSE
+        if (batt_mA - calBaseline > CAL_SPINUP_MA) detected = true;
+#endif
+        if (detected || calCompare >= CAL_SWEEP_LIMIT) {
+            if (!detected) {
+                calOffset[calMotor] = 0;
+            } else if (confirm) {
+                // The ramp kept going while the pilot reacted
+                calOffset[calMotor] = calCompare - CAL_CONFIRM_LAG_MS / CAL_STEP_MS;
+            } else {
+                calOffset[calMotor] = calCompare;
+            }
+            ESCCal_AllMin();
+            Watchdog_Kick(false); // Motors are at minimum; the report can outlast the loop deadline
+            printf("Motor %c spin-up %" PRId32 "\r\n", 'A' + calMotor, calOffset[calMotor]);
+            calTick = now;
+            calState = CAL_SPINDOWN;
+        } else if (now - calTick >= CAL_STEP_MS) {
+            calCompare++;
+            __HAL_TIM_SET_COMPARE(&htim3, calChannel[calMotor], calCompare);
+            calTick = now;
+        }
+        break;
+
+    case CAL_SPINDOWN:
+        if (now - calTick >= CAL_SPINDOWN_MS) {
+            if (++calMotor < 4) {
+                calCompare = ESC_CMD_MIN;
+                calTick = now;
+                calState = CAL_SWEEP;
+            } else {
+                Watchdog_Kick(false); // Flash writes and the report; motors are at minimum
+                ESCCal_Apply();
+                calState = CAL_DONE;
+            }
+        }
+        break;
+
+    case CAL_DONE:
+        return true;
+
+    case CAL_IDLE:
+    default:
+        break;
+    }
+
+    return false;
+}
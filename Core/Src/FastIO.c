@@ -0,0 +1,307 @@
+/**
+  ******************************************************************************
+  * @file    FastIO.c
+  * @author  Aaron Lubinsky
+  * @brief   Register-level fast path for the hot I2C, TIM and UART operations
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Three operations run in every pass of the flight loop:
+  *
+  *          - the BNO055 burst read (6 Euler or gyro bytes, 18 raw bytes
+  *            under the EKF) with HAL_I2C_Mem_Read(), which waits on every
+  *            I2C event through a HAL_GetTick() timeout loop and takes the
+  *            handle lock and state machine around the transfer
+  *          - the four TIM3 compare writes, through the htim3 handle
+  *          - the USART1 DMA kicks of the fast channel, where
+  *            HAL_UART_Transmit_DMA() and HAL_DMA_Start_IT() check and set
+  *            the handle states, install callbacks, and the completion
+  *            takes a DMA interrupt and then a USART TC interrupt
+  *
+  *          The LL versions poll the status registers directly against a
+  *          DWT cycle deadline (FASTIO_I2C_TIMEOUT_US per event), write
+  *          TIM3 and DMA2 by address, and finish a TX transfer in the one
+  *          DMA transfer complete interrupt. They only speed up the CPU
+  *          side: the I2C bytes still take their time on the wire.
+  *
+  *          The I2C read follows the RM0383 polling sequence for three or
+  *          more bytes (NACK and STOP set on the last two byte-transfer
+  *          finished events). Any bus error, NACK or timeout sends a STOP
+  *          and retries the read through the HAL, which also recovers the
+  *          bus the way it always has; fastIoI2CFallbacks counts these.
+  *
+  *          The LL TX path owns DMA2 Stream7: USART1 is transmit-only
+  *          through FastLink, so nothing else uses huart1 for sending.
+  *          USART2 keeps its HAL TX, since it shares the handle with the
+  *          HAL receive-to-idle DMA and the blocking console writes, and
+  *          its MAVLink frames are only a few dozen kicks a second.
+  *
+  *          The HAL/LL comparison comes from FastIO_Bench() on the board:
+  *          the cycle counts depend on the I2C clock, the sensor's clock
+  *          stretching and the flash wait states, and no figures have been
+  *          taken on the airframe yet, so none are quoted here. Record the
+  *          "# fastio" lines of a bench build next to this comment when
+  *          they are.
+  *
+  ******************************************************************************
+  ==============================================================================
+                        ##### How to use this driver #####
+  ==============================================================================
+  1. Call FastIO_Init() after the MX_ peripheral inits
+  2. Call FastIO_TxIRQ() at the top of DMA2_Stream7_IRQHandler() and, when
+     it returns 1, FastLink_Service() and return without the HAL handler
+  3. Use FastIO_I2CRead(), FastIO_SetMotors(), FastIO_TxStart() and
+     FastIO_TxBusy() in place of the HAL calls
+  4. For a HAL/LL cycle comparison, build with -DFASTIO_BENCH=1, take the
+     props off and trigger a dump: MainLoop_Dump() then calls FastIO_Bench()
+
+  @note FAST_IO_LL (FastIO.h) selects the version at build time; the bench
+        is left out unless FASTIO_BENCH is set, since it blocks for up to
+        1.6 s and writes the motor compares
+  */
+
+#include "FastIO.h"
+#include "FastLink.h"
+#include "BNO055.h"
+#include "RamFunc.h"
+#include "Watchdog.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#ifdef __arm__
+#include "stm32f4xx_ll_tim.h"
+#include "stm32f4xx_ll_i2c.h"
+#include "stm32f4xx_ll_dma.h"
+#include "stm32f4xx_ll_usart.h"
+#endif
+
+extern I2C_HandleTypeDef hi2c1;   ///< BNO055 bus
+extern UART_HandleTypeDef huart1; ///< Fast channel
+
+FastIOCycles fastIoTxKick = {0, UINT32_MAX, 0, 0};
+uint32_t fastIoI2CFallbacks = 0;
+
+#if FAST_IO_USE_LL
+static volatile uint8_t txBusy = 0; ///< LL transfer in progress
+#endif
+
+#ifdef __arm__
+RAMFUNC static void FastIO_Record(FastIOCycles *c, uint32_t cycles)
+{
+    c->last = cycles;
+    if (cycles < c->min) c->min = cycles;
+    if (cycles > c->max) c->max = cycles;
+    c->count++;
+}
+#endif
+
+/* ===== I2C ===== */
+
+#ifdef __arm__
+/**
+ * @brief Waits for an SR1 event; -1 on NACK, bus error, lost arbitration or timeout
+ */
+RAMFUNC static int FastIO_I2CWait(uint32_t flag)
+{
+    uint32_t start = DWT->CYCCNT;
+    uint32_t timeout = (SystemCoreClock / 1000000U) * FASTIO_I2C_TIMEOUT_US;
+    uint32_t sr1;
+
+    while (!((sr1 = LL_I2C_ReadReg(I2C1, SR1)) & flag)) {
+        if ((sr1 & (I2C_SR1_AF | I2C_SR1_BERR | I2C_SR1_ARLO)) || DWT->CYCCNT - start > timeout) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Polled register read of 3 or more bytes from an I2C1 device
+ */
+RAMFUNC static HAL_StatusTypeDef FastIO_I2CReadLL(uint16_t devAddr, uint8_t reg, uint8_t *buf, uint16_t len)
+{
+    if (len < 3 || LL_I2C_IsActiveFlag_BUSY(I2C1)) {
+        return HAL_BUSY;
+    }
+    LL_I2C_DisableBitPOS(I2C1);
+    LL_I2C_AcknowledgeNextData(I2C1, LL_I2C_ACK);
+
+    /* ===== REGISTER ADDRESS ===== */
+    LL_I2C_GenerateStartCondition(I2C1);
+    if (FastIO_I2CWait(I2C_SR1_SB)) goto fail;
+    LL_I2C_TransmitData8(I2C1, (uint8_t)(devAddr & ~1U));
+    if (FastIO_I2CWait(I2C_SR1_ADDR)) goto fail;
+    LL_I2C_ClearFlag_ADDR(I2C1);
+    if (FastIO_I2CWait(I2C_SR1_TXE)) goto fail;
+    LL_I2C_TransmitData8(I2C1, reg);
+    if (FastIO_I2CWait(I2C_SR1_TXE)) goto fail;
+
+    /* ===== REPEATED START, READ ===== */
+    LL_I2C_GenerateStartCondition(I2C1);
+    if (FastIO_I2CWait(I2C_SR1_SB)) goto fail;
+    LL_I2C_TransmitData8(I2C1, (uint8_t)(devAddr | 1U));
+    if (FastIO_I2CWait(I2C_SR1_ADDR)) goto fail;
+    LL_I2C_ClearFlag_ADDR(I2C1);
+
+    while (len > 3) {
+        if (FastIO_I2CWait(I2C_SR1_RXNE)) goto fail;
+        *buf++ = LL_I2C_ReceiveData8(I2C1);
+        len--;
+    }
+
+    // Last three: byte N-2 in DR and N-1 in the shift register, clock held
+    if (FastIO_I2CWait(I2C_SR1_BTF)) goto fail;
+    LL_I2C_AcknowledgeNextData(I2C1, LL_I2C_NACK);
+    *buf++ = LL_I2C_ReceiveData8(I2C1);
+    if (FastIO_I2CWait(I2C_SR1_BTF)) goto fail;
+    LL_I2C_GenerateStopCondition(I2C1);
+    *buf++ = LL_I2C_ReceiveData8(I2C1);
+    if (FastIO_I2CWait(I2C_SR1_RXNE)) goto fail;
+    *buf = LL_I2C_ReceiveData8(I2C1);
+    return HAL_OK;
+
+fail:
+    LL_I2C_GenerateStopCondition(I2C1);
+    LL_I2C_ClearFlag_AF(I2C1);
+    LL_I2C_ClearFlag_BERR(I2C1);
+    LL_I2C_ClearFlag_ARLO(I2C1);
+    return HAL_ERROR;
+}
+#endif
+
+RAMFUNC HAL_StatusTypeDef FastIO_I2CRead(uint16_t devAddr, uint8_t reg, uint8_t *buf, uint16_t len)
+{
+#if FAST_IO_USE_LL
+    HAL_StatusTypeDef st = FastIO_I2CReadLL(devAddr, reg, buf, len);
+
+    if (st == HAL_OK) {
+        return HAL_OK;
+    }
+    if (st == HAL_ERROR) {
+        fastIoI2CFallbacks++;
+    }
+#endif
+    return HAL_I2C_Mem_Read(&hi2c1, devAddr, reg, I2C_MEMADD_SIZE_8BIT, buf, len, 100);
+}
+
+/* ===== UART ===== */
+
+void FastIO_Init(void)
+{
+#if FAST_IO_USE_LL
+    // HAL_DMA_Init() has set the channel, direction and increments; the
+    // HAL sets the peripheral address on every start, we set it once
+    LL_DMA_SetPeriphAddress(DMA2, LL_DMA_STREAM_7, LL_USART_DMA_GetRegAddr(USART1));
+    LL_DMA_EnableIT_TC(DMA2, LL_DMA_STREAM_7);
+    LL_DMA_EnableIT_TE(DMA2, LL_DMA_STREAM_7);
+    LL_USART_EnableDMAReq_TX(USART1);
+#endif
+}
+
+RAMFUNC void FastIO_TxStart(const uint8_t *data, uint16_t len)
+{
+#ifdef __arm__
+    uint32_t start = DWT->CYCCNT;
+#endif
+
+#if FAST_IO_USE_LL
+    txBusy = 1;
+    WRITE_REG(DMA2->HIFCR, DMA_HIFCR_CTCIF7 | DMA_HIFCR_CHTIF7 | DMA_HIFCR_CTEIF7 |
+                           DMA_HIFCR_CDMEIF7 | DMA_HIFCR_CFEIF7);
+    LL_DMA_SetMemoryAddress(DMA2, LL_DMA_STREAM_7, (uint32_t)data);
+    LL_DMA_SetDataLength(DMA2, LL_DMA_STREAM_7, len);
+    LL_DMA_EnableStream(DMA2, LL_DMA_STREAM_7);
+#else
+    HAL_UART_Transmit_DMA(&huart1, data, len);
+#endif
+
+#ifdef __arm__
+    FastIO_Record(&fastIoTxKick, DWT->CYCCNT - start);
+#endif
+}
+
+RAMFUNC int FastIO_TxBusy(void)
+{
+#if FAST_IO_USE_LL
+    return txBusy;
+#else
+    return huart1.gState != HAL_UART_STATE_READY;
+#endif
+}
+
+RAMFUNC int FastIO_TxIRQ(void)
+{
+#if FAST_IO_USE_LL
+    // Transfer complete or error: either way the stream has stopped. The
+    // last byte may still be shifting out, which the next kick does not mind.
+    WRITE_REG(DMA2->HIFCR, DMA_HIFCR_CTCIF7 | DMA_HIFCR_CHTIF7 | DMA_HIFCR_CTEIF7 |
+                           DMA_HIFCR_CDMEIF7 | DMA_HIFCR_CFEIF7);
+    txBusy = 0;
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+/* ===== BENCHMARK ===== */
+
+#if FASTIO_BENCH
+#ifdef __arm__
+static void FastIO_Print(const char *name, const char *impl, const FastIOCycles *c)
+{
+    char msg[96];
+
+    snprintf(msg, sizeof(msg), "# fastio %-8s %-3s min %6" PRIu32 " max %6" PRIu32 " cycles (%" PRIu32 " runs)\r\n",
+             name, impl, c->min, c->max, c->count);
+    FastLink_SendWait(msg, (uint16_t)strlen(msg));
+}
+#endif
+
+void FastIO_Bench(void)
+{
+#ifdef __arm__
+    FastIOCycles i2cHal = {0, UINT32_MAX, 0, 0}, i2cLl = {0, UINT32_MAX, 0, 0};
+    FastIOCycles ccrHal = {0, UINT32_MAX, 0, 0}, ccrLl = {0, UINT32_MAX, 0, 0};
+    uint8_t euler[6];
+    uint32_t ccr[4] = {TIM3->CCR1, TIM3->CCR2, TIM3->CCR3, TIM3->CCR4};
+    uint32_t start;
+    char msg[96];
+
+    for (int i = 0; i < FASTIO_BENCH_RUNS; i++) {
+        Watchdog_Kick(0); // Each HAL read can wait out its 100 ms timeout
+        start = DWT->CYCCNT;
+        HAL_I2C_Mem_Read(&hi2c1, BNO055_I2C_ADDR, BNO055_EULER_LSB, I2C_MEMADD_SIZE_8BIT, euler, 6, 100);
+        FastIO_Record(&i2cHal, DWT->CYCCNT - start);
+
+        start = DWT->CYCCNT;
+        FastIO_I2CReadLL(BNO055_I2C_ADDR, BNO055_EULER_LSB, euler, 6);
+        FastIO_Record(&i2cLl, DWT->CYCCNT - start);
+
+        start = DWT->CYCCNT;
+        __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_1, ccr[0]);
+        __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_2, ccr[1]);
+        __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_3, ccr[2]);
+        __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_4, ccr[3]);
+        FastIO_Record(&ccrHal, DWT->CYCCNT - start);
+
+        start = DWT->CYCCNT;
+        LL_TIM_OC_SetCompareCH1(TIM3, ccr[0]);
+        LL_TIM_OC_SetCompareCH2(TIM3, ccr[1]);
+        LL_TIM_OC_SetCompareCH3(TIM3, ccr[2]);
+        LL_TIM_OC_SetCompareCH4(TIM3, ccr[3]);
+        FastIO_Record(&ccrLl, DWT->CYCCNT - start);
+    }
+
+    snprintf(msg, sizeof(msg), "# fastio %s build, %" PRIu32 " MHz, %" PRIu32 " I2C fallbacks\r\n",
+             FAST_IO_USE_LL ? "LL" : "HAL", SystemCoreClock / 1000000U, fastIoI2CFallbacks);
+    FastLink_SendWait(msg, (uint16_t)strlen(msg));
+    FastIO_Print("i2c6", "HAL", &i2cHal);
+    FastIO_Print("i2c6", "LL", &i2cLl);
+    FastIO_Print("ccr4", "HAL", &ccrHal);
+    FastIO_Print("ccr4", "LL", &ccrLl);
+    // Both TX versions cannot share the stream interrupt: the kick of the
+    // version built in, as timed in flight; flash the other build to compare
+    FastIO_Print("txkick", FAST_IO_USE_LL ? "LL" : "HAL", &fastIoTxKick);
+#endif
+}
+#endif
@@ -0,0 +1,154 @@
+/**
+  ******************************************************************************
+  * @file    FastLink.c
+  * @author  Aaron Lubinsky
+  * @brief   USART1 DMA output ring for blackbox dumps and telemetry
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Writers copy into a FAST_RING byte ring; FastLink_Service() hands
+  *          the oldest contiguous run (up to FAST_CHUNK bytes) to DMA2
+  *          Stream7 (FastIO_TxStart()) and, when that transfer completes,
+  *          moves the read index on and starts the next one from the TX
+  *          complete callback, or straight from the DMA interrupt with the
+  *          FastIO LL path. At
+  *          921600 baud a full chunk is about 5.5 ms on the wire, so the DMA
+  *          and USART1 interrupts (both at priority 5, below the link)
+  *          fire only a couple of hundred times a second at full rate.
+  *
+  *          Only the main loop writes, so the ring needs no locking: the
+  *          write index belongs to the main loop and the read index to
+  *          whichever of the main loop and the TX complete callback finds
+  *          the UART idle, which cannot happen in both at once.
+  *
+  *          Stream layout, line based so a plain serial capture is readable:
+  *
+  *            T,...            telemetry (FastLink_Telemetry())
+  *            # <name> ...     start of a dump section, e.g. # blackbox
+  *            # end            end of a dump section
+  *
+  *          Telemetry lines can appear inside a section sent in the
+  *          background during flight (HC05_DumpStep()).
+  *
+  *          Tools/build/fastrx splits a capture back into files.
+  *
+  ******************************************************************************
+  ==============================================================================
+                        ##### How to use this driver #####
+  ==============================================================================
+  1. USART1 and DMA2 Stream7 are configured by CubeMX (MX_USART1_UART_Init)
+  2. Call FastLink_Service() every main loop iteration and from the USART1
+     TX complete callback (or the DMA2 Stream7 interrupt, see FastIO.c)
+  3. Queue data with FastLink_Send() (drops when full) or FastLink_SendWait()
+  4. Call FastLink_Telemetry() every flight loop iteration
+
+  @note Never call the writers from an interrupt
+  */
+
+#include "FastLink.h"
+#include "Battery.h"
+#include "FastIO.h"
+#include "stm32f4xx_hal.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+extern TIM_HandleTypeDef htim3;
+extern int32_t roll_true, pitch_true, yaw_true;
+extern int32_t roll_set, pitch_set, effort_set;
+
+uint32_t fastTxBytes = 0;
+uint32_t fastDropped = 0;
+
+static uint8_t fastRing[FAST_RING];
+static volatile uint32_t ringHead = 0;    ///< Read index (free running)
+static volatile uint32_t ringTail = 0;    ///< Write index (free running)
+static volatile uint16_t inFlight = 0;    ///< Bytes in the current DMA transfer
+static uint32_t lastTelem = 0;
+
+uint32_t FastLink_Free(void)
+{
+    return FAST_RING - (ringTail - ringHead);
+}
+
+static void FastLink_Copy(const uint8_t *data, uint16_t len)
+{
+    uint32_t pos = ringTail & (FAST_RING - 1);
+    uint32_t first = FAST_RING - pos;
+
+    if (first > len) first = len;
+    memcpy(&fastRing[pos], data, first);
+    memcpy(fastRing, data + first, len - first);
+    ringTail += len;
+}
+
+void FastLink_Service(void)
+{
+    uint32_t pos, len;
+
+    if (FastIO_TxBusy()) {
+        return;
+    }
+
+    ringHead += inFlight;
+    inFlight = 0;
+
+    len = ringTail - ringHead;
+    if (len == 0) {
+        return;
+    }
+    pos = ringHead & (FAST_RING - 1);
+    if (len > FAST_RING - pos) len = FAST_RING - pos; // Up to the wrap; the rest goes next time
+    if (len > FAST_CHUNK) len = FAST_CHUNK;
+
+    inFlight = (uint16_t)len; // Before starting: the completion may preempt us
+    fastTxBytes += len;
+    FastIO_TxStart(&fastRing[pos], (uint16_t)len);
+}
+
+int FastLink_Send(const void *data, uint16_t len)
+{
+    if (len > FastLink_Free()) {
+        fastDropped++;
+        return 0;
+    }
+    FastLink_Copy(data, len);
+    FastLink_Service();
+    return 1;
+}
+
+void FastLink_SendWait(const void *data, uint16_t len)
+{
+    const uint8_t *p = data;
+
+    while (len > 0) {
+        uint32_t room = FastLink_Free();
+        uint16_t n = (len < room) ? len : (uint16_t)room;
+
+        if (n > 0) {
+            FastLink_Copy(p, n);
+            p += n;
+            len -= n;
+        }
+        FastLink_Service();
+    }
+}
+
+void FastLink_Telemetry(void)
+{
+    char line[112];
+    uint32_t now = HAL_GetTick();
+    int n;
+
+    if (now - lastTelem < FAST_TELEM_MS) {
+        return;
+    }
+    lastTelem = now;
+
+    n = snprintf(line, sizeof(line), "T,%" PRIu32 ",%" PRId32 ",%" PRId32 ",%" PRId32 ",%" PRId32 ",%" PRId32 ",%" PRId32 ",%" PRId32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 "\r\n",
+                 now, roll_true, pitch_true, yaw_true, roll_set, pitch_set, effort_set, batt_mV,
+                 htim3.Instance->CCR1, htim3.Instance->CCR2, htim3.Instance->CCR3, htim3.Instance->CCR4);
+    if (n > 0 && n < (int)sizeof(line)) {
+        FastLink_Send(line, (uint16_t)n);
+    }
+}
@@ -26,7 +26,9 @@
   1. Ensure UART2 is configured for HC-05 communication (typically 9600 baud)
   2. Pair HC-05 module with control device (phone/computer)
   4. Call processInput() with received data to parse control commands
-  5. Call dumpBlackbox() to transmit flight data for analysis
+  5. Call dumpBlackbox() to transmit flight data for analysis (on the USART1
+     fast channel, FastLink.c), or HC05_DumpStart() and then HC05_DumpStep()
+     every loop to send it in the background while flying
 
   @note Input format must start with '#' character for validation
   @note All control values are scaled appropriately for flight control
@@ -39,12 +41,24 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include "stm32f4xx_hal.h" // Needed for HAL types
 #include "BNO055.h"
+#include "AngleMath.h"
+#include "RamFunc.h"
+#include "StackMon.h"
+#include "Watchdog.h"
+#include "Latency.h"
+#include "FastLink.h"
+#include "Trace.h"
+#include "RateMode.h"
 
 /* Communication Statistics */
 int badBTcount = 0;  ///< Counter for invalid Bluetooth transmissions
+int goodBTcount = 0; ///< Counter for valid Bluetooth frames
 int effortRate = 10; ///< Rate of effort change per control input
+int btBaud = 9600;   ///< HC-05 UART baud rate (stored parameter)
+int linkMavlink = 0; ///< Link speaks MAVLink v2 instead of CSV (stored parameter)
 
 /* External UART Handle */
 extern UART_HandleTypeDef huart2; ///< UART2 handle for HC-05 communication
@@ -67,6 +81,11 @@ extern int32_t yaw_true;   ///< Current yaw angle from IMU (millidegrees)
 
 extern int stopFlag;
 
+/* Background Blackbox Transfer */
+static uint16_t bbNext = 0;   ///< Next sample to send; a new in-flight download resumes here
+static uint16_t bbEnd = 0;    ///< One past the last sample of the current download
+static int bbState = 0;       ///< 0 idle, 1 header pending, 2 sending samples
+
 /**
  * @brief Processes incoming control input from Bluetooth connection
  *
@@ -78,13 +97,16 @@ extern int stopFlag;
  * @param[out] dumpFlag  Pointer to store blackbox dump request flag
  *
  * @details Parses comma-separated joystick and button data from the control device.
- *          Expected input format: "#LjoyX,LjoyY,RjoyX,LT,RT,ENTER"
+ *          Expected input format: "#LjoyX,LjoyY,RjoyX,LT,RT,ENTER[,STAMP]"
  *
  *          Control mapping:
- *          - Left joystick X/Y → Roll/Pitch commands (±20° range)
+ *          - Left joystick X/Y → Roll/Pitch commands (±20° range), or
+ *            roll/pitch rates through the expo curve in rate mode
+ *            (Rate_Sticks(), the same for the right joystick and yaw rate)
  *          - Right joystick X → Yaw rate command (relative to current heading)
  *          - Left/Right triggers → Throttle increase/decrease
  *          - Enter button → Trigger blackbox data dump
+ *          - STAMP (optional, 1-65535) → latency probe echo stamp (Latency.c)
  *
  * @note Input must start with '#' character for validation
  * @note Roll/Pitch scaled from joystick ±1000 range to ±20° (±20000 millidegrees)
@@ -98,8 +120,11 @@ extern int stopFlag;
  * @see InitializeBT()
  * @see dumpBlackbox()
  */
-void processInput(char *charBuf, int32_t *roll, int32_t *pitch, int32_t *yaw, int32_t *effort, int *dumpFlag){
-    int32_t LjoyX, LjoyY, RjoyX, LT, RT, ENTER; ///< Parsed joystick and button values
+RAMFUNC void processInput(char *charBuf, int32_t *roll, int32_t *pitch, int32_t *yaw, int32_t *effort, int *dumpFlag){
+    int32_t LjoyX = 0, LjoyY = 0, RjoyX = 0, LT = 0, RT = 0, ENTER = 0; ///< Parsed joystick and button values
+    int32_t STAMP = 0; ///< Latency probe stamp, 0 when the frame carries none
+
+    StackMon_Mark(STACK_CTX_LINK_RX);
 
     /* ===== INPUT VALIDATION ===== */
     // Skip pound sign if present
@@ -111,6 +136,8 @@ void processInput(char *charBuf, int32_t *roll, int32_t *pitch, int32_t *yaw, in
         return;
     }
 
+    goodBTcount++;
+
     /* ===== DATA PARSING ===== */
     // Parse comma-separated values using strtok
     char *token = strtok(charBuf, ",");
@@ -131,6 +158,9 @@ void processInput(char *charBuf, int32_t *roll, int32_t *pitch, int32_t *yaw, in
     token = strtok(NULL, ",");
     if (token) ENTER = (int32_t)strtol(token, NULL, 10);
 
+    token = strtok(NULL, ",");
+    if (token) STAMP = (int32_t)strtol(token, NULL, 10);
+
     /* ===== CONTROL MAPPING ===== */
     // Convert joystick values to flight control commands
 
@@ -138,15 +168,11 @@ void processInput(char *charBuf, int32_t *roll, int32_t *pitch, int32_t *yaw, in
     *roll = LjoyX * 180 / 9;   // Scale to millidegrees (±20000)
     *pitch = LjoyY * 180 / 9;  // Scale to millidegrees (±20000)
 
-    // Yaw: Relative control - add rate command to current heading
-    *yaw = yaw_true + (RjoyX) / 10;
+    // Yaw: Relative control - add rate command to current heading, wrapped to 0-360°
+    *yaw = angle_Wrap360(yaw_true + (RjoyX) / 10);
 
-    // Handle yaw wraparound (0-360°)
-    if (*yaw < 0) {
-        *yaw = *yaw + 360000;
-    } else if (*yaw > 360000) {
-        *yaw = *yaw - 360000;
-    }
+    // Rate mode: the same sticks through the expo curves
+    Rate_Sticks(LjoyX, LjoyY, RjoyX);
 
     // Throttle: Differential trigger control (RT increases, LT decreases)
     *effort = *effort + (RT - LT) * effortRate / 1000;
@@ -164,30 +190,115 @@ void processInput(char *charBuf, int32_t *roll, int32_t *pitch, int32_t *yaw, in
     if (ENTER == 1) {
         *dumpFlag = 1;
     }
+
+    Latency_Parsed((uint16_t)STAMP);
+}
+
+/**
+ * @brief Starts a blackbox download on the USART1 fast channel
+ *
+ * @param[in] fromStart true to send every recorded sample, false to resume
+ *                      after the last sample an earlier download sent
+ *
+ * @details The download covers the samples recorded so far; anything logged
+ *          after this call goes out with the next one. Ignored while a
+ *          download is already running.
+ *
+ * @see HC05_DumpStep()
+ */
+void HC05_DumpStart(int fromStart)
+{
+    if (bbState != 0) {
+        return;
+    }
+    if (fromStart) {
+        bbNext = 0;
+    }
+    bbEnd = sample_index;
+    bbState = 1;
+}
+
+/**
+ * @brief Queues the next slice of a running blackbox download
+ *
+ * @return true when no download is running (finished or never started)
+ *
+ * @details Sends at most BB_SLICE_LINES samples per call and only while
+ *          FastLink.c has BB_RESERVE bytes of ring space to spare, so a
+ *          call costs a bounded handful of snprintf()s and never waits for
+ *          the wire; when the ring is busy the download simply picks up on
+ *          the next call. The reserve keeps room for the telemetry lines.
+ *
+ *          Output is the same section dumpBlackbox() produces, with the
+ *          first sample index after the count:
+ *          "# blackbox <n> <first>", n lines "pitch,pitchSet,roll,rollSet,vbat",
+ *          "# end".
+ */
+int HC05_DumpStep(void)
+{
+    char msg[64]; ///< Message buffer for each data line
+    int n;
+
+    if (bbState == 0) {
+        return true;
+    }
+
+    Trace_Begin(TRACE_BLACKBOX);
+    StackMon_Mark(STACK_CTX_MAIN);
+
+    if (bbState == 1 && FastLink_Free() >= BB_RESERVE + sizeof(msg)) {
+        n = snprintf(msg, sizeof(msg), "# blackbox %u %u\r\n", (unsigned)(bbEnd - bbNext), bbNext);
+        FastLink_Send(msg, (uint16_t)n);
+        bbState = 2;
+    }
+
+    for (int lines = 0; bbState == 2 && lines < BB_SLICE_LINES; lines++) {
+        if (FastLink_Free() < BB_RESERVE + sizeof(msg)) {
+            break; // Ring busy; carry on next call
+        }
+        if (bbNext >= bbEnd) {
+            FastLink_Send("# end\r\n", 7);
+            bbState = 0;
+            break;
+        }
+        n = snprintf(msg, sizeof(msg), "%" PRId32 ",%" PRId32 ",%" PRId32 ",%" PRId32 ",%" PRId32 "\r\n",
+                blackbox[bbNext].pitch,
+                blackbox[bbNext].pitchSet,
+                blackbox[bbNext].roll,
+                blackbox[bbNext].rollSet,
+                blackbox[bbNext].vbat);
+        FastLink_Send(msg, (uint16_t)n);
+        bbNext++;
+    }
+
+    Trace_End(TRACE_BLACKBOX);
+    return bbState == 0;
 }
 
 /**
- * @brief Transmits flight data blackbox over Bluetooth connection
+ * @brief Transmits the whole flight data blackbox on the USART1 fast channel
+ *
+ * @details Sends all recorded flight data from the blackbox buffer in CSV
+ *          format, one sample per line containing pitch, pitch setpoint,
+ *          roll, roll setpoint and pack voltage, between a "# blackbox <n> 0"
+ *          and a "# end" line. Bulk data stays off the 9600 baud HC-05 link.
  *
- * @details Sends all recorded flight data from the blackbox buffer via UART
- *          to the connected Bluetooth device. Data is transmitted in CSV format
- *          with one sample per line containing pitch, pitch setpoint, roll, and
- *          roll setpoint values.
+ *          Output format per line: "pitch,pitchSet,roll,rollSet,vbat\r\n"
+ *          Angles are in millidegrees, vbat in millivolts.
  *
- *          Output format per line: "pitch,pitchSet,roll,rollSet\r\n"
- *          All values are in millidegrees.
+ *          A background download still in progress is finished first, so
+ *          sections never interleave.
  *
  * @note Function transmits all samples up to current sample_index
- * @note 200ms delay added to allow receiver to process data
- * @note Data transmission is blocking (waits for completion)
+ * @note Data transmission is blocking (waits for ring space); a full
+ *       buffer takes about 1.5 s at 921600 baud
  * @note Currently only transmits pitch and roll data (yaw commented out)
  *
- * @warning Large blackbox buffers may take significant time to transmit
- * @warning Ensure receiver can handle the data rate
- * @warning Function blocks until all data is transmitted
+ * @warning Function blocks until all data is queued; only call it with the
+ *          motors stopped
  *
+ * @see HC05_DumpStart()
  * @see processInput()
- * @see InitializeBT()
  */
 void dumpBlackbox(void)
 {
@@ -196,21 +307,44 @@ void dumpBlackbox(void)
     //snprintf(paramMsg, sizeof(paramMsg), "Kp_pitch: %ld, Ki_pitch: %ld, Kd_pitch: %ld, Kp_roll: %ld, Ki_roll: %ld, Kd_roll: %ld \r\n",Kp_pitch, Ki_pitch, Kd_pitch, Kp_roll, Ki_roll, Kd_roll);
     //HAL_UART_Transmit(&huart2, (uint8_t*)paramMsg, strlen(paramMsg), HAL_MAX_DELAY);
 
+    while (!HC05_DumpStep()) { // Finish any background download
+        FastLink_Service();
+        Watchdog_Kick(false);
+    }
 
-    char msg[64]; ///< Message buffer for each data line
-
-    // Transmit all blackbox samples
-    for (uint16_t i = 0; i < sample_index; i++) {
-        snprintf(msg, sizeof(msg), "%ld,%ld,%ld,%ld\r\n",
-                blackbox[i].pitch,
-                blackbox[i].pitchSet,
-                blackbox[i].roll,
-                blackbox[i].rollSet);
-        HAL_UART_Transmit(&huart2, (uint8_t*)msg, strlen(msg), HAL_MAX_DELAY);
+    HC05_DumpStart(true);
+    while (!HC05_DumpStep()) {
+        FastLink_Service();
+        Watchdog_Kick(false);
     }
 }
 
 
+/**
+ * @brief Keeps the HC-05 receive path running during bring-up
+ *
+ * @param[in] rxBuf Buffer for DMA reception
+ * @param[in] len   Frame length to receive
+ * @return true once at least one valid frame has arrived
+ *
+ * @details Restarts DMA reception whenever the UART receiver is idle, so the
+ *          link is serviced from the first loop iteration instead of only
+ *          after the IMU is calibrated. Never blocks. With linkMavlink set the
+ *          reception also ends on an idle line so each burst is handed to
+ *          MAV_Receive() as it arrives.
+ */
+int HC05_LinkStep(uint8_t *rxBuf, uint16_t len)
+{
+    if (huart2.RxState == HAL_UART_STATE_READY) {
+        if (linkMavlink) {
+            HAL_UARTEx_ReceiveToIdle_DMA(&huart2, rxBuf, len); // MAVLink frames vary in length
+        } else {
+            HAL_UART_Receive_DMA(&huart2, rxBuf, len);
+        }
+    }
+    return goodBTcount > 0;
+}
+
 void sendATCommand(const char* cmd) {
 HAL_UART_Transmit(&huart2, (uint8_t*)cmd, strlen(cmd), HAL_MAX_DELAY);
 HAL_Delay(500); // Small delay to give HC-05 time to process
@@ -0,0 +1,108 @@
+/**
+  ******************************************************************************
+  * @file    LQR.c
+  * @author  Aaron Lubinsky
+  * @brief   LQR state-feedback attitude controller
+  * @version 1.0
+  * @date    2026
+  *
+  * @details The state is the roll, pitch and yaw errors, the three gyro
+  *          rates and the three error integrals, in the units update_Motors()
+  *          already keeps them in (millidegrees, millidegrees/s and
+  *          millidegree seconds). u = -K x gives each motor's offset in
+  *          compare counts directly, replacing both the three PIDs and the
+  *          X mixer.
+  *
+  *          The PID pushes one side of each motor pair and mixes the axes
+  *          with fixed signs, so a roll correction and a yaw correction can
+  *          fight over the same motor; the LQR gains come from one cost over
+  *          all axes and all four motors, so each motor's offset is the
+  *          optimal trade-off between them, and the rate feedback uses the
+  *          gyro instead of differencing the angle error.
+  *
+  *          K is Q16 in LQRGains.h, written by Tools/Sim/lqrgen from the
+  *          same plant model the simulator flies. The product is 36
+  *          multiply-accumulates into 64 bits (SMLAL on the M4), no floats.
+  *          The roll/pitch gain schedule does not apply. K is linearized at
+  *          one throttle (lqrgen -e, effort 500 by default) on the motors
+  *          as shipped, with no thrust curve, so the loop gain is higher
+  *          above that throttle and lower below it; run lqrcmp at the
+  *          throttles you fly before trusting it there.
+  *
+  ******************************************************************************
+  ==============================================================================
+                        ##### How to use this driver #####
+  ==============================================================================
+  1. Run Tools/build/lqrgen (see its -a/-r/-i/-y/-u weights) to regenerate
+     Core/Inc/LQRGains.h after changing the airframe model, and rebuild
+  2. Fly it in Tools/Sim/lqrcmp against the PID before flashing
+  3. Set CTRL_LAW to 1 (disarmed); main then reads BNO_ReadRates() in state 2
+     and update_Motors() calls LQR_Control() in place of the PID and mixer
+
+  @note Angle mode only; in rate mode update_Motors() keeps the rate PID
+  @warning The gains are only as good as the plant model. Check t_max, arm
+           and the inertias in Plant_Defaults() against the real airframe
+           before trusting them
+  */
+
+#include "LQR.h"
+#include "RamFunc.h"
+
+/* Stored Parameters */
+int ctrlLaw = CTRL_LAW_PID; ///< PID unless CTRL_LAW says otherwise
+
+/* External Control State */
+extern int32_t roll_error, pitch_error, yaw_error;             ///< Actual minus setpoint (mdeg)
+extern int32_t roll_integral, pitch_integral, yaw_integral;    ///< Error integrals (mdeg s)
+extern int32_t last_roll_error, last_pitch_error, last_yaw_error;
+extern int32_t roll_rate, pitch_rate, yaw_rate;                ///< Gyro rates (mdeg/s)
+extern int32_t roll_effort, pitch_effort, yaw_effort;          ///< Equivalent per-axis efforts
+extern int max_integral;
+
+/**
+ * @brief Steps one error integral the way the PID does
+ */
+RAMFUNC static void integrate(int32_t *integral, int32_t error)
+{
+    *integral += error / 1000;
+    if (*integral > max_integral) {
+        *integral = max_integral;
+    } else if (*integral < -max_integral) {
+        *integral = -max_integral;
+    }
+}
+
+/**
+ * @brief Motor offsets from the gain matrix
+ */
+RAMFUNC void LQR_Control(int32_t u[LQR_INPUTS])
+{
+    int32_t x[LQR_STATES];
+
+    integrate(&roll_integral, roll_error);
+    integrate(&pitch_integral, pitch_error);
+    integrate(&yaw_integral, yaw_error);
+
+    x[0] = roll_error;    x[1] = pitch_error;    x[2] = yaw_error;
+    x[3] = roll_rate;     x[4] = pitch_rate;     x[5] = yaw_rate;
+    x[6] = roll_integral; x[7] = pitch_integral; x[8] = yaw_integral;
+
+    for (int m = 0; m < LQR_INPUTS; m++) {
+        int64_t acc = 0;
+
+        for (int j = 0; j < LQR_STATES; j++) {
+            acc += (int64_t)lqrK[m][j] * x[j];
+        }
+        u[m] = -(int32_t)(acc >> LQR_K_SHIFT);
+    }
+
+    // Per-axis view of the same offsets, with the mixer's motor pairs
+    roll_effort = (u[0] + u[1] - u[2] - u[3]) / 2;
+    pitch_effort = (u[0] + u[3] - u[1] - u[2]) / 2;
+    yaw_effort = (u[1] + u[3] - u[0] - u[2]) / 2;
+
+    // Keeps the derivative from kicking if CTRL_LAW switches back to PID
+    last_roll_error = roll_error;
+    last_pitch_error = pitch_error;
+    last_yaw_error = yaw_error;
+}
@@ -0,0 +1,149 @@
+/**
+  ******************************************************************************
+  * @file    Latency.c
+  * @author  Aaron Lubinsky
+  * @brief   End-to-end stick-to-motor latency measurement
+  * @version 1.0
+  * @date    2026
+  *
+  * @details One probe is tracked at a time, stamped with the DWT cycle
+  *          counter at each stage:
+  *
+  *          1. received: entry of the USART2 receive callback (the DMA
+  *             transfer complete for CSV, the idle line for MAVLink)
+  *          2. parsed:   the frame's setpoints have been written
+  *          3. applied:  the next update_Motors() to start after that has
+  *             written its compares
+  *          4. latched:  the compare registers are preloaded, so the PWM
+  *             changes at the next TIM3 update. That instant is computed from
+  *             the counter position rather than waited for: it is
+  *             (ARR - CNT + 1) timer ticks away, and TIM3 runs from HCLK
+  *             (APB1 undivided) through PSC + 1.
+  *
+  *          With the 47 Hz servo PWM the last stage alone is 0-21 ms, which
+  *          usually dominates the total.
+  *
+  *          A newer probe replaces one that has not been applied yet, and a
+  *          probe parsed while update_Motors() is running waits for the
+  *          following call, since that one may already have read the old
+  *          setpoints.
+  *
+  ******************************************************************************
+  ==============================================================================
+                        ##### How to use this driver #####
+  ==============================================================================
+  1. Call Latency_FrameIn() at the top of the link receive callbacks
+  2. Call Latency_Parsed(stamp) once a frame's setpoints are written
+  3. Call Latency_ApplyStart() / Latency_Applied() around the control step
+  4. Read latHist / latStageUs, or Latency_Dump() them on the fast channel
+
+  @note The full dump goes to USART1 (the ST-Link side) only. On the CSV
+        link Latency_Dump() also prints one summary line on the HC-05, so
+        the ground station sees it; with MAVLink the ground station has
+        the echoed stamps instead.
+  */
+
+#include "Latency.h"
+#include "RamFunc.h"
+#include "FastLink.h"
+#include "HC05.h"
+#include "stm32f4xx_hal.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#define PROBE_IDLE     0
+#define PROBE_PARSED   1 ///< Waiting for the next control step
+#define PROBE_APPLYING 2 ///< Claimed by the control step in progress
+
+extern TIM_HandleTypeDef htim3;  ///< Motor PWM timer
+
+uint32_t latHist[LAT_BINS];
+uint32_t latProbes = 0;
+uint16_t latStamp = 0;
+uint32_t latStageUs[LAT_STAGES];
+
+static volatile uint32_t frameCycles = 0;  ///< Arrival of the frame(s) being parsed
+static volatile uint32_t rxCycles = 0;     ///< Arrival of the probe frame
+static volatile uint32_t parseCycles = 0;
+static volatile uint16_t probeStamp = 0;
+static volatile uint8_t probeStage = PROBE_IDLE;
+
+RAMFUNC void Latency_FrameIn(void)
+{
+    frameCycles = DWT->CYCCNT;
+}
+
+RAMFUNC void Latency_Parsed(uint16_t stamp)
+{
+    if (stamp == 0) {
+        return;
+    }
+    rxCycles = frameCycles;
+    parseCycles = DWT->CYCCNT;
+    probeStamp = stamp;
+    probeStage = PROBE_PARSED;
+}
+
+RAMFUNC void Latency_ApplyStart(void)
+{
+    if (probeStage == PROBE_PARSED) {
+        probeStage = PROBE_APPLYING;
+    }
+}
+
+RAMFUNC void Latency_Applied(void)
+{
+    uint32_t now = DWT->CYCCNT;
+    TIM_TypeDef *tim = htim3.Instance;
+    uint32_t latchCycles, perUs, bin;
+
+    if (probeStage != PROBE_APPLYING) {
+        return;
+    }
+
+    latchCycles = (tim->ARR - tim->CNT + 1U) * (tim->PSC + 1U);
+    perUs = SystemCoreClock / 1000000U;
+    latStageUs[LAT_RX_PARSE] = (parseCycles - rxCycles) / perUs;
+    latStageUs[LAT_PARSE_APPLY] = (now - parseCycles) / perUs;
+    latStageUs[LAT_APPLY_LATCH] = latchCycles / perUs;
+    latStageUs[LAT_TOTAL] = (now - rxCycles + latchCycles) / perUs;
+    latStamp = probeStamp;
+    probeStage = PROBE_IDLE;
+
+    bin = latStageUs[LAT_TOTAL] / LAT_BIN_US;
+    latHist[(bin < LAT_BINS) ? bin : LAT_BINS - 1]++;
+    latProbes++;
+}
+
+void Latency_Dump(void)
+{
+    char msg[128];
+    char range[16];
+    int most = 0;
+
+    snprintf(msg, sizeof(msg), "# latency %" PRIu32 " probes, last %u: rx-parse %" PRIu32 " us, parse-apply %" PRIu32 " us, apply-latch %" PRIu32 " us\r\n",
+             latProbes, latStamp, latStageUs[LAT_RX_PARSE], latStageUs[LAT_PARSE_APPLY], latStageUs[LAT_APPLY_LATCH]);
+    FastLink_SendWait(msg, (uint16_t)strlen(msg));
+
+    for (int i = 0; i < LAT_BINS; i++) {
+        if (latHist[i] == 0) continue;
+        if (i == LAT_BINS - 1) {
+            snprintf(msg, sizeof(msg), "# %d+ ms: %" PRIu32 "\r\n", i * LAT_BIN_US / 1000, latHist[i]);
+        } else {
+            snprintf(msg, sizeof(msg), "# %d-%d ms: %" PRIu32 "\r\n", i * LAT_BIN_US / 1000, (i + 1) * LAT_BIN_US / 1000, latHist[i]);
+        }
+        FastLink_SendWait(msg, (uint16_t)strlen(msg));
+        if (latHist[i] > latHist[most]) most = i;
+    }
+
+    if (!linkMavlink) { // printf() is on USART2 here; one short line keeps the link free
+        if (most == LAT_BINS - 1) {
+            snprintf(range, sizeof(range), "%d+", most * LAT_BIN_US / 1000);
+        } else {
+            snprintf(range, sizeof(range), "%d-%d", most * LAT_BIN_US / 1000, (most + 1) * LAT_BIN_US / 1000);
+        }
+        printf("# latency %" PRIu32 " probes, last %u: %" PRIu32 " us, most in %s ms\r\n",
+               latProbes, latStamp, latStageUs[LAT_TOTAL], range);
+    }
+}
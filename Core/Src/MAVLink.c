@@ -0,0 +1,556 @@
+/**
+  ******************************************************************************
+  * @file    MAVLink.c
+  * @author  Aaron Lubinsky
+  * @brief   Minimal MAVLink v2 encoder/decoder for the HC-05 link
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Lets standard ground tools talk to the drone without the full
+  *          generated MAVLink library. Supported messages:
+  *
+  *          - HEARTBEAT (out, 1 Hz): state machine state in custom_mode
+  *          - ATTITUDE (out): roll/pitch/yaw from the BNO055 in radians
+  *          - RC_CHANNELS_OVERRIDE (in): ch1 roll, ch2 pitch, ch3 throttle,
+  *            ch4 yaw, ch5 > 1700 requests a blackbox dump, ch18 carries
+  *            a latency probe stamp (non-zero)
+  *          - MEMINFO (out, 1 Hz, ardupilotmega dialect): untouched RAM
+  *            between the heap and the deepest stack use (StackMon.c)
+  *          - DEBUG_FLOAT_ARRAY "LATENCY" (out, every MAV_LATENCY_MS while
+  *            probes complete): last probe stamp, its stage times in us and
+  *            the latency histogram (Latency.c)
+  *          - PARAM_REQUEST_LIST / PARAM_REQUEST_READ / PARAM_SET (in) and
+  *            PARAM_VALUE (out) over the Params.c store. Values are int32
+  *            sent bytewise in the float field (MAV_PARAM_TYPE_INT32)
+  *          - LOG_REQUEST_LIST / LOG_REQUEST_DATA / LOG_REQUEST_END (in),
+  *            LOG_ENTRY / LOG_DATA (out): the blackbox as log MAV_LOG_ID,
+  *            the raw IMUSample array (20 bytes a sample, little-endian)
+  *
+  *          Blackbox download: each LOG_DATA frame carries its byte offset
+  *          and is CRC-checked like any other frame, so the ground station
+  *          knows exactly which 90-byte chunks arrived. Up to MAV_LOG_QUEUE
+  *          LOG_REQUEST_DATA ranges are queued and streamed in order, so a
+  *          client can keep a window of requests outstanding, ask again
+  *          for just the chunks it lost, and resume an interrupted download
+  *          at any offset. Samples are only ever appended, so a download
+  *          can run while the blackbox is still recording
+  *          (Tools/build/bbget is the host client).
+  *
+  *          Outgoing payloads are written field by field straight into the
+  *          static TX frame and sent with HAL_UART_Transmit_IT(); incoming
+  *          fields are read in place from the parser's frame buffer. Signed
+  *          frames are accepted but the signature is not checked.
+  *
+  ******************************************************************************
+  ==============================================================================
+                        ##### How to use this driver #####
+  ==============================================================================
+  1. Set the LINK_MAVLINK parameter to 1 so HC05_LinkStep() receives to idle
+  2. Call MAV_Receive() from HAL_UARTEx_RxEventCallback() for USART2
+  3. Call MAV_Service() every main loop iteration
+
+  @note Only one frame is in flight at a time; periodic telemetry is skipped
+        while the UART is still sending
+  */
+
+#include "MAVLink.h"
+#include "Params.h"
+#include "AngleMath.h"
+#include "RamFunc.h"
+#include "StackMon.h"
+#include "Latency.h"
+#include "BNO055.h"
+#include "RateMode.h"
+#include "stm32f4xx_hal.h"   // Needed for HAL types
+#include <string.h>
+
+#define MAV_TYPE_QUADROTOR        2
+#define MAV_AUTOPILOT_GENERIC     0
+#define MAV_MODE_FLAG_ARMED       0x80
+#define MAV_MODE_FLAG_CUSTOM      0x01
+#define MAV_STATE_BOOT            1
+#define MAV_STATE_STANDBY         3
+#define MAV_STATE_ACTIVE          4
+#define MAV_PARAM_TYPE_INT32      6
+#define MAV_PARAM_TYPE_REAL32     9
+#define MAV_IFLAG_SIGNED          0x01
+#define MAV_SIGNATURE_LEN         13
+#define MAV_PARAM_ID_LEN          16
+#define MAV_RC_IGNORE             0xFFFF  ///< Channel value meaning "leave as is"
+#define MAV_RC_STAMP_OFFSET       36      ///< chan18_raw: latency probe stamp
+#define MAV_DEBUG_NAME_LEN        10
+#define MAV_LATENCY_ARRAY_ID      1
+
+/* External Flight State */
+extern UART_HandleTypeDef huart2; ///< UART2 handle for HC-05 communication
+extern int state;
+extern int escArming;
+extern int stopFlag;
+extern int dumpFlag;
+extern int goodBTcount;
+extern int32_t roll_set, pitch_set, yaw_set, effort_set;
+extern int32_t roll_true, pitch_true, yaw_true;
+
+/**
+ * @brief Length and CRC_EXTRA of each supported message
+ */
+typedef struct {
+    uint32_t msgid;
+    uint8_t len;      ///< Full (untruncated) payload length
+    uint8_t crcExtra; ///< Seed byte from the message definition
+} MAVMsgInfo;
+
+static const MAVMsgInfo mavMsgs[] = {
+    {MAV_MSG_HEARTBEAT,            9,  50},
+    {MAV_MSG_PARAM_REQUEST_READ,   20, 214},
+    {MAV_MSG_PARAM_REQUEST_LIST,   2,  159},
+    {MAV_MSG_PARAM_VALUE,          25, 220},
+    {MAV_MSG_PARAM_SET,            23, 168},
+    {MAV_MSG_ATTITUDE,             28, 39},
+    {MAV_MSG_RC_CHANNELS_OVERRIDE, 38, 124},
+    {MAV_MSG_LOG_REQUEST_LIST,     6,  128},
+    {MAV_MSG_LOG_ENTRY,            14, 56},
+    {MAV_MSG_LOG_REQUEST_DATA,     12, 116},
+    {MAV_MSG_LOG_DATA,             97, 134},
+    {MAV_MSG_LOG_REQUEST_END,      2,  203},
+    {MAV_MSG_MEMINFO,              8,  208},
+    {MAV_MSG_DEBUG_FLOAT_ARRAY,    252, 232},
+};
+
+uint32_t mavRxGood = 0;
+uint32_t mavRxBad = 0;
+uint32_t mavLogSent = 0;
+
+static uint8_t mavTx[MAV_FRAME_MAX];   ///< Frame being sent; payload packed in place
+static uint8_t mavRx[MAV_FRAME_MAX];   ///< Frame being parsed
+static uint16_t rxPos = 0;             ///< Bytes of the current frame received
+static uint16_t rxNeed = 0;            ///< Frame length once the header is known
+static uint16_t rxTaken = 0;           ///< DMA buffer bytes already parsed
+static uint8_t txSeq = 0;
+
+static int paramListNext = -1;         ///< Next index to stream, -1 when idle
+static int paramReply = -1;            ///< Single PARAM_VALUE owed, -1 when none
+static int paramSetKey = -1;           ///< PARAM_SET waiting for the main loop
+static int32_t paramSetValue = 0;
+
+/**
+ * @brief One LOG_REQUEST_DATA byte range still to send
+ */
+typedef struct {
+    uint32_t ofs;
+    uint32_t end;                      ///< One past the last byte requested
+} MAVLogRange;
+
+static MAVLogRange logQueue[MAV_LOG_QUEUE];
+static volatile uint32_t logIn = 0;    ///< Ranges queued (written by the RX callback only)
+static volatile uint32_t logOut = 0;   ///< Ranges finished (written by MAV_Service() only)
+static volatile int logEntryDue = 0;   ///< LOG_ENTRY owed for a LOG_REQUEST_LIST
+static volatile int logStop = 0;       ///< LOG_REQUEST_END waiting for the main loop
+
+static uint32_t lastHeartbeat = 0;
+static int memInfoDue = 0;             ///< MEMINFO follows each HEARTBEAT
+static uint32_t lastAttitude = 0;
+static uint32_t lastLatency = 0;
+static uint32_t latencySent = 0;       ///< latProbes at the last report
+
+/* ===== WIRE HELPERS (little-endian, unaligned) ===== */
+
+static inline void put_u16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static inline void put_u32(uint8_t *p, uint32_t v) { put_u16(p, (uint16_t)v); put_u16(p + 2, (uint16_t)(v >> 16)); }
+static inline void put_f32(uint8_t *p, float f) { uint32_t v; memcpy(&v, &f, 4); put_u32(p, v); }
+static inline uint16_t get_u16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline uint32_t get_u32(const uint8_t *p) { return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16); }
+static inline float get_f32(const uint8_t *p) { uint32_t v = get_u32(p); float f; memcpy(&f, &v, 4); return f; }
+
+/**
+ * @brief X.25 CRC step used by MAVLink
+ */
+static inline uint16_t MAV_CRCByte(uint16_t crc, uint8_t b)
+{
+    uint8_t t = b ^ (uint8_t)crc;
+    t ^= (uint8_t)(t << 4);
+    return (crc >> 8) ^ ((uint16_t)t << 8) ^ ((uint16_t)t << 3) ^ (t >> 4);
+}
+
+static const MAVMsgInfo *MAV_Info(uint32_t msgid)
+{
+    for (unsigned i = 0; i < sizeof(mavMsgs) / sizeof(mavMsgs[0]); i++) {
+        if (mavMsgs[i].msgid == msgid) return &mavMsgs[i];
+    }
+    return NULL;
+}
+
+/* ===== ENCODER ===== */
+
+/**
+ * @brief True when the TX frame buffer is free to be packed
+ */
+static int MAV_TxReady(void)
+{
+    return huart2.gState == HAL_UART_STATE_READY;
+}
+
+/**
+ * @brief Adds the header and CRC around the packed payload and sends it
+ *
+ * @details Trailing zero bytes are truncated as MAVLink v2 allows.
+ */
+static void MAV_Send(uint32_t msgid)
+{
+    const MAVMsgInfo *info = MAV_Info(msgid);
+    uint8_t len = info->len;
+    uint16_t crc = 0xFFFF;
+
+    while (len > 1 && mavTx[MAV_HEADER_LEN + len - 1] == 0) len--;
+
+    mavTx[0] = MAV_STX;
+    mavTx[1] = len;
+    mavTx[2] = 0; // Incompatibility flags
+    mavTx[3] = 0; // Compatibility flags
+    mavTx[4] = txSeq++;
+    mavTx[5] = MAV_SYSID;
+    mavTx[6] = MAV_COMPID;
+    mavTx[7] = (uint8_t)msgid;
+    mavTx[8] = (uint8_t)(msgid >> 8);
+    mavTx[9] = (uint8_t)(msgid >> 16);
+
+    for (uint16_t i = 1; i < MAV_HEADER_LEN + len; i++) crc = MAV_CRCByte(crc, mavTx[i]);
+    crc = MAV_CRCByte(crc, info->crcExtra);
+    put_u16(&mavTx[MAV_HEADER_LEN + len], crc);
+
+    HAL_UART_Transmit_IT(&huart2, mavTx, MAV_HEADER_LEN + len + 2);
+}
+
+static void MAV_SendHeartbeat(void)
+{
+    uint8_t *p = &mavTx[MAV_HEADER_LEN];
+
+    put_u32(p, (uint32_t)state);                           // custom_mode
+    p[4] = MAV_TYPE_QUADROTOR;
+    p[5] = MAV_AUTOPILOT_GENERIC;
+    p[6] = MAV_MODE_FLAG_CUSTOM | ((state == 2) ? MAV_MODE_FLAG_ARMED : 0);
+    p[7] = (state == 0) ? MAV_STATE_BOOT : (state == 2 || state == 3) ? MAV_STATE_ACTIVE : MAV_STATE_STANDBY;
+    p[8] = 3;                                              // mavlink_version
+    MAV_Send(MAV_MSG_HEARTBEAT);
+}
+
+static void MAV_SendAttitude(void)
+{
+    const float mdegToRad = 3.14159265f / 180000.0f;
+    int32_t yaw = (yaw_true > ANGLE_HALF) ? yaw_true - ANGLE_FULL : yaw_true; // MAVLink wants -pi..pi
+    uint8_t *p = &mavTx[MAV_HEADER_LEN];
+
+    put_u32(p, HAL_GetTick());                             // time_boot_ms
+    put_f32(p + 4, roll_true * mdegToRad);
+    put_f32(p + 8, pitch_true * mdegToRad);
+    put_f32(p + 12, yaw * mdegToRad);
+    put_f32(p + 16, 0.0f);                                 // Rates are not measured
+    put_f32(p + 20, 0.0f);
+    put_f32(p + 24, 0.0f);
+    MAV_Send(MAV_MSG_ATTITUDE);
+}
+
+/**
+ * @brief MEMINFO: heap end and the RAM neither heap nor stack has touched
+ *
+ * @note Scans the painted stack (StackMon_Free()), about 0.3 ms, once a second
+ */
+static void MAV_SendMemInfo(void)
+{
+    uint8_t *p = &mavTx[MAV_HEADER_LEN];
+    uint32_t freeBytes = StackMon_Free();
+
+    put_u16(p, (uint16_t)StackMon_HeapEnd());               // brkval (low half of the address)
+    put_u16(p + 2, (freeBytes > 0xFFFF) ? 0xFFFF : (uint16_t)freeBytes);
+    put_u32(p + 4, freeBytes);                             // freemem32 extension
+    MAV_Send(MAV_MSG_MEMINFO);
+}
+
+/**
+ * @brief DEBUG_FLOAT_ARRAY "LATENCY": echo stamp, stage times (us), histogram
+ *
+ * @details data[0] is the stamp of the last completed probe, data[1..4] its
+ *          LatencyStage times, data[5..] the counts per LAT_BIN_US bin. Empty
+ *          trailing bins are truncated off the frame.
+ */
+static void MAV_SendLatency(void)
+{
+    uint8_t *p = &mavTx[MAV_HEADER_LEN];
+    uint8_t *data = p + 20;
+    uint64_t usec = (uint64_t)HAL_GetTick() * 1000U;
+
+    memset(p, 0, MAV_Info(MAV_MSG_DEBUG_FLOAT_ARRAY)->len);
+    put_u32(p, (uint32_t)usec);                            // time_usec
+    put_u32(p + 4, (uint32_t)(usec >> 32));
+    put_u16(p + 8, MAV_LATENCY_ARRAY_ID);
+    memcpy(p + 10, "LATENCY", 7);                          // name[MAV_DEBUG_NAME_LEN], zero padded
+    put_f32(data, (float)latStamp);
+    for (int i = 0; i < LAT_STAGES; i++) put_f32(data + 4 * (1 + i), (float)latStageUs[i]);
+    for (int i = 0; i < LAT_BINS; i++) put_f32(data + 4 * (1 + LAT_STAGES + i), (float)latHist[i]);
+    MAV_Send(MAV_MSG_DEBUG_FLOAT_ARRAY);
+}
+
+/**
+ * @brief Bytes of the blackbox log recorded so far
+ */
+static uint32_t MAV_LogSize(void)
+{
+    return (uint32_t)sample_index * sizeof(IMUSample);
+}
+
+/**
+ * @brief LOG_ENTRY for the blackbox, or an empty list when nothing is recorded
+ */
+static void MAV_SendLogEntry(void)
+{
+    uint8_t *p = &mavTx[MAV_HEADER_LEN];
+    uint32_t size = MAV_LogSize();
+
+    put_u32(p, 0);                                         // time_utc: no clock
+    put_u32(p + 4, size);
+    put_u16(p + 8, (size > 0) ? MAV_LOG_ID : 0);           // id
+    put_u16(p + 10, (size > 0) ? 1 : 0);                   // num_logs
+    put_u16(p + 12, (size > 0) ? MAV_LOG_ID : 0);          // last_log_num
+    MAV_Send(MAV_MSG_LOG_ENTRY);
+}
+
+/**
+ * @brief Next LOG_DATA chunk of the oldest queued range
+ *
+ * @return false if the queue held nothing left to send
+ */
+static int MAV_SendLogData(void)
+{
+    uint8_t *p = &mavTx[MAV_HEADER_LEN];
+    uint32_t size = MAV_LogSize();
+
+    while (logOut != logIn) {
+        MAVLogRange *r = &logQueue[logOut & (MAV_LOG_QUEUE - 1)];
+        uint32_t end = (r->end < size) ? r->end : size;
+
+        if (r->ofs < end) {
+            uint32_t n = end - r->ofs;
+            if (n > MAV_LOG_CHUNK) n = MAV_LOG_CHUNK;
+
+            memset(p, 0, MAV_Info(MAV_MSG_LOG_DATA)->len);
+            put_u32(p, r->ofs);
+            put_u16(p + 4, MAV_LOG_ID);
+            p[6] = (uint8_t)n;
+            memcpy(p + 7, (const uint8_t *)blackbox + r->ofs, n);
+            MAV_Send(MAV_MSG_LOG_DATA);
+            r->ofs += n;
+            mavLogSent++;
+            if (r->ofs >= end) logOut++; // Free the slot now; the client refills its window on this chunk
+            return 1;
+        }
+        logOut++; // Range done (or past what has been recorded)
+    }
+    return 0;
+}
+
+static void MAV_SendParam(int index)
+{
+    uint8_t *p = &mavTx[MAV_HEADER_LEN];
+    const char *name = Param_Name((ParamKey)index);
+
+    put_u32(p, (uint32_t)Param_Get((ParamKey)index));      // Bytewise int32
+    put_u16(p + 4, PARAM_COUNT);
+    put_u16(p + 6, (uint16_t)index);
+    memset(p + 8, 0, MAV_PARAM_ID_LEN);
+    memcpy(p + 8, name, strnlen(name, MAV_PARAM_ID_LEN));
+    p[24] = MAV_PARAM_TYPE_INT32;
+    MAV_Send(MAV_MSG_PARAM_VALUE);
+}
+
+/* ===== DECODER ===== */
+
+/**
+ * @brief Finds a parameter by its (not necessarily terminated) 16-char id
+ */
+static int MAV_FindParam(const uint8_t *id)
+{
+    for (int k = 0; k < PARAM_COUNT; k++) {
+        if (strncmp(Param_Name((ParamKey)k), (const char *)id, MAV_PARAM_ID_LEN) == 0) return k;
+    }
+    return -1;
+}
+
+/**
+ * @brief Maps RC override channels onto the setpoints
+ *
+ * @details Same ranges as processInput(): ±20° roll/pitch and a yaw step
+ *          relative to the current heading. Throttle is absolute here,
+ *          1000-2000 µs giving effort 0-1000. Rate mode setpoints are
+ *          shaped from the same channels (Rate_Sticks()).
+ */
+static void MAV_HandleRC(const uint8_t *p)
+{
+    uint16_t ch[5];
+
+    for (int i = 0; i < 5; i++) ch[i] = get_u16(p + 2 * i);
+
+    if (ch[0] != 0 && ch[0] != MAV_RC_IGNORE) roll_set = ((int32_t)ch[0] - 1500) * 40;
+    if (ch[1] != 0 && ch[1] != MAV_RC_IGNORE) pitch_set = ((int32_t)ch[1] - 1500) * 40;
+    if (ch[3] != 0 && ch[3] != MAV_RC_IGNORE) yaw_set = angle_Wrap360(yaw_true + ((int32_t)ch[3] - 1500) / 5);
+    Rate_Sticks(roll_set / 20, pitch_set / 20, // ±1000 stick
+                (ch[3] != 0 && ch[3] != MAV_RC_IGNORE) ? ((int32_t)ch[3] - 1500) * 2 : 0);
+    if (ch[2] != 0 && ch[2] != MAV_RC_IGNORE) {
+        int32_t effort = (int32_t)ch[2] - 1000;
+        stopFlag = (effort <= 0);
+        effort_set = (effort < 0) ? 0 : (effort > 1000) ? 1000 : effort;
+    }
+    if (ch[4] != 0 && ch[4] != MAV_RC_IGNORE && ch[4] > 1700) dumpFlag = 1;
+
+    Latency_Parsed(get_u16(p + MAV_RC_STAMP_OFFSET));
+}
+
+/**
+ * @brief Acts on a complete, CRC-checked frame in mavRx
+ */
+static void MAV_Handle(uint32_t msgid)
+{
+    const uint8_t *p = &mavRx[MAV_HEADER_LEN];
+
+    switch (msgid) {
+    case MAV_MSG_RC_CHANNELS_OVERRIDE: // chan1..8 (16 B), target_system, target_component
+        if (p[16] == MAV_SYSID || p[16] == 0) MAV_HandleRC(p);
+        break;
+
+    case MAV_MSG_PARAM_REQUEST_LIST:   // target_system, target_component
+        if (p[0] == MAV_SYSID || p[0] == 0) paramListNext = 0;
+        break;
+
+    case MAV_MSG_PARAM_REQUEST_READ: { // param_index, target_system, target_component, param_id
+        int16_t index = (int16_t)get_u16(p);
+        if (p[2] != MAV_SYSID && p[2] != 0) break;
+        if (index < 0) index = (int16_t)MAV_FindParam(p + 4);
+        if (index >= 0 && index < PARAM_COUNT) paramReply = index;
+        break;
+    }
+
+    case MAV_MSG_PARAM_SET: {          // param_value, target_system, target_component, param_id, param_type
+        int key = MAV_FindParam(p + 6);
+        if ((p[4] != MAV_SYSID && p[4] != 0) || key < 0) break;
+        paramSetValue = (p[22] == MAV_PARAM_TYPE_REAL32) ? (int32_t)get_f32(p) : (int32_t)get_u32(p);
+        paramSetKey = key;
+        break;
+    }
+
+    case MAV_MSG_LOG_REQUEST_LIST:     // start, end, target_system, target_component
+        if (p[4] == MAV_SYSID || p[4] == 0) logEntryDue = 1;
+        break;
+
+    case MAV_MSG_LOG_REQUEST_DATA: {   // ofs, count, id, target_system, target_component
+        uint32_t ofs = get_u32(p);
+        uint32_t count = get_u32(p + 4);
+        if ((p[10] != MAV_SYSID && p[10] != 0) || get_u16(p + 8) != MAV_LOG_ID) break;
+        if (logIn - logOut >= MAV_LOG_QUEUE) break; // Full: the client times out and asks again
+        logQueue[logIn & (MAV_LOG_QUEUE - 1)].ofs = ofs;
+        logQueue[logIn & (MAV_LOG_QUEUE - 1)].end = (count > 0xFFFFFFFFu - ofs) ? 0xFFFFFFFFu : ofs + count;
+        logIn++;
+        break;
+    }
+
+    case MAV_MSG_LOG_REQUEST_END:      // target_system, target_component
+        if (p[0] == MAV_SYSID || p[0] == 0) logStop = 1;
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Adds one byte to the frame being parsed
+ */
+RAMFUNC static void MAV_ParseByte(uint8_t c)
+{
+    if (rxPos == 0 && c != MAV_STX) return; // Hunt for the start byte
+
+    mavRx[rxPos++] = c;
+    if (rxPos == 3) {
+        rxNeed = MAV_HEADER_LEN + mavRx[1] + 2 + ((mavRx[2] & MAV_IFLAG_SIGNED) ? MAV_SIGNATURE_LEN : 0);
+    }
+    if (rxPos < 3 || rxPos < rxNeed) return;
+
+    rxPos = 0;
+    {
+        uint8_t len = mavRx[1];
+        uint32_t msgid = mavRx[7] | ((uint32_t)mavRx[8] << 8) | ((uint32_t)mavRx[9] << 16);
+        const MAVMsgInfo *info = MAV_Info(msgid);
+        uint16_t crc = 0xFFFF;
+
+        if (info == NULL || (mavRx[2] & ~MAV_IFLAG_SIGNED) || len > info->len) {
+            mavRxBad++;
+            return;
+        }
+        for (uint16_t i = 1; i < MAV_HEADER_LEN + len; i++) crc = MAV_CRCByte(crc, mavRx[i]);
+        crc = MAV_CRCByte(crc, info->crcExtra);
+        if (crc != get_u16(&mavRx[MAV_HEADER_LEN + len])) {
+            mavRxBad++;
+            return;
+        }
+
+        // Restore truncated trailing zeros (overwrites the CRC, no longer needed)
+        memset(&mavRx[MAV_HEADER_LEN + len], 0, info->len - len);
+        mavRxGood++;
+        goodBTcount++;
+        MAV_Handle(msgid);
+    }
+}
+
+RAMFUNC void MAV_Receive(const uint8_t *buf, uint16_t end)
+{
+    for (uint16_t i = rxTaken; i < end; i++) MAV_ParseByte(buf[i]);
+    rxTaken = end;
+
+    // Half-transfer events keep the reception running; anything else ends it
+    if (huart2.RxState != HAL_UART_STATE_BUSY_RX) rxTaken = 0;
+}
+
+void MAV_Service(void)
+{
+    uint32_t now = HAL_GetTick();
+
+    if (paramSetKey >= 0) {
+        int key = paramSetKey;
+        paramSetKey = -1;
+        if (state != 2 && state != 4 && !escArming) { // Never erase flash while the motors can spin
+            Param_Set((ParamKey)key, paramSetValue);
+        }
+        paramReply = key; // Echo the value now in effect; an unchanged value tells the GCS it was refused
+    }
+    if (logStop) {
+        logStop = 0;
+        logOut = logIn;
+    }
+
+    if (!MAV_TxReady()) return;
+
+    if (paramReply >= 0) {
+        MAV_SendParam(paramReply);
+        paramReply = -1;
+    } else if (paramListNext >= 0) {
+        MAV_SendParam(paramListNext++);
+        if (paramListNext >= PARAM_COUNT) paramListNext = -1;
+    } else if (now - lastHeartbeat >= MAV_HEARTBEAT_MS) {
+        lastHeartbeat = now;
+        memInfoDue = 1;
+        MAV_SendHeartbeat();
+    } else if (memInfoDue) {
+        memInfoDue = 0;
+        MAV_SendMemInfo();
+    } else if (logEntryDue) {
+        logEntryDue = 0;
+        MAV_SendLogEntry();
+    } else if (!(state == 2 && now - lastAttitude >= MAV_ATTITUDE_MS) && MAV_SendLogData()) {
+        // Downloads get the link except for the attitude stream in flight
+    } else if (latProbes != latencySent && now - lastLatency >= MAV_LATENCY_MS) {
+        lastLatency = now;
+        latencySent = latProbes;
+        MAV_SendLatency();
+    } else if (now - lastAttitude >= MAV_ATTITUDE_MS) {
+        lastAttitude = now;
+        MAV_SendAttitude();
+    }
+}
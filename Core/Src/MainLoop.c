@@ -0,0 +1,272 @@
+/**
+  ******************************************************************************
+  * @file    MainLoop.c
+  * @author  Aaron Lubinsky
+  * @brief   Flight state machine and printf() output
+  * @version 1.0
+  * @date    2026
+  *
+  * @details The body of main()'s while(1) loop. Every state returns
+  *          straight away, so one call is one loop iteration:
+  *
+  *          - 0 bring-up: IMU boot/calibration, BT link and ESC arming all
+  *            advance each loop
+  *          - 1 disarmed: roll stick left arms the ESCs; pitch stick back
+  *            with roll stick right, held for CAL_ENTRY_HOLD_MS and then
+  *            confirmed with ENTER, starts the motor calibration
+  *          - 2 flying: sensor read, control step, telemetry and the
+  *            background blackbox download
+  *          - 3 dump: trace, latency and the blackbox (and the FastIO
+  *            bench on a FASTIO_BENCH build), then back to 2 with the
+  *            throttle at zero
+  *          - 4 calibration: ESCCal_Step() until it finishes, then back to
+  *            1; the loop deadline stays enforced since motors spin here
+  *
+  *          Kept out of main.c so Tools/Sim/sitl.c runs the same state
+  *          machine on the host, together with __io_putchar() so printf()
+  *          goes to the same UART there as on the target: USART2 on the
+  *          CSV link, USART1 once the link has switched to MAVLink.
+  *
+  ******************************************************************************
+  ==============================================================================
+                        ##### How to use this driver #####
+  ==============================================================================
+  1. Initialize the peripherals, Battery_Init(), FastIO_Init() and
+     Watchdog_Init()
+  2. Call MainLoop_Step() forever
+
+  */
+
+#include "MainLoop.h"
+#include "BNO055.h"
+#include "HC05.h"
+#include "ESC.h"
+#include "Battery.h"
+#include "ESCCal.h"
+#include "Params.h"
+#include "MAVLink.h"
+#include "RamFunc.h"
+#include "StackMon.h"
+#include "Watchdog.h"
+#include "Trace.h"
+#include "Latency.h"
+#include "FastLink.h"
+#include "RateMode.h"
+#include "LQR.h"
+#include "FastIO.h"
+#include "stm32f4xx_hal.h"
+#include <stdio.h>
+#include <inttypes.h>
+
+#define true 1
+#define false 0
+
+/* External UART Handle */
+extern UART_HandleTypeDef huart2; ///< HC-05 link
+
+/* Flight state and pilot inputs (main.c) */
+extern int state;
+extern int stopFlag;
+extern int dumpFlag;
+extern int32_t roll_set, pitch_set, yaw_set, effort_set;
+extern int32_t roll_true, pitch_true, yaw_true;
+extern int32_t roll_rate, pitch_rate, yaw_rate;
+
+uint8_t BT_RxBuf[BT_MSG_LEN];
+int escArming = false;
+int escArmed = false;
+uint32_t armableTick = 0;
+
+uint32_t ctrlCycles = 0;
+uint32_t ctrlCyclesMax = 0;
+
+static int calHold = 0;          ///< Calibration combination: 0 not held, 1 holding, 2 held long enough
+static uint32_t calHoldTick = 0; ///< HAL tick when the combination was first seen
+
+/**
+ * @brief State 0: brings up the IMU, the link and optionally the ESCs
+ */
+static void MainLoop_BringUp(void)
+{
+    int imuReady = BNO_InitStep();
+    int linkReady = HC05_LinkStep(BT_RxBuf, BT_MSG_LEN - 1); // allow for DMA Callback
+
+    stopFlag = true;
+    if (linkReady && !escArming && !escArmed && roll_set < -10000) { // ESCs can be armed while the IMU calibrates
+        ESC_ArmStart();
+        escArming = true;
+    }
+    if (escArming && ESC_ArmStep()) {
+        escArming = false;
+        escArmed = true;
+    }
+
+    if (imuReady && linkReady) {
+        unsigned ramCode = 0;
+#ifdef __arm__
+        ramCode = (unsigned)(_eramfunc - _sramfunc);
+#endif
+        armableTick = HAL_GetTick();
+        printf("Armable after %" PRIu32 " ms (params %" PRIu32 " us, %u B code in RAM)\r\n", armableTick, paramLoadUs, ramCode);
+        printf("Stack peak %" PRIu32 " B, %" PRIu32 " B never used\r\n", StackMon_Peak(), StackMon_Free());
+        if (wdgReset) {
+            printf("Last reset was the watchdog\r\n");
+        }
+        state = escArmed ? 2 : 1;
+    }
+}
+
+/**
+ * @brief State 1: disarmed, waiting for the arming stick or the calibration request
+ *
+ * @details Calibration spins the motors, so a single stick position is not
+ *          enough: pitch back and roll right must be held together for
+ *          CAL_ENTRY_HOLD_MS, and ENTER pressed after that while still
+ *          holding them. ENTER pressed earlier is discarded.
+ */
+static void MainLoop_Disarmed(void)
+{
+    int calCombo = pitch_set < -10000 && roll_set > 10000; // Pitch back, roll right (props off!)
+
+    HC05_LinkStep(BT_RxBuf, BT_MSG_LEN - 1); // allow for DMA Callback
+
+    stopFlag = true;
+    if (!calCombo) {
+        calHold = 0;
+    }
+    if (escArming) {
+        if (ESC_ArmStep()) {
+            escArming = false;
+            escArmed = true;
+            state = 2;
+        }
+    } else if (roll_set < -10000) {
+        ESC_ArmStart();
+        escArming = true;
+    } else if (calCombo) {
+        uint32_t now = HAL_GetTick();
+
+        if (calHold == 0) {
+            calHold = 1;
+            calHoldTick = now;
+        }
+        if (calHold == 1 && now - calHoldTick >= CAL_ENTRY_HOLD_MS) {
+            calHold = 2;
+            printf("Motor calibration: props off, ENTER to start\r\n");
+        }
+        if (calHold == 2 && dumpFlag) {
+            calHold = 0;
+            ESCCal_Start();
+            state = 4;
+        }
+        dumpFlag = 0; // Only an ENTER after the hold counts
+    }
+    if (!escArming) {
+        effort_set = 0;
+    }
+}
+
+/**
+ * @brief State 2: reads the BNO, updates motor PWM to the latest link input
+ */
+static void MainLoop_Flying(void)
+{
+    if (flightMode == FLIGHT_MODE_RATE || ctrlLaw == CTRL_LAW_LQR) { // Gyro every loop; the LQR feeds back the rates too
+        BNO_ReadRates(&roll_true, &pitch_true, &yaw_true, &roll_rate, &pitch_rate, &yaw_rate);
+    } else {
+        BNO_Read(&roll_true, &pitch_true, &yaw_true);
+    }
+    Battery_Update();
+#ifdef __arm__
+    uint32_t ctrlStart = DWT->CYCCNT;
+    update_Motors();
+    ctrlCycles = DWT->CYCCNT - ctrlStart;
+    if (ctrlCycles > ctrlCyclesMax) {
+        ctrlCyclesMax = ctrlCycles;
+    }
+#else
+    update_Motors();
+#endif
+    FastLink_Telemetry();
+    if (dumpFlag == 1) {
+        dumpFlag = 0;
+        if (effort_set == 0) { // Throttle down: full blocking dump
+            state = 3;
+        } else { // In the air: send the new samples in the background and keep flying
+            HC05_DumpStart(false);
+        }
+    }
+    HC05_DumpStep(); // A few samples at most per loop
+}
+
+/**
+ * @brief State 3: dumps everything recorded with the throttle down, then back to 2
+ */
+static void MainLoop_Dump(void)
+{
+    Trace_Dump(); // Timeline, latency and the blackbox on the USART1 fast channel
+    Latency_Dump();
+#if FASTIO_BENCH
+    FastIO_Bench(); // HAL vs LL cycles of the I2C read, compares and TX kick
+#endif
+    dumpBlackbox();
+    dumpFlag = 0;
+    HC05_LinkStep(BT_RxBuf, BT_MSG_LEN - 1);
+    state = 2;
+    effort_set = 0;
+    HAL_GPIO_WritePin(GPIOA, GPIO_PIN_1, GPIO_PIN_SET); // Set PA0 High (go signal)
+}
+
+/**
+ * @brief State 4: guided motor calibration; ENTER confirms each motor has started spinning
+ */
+static void MainLoop_Calibrate(void)
+{
+    Battery_Update();
+    if (ESCCal_Step(dumpFlag)) {
+        state = 1;
+    }
+    dumpFlag = 0;
+}
+
+void MainLoop_Step(void)
+{
+    Watchdog_Kick(state == 2 || state == 4); // Refreshes the IWDG; the loop deadline applies whenever motors can spin
+    FastLink_Service(); // Restarts the USART1 DMA if it went idle with data queued
+
+    if (linkMavlink) { // Telemetry and parameter replies, one frame per loop at most
+        Trace_Begin(TRACE_MAV);
+        MAV_Service();
+        Trace_End(TRACE_MAV);
+    }
+
+    switch (state) {
+    case 0: MainLoop_BringUp(); break;
+    case 1: MainLoop_Disarmed(); break;
+    case 2: MainLoop_Flying(); break;
+    case 3: MainLoop_Dump(); break;
+    case 4: MainLoop_Calibrate(); break;
+    default: break;
+    }
+}
+
+/**
+  * @brief  This function is used to send printf() statments to the HC-05 link UART
+  *
+  * @details With MAVLink on the link, MAV_Service() owns USART2 and sends
+  *          with HAL_UART_Transmit_IT(); a blocking transmit on the same
+  *          handle would fail while a frame is in flight and put text into
+  *          the MAVLink stream. printf() then goes to the USART1 fast
+  *          channel instead, where fastrx shows it as console output.
+  * @retval None
+  */
+int __io_putchar(int ch) {
+    uint8_t c = (uint8_t)ch;
+
+    if (linkMavlink) {
+        FastLink_SendWait(&c, 1);
+    } else {
+        HAL_UART_Transmit(&huart2, &c, 1, HAL_MAX_DELAY);
+    }
+    return ch;
+}
@@ -0,0 +1,301 @@
+/**
+  ******************************************************************************
+  * @file    Params.c
+  * @author  Aaron Lubinsky
+  * @brief   Wear-leveled, append-only parameter store in flash
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Flash sectors 6 and 7 (128 KB each) are used as a pair. Each
+  *          sector starts with a header slot followed by 8-byte records:
+  *
+  *            word 0: key (bits 15:0) | CRC-16 of key and value (bits 31:16)
+  *            word 1: value
+  *
+  *          Header slot: word 0 = 0x5052 << 16 | PARAM_VERSION,
+  *                       word 1 = sequence number (newest sector wins).
+  *
+  *          A change is one appended record, so each slot is programmed once
+  *          and erases only happen on compaction. When the active sector's
+  *          first PARAM_MAX_RECORDS slots are used, every current value is
+  *          copied into the other sector and its header is programmed last,
+  *          so a reset mid-compaction leaves the old sector in charge.
+  *
+  *          Boot load binary-searches for the first blank slot, then walks
+  *          backwards taking the first record with a good CRC for each key and
+  *          stops once every key is found. Only accepted records are CRC'd,
+  *          so a full 2048-slot scan is well under a millisecond.
+  *
+  ******************************************************************************
+  ==============================================================================
+                        ##### How to use this driver #####
+  ==============================================================================
+  1. Call Param_Load() once at boot, before the values are used
+  2. Call Param_Set() to change a value; it persists across resets
+  3. Keep code and constants out of sectors 6-7 (see STM32F411CEUX_FLASH.ld)
+
+  @warning Param_Set() can erase a sector; only call it while disarmed
+  */
+
+#include "Params.h"
+#include "stm32f4xx_hal.h"   // Needed for HAL flash driver
+#include <stddef.h>
+
+#define PARAM_MAGIC   ((0x5052UL << 16) | PARAM_VERSION) ///< Header word 0
+#define PARAM_BLANK   0xFFFFFFFFUL                     ///< Erased flash word
+
+/* External Tunables */
+extern int32_t Kp_roll, Ki_roll, Kd_roll;
+extern int32_t Kp_pitch, Ki_pitch, Kd_pitch;
+extern int32_t Kp_yaw, Ki_yaw, Kd_yaw;
+extern int32_t K_effort;
+extern int max_integral;
+extern int motA_offset, motB_offset, motC_offset, motD_offset;
+extern int blackboxFreq;
+extern int effortRate;
+extern int btBaud;
+extern int linkMavlink;
+extern int attSource;
+extern int flightMode, rateMax, rateYawMax, rateExpo;
+extern int32_t Kp_rate, Ki_rate, Kd_rate, Kp_rate_yaw, Ki_rate_yaw;
+extern int gainSched;
+extern int ctrlLaw;
+
+/**
+ * @brief Where each parameter lives in RAM, indexed by ParamKey
+ */
+typedef struct {
+    const char *name; ///< Short name (≤16 chars, MAVLink param_id compatible)
+    int32_t *value;   ///< RAM variable the value is loaded into
+} ParamEntry;
+
+static const ParamEntry paramTable[PARAM_COUNT] = {
+    [PARAM_KP_ROLL]       = {"KP_ROLL",      (int32_t *)&Kp_roll},
+    [PARAM_KI_ROLL]       = {"KI_ROLL",      (int32_t *)&Ki_roll},
+    [PARAM_KD_ROLL]       = {"KD_ROLL",      (int32_t *)&Kd_roll},
+    [PARAM_KP_PITCH]      = {"KP_PITCH",     (int32_t *)&Kp_pitch},
+    [PARAM_KI_PITCH]      = {"KI_PITCH",     (int32_t *)&Ki_pitch},
+    [PARAM_KD_PITCH]      = {"KD_PITCH",     (int32_t *)&Kd_pitch},
+    [PARAM_KP_YAW]        = {"KP_YAW",       (int32_t *)&Kp_yaw},
+    [PARAM_KI_YAW]        = {"KI_YAW",       (int32_t *)&Ki_yaw},
+    [PARAM_KD_YAW]        = {"KD_YAW",       (int32_t *)&Kd_yaw},
+    [PARAM_K_EFFORT]      = {"K_EFFORT",     (int32_t *)&K_effort},
+    [PARAM_MAX_INTEGRAL]  = {"MAX_INTEGRAL", (int32_t *)&max_integral},
+    [PARAM_MOTA_OFFSET]   = {"MOTA_OFFSET",  (int32_t *)&motA_offset},
+    [PARAM_MOTB_OFFSET]   = {"MOTB_OFFSET",  (int32_t *)&motB_offset},
+    [PARAM_MOTC_OFFSET]   = {"MOTC_OFFSET",  (int32_t *)&motC_offset},
+    [PARAM_MOTD_OFFSET]   = {"MOTD_OFFSET",  (int32_t *)&motD_offset},
+    [PARAM_BLACKBOX_FREQ] = {"BLACKBOX_FREQ",(int32_t *)&blackboxFreq},
+    [PARAM_EFFORT_RATE]   = {"EFFORT_RATE",  (int32_t *)&effortRate},
+    [PARAM_BT_BAUD]       = {"BT_BAUD",      (int32_t *)&btBaud},
+    [PARAM_LINK_MAVLINK]  = {"LINK_MAVLINK", (int32_t *)&linkMavlink},
+    [PARAM_ATT_SOURCE]    = {"ATT_SOURCE",   (int32_t *)&attSource},
+    [PARAM_FLIGHT_MODE]   = {"FLIGHT_MODE",  (int32_t *)&flightMode},
+    [PARAM_RATE_MAX]      = {"RATE_MAX",     (int32_t *)&rateMax},
+    [PARAM_RATE_YAW_MAX]  = {"RATE_YAW_MAX", (int32_t *)&rateYawMax},
+    [PARAM_RATE_EXPO]     = {"RATE_EXPO",    (int32_t *)&rateExpo},
+    [PARAM_KP_RATE]       = {"KP_RATE",      (int32_t *)&Kp_rate},
+    [PARAM_KI_RATE]       = {"KI_RATE",      (int32_t *)&Ki_rate},
+    [PARAM_KD_RATE]       = {"KD_RATE",      (int32_t *)&Kd_rate},
+    [PARAM_KP_RATE_YAW]   = {"KP_RATE_YAW",  (int32_t *)&Kp_rate_yaw},
+    [PARAM_KI_RATE_YAW]   = {"KI_RATE_YAW",  (int32_t *)&Ki_rate_yaw},
+    [PARAM_GAIN_SCHED]    = {"GAIN_SCHED",   (int32_t *)&gainSched},
+    [PARAM_CTRL_LAW]      = {"CTRL_LAW",     (int32_t *)&ctrlLaw},
+};
+
+uint32_t paramLoadUs = 0;        ///< Time the last Param_Load() took (µs)
+
+static uint32_t paramBase = 0;   ///< Active sector address, 0 if none
+static uint32_t paramSeq = 0;    ///< Active sector sequence number
+static uint32_t paramNext = 0;   ///< First blank slot in the active sector
+
+/**
+ * @brief Word at a record slot (word = 0 or 1)
+ */
+static inline uint32_t Param_Word(uint32_t base, uint32_t slot, uint32_t word)
+{
+    return *(volatile const uint32_t *)(uintptr_t)(base + slot * 8U + word * 4U);
+}
+
+/**
+ * @brief CRC-16/CCITT over a key and value
+ */
+static uint16_t Param_CRC(uint16_t key, int32_t value)
+{
+    uint8_t bytes[6] = {
+        (uint8_t)key, (uint8_t)(key >> 8),
+        (uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24)
+    };
+    uint16_t crc = 0xFFFF;
+
+    for (int i = 0; i < 6; i++) {
+        crc ^= (uint16_t)bytes[i] << 8;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/**
+ * @brief Sequence number of a sector, or 0 if its header is missing or stale
+ */
+static uint32_t Param_SectorSeq(uint32_t base)
+{
+    uint32_t seq = Param_Word(base, 0, 1);
+
+    if (Param_Word(base, 0, 0) != PARAM_MAGIC || seq == PARAM_BLANK) return 0;
+    return seq;
+}
+
+/**
+ * @brief First blank slot of a sector (binary search; slots fill in order)
+ */
+static uint32_t Param_FindNext(uint32_t base)
+{
+    uint32_t lo = 1, hi = PARAM_MAX_RECORDS;
+
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (Param_Word(base, mid, 0) == PARAM_BLANK && Param_Word(base, mid, 1) == PARAM_BLANK) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+#ifdef __arm__
+/**
+ * @brief Programs one record slot; value first so a torn write never looks valid
+ */
+static int Param_Program(uint32_t base, uint32_t slot, uint32_t word0, uint32_t word1)
+{
+    uint32_t addr = base + slot * 8U;
+
+    if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr + 4U, word1) != HAL_OK) return -1;
+    if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr, word0) != HAL_OK) return -1;
+    return 0;
+}
+
+/**
+ * @brief Copies every current value into the inactive sector and switches to it
+ *
+ * @return 0 on success, -1 on a flash error (the old sector stays active)
+ */
+static int Param_Compact(void)
+{
+    FLASH_EraseInitTypeDef erase = {0};
+    uint32_t sectorError = 0;
+    uint32_t base = (paramBase == PARAM_ADDR_A) ? PARAM_ADDR_B : PARAM_ADDR_A;
+
+    erase.TypeErase = FLASH_TYPEERASE_SECTORS;
+    erase.Sector = (base == PARAM_ADDR_A) ? PARAM_SECTOR_A : PARAM_SECTOR_B;
+    erase.NbSectors = 1;
+    erase.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+    if (HAL_FLASHEx_Erase(&erase, &sectorError) != HAL_OK) return -1;
+
+    for (uint32_t k = 0; k < PARAM_COUNT; k++) {
+        int32_t v = *paramTable[k].value;
+        if (Param_Program(base, k + 1, ((uint32_t)Param_CRC(k, v) << 16) | k, (uint32_t)v) != 0) return -1;
+    }
+
+    // Header last: until it is written the old sector remains the newest
+    if (Param_Program(base, 0, PARAM_MAGIC, paramSeq + 1) != 0) return -1;
+
+    paramBase = base;
+    paramSeq++;
+    paramNext = PARAM_COUNT + 1;
+    return 0;
+}
+#endif
+
+/**
+ * @brief Loads the newest stored value of every parameter into RAM
+ *
+ * @details Picks the sector with the higher valid sequence number, finds its
+ *          write frontier and walks backwards. Parameters with no valid record
+ *          keep their compiled-in default. Also records how long it took in
+ *          paramLoadUs, so main() starts the DWT cycle counter first.
+ */
+void Param_Load(void)
+{
+    uint32_t seqA, seqB, found = 0;
+    uint32_t seen = 0; // Bit per key
+    uint32_t start;
+
+    start = DWT->CYCCNT;
+
+    seqA = Param_SectorSeq(PARAM_ADDR_A);
+    seqB = Param_SectorSeq(PARAM_ADDR_B);
+    if (seqA == 0 && seqB == 0) {
+        paramBase = 0; // Nothing stored yet: defaults stand
+        paramSeq = 0;
+    } else {
+        paramBase = (seqA >= seqB) ? PARAM_ADDR_A : PARAM_ADDR_B;
+        paramSeq = (seqA >= seqB) ? seqA : seqB;
+        paramNext = Param_FindNext(paramBase);
+
+        for (uint32_t slot = paramNext - 1; slot >= 1 && found < PARAM_COUNT; slot--) {
+            uint32_t w0 = Param_Word(paramBase, slot, 0);
+            uint32_t key = w0 & 0xFFFF;
+            int32_t value;
+
+            if (key >= PARAM_COUNT || (seen & (1UL << key))) continue;
+            value = (int32_t)Param_Word(paramBase, slot, 1);
+            if ((w0 >> 16) != Param_CRC(key, value)) continue; // Torn or corrupt, try an older one
+
+            *paramTable[key].value = value;
+            seen |= 1UL << key;
+            found++;
+        }
+    }
+
+    paramLoadUs = (DWT->CYCCNT - start) / (SystemCoreClock / 1000000U);
+}
+
+/**
+ * @brief Sets a parameter in RAM and appends it to flash
+ *
+ * @details Compacts into the other sector first when the active one is full
+ *          (or when nothing has been stored yet). Writing the same value again
+ *          is skipped so repeated saves do not wear the flash.
+ */
+int Param_Set(ParamKey key, int32_t value)
+{
+    int status = 0;
+
+    if ((uint32_t)key >= PARAM_COUNT) return -1;
+    if (paramBase != 0 && *paramTable[key].value == value) return 0;
+    *paramTable[key].value = value;
+
+#ifdef __arm__ // The host tools have no flash: the value lives in RAM only
+    HAL_FLASH_Unlock();
+    __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR |
+                           FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+
+    if (paramBase == 0 || paramNext >= PARAM_MAX_RECORDS) {
+        status = Param_Compact(); // The new value is copied with the rest
+    } else {
+        status = Param_Program(paramBase, paramNext,
+                               ((uint32_t)Param_CRC(key, value) << 16) | key, (uint32_t)value);
+        paramNext++;
+    }
+
+    HAL_FLASH_Lock();
+#endif
+    return status;
+}
+
+int32_t Param_Get(ParamKey key)
+{
+    if ((uint32_t)key >= PARAM_COUNT) return 0;
+    return *paramTable[key].value;
+}
+
+const char *Param_Name(ParamKey key)
+{
+    if ((uint32_t)key >= PARAM_COUNT) return NULL;
+    return paramTable[key].name;
+}
@@ -0,0 +1,74 @@
+/**
+  ******************************************************************************
+  * @file    RateMode.c
+  * @author  Aaron Lubinsky
+  * @brief   Rate (acro) flight mode stick shaping
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Maps stick deflections to body-rate setpoints through an expo
+  *          curve. The rate controller itself is in update_Motors(), which
+  *          picks the rate or angle errors by flightMode, and the gyro is
+  *          read by BNO_ReadRates(). Integer only; a setpoint is two
+  *          multiplies and two divides per axis, once per link frame.
+  *
+  ******************************************************************************
+  ==============================================================================
+                        ##### How to use this driver #####
+  ==============================================================================
+  1. Set FLIGHT_MODE to 1 (disarmed) to fly in rate mode; RATE_MAX,
+     RATE_YAW_MAX and RATE_EXPO shape the sticks, KP_RATE/KI_RATE/KD_RATE
+     and KP_RATE_YAW/KI_RATE_YAW are the rate loop gains
+  2. The link parsers call Rate_Sticks() with every frame
+  3. In state 2, main reads BNO_ReadRates() instead of BNO_Read()
+
+  @warning Rate mode does not self-level: with the sticks centred the drone
+           holds whatever attitude it has. Fly angle mode until the rate
+           gains are tuned (see Tools/Sim/ratestep.c)
+  */
+
+#include "RateMode.h"
+#include "RamFunc.h"
+
+/* Stored Parameters */
+int flightMode = FLIGHT_MODE_ANGLE; ///< Angle mode unless FLIGHT_MODE says otherwise
+int rateMax = 360;                  ///< One roll per second at full stick
+int rateYawMax = 180;               ///< Yaw rate at full stick (deg/s)
+int rateExpo = 50;                  ///< Half linear, half cubic
+
+/* External Rate Setpoints */
+extern int32_t roll_rate_set, pitch_rate_set, yaw_rate_set; ///< millidegrees/s
+
+/**
+ * @brief Expo-shaped rate for a stick deflection
+ *
+ * @param stick  Deflection, ±RATE_STICK_MAX
+ * @param maxDps Rate at full deflection (deg/s)
+ * @return Rate setpoint in millidegrees/s
+ *
+ * @details The cube is taken in thousandths of full stick, so every
+ *          intermediate stays below 10^6 and the result below
+ *          RATE_STICK_MAX * maxDps.
+ */
+RAMFUNC int32_t Rate_Expo(int32_t stick, int32_t maxDps)
+{
+    int32_t cube, shaped;
+
+    if (stick > RATE_STICK_MAX) stick = RATE_STICK_MAX;
+    if (stick < -RATE_STICK_MAX) stick = -RATE_STICK_MAX;
+
+    cube = stick * stick / RATE_STICK_MAX * stick / RATE_STICK_MAX;
+    shaped = (stick * (100 - rateExpo) + cube * rateExpo) / 100;
+
+    return shaped * maxDps; // 1000 stick counts = maxDps deg/s = maxDps * 1000 mdeg/s
+}
+
+/**
+ * @brief Stores the shaped rate setpoints for update_Motors()
+ */
+RAMFUNC void Rate_Sticks(int32_t roll, int32_t pitch, int32_t yaw)
+{
+    roll_rate_set = Rate_Expo(roll, rateMax);
+    pitch_rate_set = Rate_Expo(pitch, rateMax);
+    yaw_rate_set = Rate_Expo(yaw, rateYawMax);
+}
@@ -0,0 +1,82 @@
+/**
+  ******************************************************************************
+  * @file    StackMon.c
+  * @author  Aaron Lubinsky
+  * @brief   Stack painting and per-context stack high-water marks
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Everything runs on the one MSP stack that grows down from _estack
+  *          towards the newlib heap (see sysmem.c). StackMon_Paint() fills
+  *          the gap with STACK_PAINT; StackMon_Peak() scans up from the heap
+  *          end for the first overwritten word. That figure is exact but does
+  *          not say which context caused it.
+  *
+  *          For the breakdown, StackMon_Mark() keeps the lowest frame address
+  *          seen per context. Marks sit at every interrupt entry (the depth of
+  *          whatever was interrupted) and in the deepest user routines of each
+  *          context, so they slightly under-read the HAL and libc frames
+  *          below them; the painted peak bounds the total.
+  *
+  ******************************************************************************
+  ==============================================================================
+                        ##### How to use this driver #####
+  ==============================================================================
+  1. Call StackMon_Paint() at the top of main(), before HAL_Init()
+  2. Call StackMon_Mark(ctx) at interrupt entry and in deep routines
+  3. Read StackMon_Peak() / StackMon_Free() / StackMon_CtxPeak() at a low rate
+
+  @note _Min_Stack_Size in the linker script is only a link-time check; the
+        stack really has all of the space the heap does not use
+  */
+
+#include "StackMon.h"
+#include <stddef.h>
+
+extern uint8_t _estack;                 ///< Top of RAM / initial MSP (linker script)
+extern void *_sbrk(ptrdiff_t incr);     ///< newlib heap (sysmem.c)
+
+uintptr_t stackMinSP[STACK_CTX_COUNT];  ///< Lowest frame address seen per context
+
+uintptr_t StackMon_HeapEnd(void)
+{
+    return ((uintptr_t)_sbrk(0) + 3U) & ~(uintptr_t)3U;
+}
+
+void StackMon_Paint(void)
+{
+    uint32_t *p = (uint32_t *)StackMon_HeapEnd();
+    uint32_t *limit = (uint32_t *)__builtin_frame_address(0) - 16; // Stay clear of our own frame
+
+    while (p < limit) *p++ = STACK_PAINT;
+
+    for (int i = 0; i < STACK_CTX_COUNT; i++) stackMinSP[i] = (uintptr_t)&_estack;
+}
+
+/**
+ * @brief Lowest word the stack has overwritten
+ */
+static uint32_t *StackMon_LowWater(void)
+{
+    uint32_t *p = (uint32_t *)StackMon_HeapEnd();
+    uint32_t *top = (uint32_t *)&_estack;
+
+    while (p < top && *p == STACK_PAINT) p++;
+    return p;
+}
+
+uint32_t StackMon_Peak(void)
+{
+    return (uint32_t)((uintptr_t)&_estack - (uintptr_t)StackMon_LowWater());
+}
+
+uint32_t StackMon_Free(void)
+{
+    return (uint32_t)((uintptr_t)StackMon_LowWater() - StackMon_HeapEnd());
+}
+
+uint32_t StackMon_CtxPeak(StackCtx ctx)
+{
+    if ((unsigned)ctx >= STACK_CTX_COUNT) return 0;
+    return (uint32_t)((uintptr_t)&_estack - stackMinSP[ctx]);
+}
@@ -0,0 +1,80 @@
+/**
+  ******************************************************************************
+  * @file    Trace.c
+  * @author  Aaron Lubinsky
+  * @brief   Event trace ring and its console dump
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Trace_Begin()/Trace_End() (Trace.h) claim the next ring slot with
+  *          an atomic increment and stamp it with the DWT cycle counter and
+  *          the active exception number, so the main loop and every ISR can
+  *          record without locking. The ring overwrites its oldest entries;
+  *          at about eight events per millisecond in flight it holds the last
+  *          quarter second or so.
+  *
+  *          The dump is plain text on the USART1 fast channel (FastLink.c),
+  *          away from the HC-05 link:
+  *
+  *            # trace <events> <cycles per second>
+  *            <cycles>,<id>,<B|E>,<ctx>
+  *            ...
+  *            # end
+  *
+  *          Tools/trace2json reads a capture of it and writes Chrome trace
+  *          JSON for chrome://tracing or ui.perfetto.dev.
+  *
+  ******************************************************************************
+  ==============================================================================
+                        ##### How to use this driver #####
+  ==============================================================================
+  1. Wrap spans in Trace_Begin(TRACE_x) / Trace_End(TRACE_x); new spans get
+     an entry in TRACE_IDS
+  2. Call Trace_Dump() from the main loop when the pilot requests a dump
+  3. Capture USART1 to a file and run Tools/build/trace2json on it
+
+  @note Set TRACE_ENABLED to 0 to remove every trace point from the build
+  */
+
+#include "Trace.h"
+#include "Watchdog.h"
+#include "FastLink.h"
+#include "stm32f4xx_hal.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+TraceEvent traceRing[TRACE_EVENTS];
+volatile uint32_t traceHead = 0;
+volatile int traceOn = TRACE_ENABLED;
+
+static void Trace_Print(const char *line)
+{
+    FastLink_SendWait(line, (uint16_t)strlen(line));
+}
+
+void Trace_Dump(void)
+{
+    char line[48];
+    uint32_t head, count;
+
+    traceOn = 0;
+    head = traceHead;
+    count = (head < TRACE_EVENTS) ? head : TRACE_EVENTS;
+
+    snprintf(line, sizeof(line), "# trace %" PRIu32 " %" PRIu32 "\r\n", count, SystemCoreClock);
+    Trace_Print(line);
+
+    for (uint32_t i = head - count; i != head; i++) {
+        const TraceEvent *e = &traceRing[i & (TRACE_EVENTS - 1)];
+        snprintf(line, sizeof(line), "%" PRIu32 ",%u,%c,%u\r\n", e->cycles, e->id, e->phase, e->ctx);
+        Trace_Print(line);
+        if ((i & 63) == 0) {
+            Watchdog_Kick(0); // The whole ring takes about half a second
+        }
+    }
+    Trace_Print("# end\r\n");
+
+    traceHead = 0;
+    traceOn = TRACE_ENABLED;
+}
@@ -0,0 +1,135 @@
+/**
+  ******************************************************************************
+  * @file    Watchdog.c
+  * @author  Aaron Lubinsky
+  * @brief   Main loop deadline monitor, overrun statistics and IWDG backstop
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Two layers, both fed by the one Watchdog_Kick() per loop:
+  *
+  *          - Deadline: SysTick runs at the lowest priority, so it still gets
+  *            in while the main loop is stuck in a polled HAL call (a BNO055
+  *            read can block for its full 100 ms I2C timeout). If the flight
+  *            loop has not checked in for WDG_DEADLINE_MS it writes the
+  *            minimum compare to all four ESCs and latches wdgSafe, which
+  *            update_Motors() honours like a throttle cut. The latch clears
+  *            once the loop has been on time for WDG_RECOVER_MS and the pilot
+  *            has brought effort_set back to zero, so the motors never jump
+  *            back to the old throttle by themselves.
+  *
+  *          - IWDG: resets the MCU if the loop stops checking in for about
+  *            4 s in any state, e.g. a hard fault loop or an interrupt storm
+  *            that starves SysTick too. It runs from the LSI, so it also
+  *            survives a clock failure. Long enough for a flash sector erase
+  *            in Param_Set(); the WWDG tops out near 42 ms at this PCLK1 and
+  *            could not be fed through one.
+  *
+  *          The flight loop iteration is timed with the DWT cycle counter:
+  *          loopUs, the worst case loopUsMax and loopOverruns against the
+  *          WDG_LOOP_US budget.
+  *
+  ******************************************************************************
+  ==============================================================================
+                        ##### How to use this driver #####
+  ==============================================================================
+  1. Call Watchdog_Init() once after the peripherals are initialized
+  2. Call Watchdog_Kick(state == flying) at the top of every main loop
+     iteration, and Watchdog_Kick(false) inside long blocking transfers
+  3. Call Watchdog_Tick() from SysTick_Handler()
+
+  @note The HAL IWDG driver is not part of this project; the handful of
+        register writes it would wrap are done directly
+  @note IWDG is frozen while the core is halted by the debugger
+  */
+
+#include "Watchdog.h"
+#include "ESC.h"
+#include "RamFunc.h"
+#include "stm32f4xx_hal.h"
+
+#define IWDG_KEY_RELOAD 0xAAAAU ///< Refresh the counter
+#define IWDG_KEY_ENABLE 0xCCCCU ///< Start the watchdog (and the LSI)
+#define IWDG_KEY_ACCESS 0x5555U ///< Unlock PR and RLR
+
+extern TIM_HandleTypeDef htim3;
+extern int32_t effort_set;
+
+volatile int wdgSafe = false;
+uint32_t wdgTrips = 0;
+int wdgReset = false;
+uint32_t loopUs = 0;
+uint32_t loopUsMax = 0;
+uint32_t loopOverruns = 0;
+
+static volatile uint32_t kickTick = 0; ///< HAL tick of the last check-in
+static volatile int armed = false;     ///< Deadline enforced (last check-in was in flight)
+static uint32_t kickCycles = 0;        ///< DWT count at the last flight check-in
+static volatile uint32_t lateTick = 0; ///< HAL tick of the last overrun or missed deadline
+
+void Watchdog_Init(void)
+{
+    wdgReset = (RCC->CSR & RCC_CSR_IWDGRSTF) != 0;
+    RCC->CSR |= RCC_CSR_RMVF; // Clear the reset flags for next time
+
+    DBGMCU->APB1FZ |= DBGMCU_APB1_FZ_DBG_IWDG_STOP;
+
+    IWDG->KR = IWDG_KEY_ENABLE;
+    IWDG->KR = IWDG_KEY_ACCESS;
+    IWDG->PR = WDG_IWDG_PR;
+    IWDG->RLR = WDG_IWDG_RLR;
+    while (IWDG->SR != 0) {} // PR/RLR cross into the LSI domain
+    IWDG->KR = IWDG_KEY_RELOAD;
+
+    kickTick = HAL_GetTick();
+}
+
+RAMFUNC void Watchdog_Kick(int flying)
+{
+    uint32_t now = HAL_GetTick();
+
+    IWDG->KR = IWDG_KEY_RELOAD;
+
+    if (flying) {
+        uint32_t cycles = DWT->CYCCNT;
+        if (armed) {
+            loopUs = (cycles - kickCycles) / (SystemCoreClock / 1000000U);
+            if (loopUs > loopUsMax) {
+                loopUsMax = loopUs;
+            }
+            if (loopUs > WDG_LOOP_US) {
+                loopOverruns++;
+                lateTick = now;
+            }
+        }
+        kickCycles = cycles;
+    }
+
+    if (wdgSafe && now - lateTick >= WDG_RECOVER_MS && effort_set == 0) {
+        wdgSafe = false;
+    }
+
+    kickTick = now;
+    armed = flying;
+}
+
+RAMFUNC void Watchdog_Tick(void)
+{
+    uint32_t now = HAL_GetTick();
+
+    if (!armed || now - kickTick < WDG_DEADLINE_MS) {
+        return;
+    }
+
+    if (!wdgSafe) {
+        wdgSafe = true;
+        wdgTrips++;
+    }
+    lateTick = now;
+
+    // Repeated every tick the loop stays late
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_1, ESC_CMD_MIN);
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_2, ESC_CMD_MIN);
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_3, ESC_CMD_MIN);
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_4, ESC_CMD_MIN);
+}
@@ -23,9 +23,24 @@
 /* USER CODE BEGIN Includes */
 #include <unistd.h>
 #include <string.h>
+#include <inttypes.h>
 #include "BNO055.h"
 #include "HC05.h"
 #include "ESC.h"
+#include "Battery.h"
+#include "ESCCal.h"
+#include "Params.h"
+#include "MAVLink.h"
+#include "RamFunc.h"
+#include "StackMon.h"
+#include "Watchdog.h"
+#include "Trace.h"
+#include "Latency.h"
+#include "FastLink.h"
+#include "RateMode.h"
+#include "LQR.h"
+#include "FastIO.h"
+#include "MainLoop.h"
 
 //#include "HC05.h"
 /* USER CODE END Includes */
@@ -40,8 +55,6 @@
 #define PID_SCALE 100000 //100,000 allow us to use ints, not floats for Kp of 1.1 --> 1,100_000
 #define true 1
 #define false 0
-#define BT_MSG_LEN 37
-//#define BT_MSG_LEN 2
 
 /* USER CODE END PD */
 
@@ -59,6 +72,7 @@ TIM_HandleTypeDef htim3;
 UART_HandleTypeDef huart1;
 UART_HandleTypeDef huart2;
 DMA_HandleTypeDef hdma_usart2_rx;
+DMA_HandleTypeDef hdma_usart1_tx;
 
 /* USER CODE BEGIN PV */
 UART_HandleTypeDef *BT_UART_ptr = &huart2;
@@ -69,6 +83,8 @@ volatile int imu_request = 0;
 int state = 0;
 int32_t roll_set, pitch_set, yaw_set, effort_set;                // from user control
 int32_t roll_true, pitch_true, yaw_true;             // from IMU
+int32_t roll_rate_set, pitch_rate_set, yaw_rate_set; // rate mode, from user control (mdeg/s)
+int32_t roll_rate, pitch_rate, yaw_rate;             // rate mode, from the gyro (mdeg/s)
 int32_t roll_effort, pitch_effort, yaw_effort;
 int stopFlag = false; //triggered when effortSet is 0
 
@@ -95,9 +111,15 @@ int32_t Kp_yaw  =0;
 int32_t Ki_yaw = 0;
 int32_t Kd_yaw = 0;
 
+// Rate mode (errors in mdeg/s)
+int32_t Kp_rate = 250;
+int32_t Ki_rate = 20;
+int32_t Kd_rate = 0;
+int32_t Kp_rate_yaw = 500;
+int32_t Ki_rate_yaw = 20;
+
 
 //BT
-uint8_t BT_RxBuf[BT_MSG_LEN];
 int     dumpFlag = 0;
 
 //IMU
@@ -135,7 +157,7 @@ int main(void)
 {
 
   /* USER CODE BEGIN 1 */
-
+  StackMon_Paint(); //must run before anything deepens the stack
   /* USER CODE END 1 */
 
   /* MCU Configuration--------------------------------------------------------*/
@@ -151,7 +173,9 @@ int main(void)
   SystemClock_Config();
 
   /* USER CODE BEGIN SysInit */
-
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; // DWT cycle counter: loop deadline, trace, latency and bench timing
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  Param_Load(); // Stored tunables override the defaults below before anything uses them
   /* USER CODE END SysInit */
 
   /* Initialize all configured peripherals */
@@ -164,6 +188,9 @@ int main(void)
   MX_I2C3_Init();
 
   /* USER CODE BEGIN 2 */
+  Battery_Init();
+  FastIO_Init(); // LL fast path takes over the USART1 TX DMA stream
+  Watchdog_Init(); // From here the loop must check in at least every few seconds
 
   /* USER CODE END 2 */
 
@@ -171,44 +198,7 @@ int main(void)
   /* USER CODE BEGIN WHILE */
   while (1)
   {
-	 if (state == 0){
-		 //configure_HC05();
-		 BNO_Init();
-		 state = 1;
-
-	 }else if (state == 1){
-		 HAL_UART_Receive_DMA(&huart2, BT_RxBuf, BT_MSG_LEN-1); //allow for DMA Callback
-
-		 		 stopFlag = true;
-		 if (roll_set < -10000){
-			 armESC();
-			 state = 2;
-		 }
-		 effort_set = 0;
-
-	 }else if(state == 2){ //State 2 is operation (flying) mode where the drone reads the BNO, updates motor PWM to the latest bluetooth DMA
-		  BNO_Read(&roll_true, &pitch_true, &yaw_true);
-		  update_Motors();
-		  if (dumpFlag == 1){
-		  			effort_set = 0;
-		  			state = 3;
-		  		 }
-
-
-	 }else if(state == 3){//This state is triggered by user input. It sends blackBox data then returns to state 2
-		 	dumpBlackbox();
-		 	dumpFlag = 0;
-		 	HAL_UART_Receive_DMA(&huart2, BT_RxBuf, BT_MSG_LEN-1);
-		 	state = 2;
-		 	effort_set = 0;
-		 	HAL_GPIO_WritePin(GPIOA, GPIO_PIN_1, GPIO_PIN_SET);   // Set PA0 High (go signal)
-
-
- }
-
-
-
-
+	 MainLoop_Step(); //One pass of the state machine (MainLoop.c)
 	  }//while loop close
 
 
@@ -414,7 +404,7 @@ static void MX_USART1_UART_Init(void)
 
   /* USER CODE END USART1_Init 1 */
   huart1.Instance = USART1;
-  huart1.Init.BaudRate = 115200;
+  huart1.Init.BaudRate = 921600;
   huart1.Init.WordLength = UART_WORDLENGTH_8B;
   huart1.Init.StopBits = UART_STOPBITS_1;
   huart1.Init.Parity = UART_PARITY_NONE;
@@ -459,7 +449,13 @@ static void MX_USART2_UART_Init(void)
     Error_Handler();
   }
   /* USER CODE BEGIN USART2_Init 2 */
-
+  if (btBaud != 9600 && btBaud > 0) {
+    huart2.Init.BaudRate = btBaud; // Stored HC-05 rate
+    if (HAL_UART_Init(&huart2) != HAL_OK)
+    {
+      Error_Handler();
+    }
+  }
   /* USER CODE END USART2_Init 2 */
 
 }
@@ -472,11 +468,15 @@ static void MX_DMA_Init(void)
 
   /* DMA controller clock enable */
   __HAL_RCC_DMA1_CLK_ENABLE();
+  __HAL_RCC_DMA2_CLK_ENABLE();
 
   /* DMA interrupt init */
   /* DMA1_Stream5_IRQn interrupt configuration */
   HAL_NVIC_SetPriority(DMA1_Stream5_IRQn, 0, 0);
   HAL_NVIC_EnableIRQ(DMA1_Stream5_IRQn);
+  /* DMA2_Stream7_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA2_Stream7_IRQn, 5, 0);
+  HAL_NVIC_EnableIRQ(DMA2_Stream7_IRQn);
 
 }
 
@@ -549,8 +549,11 @@ static void MX_GPIO_Init(void)
   *
   * @retval None
   */
-void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)//should trigger when DMA reads complete message
-{    if (huart->Instance == USART2) {
+RAMFUNC void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)//should trigger when DMA reads complete message
+{    StackMon_Mark(STACK_CTX_LINK_RX);
+    Latency_FrameIn();
+    Trace_Begin(TRACE_LINK_FRAME);
+    if (huart->Instance == USART2) {
         // Null-terminate just in case you're using sscanf or string functions
         BT_RxBuf[BT_MSG_LEN - 1] = '\0';
 
@@ -562,15 +565,40 @@ void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)//should trigger when DMA
         //HAL_UART_Receive_DMA(&huart2, BT_RxBuf, BT_MSG_LEN); //set up this function to run on next BT input
         imu_request = true; //set up IMU to run when interupt exits
         HAL_UART_Receive_DMA(&huart2, BT_RxBuf, BT_MSG_LEN-1); //set up this function to run on next BT input
+        Trace_End(TRACE_LINK_FRAME);
 }
+
 /**
-  * @brief  This function is used to send printf() statments to the ST-Link UART
+  * @brief  Called when UART2 goes idle, fills BT_RxBuf or reaches half of it while the link runs MAVLink.
+  *  Passes the new bytes to the MAVLink parser and restarts reception once it has stopped.
+  *
   * @retval None
   */
-int __io_putchar(int ch) {
-    HAL_UART_Transmit(&huart2, (uint8_t *)&ch, 1, HAL_MAX_DELAY);
-    return ch;
+RAMFUNC void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+	StackMon_Mark(STACK_CTX_LINK_RX);
+	Latency_FrameIn();
+	Trace_Begin(TRACE_LINK_EVENT);
+	if (huart->Instance == USART2) {
+		MAV_Receive(BT_RxBuf, Size);
+		imu_request = true;
+		HC05_LinkStep(BT_RxBuf, BT_MSG_LEN-1); //no-op while the reception is still running
+	}
+	Trace_End(TRACE_LINK_EVENT);
 }
+
+/**
+  * @brief  Called when a USART1 DMA chunk has gone out; queues the next one straight away.
+  *
+  * @retval None
+  */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+	if (huart->Instance == USART1) {
+		FastLink_Service();
+	}
+}
+
 /* USER CODE END 4 */
 
 /**
@@ -22,6 +22,12 @@
 #include "stm32f4xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "RamFunc.h"
+#include "StackMon.h"
+#include "Watchdog.h"
+#include "Trace.h"
+#include "FastIO.h"
+#include "FastLink.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -46,7 +52,12 @@
 
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN PFP */
-
+/* Run the flight-critical handlers from SRAM (the attribute carries over to the definitions below) */
+RAMFUNC void SysTick_Handler(void);
+RAMFUNC void DMA1_Stream5_IRQHandler(void);
+RAMFUNC void USART1_IRQHandler(void);
+RAMFUNC void USART2_IRQHandler(void);
+RAMFUNC void DMA2_Stream7_IRQHandler(void);
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -56,7 +67,9 @@
 
 /* External variables --------------------------------------------------------*/
 extern DMA_HandleTypeDef hdma_usart2_rx;
+extern DMA_HandleTypeDef hdma_usart1_tx;
 extern UART_HandleTypeDef huart1;
+extern UART_HandleTypeDef huart2;
 /* USER CODE BEGIN EV */
 
 /* USER CODE END EV */
@@ -184,10 +197,11 @@ void PendSV_Handler(void)
 void SysTick_Handler(void)
 {
   /* USER CODE BEGIN SysTick_IRQn 0 */
-
+  StackMon_Mark(STACK_CTX_SYSTICK);
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
   /* USER CODE BEGIN SysTick_IRQn 1 */
+  Watchdog_Tick();
 
   /* USER CODE END SysTick_IRQn 1 */
 }
@@ -205,11 +219,12 @@ void SysTick_Handler(void)
 void DMA1_Stream5_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Stream5_IRQn 0 */
-
+  StackMon_Mark(STACK_CTX_LINK_RX);
+  Trace_Begin(TRACE_LINK_DMA);
   /* USER CODE END DMA1_Stream5_IRQn 0 */
   HAL_DMA_IRQHandler(&hdma_usart2_rx);
   /* USER CODE BEGIN DMA1_Stream5_IRQn 1 */
-
+  Trace_End(TRACE_LINK_DMA);
   /* USER CODE END DMA1_Stream5_IRQn 1 */
 }
 
@@ -219,7 +234,7 @@ void DMA1_Stream5_IRQHandler(void)
 void USART1_IRQHandler(void)
 {
   /* USER CODE BEGIN USART1_IRQn 0 */
-
+  StackMon_Mark(STACK_CTX_CONSOLE);
   /* USER CODE END USART1_IRQn 0 */
   HAL_UART_IRQHandler(&huart1);
   /* USER CODE BEGIN USART1_IRQn 1 */
@@ -227,6 +242,39 @@ void USART1_IRQHandler(void)
   /* USER CODE END USART1_IRQn 1 */
 }
 
+/**
+  * @brief This function handles USART2 global interrupt.
+  */
+void USART2_IRQHandler(void)
+{
+  /* USER CODE BEGIN USART2_IRQn 0 */
+  StackMon_Mark(STACK_CTX_LINK_RX);
+  Trace_Begin(TRACE_LINK_UART);
+  /* USER CODE END USART2_IRQn 0 */
+  HAL_UART_IRQHandler(&huart2);
+  /* USER CODE BEGIN USART2_IRQn 1 */
+  Trace_End(TRACE_LINK_UART);
+  /* USER CODE END USART2_IRQn 1 */
+}
+
+/**
+  * @brief This function handles DMA2 stream7 global interrupt.
+  */
+void DMA2_Stream7_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA2_Stream7_IRQn 0 */
+  StackMon_Mark(STACK_CTX_CONSOLE);
+  if (FastIO_TxIRQ()) {
+    FastLink_Service(); // LL fast path: the stream is ours, skip the HAL handler
+    return;
+  }
+  /* USER CODE END DMA2_Stream7_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_usart1_tx);
+  /* USER CODE BEGIN DMA2_Stream7_IRQn 1 */
+
+  /* USER CODE END DMA2_Stream7_IRQn 1 */
+}
+
 /* USER CODE BEGIN 1 */
 
 /* USER CODE END 1 */
@@ -5,37 +5,82 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
+../Core/Src/AngleMath.c \
+../Core/Src/AttEKF.c \
+../Core/Src/Battery.c \
 ../Core/Src/BNO055.c \
 ../Core/Src/ESC.c \
+../Core/Src/ESCCal.c \
+../Core/Src/FastIO.c \
+../Core/Src/FastLink.c \
 ../Core/Src/HC05.c \
+../Core/Src/Latency.c \
+../Core/Src/LQR.c \
 ../Core/Src/main.c \
+../Core/Src/MainLoop.c \
+../Core/Src/MAVLink.c \
+../Core/Src/Params.c \
+../Core/Src/RateMode.c \
+../Core/Src/StackMon.c \
 ../Core/Src/stm32f4xx_hal_msp.c \
 ../Core/Src/stm32f4xx_it.c \
 ../Core/Src/syscalls.c \
 ../Core/Src/sysmem.c \
-../Core/Src/system_stm32f4xx.c 
+../Core/Src/system_stm32f4xx.c \
+../Core/Src/Trace.c \
+../Core/Src/Watchdog.c 
 
 OBJS += \
+./Core/Src/AngleMath.o \
+./Core/Src/AttEKF.o \
+./Core/Src/Battery.o \
 ./Core/Src/BNO055.o \
 ./Core/Src/ESC.o \
+./Core/Src/ESCCal.o \
+./Core/Src/FastIO.o \
+./Core/Src/FastLink.o \
 ./Core/Src/HC05.o \
+./Core/Src/Latency.o \
+./Core/Src/LQR.o \
 ./Core/Src/main.o \
+./Core/Src/MainLoop.o \
+./Core/Src/MAVLink.o \
+./Core/Src/Params.o \
+./Core/Src/RateMode.o \
+./Core/Src/StackMon.o \
 ./Core/Src/stm32f4xx_hal_msp.o \
 ./Core/Src/stm32f4xx_it.o \
 ./Core/Src/syscalls.o \
 ./Core/Src/sysmem.o \
-./Core/Src/system_stm32f4xx.o 
+./Core/Src/system_stm32f4xx.o \
+./Core/Src/Trace.o \
+./Core/Src/Watchdog.o 
 
 C_DEPS += \
+./Core/Src/AngleMath.d \
+./Core/Src/AttEKF.d \
+./Core/Src/Battery.d \
 ./Core/Src/BNO055.d \
 ./Core/Src/ESC.d \
+./Core/Src/ESCCal.d \
+./Core/Src/FastIO.d \
+./Core/Src/FastLink.d \
 ./Core/Src/HC05.d \
+./Core/Src/Latency.d \
+./Core/Src/LQR.d \
 ./Core/Src/main.d \
+./Core/Src/MainLoop.d \
+./Core/Src/MAVLink.d \
+./Core/Src/Params.d \
+./Core/Src/RateMode.d \
+./Core/Src/StackMon.d \
 ./Core/Src/stm32f4xx_hal_msp.d \
 ./Core/Src/stm32f4xx_it.d \
 ./Core/Src/syscalls.d \
 ./Core/Src/sysmem.d \
-./Core/Src/system_stm32f4xx.d 
+./Core/Src/system_stm32f4xx.d \
+./Core/Src/Trace.d \
+./Core/Src/Watchdog.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -45,7 +90,7 @@ Core/Src/%.o Core/Src/%.su Core/Src/%.cyclo: ../Core/Src/%.c Core/Src/subdir.mk
 clean: clean-Core-2f-Src
 
 clean-Core-2f-Src:
-	-$(RM) ./Core/Src/BNO055.cyclo ./Core/Src/BNO055.d ./Core/Src/BNO055.o ./Core/Src/BNO055.su ./Core/Src/ESC.cyclo ./Core/Src/ESC.d ./Core/Src/ESC.o ./Core/Src/ESC.su ./Core/Src/HC05.cyclo ./Core/Src/HC05.d ./Core/Src/HC05.o ./Core/Src/HC05.su ./Core/Src/main.cyclo ./Core/Src/main.d ./Core/Src/main.o ./Core/Src/main.su ./Core/Src/stm32f4xx_hal_msp.cyclo ./Core/Src/stm32f4xx_hal_msp.d ./Core/Src/stm32f4xx_hal_msp.o ./Core/Src/stm32f4xx_hal_msp.su ./Core/Src/stm32f4xx_it.cyclo ./Core/Src/stm32f4xx_it.d ./Core/Src/stm32f4xx_it.o ./Core/Src/stm32f4xx_it.su ./Core/Src/syscalls.cyclo ./Core/Src/syscalls.d ./Core/Src/syscalls.o ./Core/Src/syscalls.su ./Core/Src/sysmem.cyclo ./Core/Src/sysmem.d ./Core/Src/sysmem.o ./Core/Src/sysmem.su ./Core/Src/system_stm32f4xx.cyclo ./Core/Src/system_stm32f4xx.d ./Core/Src/system_stm32f4xx.o ./Core/Src/system_stm32f4xx.su
+	-$(RM) ./Core/Src/MainLoop.cyclo ./Core/Src/MainLoop.d ./Core/Src/MainLoop.o ./Core/Src/MainLoop.su ./Core/Src/FastIO.cyclo ./Core/Src/FastIO.d ./Core/Src/FastIO.o ./Core/Src/FastIO.su ./Core/Src/LQR.cyclo ./Core/Src/LQR.d ./Core/Src/LQR.o ./Core/Src/LQR.su ./Core/Src/RateMode.cyclo ./Core/Src/RateMode.d ./Core/Src/RateMode.o ./Core/Src/RateMode.su ./Core/Src/AttEKF.cyclo ./Core/Src/AttEKF.d ./Core/Src/AttEKF.o ./Core/Src/AttEKF.su ./Core/Src/FastLink.cyclo ./Core/Src/FastLink.d ./Core/Src/FastLink.o ./Core/Src/FastLink.su ./Core/Src/Latency.cyclo ./Core/Src/Latency.d ./Core/Src/Latency.o ./Core/Src/Latency.su ./Core/Src/Trace.cyclo ./Core/Src/Trace.d ./Core/Src/Trace.o ./Core/Src/Trace.su ./Core/Src/Watchdog.cyclo ./Core/Src/Watchdog.d ./Core/Src/Watchdog.o ./Core/Src/Watchdog.su ./Core/Src/StackMon.cyclo ./Core/Src/StackMon.d ./Core/Src/StackMon.o ./Core/Src/StackMon.su ./Core/Src/MAVLink.cyclo ./Core/Src/MAVLink.d ./Core/Src/MAVLink.o ./Core/Src/MAVLink.su ./Core/Src/Params.cyclo ./Core/Src/Params.d ./Core/Src/Params.o ./Core/Src/Params.su ./Core/Src/ESCCal.cyclo ./Core/Src/ESCCal.d ./Core/Src/ESCCal.o ./Core/Src/ESCCal.su ./Core/Src/AngleMath.cyclo ./Core/Src/AngleMath.d ./Core/Src/AngleMath.o ./Core/Src/AngleMath.su ./Core/Src/Battery.cyclo ./Core/Src/Battery.d ./Core/Src/Battery.o ./Core/Src/Battery.su ./Core/Src/BNO055.cyclo ./Core/Src/BNO055.d ./Core/Src/BNO055.o ./Core/Src/BNO055.su ./Core/Src/ESC.cyclo ./Core/Src/ESC.d ./Core/Src/ESC.o ./Core/Src/ESC.su ./Core/Src/HC05.cyclo ./Core/Src/HC05.d ./Core/Src/HC05.o ./Core/Src/HC05.su ./Core/Src/main.cyclo ./Core/Src/main.d ./Core/Src/main.o ./Core/Src/main.su ./Core/Src/stm32f4xx_hal_msp.cyclo ./Core/Src/stm32f4xx_hal_msp.d ./Core/Src/stm32f4xx_hal_msp.o ./Core/Src/stm32f4xx_hal_msp.su ./Core/Src/stm32f4xx_it.cyclo ./Core/Src/stm32f4xx_it.d ./Core/Src/stm32f4xx_it.o ./Core/Src/stm32f4xx_it.su ./Core/Src/syscalls.cyclo ./Core/Src/syscalls.d ./Core/Src/syscalls.o ./Core/Src/syscalls.su ./Core/Src/sysmem.cyclo ./Core/Src/sysmem.d ./Core/Src/sysmem.o ./Core/Src/sysmem.su ./Core/Src/system_stm32f4xx.cyclo ./Core/Src/system_stm32f4xx.d ./Core/Src/system_stm32f4xx.o ./Core/Src/system_stm32f4xx.su
 
 .PHONY: clean-Core-2f-Src
 
@@ -0,0 +1,116 @@
+/**
+  ******************************************************************************
+  * @file    Plant.c
+  * @author  Aaron Lubinsky
+  * @brief   Quadcopter attitude plant model for host simulation
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Motor layout matches update_Motors(): A front-right, B rear-right,
+  *          C rear-left, D front-left, X configuration. Positive roll torque
+  *          comes from A+B, positive pitch from A+D, positive yaw from B+D,
+  *          so the firmware's sign conventions give negative feedback.
+  *
+  ******************************************************************************
+  */
+
+#include "Plant.h"
+#include <math.h>
+
+#define CMD_IDLE  1000.0 ///< Compare value where the props start producing thrust
+#define CMD_SPAN  700.0  ///< Compare counts from idle to full thrust
+
+void Plant_Defaults(PlantParams *pp)
+{
+    pp->t_max = 8.0;
+    pp->thrust_exp = 2.0;
+    pp->lut_exp = 1.0;
+    pp->tau_motor = 0.03;
+    pp->arm = 0.12;
+    pp->ixx = 0.008;
+    pp->iyy = 0.008;
+    pp->izz = 0.015;
+    pp->k_yaw = 0.016;
+    pp->drag = 0.01;
+    pp->v_nominal = 11.1;
+    pp->v_start = 11.1;
+    pp->v_sag = 0.0;
+    pp->noise_mdeg = 0.0;
+    pp->delay_ticks = 0;
+    pp->gyro_bias[0] = pp->gyro_bias[1] = pp->gyro_bias[2] = 0.0;
+    pp->gyro_noise = 0.0;
+    pp->acc_noise = 0.0;
+    pp->mag_noise = 0.0;
+    pp->raw_hold = 1;
+}
+
+void Plant_Init(PlantState *ps, const PlantParams *pp)
+{
+    ps->roll = ps->pitch = ps->yaw = 0.0;
+    ps->p = ps->q = ps->r = 0.0;
+    for (int i = 0; i < 4; i++) ps->thrust[i] = 0.0;
+    ps->vbat = pp->v_start;
+    ps->dist[0] = ps->dist[1] = ps->dist[2] = 0.0;
+    ps->t = 0.0;
+}
+
+double Plant_Thrust(const PlantParams *pp, uint32_t cmd)
+{
+    double f = ((double)cmd - CMD_IDLE) / CMD_SPAN;
+    if (f <= 0.0) return 0.0;
+    if (f > 1.0) f = 1.0;
+    return pp->t_max * pow(f, pp->thrust_exp / pp->lut_exp);
+}
+
+void Plant_Step(PlantState *ps, const PlantParams *pp, const uint32_t cmd[4], double dt)
+{
+    const double k = 0.70710678 * pp->arm; // Lever arm of an X-frame motor about roll/pitch
+    double vScale = (ps->vbat / pp->v_nominal) * (ps->vbat / pp->v_nominal);
+    double total = 0.0;
+    double tauRoll, tauPitch, tauYaw;
+    double *T = ps->thrust;
+
+    /* ===== MOTORS ===== */
+    for (int i = 0; i < 4; i++) {
+        double target = Plant_Thrust(pp, cmd[i]) * vScale;
+        T[i] += (target - T[i]) * (dt / pp->tau_motor);
+        total += T[i];
+    }
+
+    /* ===== RIGID BODY ===== */
+    tauRoll  = k * (T[0] + T[1] - T[2] - T[3]) + ps->dist[0];
+    tauPitch = k * (T[0] + T[3] - T[1] - T[2]) + ps->dist[1];
+    tauYaw   = pp->k_yaw * (T[1] + T[3] - T[0] - T[2]) + ps->dist[2];
+
+    ps->p += (tauRoll  - pp->drag * ps->p) / pp->ixx * dt;
+    ps->q += (tauPitch - pp->drag * ps->q) / pp->iyy * dt;
+    ps->r += (tauYaw   - pp->drag * ps->r) / pp->izz * dt;
+
+    ps->roll  += ps->p * dt;
+    ps->pitch += ps->q * dt;
+    ps->yaw   += ps->r * dt;
+    if (ps->yaw < 0.0) ps->yaw += 2.0 * M_PI;
+    if (ps->yaw >= 2.0 * M_PI) ps->yaw -= 2.0 * M_PI;
+
+    /* ===== BATTERY ===== */
+    ps->vbat -= pp->v_sag * (total / (4.0 * pp->t_max)) * dt;
+    ps->t += dt;
+}
+
+double Plant_Rand(uint64_t *seed)
+{
+    // xorshift64*, good enough for disturbances and noise
+    uint64_t x = *seed;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *seed = x;
+    return (double)((x * 2685821657736338717ULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+double Plant_Gauss(uint64_t *seed)
+{
+    double u1 = Plant_Rand(seed), u2 = Plant_Rand(seed);
+    if (u1 < 1e-12) u1 = 1e-12;
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
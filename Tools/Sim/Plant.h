@@ -0,0 +1,93 @@
+/**
+ * @file Plant.h
+ * @brief Host-side quadcopter attitude plant for simulating the flight code.
+ *
+ * Rigid-body roll/pitch/yaw dynamics with first-order motor lag, a quadratic
+ * thrust curve, battery sag and a BNO055-like sensor (1/16 degree steps,
+ * noise, delay, plus raw gyro/accel/mag registers with bias and noise). Translational motion is not modelled: the airframe behaves
+ * like it is on a test gimbal, which is all the attitude loop sees.
+ *
+ * @author Aaron
+ * @date Oct 17, 2026
+ */
+
+#ifndef TOOLS_SIM_PLANT_H_
+#define TOOLS_SIM_PLANT_H_
+
+#include <stdint.h>
+
+/**
+ * @struct PlantParams
+ * @brief Physical constants of the airframe, motors and sensor.
+ */
+typedef struct {
+    double t_max;      ///< Thrust of one motor at full command (N)
+    double thrust_exp; ///< Thrust ~ (command fraction)^thrust_exp; about 2 for fixed-pitch props
+    double lut_exp;    ///< Part of thrust_exp a calibrated thrustLUT would cancel: thrust ~ fraction^(thrust_exp / lut_exp).
+                       ///< 1 (default) is the shipped firmware, whose identity rows cancel nothing; set it equal to
+                       ///< thrust_exp to fly motors that look linear to the mixer without rebuilding the firmware
+    double tau_motor;  ///< Motor/ESC time constant (s)
+    double arm;        ///< Motor distance from centre (m)
+    double ixx;        ///< Roll inertia (kg m^2)
+    double iyy;        ///< Pitch inertia (kg m^2)
+    double izz;        ///< Yaw inertia (kg m^2)
+    double k_yaw;      ///< Reaction torque per newton of thrust (m)
+    double drag;       ///< Rotational damping (N m s/rad)
+    double v_nominal;  ///< Pack voltage the thrust curve was measured at (V)
+    double v_start;    ///< Pack voltage at the start of the run (V)
+    double v_sag;      ///< Pack voltage lost per second at full thrust (V/s)
+    double noise_mdeg; ///< Sensor noise standard deviation (millidegrees)
+    int    delay_ticks;///< Sensor latency in control ticks
+    double gyro_bias[3]; ///< Raw gyro bias, body x/y/z (rad/s)
+    double gyro_noise; ///< Raw gyro noise per sample (rad/s, 1 sigma)
+    double acc_noise;  ///< Raw accelerometer noise per sample (m/s^2, 1 sigma)
+    double mag_noise;  ///< Raw magnetometer noise per sample (uT, 1 sigma)
+    int    raw_hold;   ///< Ticks each raw sample is held (the BNO055 refreshes at 100 Hz)
+} PlantParams;
+
+/**
+ * @struct PlantState
+ * @brief Time-varying state of the plant.
+ */
+typedef struct {
+    double roll, pitch, yaw;     ///< Attitude (rad)
+    double p, q, r;              ///< Body rates (rad/s)
+    double thrust[4];            ///< Motor thrusts A..D (N)
+    double vbat;                 ///< Pack voltage (V)
+    double dist[3];              ///< External torque roll/pitch/yaw (N m)
+    double t;                    ///< Simulated time (s)
+} PlantState;
+
+/**
+ * @brief Fills in the reference airframe (≈1 kg quad, 5" props, 3S pack).
+ */
+void Plant_Defaults(PlantParams *pp);
+
+/**
+ * @brief Starts a level, motionless plant.
+ */
+void Plant_Init(PlantState *ps, const PlantParams *pp);
+
+/**
+ * @brief Advances the plant by dt with the given TIM3 compare values.
+ *
+ * @param cmd Compare values for motors A..D, as written to CCR1..CCR4.
+ */
+void Plant_Step(PlantState *ps, const PlantParams *pp, const uint32_t cmd[4], double dt);
+
+/**
+ * @brief Thrust a compare value produces at nominal voltage (N).
+ */
+double Plant_Thrust(const PlantParams *pp, uint32_t cmd);
+
+/**
+ * @brief Uniform random number in [0, 1) from the given state.
+ */
+double Plant_Rand(uint64_t *seed);
+
+/**
+ * @brief Standard normal random number from the given state.
+ */
+double Plant_Gauss(uint64_t *seed);
+
+#endif /* TOOLS_SIM_PLANT_H_ */
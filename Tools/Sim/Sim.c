@@ -0,0 +1,453 @@
+/**
+  ******************************************************************************
+  * @file    Sim.c
+  * @author  Aaron Lubinsky
+  * @brief   Host harness that runs the flight code against the plant model
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Compiled with the real HAL headers so the flight code builds
+  *          unchanged. Peripherals are never touched: htim3 points at a RAM
+  *          TIM_TypeDef, and the HAL functions the flight code calls are
+  *          defined here. Battery.c is register-level, so its three entry
+  *          points are replaced by equivalents that read the plant's pack voltage.
+  *          Flash programming succeeds without writing anything, so Params.c
+  *          keeps its values in RAM (Param_Load() must not be called).
+  *
+  ******************************************************************************
+  */
+
+#include "Sim.h"
+#include "main.h"
+#include "BNO055.h"
+#include "Battery.h"
+#include "ESC.h"
+#include "StackMon.h"
+#include "Watchdog.h"
+#include "Latency.h"
+#include "RateMode.h"
+#include "LQR.h"
+#include <math.h>
+#include <string.h>
+
+#define RAD_TO_MDEG (180000.0 / M_PI)
+#define SENSOR_QUEUE 64 ///< Longest sensor delay supported (ticks)
+#define SIM_GRAVITY  9.80665
+#define SIM_FIELD_UT 50.0  ///< Earth field strength (uT)
+#define SIM_DIP      1.05  ///< Field inclination below horizontal (rad, about 60 degrees)
+
+/* ===== GLOBALS OWNED BY main.c ON TARGET ===== */
+I2C_HandleTypeDef hi2c1;
+I2C_HandleTypeDef hi2c3;
+TIM_HandleTypeDef htim3;
+UART_HandleTypeDef huart1;
+UART_HandleTypeDef huart2;
+uint32_t SystemCoreClock = 100000000; ///< Normally system_stm32f4xx.c
+
+int state = 2;
+int32_t roll_set, pitch_set, yaw_set, effort_set;
+int32_t roll_true, pitch_true, yaw_true;
+int32_t roll_rate_set, pitch_rate_set, yaw_rate_set;
+int32_t roll_rate, pitch_rate, yaw_rate;
+int32_t roll_effort, pitch_effort, yaw_effort;
+int stopFlag = false;
+int32_t roll_integral, pitch_integral, yaw_integral;
+int32_t roll_derivative, pitch_derivative, yaw_derivative;
+int32_t roll_error, pitch_error, yaw_error;
+int32_t last_roll_error, last_pitch_error, last_yaw_error;
+int32_t last_last_roll_error, last_last_pitch_error, last_last_yaw_error;
+int32_t K_effort = 50000;
+int32_t Kp_roll = 200;
+int32_t Ki_roll = 15;
+int32_t Kd_roll = 0;
+int32_t Kp_pitch = 200;
+int32_t Ki_pitch = 15;
+int32_t Kd_pitch = 0;
+int32_t Kp_yaw = 0;
+int32_t Ki_yaw = 0;
+int32_t Kd_yaw = 0;
+int32_t Kp_rate = 250;
+int32_t Ki_rate = 20;
+int32_t Kd_rate = 0;
+int32_t Kp_rate_yaw = 500;
+int32_t Ki_rate_yaw = 20;
+int dumpFlag = 0;
+
+/* ===== SIMULATION STATE ===== */
+static TIM_TypeDef simTIM3;          ///< RAM stand-in for the TIM3 registers
+static PlantParams simParams;
+static PlantState simState;
+static uint64_t simSeed;
+static SimUartSink simSink;
+static int16_t sensorQueue[SENSOR_QUEUE][3]; ///< Delayed BNO055 Euler registers
+static int sensorHead;
+static int16_t sensorRaw[9];                 ///< Accel, mag, gyro registers, chip axes
+static int rawAge;                           ///< Ticks since sensorRaw was refreshed
+
+/* ===== STACKMON STAND-IN ===== */
+uintptr_t stackMinSP[STACK_CTX_COUNT]; ///< StackMon_Mark() calls in the flight code land here
+
+uint32_t StackMon_Peak(void)
+{
+    return 0;
+}
+
+uint32_t StackMon_Free(void)
+{
+    return 0; // The host stack is not painted
+}
+
+uintptr_t StackMon_HeapEnd(void)
+{
+    return 0;
+}
+
+/* ===== WATCHDOG STAND-IN ===== */
+volatile int wdgSafe = false; ///< The host loop never misses its deadline
+int wdgReset = false;
+
+void Watchdog_Kick(int flying)
+{
+    (void)flying;
+}
+
+/* ===== LATENCY STAND-IN ===== */
+uint32_t latHist[LAT_BINS];
+uint32_t latProbes = 0;   ///< Stays 0, so MAVLink.c never sends a latency report
+uint16_t latStamp = 0;
+uint32_t latStageUs[LAT_STAGES];
+
+void Latency_Parsed(uint16_t stamp)
+{
+    (void)stamp; // No cycle counter on the host
+}
+
+void Latency_ApplyStart(void)
+{
+}
+
+void Latency_Applied(void)
+{
+}
+
+void Latency_Dump(void)
+{
+}
+
+/* ===== BATTERY STAND-IN ===== */
+int32_t batt_mV = 0;
+int32_t batt_mA = 0;
+static int32_t battScale = 1024;
+
+void Battery_Init(void)
+{
+}
+
+void Battery_Update(void)
+{
+    // Same compensation law as Battery.c, fed from the plant instead of the ADC
+    batt_mV = (int32_t)(simState.vbat * 1000.0);
+    if (batt_mV < BATT_MIN_MV / 2) {
+        battScale = 1024;
+    } else if (batt_mV < BATT_MIN_MV) {
+        battScale = (BATT_NOMINAL_MV << 10) / BATT_MIN_MV;
+    } else {
+        battScale = (BATT_NOMINAL_MV << 10) / batt_mV;
+    }
+}
+
+int32_t Battery_Compensate(int32_t cmd)
+{
+    if (cmd <= ESC_CMD_MIN) return cmd;
+    return ESC_CMD_MIN + (((cmd - ESC_CMD_MIN) * battScale) >> 10);
+}
+
+/* ===== HAL STAND-INS ===== */
+void HAL_Delay(uint32_t Delay)
+{
+    simState.t += Delay / 1000.0;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return (uint32_t)(simState.t * 1000.0);
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+    (void)GPIOx; (void)GPIO_Pin; (void)PinState;
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    (void)GPIOx; (void)GPIO_Pin;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    (void)htim; (void)Channel;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c)
+{
+    hi2c->State = HAL_I2C_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c)
+{
+    hi2c->State = HAL_I2C_STATE_RESET;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+                                    uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    (void)hi2c; (void)DevAddress; (void)MemAddress; (void)MemAddSize; (void)pData; (void)Size; (void)Timeout;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+                                   uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    (void)hi2c; (void)DevAddress; (void)MemAddSize; (void)Timeout;
+    memset(pData, 0, Size);
+
+    if (MemAddress == 0x00) {
+        pData[0] = 0xA0;                 // Chip ID
+    } else if (MemAddress == BNO055_CALIB_STAT) {
+        pData[0] = 0xFF;                 // Fully calibrated
+    } else if (MemAddress == BNO055_EULER_LSB && Size >= 6) {
+        int idx = (sensorHead - simParams.delay_ticks + SENSOR_QUEUE) % SENSOR_QUEUE;
+        for (int i = 0; i < 3; i++) {
+            pData[2 * i]     = (uint8_t)(sensorQueue[idx][i] & 0xFF);
+            pData[2 * i + 1] = (uint8_t)((uint16_t)sensorQueue[idx][i] >> 8);
+        }
+    } else if (MemAddress >= BNO055_ACC_DATA && MemAddress + Size <= BNO055_ACC_DATA + BNO_RAW_LEN) {
+        for (int i = 0; i < Size; i++) {
+            int reg = MemAddress - BNO055_ACC_DATA + i;
+            pData[i] = (uint8_t)((uint16_t)sensorRaw[reg / 2] >> ((reg & 1) * 8));
+        }
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    (void)Timeout;
+    if (simSink) simSink(huart == &huart1 ? 1 : 2, pData, Size);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size)
+{
+    // Completes immediately, so gState never leaves READY
+    if (simSink) simSink(huart == &huart1 ? 1 : 2, pData, Size);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size)
+{
+    // Same: the next FastLink_Service() call sees the chunk done
+    if (simSink) simSink(huart == &huart1 ? 1 : 2, pData, Size);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    (void)huart; (void)pData; (void)Size;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    (void)huart; (void)pData; (void)Size;
+    return HAL_OK;
+}
+
+/* Flash writes from Params.c are accepted and dropped: values live in RAM for the run */
+HAL_StatusTypeDef HAL_FLASH_Unlock(void)
+{
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void)
+{
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data)
+{
+    (void)TypeProgram; (void)Address; (void)Data;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *SectorError)
+{
+    (void)pEraseInit;
+    *SectorError = 0xFFFFFFFFU;
+    return HAL_OK;
+}
+
+/* ===== SENSOR MODEL ===== */
+/**
+ * @brief Register value with noise, clipped to int16
+ */
+static int16_t Sim_Reg(double v, double noise, double lsb)
+{
+    double r = lround((v + noise * Plant_Gauss(&simSeed)) * lsb);
+
+    return (int16_t)(r > 32767.0 ? 32767.0 : r < -32768.0 ? -32768.0 : r);
+}
+
+/**
+ * @brief Raw accel (100 LSB per m/s^2), mag (16 LSB per uT) and gyro (16 LSB
+ *        per deg/s) registers for the current attitude
+ *
+ * @details The plant integrates Euler rates, so they are turned into body
+ *          rates here. Body vectors (x forward, y right, z down) go to the
+ *          chip axes the way BNO_RawToBody() undoes: chip X = right,
+ *          chip Y = forward, chip Z = up.
+ */
+static void Sim_SenseRaw(void)
+{
+    double sr = sin(simState.roll), cr = cos(simState.roll);
+    double sp = sin(simState.pitch), cp = cos(simState.pitch);
+    double sy = sin(simState.yaw), cy = cos(simState.yaw);
+    double acc[3], mag[3], gyro[3];
+    double mn[3] = {SIM_FIELD_UT * cos(SIM_DIP), 0.0, SIM_FIELD_UT * sin(SIM_DIP)};
+    // Rows of the earth-to-body rotation (transpose of body-to-earth, ZYX)
+    double R[3][3] = {
+        {cp * cy,                  cp * sy,                  -sp},
+        {sr * sp * cy - cr * sy,   sr * sp * sy + cr * cy,   sr * cp},
+        {cr * sp * cy + sr * sy,   cr * sp * sy - sr * cy,   cr * cp},
+    };
+
+    for (int i = 0; i < 3; i++) {
+        acc[i] = -SIM_GRAVITY * R[i][2];
+        mag[i] = R[i][0] * mn[0] + R[i][1] * mn[1] + R[i][2] * mn[2];
+    }
+    gyro[0] = simState.p - simState.r * sp;
+    gyro[1] = simState.q * cr + simState.r * sr * cp;
+    gyro[2] = -simState.q * sr + simState.r * cr * cp;
+    for (int i = 0; i < 3; i++) gyro[i] = (gyro[i] + simParams.gyro_bias[i]) * 180.0 / M_PI;
+
+    sensorRaw[0] = Sim_Reg(acc[1], simParams.acc_noise, 100.0);
+    sensorRaw[1] = Sim_Reg(acc[0], simParams.acc_noise, 100.0);
+    sensorRaw[2] = Sim_Reg(-acc[2], simParams.acc_noise, 100.0);
+    sensorRaw[3] = Sim_Reg(mag[1], simParams.mag_noise, 16.0);
+    sensorRaw[4] = Sim_Reg(mag[0], simParams.mag_noise, 16.0);
+    sensorRaw[5] = Sim_Reg(-mag[2], simParams.mag_noise, 16.0);
+    sensorRaw[6] = Sim_Reg(gyro[1], simParams.gyro_noise * 180.0 / M_PI, 16.0);
+    sensorRaw[7] = Sim_Reg(gyro[0], simParams.gyro_noise * 180.0 / M_PI, 16.0);
+    sensorRaw[8] = Sim_Reg(-gyro[2], simParams.gyro_noise * 180.0 / M_PI, 16.0);
+}
+
+/**
+ * @brief Quantizes the plant attitude to BNO055 Euler registers (1/16 degree)
+ *        and pushes it onto the delay queue
+ */
+static void Sim_Sense(void)
+{
+    double n = simParams.noise_mdeg;
+    double yaw   = simState.yaw   * RAD_TO_MDEG + n * Plant_Gauss(&simSeed);
+    double roll  = simState.roll  * RAD_TO_MDEG + n * Plant_Gauss(&simSeed);
+    double pitch = simState.pitch * RAD_TO_MDEG + n * Plant_Gauss(&simSeed);
+
+    if (yaw < 0.0) yaw += 360000.0;
+    if (yaw >= 360000.0) yaw -= 360000.0;
+
+    sensorHead = (sensorHead + 1) % SENSOR_QUEUE;
+    sensorQueue[sensorHead][0] = (int16_t)lround(yaw * 16.0 / 1000.0);
+    sensorQueue[sensorHead][1] = (int16_t)lround(roll * 16.0 / 1000.0);
+    sensorQueue[sensorHead][2] = (int16_t)lround(pitch * 16.0 / 1000.0);
+
+    if (++rawAge >= simParams.raw_hold) {
+        rawAge = 0;
+        Sim_SenseRaw();
+    }
+}
+
+/* ===== HARNESS ===== */
+void Sim_Init(const PlantParams *pp, uint64_t seed)
+{
+    simParams = *pp;
+    simSeed = seed ? seed : 0x9E3779B97F4A7C15ULL;
+    Plant_Init(&simState, &simParams);
+
+    memset(&simTIM3, 0, sizeof(simTIM3));
+    htim3.Instance = &simTIM3;
+    hi2c1.State = HAL_I2C_STATE_READY;
+    huart1.gState = HAL_UART_STATE_READY;
+    huart2.gState = HAL_UART_STATE_READY;
+
+    roll_set = pitch_set = yaw_set = effort_set = 0;
+    roll_true = pitch_true = yaw_true = 0;
+    roll_rate_set = pitch_rate_set = yaw_rate_set = 0;
+    roll_rate = pitch_rate = yaw_rate = 0;
+    roll_effort = pitch_effort = yaw_effort = 0;
+    roll_integral = pitch_integral = yaw_integral = 0;
+    roll_error = pitch_error = yaw_error = 0;
+    last_roll_error = last_pitch_error = last_yaw_error = 0;
+    stopFlag = false;
+    dumpFlag = 0;
+    sample_index = 0;
+    counter = 0;
+    batt_mV = 0;
+    battScale = 1024;
+
+    memset(sensorQueue, 0, sizeof(sensorQueue));
+    sensorHead = 0;
+    rawAge = 0;
+    for (int i = 0; i < SENSOR_QUEUE; i++) Sim_Sense();
+}
+
+void Sim_Tick(double dt)
+{
+    uint32_t cmd[4];
+
+    Sim_Sense();
+    if (flightMode == FLIGHT_MODE_RATE || ctrlLaw == CTRL_LAW_LQR) {
+        BNO_ReadRates(&roll_true, &pitch_true, &yaw_true, &roll_rate, &pitch_rate, &yaw_rate);
+    } else {
+        BNO_Read(&roll_true, &pitch_true, &yaw_true);
+    }
+    Battery_Update();
+    update_Motors();
+
+    Sim_Motors(cmd);
+    Plant_Step(&simState, &simParams, cmd, dt);
+}
+
+void Sim_Advance(double dt)
+{
+    uint32_t cmd[4];
+
+    Sim_Motors(cmd);
+    Plant_Step(&simState, &simParams, cmd, dt);
+    Sim_Sense();
+}
+
+void Sim_SetUartSink(SimUartSink sink)
+{
+    simSink = sink;
+}
+
+void Sim_Motors(uint32_t cmd[4])
+{
+    cmd[0] = simTIM3.CCR1;
+    cmd[1] = simTIM3.CCR2;
+    cmd[2] = simTIM3.CCR3;
+    cmd[3] = simTIM3.CCR4;
+}
+
+PlantState *Sim_State(void)
+{
+    return &simState;
+}
+
+const PlantParams *Sim_Params(void)
+{
+    return &simParams;
+}
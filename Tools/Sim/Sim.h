@@ -0,0 +1,85 @@
+/**
+ * @file Sim.h
+ * @brief Runs the flight code (ESC, BNO055, HC05, AngleMath) against Plant on the host.
+ *
+ * Sim.c provides the globals main.c normally owns and stands in for the HAL
+ * calls the flight code makes: TIM3 compare writes land in a RAM copy of
+ * the timer, BNO055 register reads are answered from the plant, and UART
+ * transmits go to a caller-supplied sink.
+ *
+ * @author Aaron
+ * @date Oct 17, 2026
+ */
+
+#ifndef TOOLS_SIM_SIM_H_
+#define TOOLS_SIM_SIM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Plant.h"
+
+/* Flight-code globals (defined in Sim.c, as main.c does on target) */
+extern int32_t roll_set, pitch_set, yaw_set, effort_set;
+extern int32_t roll_true, pitch_true, yaw_true;
+extern int32_t roll_rate_set, pitch_rate_set, yaw_rate_set;
+extern int32_t roll_rate, pitch_rate, yaw_rate;
+extern int32_t roll_effort, pitch_effort, yaw_effort;
+extern int32_t roll_integral, pitch_integral, yaw_integral;
+extern int32_t K_effort;
+extern int32_t Kp_roll, Ki_roll, Kd_roll;
+extern int32_t Kp_pitch, Ki_pitch, Kd_pitch;
+extern int32_t Kp_yaw, Ki_yaw, Kd_yaw;
+extern int32_t Kp_rate, Ki_rate, Kd_rate, Kp_rate_yaw, Ki_rate_yaw;
+extern int state;
+extern int stopFlag;
+extern int dumpFlag;
+extern int antiWindup;
+extern int gainSched;
+extern int max_integral;
+
+/**
+ * @brief Byte sink for UART transmits from the flight code.
+ *
+ * @param uart 1 for USART1 (ST-Link console), 2 for USART2 (BT link).
+ */
+typedef void (*SimUartSink)(int uart, const uint8_t *data, size_t len);
+
+/**
+ * @brief Resets the plant and all controller state; gains are left alone.
+ */
+void Sim_Init(const PlantParams *pp, uint64_t seed);
+
+/**
+ * @brief Runs one flying-state loop iteration, then advances the plant by dt.
+ */
+void Sim_Tick(double dt);
+
+/**
+ * @brief Advances the plant by dt on the current motor commands and samples
+ *        the sensor, without running any flight code.
+ *
+ * For harnesses that run their own loop (e.g. the SITL state machine).
+ */
+void Sim_Advance(double dt);
+
+/**
+ * @brief Routes flight-code UART output; NULL discards it.
+ */
+void Sim_SetUartSink(SimUartSink sink);
+
+/**
+ * @brief Compare values last written to TIM3 CCR1..CCR4.
+ */
+void Sim_Motors(uint32_t cmd[4]);
+
+/**
+ * @brief Current plant state (writable, e.g. to inject disturbances).
+ */
+PlantState *Sim_State(void);
+
+/**
+ * @brief Current plant parameters.
+ */
+const PlantParams *Sim_Params(void);
+
+#endif /* TOOLS_SIM_SIM_H_ */
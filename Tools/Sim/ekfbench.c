@@ -0,0 +1,195 @@
+/**
+  ******************************************************************************
+  * @file    ekfbench.c
+  * @author  Aaron Lubinsky
+  * @brief   Accuracy and cost of AttEKF against the BNO055 fusion output
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Flies the simulated airframe through a sequence of roll and pitch
+  *          steps (with a yaw disturbance turning it) on the usual BNO055
+  *          Euler path, and alongside runs several AttEKF instances on the
+  *          raw accel/mag/gyro registers the sensor model produces: gyro
+  *          only, and corrections every 1, 2, 5, 10 and 20 ticks. Each is
+  *          scored against the plant's true attitude after a settling
+  *          period, together with the Euler output BNO_Read() saw.
+  *
+  *          The raw registers refresh at 100 Hz with a constant gyro bias
+  *          and white noise; the Euler output is the plant attitude with
+  *          noise and latency (the BNO055's fusion itself is not modelled,
+  *          so its row is only as good as those two numbers). Cost is host
+  *          time per loop; the target figure is ekfCycles in BNO055.c.
+  *
+  *          A final run flies the controller on the EKF (ATT_SOURCE=1).
+  *
+  *          Usage: ekfbench [seconds] [euler_noise_mdeg] [euler_delay_ticks]
+  *
+  ******************************************************************************
+  */
+
+#define _GNU_SOURCE
+#include "Sim.h"
+#include "BNO055.h"
+#include "AttEKF.h"
+#include "stm32f4xx_hal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#define DT        0.001  ///< Control loop period (s)
+#define SETTLE_S  2.0    ///< Errors are scored after this
+#define N_CASES   6
+
+extern I2C_HandleTypeDef hi2c1;
+
+static const int corrDiv[N_CASES] = {0, 1, 2, 5, 10, 20}; ///< 0: gyro only
+
+typedef struct {
+    double sumRP, sumYaw;   ///< Squared errors (deg^2)
+    double maxRP, maxYaw;   ///< Largest errors (deg)
+    double ns;              ///< Host time in the filter
+    long n;
+} Score;
+
+static double nowNs(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static double wrapDeg(double d)
+{
+    while (d > 180.0) d -= 360.0;
+    while (d < -180.0) d += 360.0;
+    return d;
+}
+
+static void score(Score *s, int32_t roll, int32_t pitch, int32_t yaw)
+{
+    const PlantState *ps = Sim_State();
+    double er = roll / 1000.0 - ps->roll * 180.0 / M_PI;
+    double ep = pitch / 1000.0 - ps->pitch * 180.0 / M_PI;
+    double ey = wrapDeg(yaw / 1000.0 - ps->yaw * 180.0 / M_PI);
+
+    s->sumRP += 0.5 * (er * er + ep * ep);
+    s->sumYaw += ey * ey;
+    if (fabs(er) > s->maxRP) s->maxRP = fabs(er);
+    if (fabs(ep) > s->maxRP) s->maxRP = fabs(ep);
+    if (fabs(ey) > s->maxYaw) s->maxYaw = fabs(ey);
+    s->n++;
+}
+
+/**
+ * @brief Setpoint schedule: a roll or pitch step every second, and a yaw push
+ */
+static void schedule(long tick)
+{
+    static const int32_t steps[8][2] = {
+        {15000, 0}, {0, 0}, {-15000, 0}, {0, 15000}, {0, -15000}, {10000, 10000}, {-10000, -10000}, {0, 0}
+    };
+    long sec = tick / 1000;
+
+    roll_set = steps[sec % 8][0];
+    pitch_set = steps[sec % 8][1];
+    Sim_State()->dist[2] = ((sec / 4) % 2) ? 0.02 : -0.02;
+}
+
+static void setupPlant(PlantParams *pp, double noise, int delay)
+{
+    Plant_Defaults(pp);
+    pp->noise_mdeg = noise;
+    pp->delay_ticks = delay;
+    pp->gyro_bias[0] = 0.02;   // About 1 deg/s
+    pp->gyro_bias[1] = -0.015;
+    pp->gyro_bias[2] = 0.01;
+    pp->gyro_noise = 0.003;
+    pp->acc_noise = 0.05;
+    pp->mag_noise = 0.5;
+    pp->raw_hold = 10;
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = (argc > 1) ? atof(argv[1]) : 30.0;
+    double noise = (argc > 2) ? atof(argv[2]) : 100.0;
+    int delay = (argc > 3) ? atoi(argv[3]) : 10;
+    long ticks = (long)(seconds / DT);
+    long settle = (long)(SETTLE_S / DT);
+    PlantParams pp;
+    AttEKF f[N_CASES];
+    Score sc[N_CASES + 1] = {0};
+    Score flown = {0};
+
+    /* ===== OPEN LOOP: ESTIMATORS SIDE BY SIDE ===== */
+    setupPlant(&pp, noise, delay);
+    Sim_Init(&pp, 7);
+    attSource = ATT_SOURCE_BNO;
+    effort_set = 500;
+
+    for (long t = 0; t < ticks; t++) {
+        uint8_t raw[BNO_RAW_LEN];
+        float acc[3], mag[3], gyro[3];
+
+        schedule(t);
+        Sim_Tick(DT); // Flight code on the BNO055 Euler output; plant steps and is sampled
+
+        HAL_I2C_Mem_Read(&hi2c1, BNO055_I2C_ADDR, BNO055_ACC_DATA, I2C_MEMADD_SIZE_8BIT, raw, BNO_RAW_LEN, 100);
+        BNO_RawToBody(raw, acc, mag, gyro);
+
+        for (int c = 0; c < N_CASES; c++) {
+            int32_t r, p, y;
+            double t0 = nowNs();
+
+            if (t == 0) {
+                AttEKF_Start(&f[c], acc, mag);
+            } else {
+                AttEKF_Predict(&f[c], gyro, (float)DT);
+                if (corrDiv[c] > 0 && t % corrDiv[c] == 0) {
+                    AttEKF_UpdateAccel(&f[c], acc);
+                    AttEKF_UpdateMag(&f[c], mag);
+                }
+            }
+            AttEKF_Euler(&f[c], &r, &p, &y);
+            sc[c].ns += nowNs() - t0;
+            if (t >= settle) score(&sc[c], r, p, y);
+        }
+        if (t >= settle) score(&sc[N_CASES], roll_true, pitch_true, yaw_true);
+    }
+
+    printf("%.0f s of roll/pitch steps, raw sensors at 100 Hz, gyro bias %.2f/%.2f/%.2f deg/s\n",
+           seconds, pp.gyro_bias[0] * 180.0 / M_PI, pp.gyro_bias[1] * 180.0 / M_PI, pp.gyro_bias[2] * 180.0 / M_PI);
+    printf("%-22s %10s %10s %10s %10s %12s\n", "estimator", "rp rms", "rp max", "yaw rms", "yaw max", "host ns/loop");
+    for (int c = 0; c <= N_CASES; c++) {
+        char name[32];
+
+        if (c == N_CASES) snprintf(name, sizeof(name), "BNO055 Euler (model)");
+        else if (corrDiv[c] == 0) snprintf(name, sizeof(name), "EKF gyro only");
+        else snprintf(name, sizeof(name), "EKF correct /%d", corrDiv[c]);
+
+        printf("%-22s %9.3f° %9.3f° %9.3f° %9.3f° %12.0f\n", name,
+               sqrt(sc[c].sumRP / sc[c].n), sc[c].maxRP, sqrt(sc[c].sumYaw / sc[c].n), sc[c].maxYaw,
+               (c < N_CASES) ? sc[c].ns / ticks : 0.0);
+    }
+    for (int c = 1; c < N_CASES; c++) {
+        if (corrDiv[c] == EKF_CORR_DIV) {
+            printf("bias estimate (/%d): %.3f/%.3f/%.3f deg/s\n", EKF_CORR_DIV,
+                   f[c].b[0] * 180.0 / M_PI, f[c].b[1] * 180.0 / M_PI, f[c].b[2] * 180.0 / M_PI);
+        }
+    }
+
+    /* ===== CLOSED LOOP ON THE EKF ===== */
+    Sim_Init(&pp, 7);
+    attSource = ATT_SOURCE_EKF;
+    effort_set = 500;
+    for (long t = 0; t < ticks; t++) {
+        schedule(t);
+        Sim_Tick(DT);
+        if (t >= settle) score(&flown, roll_true, pitch_true, yaw_true);
+    }
+    printf("flying on the EKF (correct /%d): rp rms %.3f°, yaw rms %.3f° against the truth\n",
+           EKF_CORR_DIV, sqrt(flown.sumRP / flown.n), sqrt(flown.sumYaw / flown.n));
+    return 0;
+}
@@ -0,0 +1,113 @@
+/**
+  ******************************************************************************
+  * @file    gainsched.c
+  * @author  Aaron Lubinsky
+  * @brief   Step response across the throttle range with and without gain scheduling
+  * @version 1.0
+  * @date    2026
+  *
+  * @details For each throttle level, levels the simulated airframe, steps
+  *          roll_set by 10 degrees and records the overshoot, the time to
+  *          settle within ±1 degree and the peak-to-peak ringing over the
+  *          last second, once with gainSched off and once on.
+  *
+  *          The firmware ships without a thrust curve, so the plant's thrust
+  *          exponent (2, quadratic, by default) is all mismatch: a count of
+  *          effort buys more torque the higher the throttle, which is the
+  *          ringing-at-the-top, soft-near-idle behaviour the schedule is
+  *          for. lut_exp models a calibrated thrustLUT taking part of it
+  *          out (PlantParams); equal to thrust_exp, authority is the same at
+  *          every throttle and the schedule has nothing left to correct.
+  *
+  *          The default gains are well damped at the tuning throttle, so
+  *          the spread of overshoot and settling time across the range is
+  *          what to compare.
+  *
+  *          Usage: gainsched [thrust_exp [lut_exp]] [kp ki kd]
+  *
+  ******************************************************************************
+  */
+
+#include "Sim.h"
+#include "ESC.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define DT          0.001  ///< Control loop period (s)
+#define STEP_MDEG   10000  ///< Roll step
+#define SETTLE_MDEG 1000   ///< Settled when within ±1 degree
+#define RUN_TICKS   3000   ///< Length of each step response
+
+typedef struct {
+    double overshoot; ///< Largest roll past the step (deg)
+    double settle;    ///< Time until it stays within ±1 degree (s)
+    double ring;      ///< Peak-to-peak roll over the last second (deg)
+} StepResult;
+
+static StepResult runStep(const PlantParams *pp, int32_t effort, int sched)
+{
+    StepResult res = {0};
+    double lo = 1e9, hi = -1e9;
+
+    Sim_Init(pp, 5);
+    gainSched = sched;
+    effort_set = effort;
+    for (int i = 0; i < 1000; i++) Sim_Tick(DT);
+
+    roll_set = STEP_MDEG;
+    for (int i = 0; i < RUN_TICKS; i++) {
+        double r = Sim_State()->roll * 180.0 / M_PI;
+
+        Sim_Tick(DT);
+        if (r - STEP_MDEG / 1000.0 > res.overshoot) res.overshoot = r - STEP_MDEG / 1000.0;
+        if (fabs(r * 1000.0 - STEP_MDEG) > SETTLE_MDEG) res.settle = (i + 1) * DT;
+        if (i >= RUN_TICKS - 1000) {
+            if (r < lo) lo = r;
+            if (r > hi) hi = r;
+        }
+    }
+    res.ring = hi - lo;
+    return res;
+}
+
+int main(int argc, char **argv)
+{
+    static const int32_t efforts[] = {128, 256, 384, 512, 640, 768, 896, 1000};
+    PlantParams pp;
+    double spread[2][4] = {{1e9, -1e9, 1e9, -1e9}, {1e9, -1e9, 1e9, -1e9}}; ///< Min/max overshoot, min/max settle
+
+    Plant_Defaults(&pp);
+    if (argc > 1) pp.thrust_exp = atof(argv[1]);
+    if (argc > 2) pp.lut_exp = atof(argv[2]);
+    Kp_roll = (argc > 5) ? atoi(argv[3]) : 1500;
+    Ki_roll = (argc > 5) ? atoi(argv[4]) : 100;
+    Kd_roll = (argc > 5) ? atoi(argv[5]) : 100000;
+
+    printf("thrust exponent %.1f, lut_exp %.1f, Kp=%ld Ki=%ld Kd=%ld, %d° roll step\n",
+           pp.thrust_exp, pp.lut_exp, (long)Kp_roll, (long)Ki_roll, (long)Kd_roll, STEP_MDEG / 1000);
+    printf("%6s %6s | %21s | %21s\n", "", "", "fixed gains", "scheduled");
+    printf("%6s %6s | %6s %7s %6s | %6s %7s %6s\n", "effort", "scale",
+           "over°", "settle", "ring°", "over°", "settle", "ring°");
+
+    for (unsigned k = 0; k < sizeof(efforts) / sizeof(efforts[0]); k++) {
+        StepResult f = runStep(&pp, efforts[k], false);
+        StepResult s = runStep(&pp, efforts[k], true);
+        const StepResult *both[2] = {&f, &s};
+
+        for (int c = 0; c < 2; c++) {
+            spread[c][0] = fmin(spread[c][0], both[c]->overshoot);
+            spread[c][1] = fmax(spread[c][1], both[c]->overshoot);
+            spread[c][2] = fmin(spread[c][2], both[c]->settle);
+            spread[c][3] = fmax(spread[c][3], both[c]->settle);
+        }
+
+        printf("%6ld %5.2fx | %6.2f %6.2fs %6.2f | %6.2f %6.2fs %6.2f\n", (long)efforts[k],
+               gainScale / (double)GAIN_SCHED_ONE, f.overshoot, f.settle, f.ring, s.overshoot, s.settle, s.ring);
+    }
+    for (int c = 0; c < 2; c++) {
+        printf("%s: overshoot %.2f-%.2f°, settle %.2f-%.2f s\n", c ? "scheduled  " : "fixed gains",
+               spread[c][0], spread[c][1], spread[c][2], spread[c][3]);
+    }
+    return 0;
+}
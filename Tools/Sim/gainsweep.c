@@ -0,0 +1,311 @@
+/**
+  ******************************************************************************
+  * @file    gainsweep.c
+  * @author  Aaron Lubinsky
+  * @brief   Monte Carlo roll/pitch gain search with a Pareto front output
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Draws candidate Kp/Ki/Kd sets (log-uniform, same gains on roll and
+  *          pitch) and flies each one through a batch of randomized flights:
+  *          stick steps, gusts on both axes, sensor noise and latency, ESC lag
+  *          and pack sag all vary per flight. Each candidate is scored on
+  *
+  *          - tracking: RMS attitude error over all flights (degrees)
+  *          - effort:   RMS of the differential motor command, i.e. how hard
+  *                      the mixer pushes the motors apart (compare counts)
+  *
+  *          A flight that tips past 60 degrees marks the candidate unstable.
+  *          Stable candidates not beaten on both scores by another form the
+  *          Pareto set, printed best-tracking first with lines ready to paste
+  *          into main.c.
+  *
+  *          The flight code keeps its state in globals, so flights run in
+  *          forked worker processes (one per core) rather than threads; each
+  *          worker takes every Nth candidate and streams results back over a
+  *          pipe. Every flight seeds from (seed, candidate, flight), so the
+  *          output does not depend on the number of workers.
+  *
+  *          The flights run the firmware as shipped, with no thrust curve,
+  *          on quadratic motors, so the printed gains are for that build.
+  *          Once thrustLUT holds measured rows, sweep again with -l 2 (the
+  *          plant's lut_exp) for gains that match it.
+  *
+  *          Usage: gainsweep [-n candidates] [-f flights] [-t seconds]
+  *                           [-j workers] [-S seed] [-l lut_exp] [-o all.csv]
+  *
+  ******************************************************************************
+  */
+
+#include "Sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define DT            0.001   ///< Control loop period (s)
+#define TIP_MDEG      60000   ///< Attitude treated as a loss of control
+#define SETTLE_S      0.5     ///< Initial level-off excluded from the scores (s)
+
+/**
+ * @brief One candidate gain set and its scores
+ */
+typedef struct {
+    int32_t kp, ki, kd;
+    double track;   ///< RMS attitude error (deg)
+    double effort;  ///< RMS differential motor command (counts)
+    int stable;     ///< No flight tipped over
+    int pareto;     ///< On the Pareto front
+} Candidate;
+
+/**
+ * @brief Worker-to-parent record; one write() each so records never interleave
+ */
+typedef struct {
+    int index;
+    Candidate c;
+} Result;
+
+static int nFlights = 12;
+static double flightSeconds = 4.0;
+static double lutExp = 1.0; ///< PlantParams.lut_exp: 1 is the shipped firmware (no thrust curve)
+
+/**
+ * @brief Log-uniform integer in [lo, hi]
+ */
+static int32_t logUniform(uint64_t *seed, double lo, double hi)
+{
+    return (int32_t)lround(exp(log(lo) + Plant_Rand(seed) * (log(hi) - log(lo))));
+}
+
+/**
+ * @brief Flies one randomized flight, adding squared errors to the sums
+ *
+ * @return false if the airframe tipped over
+ */
+static int flyOnce(const Candidate *c, uint64_t seed, double *errSq, double *effSq, long *n)
+{
+    PlantParams pp;
+    PlantState *ps;
+    int ticks = (int)(flightSeconds / DT);
+    int settleTicks = (int)(SETTLE_S / DT);
+    int nextStep, nextGust, gustEnd = -1;
+
+    Plant_Defaults(&pp);
+    pp.noise_mdeg  = 50.0 + 250.0 * Plant_Rand(&seed);
+    pp.delay_ticks = 1 + (int)(5.0 * Plant_Rand(&seed));
+    pp.tau_motor   = 0.02 + 0.06 * Plant_Rand(&seed);
+    pp.v_start     = 11.1 + 1.4 * Plant_Rand(&seed);
+    pp.v_sag       = 0.05 * Plant_Rand(&seed);
+    pp.lut_exp     = lutExp;
+
+    Sim_Init(&pp, seed);
+    ps = Sim_State();
+    gainSched = 0; // Candidates are the gains themselves, unscaled
+    Kp_roll = Kp_pitch = c->kp;
+    Ki_roll = Ki_pitch = c->ki;
+    Kd_roll = Kd_pitch = c->kd;
+    effort_set = 300 + (int32_t)(500.0 * Plant_Rand(&seed));
+
+    nextStep = settleTicks + (int)(1000.0 * Plant_Rand(&seed));
+    nextGust = settleTicks + (int)(2000.0 * Plant_Rand(&seed));
+
+    for (int i = 0; i < ticks; i++) {
+        uint32_t cmd[4];
+
+        if (i == nextStep) { // Pilot stick step on both axes
+            roll_set  = (int32_t)(20000.0 * (Plant_Rand(&seed) - 0.5));
+            pitch_set = (int32_t)(20000.0 * (Plant_Rand(&seed) - 0.5));
+            nextStep += 500 + (int)(1500.0 * Plant_Rand(&seed));
+        }
+        if (i == nextGust) {
+            ps->dist[0] = 0.3 * (Plant_Rand(&seed) - 0.5);
+            ps->dist[1] = 0.3 * (Plant_Rand(&seed) - 0.5);
+            gustEnd = i + 100 + (int)(400.0 * Plant_Rand(&seed));
+            nextGust += 1000 + (int)(2000.0 * Plant_Rand(&seed));
+        }
+        if (i == gustEnd) {
+            ps->dist[0] = ps->dist[1] = 0.0;
+        }
+
+        Sim_Tick(DT);
+
+        if (abs(roll_true) > TIP_MDEG || abs(pitch_true) > TIP_MDEG) return false;
+        if (i < settleTicks) continue;
+
+        {
+            double er = (roll_true - roll_set) / 1000.0;
+            double ep = (pitch_true - pitch_set) / 1000.0;
+            double mean;
+
+            Sim_Motors(cmd);
+            mean = (cmd[0] + cmd[1] + cmd[2] + cmd[3]) / 4.0;
+            *errSq += er * er + ep * ep;
+            for (int m = 0; m < 4; m++) *effSq += (cmd[m] - mean) * (cmd[m] - mean);
+            (*n)++;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Scores one candidate over nFlights flights
+ */
+static void evaluate(Candidate *c, uint64_t baseSeed, int index)
+{
+    double errSq = 0.0, effSq = 0.0;
+    long n = 0;
+
+    c->stable = true;
+    for (int f = 0; f < nFlights; f++) {
+        uint64_t seed = baseSeed ^ ((uint64_t)(index + 1) * 0x9E3779B97F4A7C15ULL) ^ ((uint64_t)(f + 1) << 40);
+        if (!flyOnce(c, seed, &errSq, &effSq, &n)) {
+            c->stable = false;
+            break;
+        }
+    }
+    c->track = (n > 0) ? sqrt(errSq / (2.0 * n)) : INFINITY;
+    c->effort = (n > 0) ? sqrt(effSq / (4.0 * n)) : INFINITY;
+}
+
+/**
+ * @brief Evaluates candidates w, w+workers, ... and writes them to fd
+ */
+static void worker(Candidate *cands, int count, int w, int workers, uint64_t seed, int fd)
+{
+    for (int i = w; i < count; i += workers) {
+        Result r;
+        evaluate(&cands[i], seed, i);
+        r.index = i;
+        r.c = cands[i];
+        if (write(fd, &r, sizeof(r)) != sizeof(r)) _exit(1);
+    }
+    _exit(0);
+}
+
+static int byTrack(const void *a, const void *b)
+{
+    const Candidate *x = a, *y = b;
+    return (x->track > y->track) - (x->track < y->track);
+}
+
+int main(int argc, char **argv)
+{
+    int count = 300;
+    int workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t seed = 1;
+    const char *csvPath = NULL;
+    Candidate *cands;
+    int pipes[2], opt, received = 0, nStable = 0, nPareto = 0;
+
+    while ((opt = getopt(argc, argv, "n:f:t:j:S:l:o:")) != -1) {
+        switch (opt) {
+        case 'n': count = atoi(optarg); break;
+        case 'f': nFlights = atoi(optarg); break;
+        case 't': flightSeconds = atof(optarg); break;
+        case 'j': workers = atoi(optarg); break;
+        case 'S': seed = strtoull(optarg, NULL, 0); break;
+        case 'l': lutExp = atof(optarg); break;
+        case 'o': csvPath = optarg; break;
+        default:
+            fprintf(stderr, "usage: gainsweep [-n candidates] [-f flights] [-t seconds] "
+                            "[-j workers] [-S seed] [-l lut_exp] [-o all.csv]\n");
+            return 2;
+        }
+    }
+    if (workers < 1) workers = 1;
+
+    // Candidates are drawn up front so every worker count sees the same set
+    cands = calloc((size_t)count, sizeof(Candidate));
+    {
+        uint64_t s = seed;
+        for (int i = 0; i < count; i++) {
+            cands[i].kp = logUniform(&s, 50, 5000);
+            cands[i].ki = (Plant_Rand(&s) < 0.1) ? 0 : logUniform(&s, 1, 2000);
+            cands[i].kd = (Plant_Rand(&s) < 0.1) ? 0 : logUniform(&s, 1000, 200000);
+        }
+    }
+
+    fprintf(stderr, "%d candidates x %d flights x %.1f s on %d workers, lut_exp %.1f\n",
+            count, nFlights, flightSeconds, workers, lutExp);
+
+    if (pipe(pipes) != 0) {
+        perror("pipe");
+        return 1;
+    }
+    for (int w = 0; w < workers; w++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(pipes[0]);
+            worker(cands, count, w, workers, seed, pipes[1]);
+        } else if (pid < 0) {
+            perror("fork");
+            return 1;
+        }
+    }
+    close(pipes[1]);
+
+    // Records are smaller than PIPE_BUF, so each arrives whole
+    for (;;) {
+        Result r;
+        if (read(pipes[0], &r, sizeof(r)) != sizeof(r)) break;
+        if (r.index >= 0 && r.index < count) cands[r.index] = r.c;
+        if (++received % 50 == 0) fprintf(stderr, "  %d/%d\n", received, count);
+    }
+    while (wait(NULL) > 0) {}
+    if (received != count) {
+        fprintf(stderr, "only %d of %d candidates came back\n", received, count);
+        return 1;
+    }
+
+    // Pareto front over the stable candidates
+    for (int i = 0; i < count; i++) {
+        if (!cands[i].stable) continue;
+        nStable++;
+        cands[i].pareto = true;
+        for (int j = 0; j < count && cands[i].pareto; j++) {
+            if (j == i || !cands[j].stable) continue;
+            if (cands[j].track <= cands[i].track && cands[j].effort <= cands[i].effort &&
+                (cands[j].track < cands[i].track || cands[j].effort < cands[i].effort)) {
+                cands[i].pareto = false;
+            }
+        }
+        nPareto += cands[i].pareto;
+    }
+
+    if (csvPath) {
+        FILE *f = fopen(csvPath, "w");
+        if (!f) {
+            perror(csvPath);
+            return 1;
+        }
+        fprintf(f, "kp,ki,kd,stable,track_deg,effort,pareto\n");
+        for (int i = 0; i < count; i++) {
+            fprintf(f, "%d,%d,%d,%d,%.4f,%.3f,%d\n", cands[i].kp, cands[i].ki, cands[i].kd,
+                    cands[i].stable, cands[i].track, cands[i].effort, cands[i].pareto);
+        }
+        fclose(f);
+    }
+
+    qsort(cands, (size_t)count, sizeof(Candidate), byTrack);
+    printf("%d of %d candidates stable, %d on the Pareto front\n\n", nStable, count, nPareto);
+    printf("%8s %8s %8s %12s %10s\n", "Kp", "Ki", "Kd", "track(deg)", "effort");
+    for (int i = 0; i < count; i++) {
+        if (!cands[i].pareto) continue;
+        printf("%8d %8d %8d %12.3f %10.2f\n", cands[i].kp, cands[i].ki, cands[i].kd,
+               cands[i].track, cands[i].effort);
+    }
+    for (int i = 0; i < count; i++) {
+        if (!cands[i].pareto) continue;
+        printf("\nBest tracking, for main.c:\n"
+               "int32_t Kp_roll = %d;\nint32_t Ki_roll = %d;\nint32_t Kd_roll = %d;\n\n"
+               "int32_t Kp_pitch = %d;\nint32_t Ki_pitch = %d;\nint32_t Kd_pitch = %d;\n",
+               cands[i].kp, cands[i].ki, cands[i].kd, cands[i].kp, cands[i].ki, cands[i].kd);
+        break;
+    }
+    free(cands);
+    return 0;
+}
@@ -0,0 +1,162 @@
+/**
+  ******************************************************************************
+  * @file    lqrcmp.c
+  * @author  Aaron Lubinsky
+  * @brief   PID against LQR state feedback on steps and disturbances
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Flies the same scenarios with three controllers: the PID with
+  *          the firmware's default gains, the PID with a tuned roll/pitch
+  *          set, and the LQR gains compiled in from LQRGains.h:
+  *
+  *            roll step     10° roll step
+  *            roll+yaw      10° roll and 30° yaw together, which is where
+  *                          the PID's fixed mixer makes the axes fight over
+  *                          the same motors
+  *            disturbance   roll, pitch and yaw torques for 1 s, then the
+  *                          recovery
+  *
+  *          Each is scored on the true attitude against the setpoint (RMS
+  *          and largest roll/pitch error, RMS yaw error), the RMS motor
+  *          offset from the mean command as the control effort, and the
+  *          ticks with a motor at the ESC limit. The sensor has noise and
+  *          latency and the motors their time constant, none of which the
+  *          LQR design knows about.
+  *
+  *          The firmware's default yaw PID gains are zero, so the PID rows
+  *          hold yaw only by drag; the LQR regulates all three axes.
+  *
+  *          Usage: lqrcmp [noise_mdeg] [delay_ticks] [effort]
+  *
+  ******************************************************************************
+  */
+
+#include "Sim.h"
+#include "LQR.h"
+#include "ESC.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define DT          0.001  ///< Control loop period (s)
+#define RUN_TICKS   3000   ///< Length of each scenario after levelling
+#define N_CTRL      3
+#define N_SCEN      3
+
+typedef struct {
+    const char *name;
+    int law;                  ///< CTRL_LAW_PID or CTRL_LAW_LQR
+    int32_t kp, ki, kd;       ///< Roll/pitch PID gains
+} Controller;
+
+typedef struct {
+    double sumRP, maxRP;      ///< Squared and largest roll/pitch error (deg)
+    double sumYaw;            ///< Squared yaw error (deg^2)
+    double sumU;              ///< Squared motor offsets from the mean (counts^2)
+    long sat;                 ///< Ticks with a motor at ESC_CMD_MAX or idle
+    long n;
+} Score;
+
+static const char *scenName[N_SCEN] = {"roll step", "roll+yaw", "disturbance"};
+
+static double wrapDeg(double d)
+{
+    while (d > 180.0) d -= 360.0;
+    while (d < -180.0) d += 360.0;
+    return d;
+}
+
+static void score(Score *s)
+{
+    const PlantState *ps = Sim_State();
+    double er = ps->roll * 180.0 / M_PI - roll_set / 1000.0;
+    double ep = ps->pitch * 180.0 / M_PI - pitch_set / 1000.0;
+    double ey = wrapDeg(ps->yaw * 180.0 / M_PI - yaw_set / 1000.0);
+    uint32_t cmd[4];
+    double mean;
+
+    Sim_Motors(cmd);
+    mean = (cmd[0] + cmd[1] + cmd[2] + cmd[3]) / 4.0;
+    for (int m = 0; m < 4; m++) {
+        s->sumU += (cmd[m] - mean) * (cmd[m] - mean);
+        if (cmd[m] >= ESC_CMD_MAX || cmd[m] <= ESC_CMD_MIN) {
+            s->sat++;
+            break;
+        }
+    }
+    s->sumRP += 0.5 * (er * er + ep * ep);
+    s->sumYaw += ey * ey;
+    if (fabs(er) > s->maxRP) s->maxRP = fabs(er);
+    if (fabs(ep) > s->maxRP) s->maxRP = fabs(ep);
+    s->n++;
+}
+
+static Score run(const Controller *c, int scen, const PlantParams *pp, int32_t effort)
+{
+    Score s = {0};
+
+    ctrlLaw = c->law;
+    Kp_roll = Kp_pitch = c->kp;
+    Ki_roll = Ki_pitch = c->ki;
+    Kd_roll = Kd_pitch = c->kd;
+
+    Sim_Init(pp, 11);
+    effort_set = effort;
+    for (int i = 0; i < 1000; i++) Sim_Tick(DT);
+
+    switch (scen) {
+    case 0:
+        roll_set = 10000;
+        break;
+    case 1:
+        roll_set = 10000;
+        yaw_set = 30000;
+        break;
+    default:
+        Sim_State()->dist[0] = 0.02;
+        Sim_State()->dist[1] = -0.015;
+        Sim_State()->dist[2] = 0.01;
+        break;
+    }
+    for (int i = 0; i < RUN_TICKS; i++) {
+        if (scen == 2 && i == 1000) {
+            Sim_State()->dist[0] = Sim_State()->dist[1] = Sim_State()->dist[2] = 0.0;
+        }
+        Sim_Tick(DT);
+        score(&s);
+    }
+    return s;
+}
+
+int main(int argc, char **argv)
+{
+    double noise = (argc > 1) ? atof(argv[1]) : 50.0;
+    int delay = (argc > 2) ? atoi(argv[2]) : 5;
+    int32_t effort = (argc > 3) ? atoi(argv[3]) : 500;
+    const Controller ctrl[N_CTRL] = {
+        {"PID (defaults)", CTRL_LAW_PID, Kp_roll, Ki_roll, Kd_roll},
+        {"PID (tuned)",    CTRL_LAW_PID, 1500, 100, 100000},
+        {"LQR",            CTRL_LAW_LQR, Kp_roll, Ki_roll, Kd_roll},
+    };
+    PlantParams pp;
+
+    Plant_Defaults(&pp);
+    pp.noise_mdeg = noise;
+    pp.delay_ticks = delay;
+    pp.gyro_noise = 0.003;
+
+    printf("effort %ld, Euler noise %.0f mdeg, delay %d ticks, motor tau %.0f ms\n",
+           (long)effort, noise, delay, pp.tau_motor * 1000.0);
+    printf("%-12s %-15s %8s %8s %8s %9s %6s\n", "scenario", "controller",
+           "rp rms", "rp max", "yaw rms", "effort", "sat ms");
+    for (int sc = 0; sc < N_SCEN; sc++) {
+        for (int c = 0; c < N_CTRL; c++) {
+            Score s = run(&ctrl[c], sc, &pp, effort);
+
+            printf("%-12s %-15s %7.2f° %7.2f° %7.2f° %6.1f ct %6ld\n", c ? "" : scenName[sc], ctrl[c].name,
+                   sqrt(s.sumRP / s.n), s.maxRP, sqrt(s.sumYaw / s.n), sqrt(s.sumU / (4.0 * s.n)), s.sat);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,334 @@
+/**
+  ******************************************************************************
+  * @file    lqrgen.c
+  * @author  Aaron Lubinsky
+  * @brief   Computes the LQR gain matrix from the plant model into Core/Inc/LQRGains.h
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Linearizes the Plant.c rigid body about level hover with the
+  *          firmware's units and sign conventions:
+  *
+  *            state  x = [roll pitch yaw errors (rad), p q r (rad/s),
+  *                        integrals of the three errors (rad s)]
+  *            input  u = [A B C D] motor command offsets (compare counts)
+  *
+  *          Thrust per count is the slope of Plant_Thrust() at the design
+  *          throttle (-e, effort_set). The firmware ships without a thrust
+  *          curve, so on the quadratic plant that slope grows with throttle
+  *          and K is only exact at that effort; set the plant's lut_exp
+  *          (-l) to design for a calibrated thrustLUT instead. The torque
+  *          rows follow the X geometry in Plant_Step(). The continuous model is discretized at
+  *          the 1 kHz loop and the discrete Riccati equation iterated to a
+  *          fixed point. Weights are Bryson's rule: each state or input is
+  *          divided by the largest value it should normally reach.
+  *
+  *          K is written in firmware units (counts per millidegree,
+  *          millidegree/s and millidegree second) in Q16, so LQR.c needs
+  *          only integer multiply-accumulates. Motor lag and sensor delay
+  *          are left out of the design; lqrcmp flies the result with both.
+  *
+  *          Usage: lqrgen [-a deg] [-r deg/s] [-i deg_s] [-y deg] [-u counts]
+  *                        [-e effort] [-l lut_exp] [-o header]
+  *
+  ******************************************************************************
+  */
+
+#include "Plant.h"
+#include "ESC.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#define NX      9       ///< States
+#define NU      4       ///< Inputs (motors)
+#define DT      0.001   ///< Control loop period (s)
+#define K_SHIFT 16      ///< Fixed-point shift of the written gains
+#define MAX_ITER 2000000
+#define TOL     1e-10
+#define EFFORT_COUNTS 0.5 ///< Compare counts per count of effort_set (K_effort / PID_SCALE in main.c)
+
+typedef double MatXX[NX][NX];
+typedef double MatXU[NX][NU];
+typedef double MatUU[NU][NU];
+
+/**
+ * @brief Inverts a 4x4 matrix by Gauss-Jordan with partial pivoting
+ */
+static int invertUU(const MatUU a, MatUU inv)
+{
+    double m[NU][2 * NU];
+
+    for (int i = 0; i < NU; i++) {
+        for (int j = 0; j < NU; j++) {
+            m[i][j] = a[i][j];
+            m[i][NU + j] = (i == j) ? 1.0 : 0.0;
+        }
+    }
+    for (int c = 0; c < NU; c++) {
+        int p = c;
+        for (int r = c + 1; r < NU; r++) {
+            if (fabs(m[r][c]) > fabs(m[p][c])) p = r;
+        }
+        if (fabs(m[p][c]) < 1e-300) return -1;
+        for (int j = 0; j < 2 * NU; j++) {
+            double t = m[c][j];
+            m[c][j] = m[p][j];
+            m[p][j] = t;
+        }
+        for (int r = 0; r < NU; r++) {
+            double f;
+            if (r == c) continue;
+            f = m[r][c] / m[c][c];
+            for (int j = 0; j < 2 * NU; j++) m[r][j] -= f * m[c][j];
+        }
+    }
+    for (int i = 0; i < NU; i++) {
+        for (int j = 0; j < NU; j++) inv[i][j] = m[i][NU + j] / m[i][i];
+    }
+    return 0;
+}
+
+/**
+ * @brief Thrust per compare count at a throttle, through the plant's thrust curve (N)
+ */
+static double thrustSlope(const PlantParams *pp, int effort)
+{
+    uint32_t cmd = (uint32_t)lround(ESC_CMD_MIN + effort * EFFORT_COUNTS);
+    return (Plant_Thrust(pp, cmd + 1) - Plant_Thrust(pp, cmd - 1)) / 2.0;
+}
+
+/**
+ * @brief Continuous-time model about level hover
+ */
+static void buildModel(const PlantParams *pp, double perCount, MatXX A, MatXU B)
+{
+    const double k = 0.70710678 * pp->arm; // Same lever arm as Plant_Step()
+    static const double rollSign[NU]  = {+1, +1, -1, -1}; // A+B roll positive
+    static const double pitchSign[NU] = {+1, -1, -1, +1}; // A+D pitch positive
+    static const double yawSign[NU]   = {-1, +1, -1, +1}; // B+D yaw positive
+
+    memset(A, 0, sizeof(MatXX));
+    memset(B, 0, sizeof(MatXU));
+    for (int i = 0; i < 3; i++) {
+        A[i][3 + i] = 1.0;     // Angle error integrates the rate
+        A[6 + i][i] = 1.0;     // Integral state integrates the angle error
+    }
+    A[3][3] = -pp->drag / pp->ixx;
+    A[4][4] = -pp->drag / pp->iyy;
+    A[5][5] = -pp->drag / pp->izz;
+    for (int m = 0; m < NU; m++) {
+        B[3][m] = k * perCount * rollSign[m] / pp->ixx;
+        B[4][m] = k * perCount * pitchSign[m] / pp->iyy;
+        B[5][m] = pp->k_yaw * perCount * yawSign[m] / pp->izz;
+    }
+}
+
+/**
+ * @brief Second-order discretization: Ad = I + A dt + (A dt)^2 / 2, Bd = (I dt + A dt^2 / 2) B
+ */
+static void discretize(const MatXX A, const MatXU B, MatXX Ad, MatXU Bd)
+{
+    MatXX A2;
+
+    for (int i = 0; i < NX; i++) {
+        for (int j = 0; j < NX; j++) {
+            A2[i][j] = 0.0;
+            for (int k = 0; k < NX; k++) A2[i][j] += A[i][k] * A[k][j];
+        }
+    }
+    for (int i = 0; i < NX; i++) {
+        for (int j = 0; j < NX; j++) {
+            Ad[i][j] = (i == j) + A[i][j] * DT + A2[i][j] * DT * DT / 2.0;
+        }
+        for (int m = 0; m < NU; m++) {
+            Bd[i][m] = B[i][m] * DT;
+            for (int k = 0; k < NX; k++) Bd[i][m] += A[i][k] * B[k][m] * DT * DT / 2.0;
+        }
+    }
+}
+
+/**
+ * @brief Iterates P = Q + A'P(A - BK), K = (R + B'PB)^-1 B'PA to a fixed point
+ *
+ * @return Iterations taken, -1 if it did not converge
+ */
+static int solveDare(const MatXX A, const MatXU B, const double Q[NX], const double R[NU], double K[NU][NX])
+{
+    static MatXX P, Pn, Acl, T;
+    MatXU PB;
+    MatUU S, Si;
+    double BtPA[NU][NX];
+
+    memset(P, 0, sizeof(P));
+    for (int i = 0; i < NX; i++) P[i][i] = Q[i];
+
+    for (int it = 0; it < MAX_ITER; it++) {
+        double change = 0.0, scale = 0.0;
+
+        // PB = P B, S = R + B'PB, BtPA = B'P A
+        for (int i = 0; i < NX; i++) {
+            for (int m = 0; m < NU; m++) {
+                PB[i][m] = 0.0;
+                for (int k = 0; k < NX; k++) PB[i][m] += P[i][k] * B[k][m];
+            }
+        }
+        for (int a = 0; a < NU; a++) {
+            for (int b = 0; b < NU; b++) {
+                S[a][b] = (a == b) ? R[a] : 0.0;
+                for (int k = 0; k < NX; k++) S[a][b] += B[k][a] * PB[k][b];
+            }
+            for (int j = 0; j < NX; j++) {
+                BtPA[a][j] = 0.0;
+                for (int k = 0; k < NX; k++) BtPA[a][j] += PB[k][a] * A[k][j];
+            }
+        }
+        if (invertUU(S, Si) != 0) return -1;
+        for (int a = 0; a < NU; a++) {
+            for (int j = 0; j < NX; j++) {
+                K[a][j] = 0.0;
+                for (int b = 0; b < NU; b++) K[a][j] += Si[a][b] * BtPA[b][j];
+            }
+        }
+
+        // Pn = Q + A'P(A - BK)
+        for (int i = 0; i < NX; i++) {
+            for (int j = 0; j < NX; j++) {
+                Acl[i][j] = A[i][j];
+                for (int m = 0; m < NU; m++) Acl[i][j] -= B[i][m] * K[m][j];
+            }
+        }
+        for (int i = 0; i < NX; i++) {
+            for (int j = 0; j < NX; j++) {
+                T[i][j] = 0.0;
+                for (int k = 0; k < NX; k++) T[i][j] += P[i][k] * Acl[k][j];
+            }
+        }
+        for (int i = 0; i < NX; i++) {
+            for (int j = 0; j < NX; j++) {
+                Pn[i][j] = (i == j) ? Q[i] : 0.0;
+                for (int k = 0; k < NX; k++) Pn[i][j] += A[k][i] * T[k][j];
+            }
+        }
+        for (int i = 0; i < NX; i++) {
+            for (int j = 0; j < NX; j++) {
+                change = fmax(change, fabs(Pn[i][j] - P[i][j]));
+                scale = fmax(scale, fabs(Pn[i][j]));
+                P[i][j] = 0.5 * (Pn[i][j] + Pn[j][i]); // Keep it symmetric
+            }
+        }
+        if (change <= TOL * scale) return it + 1;
+    }
+    return -1;
+}
+
+int main(int argc, char **argv)
+{
+    double angleMax = 2.0, rateMax = 30.0, intMax = 0.5, yawMax = 10.0, uMax = 100.0;
+    double lutExp = 1.0, perCount;
+    int effort = 500;
+    const char *out = "../Core/Inc/LQRGains.h";
+    PlantParams pp;
+    MatXX A, Ad;
+    MatXU B, Bd;
+    double Q[NX], R[NU], K[NU][NX];
+    const double toRad = M_PI / 180.0;
+    const double perMdeg = M_PI / 180000.0; // rad per millidegree
+    FILE *f;
+    int opt, iters;
+
+    while ((opt = getopt(argc, argv, "a:r:i:y:u:e:l:o:")) != -1) {
+        switch (opt) {
+        case 'a': angleMax = atof(optarg); break;
+        case 'r': rateMax = atof(optarg); break;
+        case 'i': intMax = atof(optarg); break;
+        case 'y': yawMax = atof(optarg); break;
+        case 'u': uMax = atof(optarg); break;
+        case 'e': effort = atoi(optarg); break;
+        case 'l': lutExp = atof(optarg); break;
+        case 'o': out = optarg; break;
+        default:
+            fprintf(stderr, "usage: lqrgen [-a deg] [-r deg/s] [-i deg_s] [-y deg] [-u counts] "
+                            "[-e effort] [-l lut_exp] [-o header]\n");
+            return 1;
+        }
+    }
+
+    Plant_Defaults(&pp);
+    pp.lut_exp = lutExp;
+    perCount = thrustSlope(&pp, effort);
+    if (perCount <= 0.0) {
+        fprintf(stderr, "lqrgen: no thrust at effort %d\n", effort);
+        return 1;
+    }
+    buildModel(&pp, perCount, A, B);
+    discretize(A, B, Ad, Bd);
+
+    // Bryson's rule; yaw gets its own angle limit and proportionally looser rate and integral
+    for (int i = 0; i < 2; i++) {
+        Q[i] = 1.0 / pow(angleMax * toRad, 2);
+        Q[3 + i] = 1.0 / pow(rateMax * toRad, 2);
+        Q[6 + i] = 1.0 / pow(intMax * toRad, 2);
+    }
+    Q[2] = 1.0 / pow(yawMax * toRad, 2);
+    Q[5] = 1.0 / pow(rateMax * yawMax / angleMax * toRad, 2);
+    Q[8] = 1.0 / pow(intMax * yawMax / angleMax * toRad, 2);
+    for (int m = 0; m < NU; m++) R[m] = 1.0 / (uMax * uMax);
+
+    iters = solveDare(Ad, Bd, Q, R, K);
+    if (iters < 0) {
+        fprintf(stderr, "lqrgen: Riccati iteration did not converge\n");
+        return 1;
+    }
+
+    f = fopen(out, "w");
+    if (!f) {
+        perror(out);
+        return 1;
+    }
+    fprintf(f, "/**\n"
+               " * @file LQRGains.h\n"
+               " * @brief LQR state-feedback gains for LQR.c, generated by Tools/Sim/lqrgen.\n"
+               " *\n"
+               " * Do not edit; rerun lqrgen after changing the plant model or weights.\n"
+               " * Weights (largest expected value): angle %.1f deg, rate %.0f deg/s,\n"
+               " * integral %.2f deg s, yaw %.1f deg, motor offset %.0f counts.\n"
+               " * Plant: t_max %.2f N, arm %.3f m, Ixx %.4f, Iyy %.4f, Izz %.4f kg m^2.\n"
+               " * Linearized at effort %d: %.5f N per count (thrust exponent %.1f,\n"
+               " * lut_exp %.1f); other throttles see a different loop gain.\n"
+               " * Riccati iteration converged in %d steps at %.0f Hz.\n"
+               " *\n"
+               " * Row m is motor m (A, B, C, D); columns are the roll, pitch and yaw\n"
+               " * errors (mdeg), the body rates (mdeg/s) and the error integrals\n"
+               " * (mdeg s, as update_Motors() accumulates them). Offset in compare\n"
+               " * counts = -(row . x) >> LQR_K_SHIFT.\n"
+               " */\n\n"
+               "#ifndef INC_LQRGAINS_H_\n"
+               "#define INC_LQRGAINS_H_\n\n"
+               "#include <stdint.h>\n\n"
+               "#define LQR_STATES  %d  ///< Errors, rates, integrals\n"
+               "#define LQR_INPUTS  %d  ///< Motors A to D\n"
+               "#define LQR_K_SHIFT %d ///< Gains are Q%d\n\n"
+               "static const int32_t lqrK[LQR_INPUTS][LQR_STATES] = {\n",
+            angleMax, rateMax, intMax, yawMax, uMax, pp.t_max, pp.arm, pp.ixx, pp.iyy, pp.izz,
+            effort, perCount, pp.thrust_exp, pp.lut_exp, iters, 1.0 / DT, NX, NU, K_SHIFT, K_SHIFT);
+    for (int m = 0; m < NU; m++) {
+        fprintf(f, "    {");
+        for (int j = 0; j < NX; j++) {
+            fprintf(f, "%s%ld", j ? ", " : "", lround(K[m][j] * perMdeg * (1 << K_SHIFT)));
+        }
+        fprintf(f, "}, ///< Motor %c\n", 'A' + m);
+    }
+    fprintf(f, "};\n\n#endif /* INC_LQRGAINS_H_ */\n");
+    fclose(f);
+
+    printf("wrote %s (%d iterations)\n", out, iters);
+    for (int m = 0; m < NU; m++) {
+        printf("  %c:", 'A' + m);
+        for (int j = 0; j < NX; j++) printf(" %9.2f", K[m][j]);
+        printf("\n");
+    }
+    return 0;
+}
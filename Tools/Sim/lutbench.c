@@ -0,0 +1,104 @@
+/**
+  ******************************************************************************
+  * @file    lutbench.c
+  * @author  Aaron Lubinsky
+  * @brief   Per-tick cost and accuracy of the thrust linearization lookup
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Times the four linearize_Thrust() calls update_Motors() makes
+  *          per control tick, over a pseudo-random spread of mixer outputs,
+  *          against the same loop without the lookup, and puts the
+  *          difference next to the cost of a whole update_Motors() call
+  *          on the simulated airframe.
+  *
+  *          Also checks the table against the curve it stands for: with the
+  *          THRUST_LUT_IDEAL rows this tool alone is built with (the other
+  *          tools fly the shipped identity rows), the exact inverse of the
+  *          plant's quadratic thrust (1000 + 700 * sqrt(fraction)), so the
+  *          interpolation error between breakpoints shows up in counts.
+  *
+  *          Host numbers only rank the options; the Cortex-M4 cost is in
+  *          ctrlCycles on the target.
+  *
+  *          Usage: lutbench [ticks]
+  *
+  ******************************************************************************
+  */
+
+#include "Sim.h"
+#include "ESC.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#define DT 0.001 ///< Control loop period (s)
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+    long ticks = (argc > 1) ? atol(argv[1]) : 20000000L;
+    int32_t *cmd = malloc(sizeof(int32_t) * 4096);
+    volatile int32_t sink = 0;
+    double t0, tRaw, tLut, tCtrl, maxErr = 0.0, sumErr = 0.0;
+    PlantParams pp;
+    long n = 0;
+
+    // Mixer outputs across the whole range, a little past both ends
+    srand(1);
+    for (int i = 0; i < 4096; i++) {
+        cmd[i] = ESC_CMD_MIN - 20 + rand() % (ESC_CMD_MAX - ESC_CMD_MIN + 40);
+    }
+
+    t0 = now();
+    for (long t = 0; t < ticks; t++) {
+        const int32_t *c = &cmd[(t * 4) & 4095];
+        sink += c[0] + c[1] + c[2] + c[3];
+    }
+    tRaw = now() - t0;
+
+    t0 = now();
+    for (long t = 0; t < ticks; t++) {
+        const int32_t *c = &cmd[(t * 4) & 4095];
+        sink += linearize_Thrust(0, c[0]) + linearize_Thrust(1, c[1]) +
+                linearize_Thrust(2, c[2]) + linearize_Thrust(3, c[3]);
+    }
+    tLut = now() - t0;
+
+    // Whole control step for scale, on a hovering airframe
+    Plant_Defaults(&pp);
+    Sim_Init(&pp, 1);
+    effort_set = 500;
+    for (int i = 0; i < 1000; i++) Sim_Tick(DT);
+    t0 = now();
+    for (long t = 0; t < ticks / 20; t++) update_Motors();
+    tCtrl = (now() - t0) / (ticks / 20);
+
+    for (int32_t c = ESC_CMD_MIN + 1; c < ESC_CMD_MAX; c++) {
+        double f = (double)(c - ESC_CMD_MIN) / (ESC_CMD_MAX - ESC_CMD_MIN);
+        double exact = THRUST_LUT_IDEAL ? 1000.0 + 700.0 * sqrt(f) : c;
+        double err = fabs(linearize_Thrust(0, c) - exact);
+
+        if (err > maxErr) maxErr = err;
+        sumErr += err;
+        n++;
+    }
+
+    printf("%ld ticks, %s rows\n", ticks, THRUST_LUT_IDEAL ? "ideal quadratic" : "identity");
+    printf("4 lookups per tick: %.2f ns (%.2f ns with the lookup, %.2f ns without)\n",
+           (tLut - tRaw) / ticks * 1e9, tLut / ticks * 1e9, tRaw / ticks * 1e9);
+    printf("update_Motors():    %.2f ns per call, lookups %.1f%% of it\n",
+           tCtrl * 1e9, 100.0 * (tLut - tRaw) / ticks / tCtrl);
+    printf("table vs curve:     mean %.2f, max %.2f counts", sumErr / n, maxErr);
+    printf(THRUST_LUT_IDEAL ? " (the first segment is the steepest)\n" : "\n");
+    free(cmd);
+    return sink == 42; // Keeps the loops from being optimised away
+}
@@ -0,0 +1,613 @@
+/**
+  ******************************************************************************
+  * @file    mavcheck.c
+  * @author  Aaron Lubinsky
+  * @brief   Round trip of every MAVLink message MAVLink.c supports
+  * @version 1.0
+  * @date    2026
+  *
+  * @details The message definitions below are the field lists from
+  *          common.xml / ardupilotmega.xml, not copies of MAVLink.c's
+  *          table. From them this tool derives what mavgen would: the wire
+  *          order (fields sorted by type size, extensions last), each
+  *          field's offset, the full payload length and CRC_EXTRA. Those
+  *          are first checked against the published values, then used to:
+  *
+  *          - decode every frame MAVLink.c sends (HEARTBEAT, MEMINFO,
+  *            ATTITUDE, DEBUG_FLOAT_ARRAY, PARAM_VALUE, LOG_ENTRY,
+  *            LOG_DATA): start byte, IDs, length no longer than the full
+  *            payload, CRC with the derived CRC_EXTRA, and the field values
+  *            read at the derived offsets
+  *          - encode every message it receives (RC_CHANNELS_OVERRIDE,
+  *            PARAM_REQUEST_LIST/READ, PARAM_SET, LOG_REQUEST_LIST/DATA/END),
+  *            truncated the way v2 senders do, and check the drone acts on
+  *            them; plus a bad CRC, an unknown ID and an overlong payload,
+  *            which must be counted in mavRxBad
+  *
+  *          Usage: mavcheck   (exits 1 on any failure)
+  *
+  ******************************************************************************
+  */
+
+#include "Sim.h"
+#include "MAVLink.h"
+#include "Params.h"
+#include "BNO055.h"
+#include "Latency.h"
+#include "StackMon.h"
+#include "stm32f4xx_hal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define DT          0.001 ///< Control loop period (s)
+#define MAX_FIELDS  32
+#define CAPTURE     (1 << 20)
+#define MAX_FRAMES  4096
+
+extern UART_HandleTypeDef huart2;
+
+int escArming = 0; ///< Normally MainLoop.c, which this check does not link
+
+/* ===== MESSAGE DEFINITIONS (XML order) ===== */
+
+typedef struct {
+    const char *type;  ///< Base type as in the XML (uint8_t_mavlink_version counts as uint8_t)
+    const char *name;
+    uint8_t array;     ///< Array length, 0 for a scalar
+    uint8_t ext;       ///< Declared after <extensions/>
+} Field;
+
+typedef struct {
+    const char *name;
+    uint32_t id;
+    uint8_t extra;     ///< Published CRC_EXTRA
+    uint8_t len;       ///< Published full payload length (with extensions)
+    Field f[MAX_FIELDS];
+    /* Derived */
+    int n;
+    uint8_t offset[MAX_FIELDS];
+    uint8_t wireLen;
+    uint8_t wireExtra;
+} MsgDef;
+
+static MsgDef msgs[] = {
+    {"HEARTBEAT", MAV_MSG_HEARTBEAT, 50, 9, {
+        {"uint8_t", "type"}, {"uint8_t", "autopilot"}, {"uint8_t", "base_mode"},
+        {"uint32_t", "custom_mode"}, {"uint8_t", "system_status"}, {"uint8_t", "mavlink_version"}}},
+    {"PARAM_REQUEST_READ", MAV_MSG_PARAM_REQUEST_READ, 214, 20, {
+        {"uint8_t", "target_system"}, {"uint8_t", "target_component"},
+        {"char", "param_id", 16}, {"int16_t", "param_index"}}},
+    {"PARAM_REQUEST_LIST", MAV_MSG_PARAM_REQUEST_LIST, 159, 2, {
+        {"uint8_t", "target_system"}, {"uint8_t", "target_component"}}},
+    {"PARAM_VALUE", MAV_MSG_PARAM_VALUE, 220, 25, {
+        {"char", "param_id", 16}, {"float", "param_value"}, {"uint8_t", "param_type"},
+        {"uint16_t", "param_count"}, {"uint16_t", "param_index"}}},
+    {"PARAM_SET", MAV_MSG_PARAM_SET, 168, 23, {
+        {"uint8_t", "target_system"}, {"uint8_t", "target_component"}, {"char", "param_id", 16},
+        {"float", "param_value"}, {"uint8_t", "param_type"}}},
+    {"ATTITUDE", MAV_MSG_ATTITUDE, 39, 28, {
+        {"uint32_t", "time_boot_ms"}, {"float", "roll"}, {"float", "pitch"}, {"float", "yaw"},
+        {"float", "rollspeed"}, {"float", "pitchspeed"}, {"float", "yawspeed"}}},
+    {"RC_CHANNELS_OVERRIDE", MAV_MSG_RC_CHANNELS_OVERRIDE, 124, 38, {
+        {"uint8_t", "target_system"}, {"uint8_t", "target_component"},
+        {"uint16_t", "chan1_raw"}, {"uint16_t", "chan2_raw"}, {"uint16_t", "chan3_raw"}, {"uint16_t", "chan4_raw"},
+        {"uint16_t", "chan5_raw"}, {"uint16_t", "chan6_raw"}, {"uint16_t", "chan7_raw"}, {"uint16_t", "chan8_raw"},
+        {"uint16_t", "chan9_raw", 0, 1}, {"uint16_t", "chan10_raw", 0, 1}, {"uint16_t", "chan11_raw", 0, 1},
+        {"uint16_t", "chan12_raw", 0, 1}, {"uint16_t", "chan13_raw", 0, 1}, {"uint16_t", "chan14_raw", 0, 1},
+        {"uint16_t", "chan15_raw", 0, 1}, {"uint16_t", "chan16_raw", 0, 1}, {"uint16_t", "chan17_raw", 0, 1},
+        {"uint16_t", "chan18_raw", 0, 1}}},
+    {"LOG_REQUEST_LIST", MAV_MSG_LOG_REQUEST_LIST, 128, 6, {
+        {"uint8_t", "target_system"}, {"uint8_t", "target_component"},
+        {"uint16_t", "start"}, {"uint16_t", "end"}}},
+    {"LOG_ENTRY", MAV_MSG_LOG_ENTRY, 56, 14, {
+        {"uint16_t", "id"}, {"uint16_t", "num_logs"}, {"uint16_t", "last_log_num"},
+        {"uint32_t", "time_utc"}, {"uint32_t", "size"}}},
+    {"LOG_REQUEST_DATA", MAV_MSG_LOG_REQUEST_DATA, 116, 12, {
+        {"uint8_t", "target_system"}, {"uint8_t", "target_component"}, {"uint16_t", "id"},
+        {"uint32_t", "ofs"}, {"uint32_t", "count"}}},
+    {"LOG_DATA", MAV_MSG_LOG_DATA, 134, 97, {
+        {"uint16_t", "id"}, {"uint32_t", "ofs"}, {"uint8_t", "count"}, {"uint8_t", "data", 90}}},
+    {"LOG_REQUEST_END", MAV_MSG_LOG_REQUEST_END, 203, 2, {
+        {"uint8_t", "target_system"}, {"uint8_t", "target_component"}}},
+    {"MEMINFO", MAV_MSG_MEMINFO, 208, 8, {
+        {"uint16_t", "brkval"}, {"uint16_t", "freemem"}, {"uint32_t", "freemem32", 0, 1}}},
+    {"DEBUG_FLOAT_ARRAY", MAV_MSG_DEBUG_FLOAT_ARRAY, 232, 252, {
+        {"uint64_t", "time_usec"}, {"char", "name", 10}, {"uint16_t", "array_id"},
+        {"float", "data", 58, 1}}},
+};
+#define N_MSGS ((int)(sizeof(msgs) / sizeof(msgs[0])))
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf("  FAIL: " __VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+static int typeSize(const char *t)
+{
+    if (strstr(t, "64") || strcmp(t, "double") == 0) return 8;
+    if (strstr(t, "32") || strcmp(t, "float") == 0) return 4;
+    if (strstr(t, "16")) return 2;
+    return 1;
+}
+
+static uint16_t crcByte(uint16_t crc, uint8_t b)
+{
+    uint8_t t = b ^ (uint8_t)crc;
+    t ^= (uint8_t)(t << 4);
+    return (crc >> 8) ^ ((uint16_t)t << 8) ^ ((uint16_t)t << 3) ^ (t >> 4);
+}
+
+static uint16_t crcStr(uint16_t crc, const char *s)
+{
+    while (*s) crc = crcByte(crc, (uint8_t)*s++);
+    return crc;
+}
+
+/**
+ * @brief Wire order, offsets, length and CRC_EXTRA, as mavgen derives them
+ */
+static void derive(MsgDef *m)
+{
+    int order[MAX_FIELDS], k = 0, ofs = 0;
+    uint16_t crc;
+
+    for (m->n = 0; m->n < MAX_FIELDS && m->f[m->n].name; m->n++) {}
+
+    // Base fields by descending type size (stable), then extensions as declared
+    for (int size = 8; size >= 1; size /= 2) {
+        for (int i = 0; i < m->n; i++) {
+            if (!m->f[i].ext && typeSize(m->f[i].type) == size) order[k++] = i;
+        }
+    }
+    for (int i = 0; i < m->n; i++) {
+        if (m->f[i].ext) order[k++] = i;
+    }
+
+    crc = crcStr(0xFFFF, m->name);
+    crc = crcByte(crc, ' ');
+    for (int j = 0; j < m->n; j++) {
+        const Field *f = &m->f[order[j]];
+        int count = f->array ? f->array : 1;
+
+        m->offset[order[j]] = (uint8_t)ofs;
+        ofs += typeSize(f->type) * count;
+        if (f->ext) continue; // Extensions are not part of CRC_EXTRA
+        crc = crcStr(crc, f->type);
+        crc = crcByte(crc, ' ');
+        crc = crcStr(crc, f->name);
+        crc = crcByte(crc, ' ');
+        if (f->array) crc = crcByte(crc, f->array);
+    }
+    m->wireLen = (uint8_t)ofs;
+    m->wireExtra = (uint8_t)((crc & 0xFF) ^ (crc >> 8));
+}
+
+static MsgDef *msgById(uint32_t id)
+{
+    for (int i = 0; i < N_MSGS; i++) {
+        if (msgs[i].id == id) return &msgs[i];
+    }
+    return NULL;
+}
+
+/**
+ * @brief Offset of a field on the wire
+ */
+static int off(const MsgDef *m, const char *name)
+{
+    for (int i = 0; i < m->n; i++) {
+        if (strcmp(m->f[i].name, name) == 0) return m->offset[i];
+    }
+    fprintf(stderr, "%s has no field %s\n", m->name, name);
+    exit(2);
+}
+
+static uint16_t rd16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t rd32(const uint8_t *p) { return rd16(p) | ((uint32_t)rd16(p + 2) << 16); }
+static float rdf(const uint8_t *p) { uint32_t v = rd32(p); float f; memcpy(&f, &v, 4); return f; }
+static void wr16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void wr32(uint8_t *p, uint32_t v) { wr16(p, (uint16_t)v); wr16(p + 2, (uint16_t)(v >> 16)); }
+static void wrf(uint8_t *p, float f) { uint32_t v; memcpy(&v, &f, 4); wr32(p, v); }
+
+/* ===== CAPTURE AND DECODE (drone to ground) ===== */
+
+typedef struct {
+    uint32_t id;
+    uint8_t len;          ///< Length on the wire
+    uint8_t p[256];       ///< Payload, zero-extended to the full length
+} Frame;
+
+static uint8_t cap[CAPTURE];
+static size_t capLen = 0;
+static Frame frames[MAX_FRAMES];
+static int nFrames = 0;
+
+static void sink(int uart, const uint8_t *data, size_t len)
+{
+    if (uart != 2) return;
+    if (capLen + len > CAPTURE) len = CAPTURE - capLen;
+    memcpy(&cap[capLen], data, len);
+    capLen += len;
+}
+
+/**
+ * @brief Splits the capture into frames, checking every header and CRC
+ */
+static void decode(void)
+{
+    size_t i = 0;
+
+    nFrames = 0;
+    while (i < capLen) {
+        uint8_t len;
+        uint32_t id;
+        const MsgDef *m;
+        uint16_t crc = 0xFFFF;
+
+        if (cap[i] != MAV_STX || i + MAV_HEADER_LEN > capLen) {
+            CHECK(0, "stray byte 0x%02x at %zu", cap[i], i);
+            i++;
+            continue;
+        }
+        len = cap[i + 1];
+        id = cap[i + 7] | ((uint32_t)cap[i + 8] << 8) | ((uint32_t)cap[i + 9] << 16);
+        m = msgById(id);
+        CHECK(cap[i + 2] == 0 && cap[i + 3] == 0, "msg %u: flags %02x %02x", id, cap[i + 2], cap[i + 3]);
+        CHECK(cap[i + 5] == MAV_SYSID && cap[i + 6] == MAV_COMPID, "msg %u: sys/comp %u/%u", id, cap[i + 5], cap[i + 6]);
+        CHECK(m != NULL, "unknown msg id %u sent", id);
+        if (m == NULL || i + MAV_HEADER_LEN + len + 2 > capLen) break;
+        CHECK(len >= 1 && len <= m->wireLen, "%s: payload %u, full length %u", m->name, len, m->wireLen);
+
+        for (size_t j = i + 1; j < i + MAV_HEADER_LEN + len; j++) crc = crcByte(crc, cap[j]);
+        crc = crcByte(crc, m->wireExtra);
+        CHECK(crc == rd16(&cap[i + MAV_HEADER_LEN + len]), "%s: CRC %04x, expected %04x with CRC_EXTRA %u",
+              m->name, rd16(&cap[i + MAV_HEADER_LEN + len]), crc, m->wireExtra);
+        CHECK(len == 1 || len == m->wireLen || cap[i + MAV_HEADER_LEN + len - 1] != 0, "%s: trailing zero not truncated", m->name);
+
+        if (nFrames < MAX_FRAMES) {
+            Frame *f = &frames[nFrames++];
+            memset(f, 0, sizeof(*f));
+            f->id = id;
+            f->len = len;
+            memcpy(f->p, &cap[i + MAV_HEADER_LEN], len);
+        }
+        i += MAV_HEADER_LEN + len + 2;
+    }
+    capLen = 0;
+}
+
+/**
+ * @brief Runs MAV_Service() once per simulated ms, then decodes what it sent
+ */
+static void pump(int ms)
+{
+    for (int i = 0; i < ms; i++) {
+        MAV_Service();
+        Sim_Advance(DT);
+    }
+    decode();
+}
+
+static const Frame *find(const char *name, int nth)
+{
+    for (int i = 0; i < nFrames; i++) {
+        if (strcmp(msgById(frames[i].id)->name, name) == 0 && nth-- == 0) return &frames[i];
+    }
+    return NULL;
+}
+
+static int count(const char *name)
+{
+    int n = 0;
+    for (int i = 0; i < nFrames; i++) n += strcmp(msgById(frames[i].id)->name, name) == 0;
+    return n;
+}
+
+/* ===== ENCODE (ground to drone) ===== */
+
+static uint8_t txSeq = 0;
+
+/**
+ * @brief Frames a payload with the derived CRC_EXTRA, trailing zeros truncated,
+ *        and feeds it to MAV_Receive() as one idle-line event
+ */
+static void send(const char *name, const uint8_t *payload, int fullLen, int corrupt)
+{
+    MsgDef *m = NULL;
+    uint8_t f[MAV_FRAME_MAX];
+    uint16_t crc = 0xFFFF;
+    int len = fullLen;
+
+    for (int i = 0; i < N_MSGS; i++) {
+        if (strcmp(msgs[i].name, name) == 0) m = &msgs[i];
+    }
+    while (len > 1 && payload[len - 1] == 0) len--;
+
+    f[0] = MAV_STX;
+    f[1] = (uint8_t)len;
+    f[2] = 0;
+    f[3] = 0;
+    f[4] = txSeq++;
+    f[5] = 255; // Ground station
+    f[6] = 190;
+    f[7] = (uint8_t)m->id;
+    f[8] = (uint8_t)(m->id >> 8);
+    f[9] = (uint8_t)(m->id >> 16);
+    memcpy(&f[MAV_HEADER_LEN], payload, len);
+    for (int i = 1; i < MAV_HEADER_LEN + len; i++) crc = crcByte(crc, f[i]);
+    crc = crcByte(crc, m->wireExtra);
+    wr16(&f[MAV_HEADER_LEN + len], corrupt ? (uint16_t)~crc : crc);
+
+    huart2.RxState = HAL_UART_STATE_READY; // Each call is a complete reception
+    MAV_Receive(f, (uint16_t)(MAV_HEADER_LEN + len + 2));
+}
+
+/* ===== CHECKS ===== */
+
+static void checkDefinitions(void)
+{
+    printf("%-22s %5s %4s %6s\n", "message", "id", "len", "extra");
+    for (int i = 0; i < N_MSGS; i++) {
+        MsgDef *m = &msgs[i];
+        derive(m);
+        printf("%-22s %5u %4u %6u\n", m->name, m->id, m->wireLen, m->wireExtra);
+        CHECK(m->wireLen == m->len, "%s: derived length %u, published %u", m->name, m->wireLen, m->len);
+        CHECK(m->wireExtra == m->extra, "%s: derived CRC_EXTRA %u, published %u", m->name, m->wireExtra, m->extra);
+    }
+}
+
+static void checkTelemetry(void)
+{
+    const MsgDef *hb = msgById(MAV_MSG_HEARTBEAT), *att = msgById(MAV_MSG_ATTITUDE);
+    const MsgDef *mem = msgById(MAV_MSG_MEMINFO), *dbg = msgById(MAV_MSG_DEBUG_FLOAT_ARRAY);
+    const Frame *f;
+
+    printf("telemetry\n");
+    state = 1;
+    roll_true = 10000;
+    pitch_true = -5000;
+    yaw_true = 270000;
+    latProbes = 1;
+    latStamp = 1234;
+    latStageUs[0] = 150;
+    pump(5200);
+
+    f = find("HEARTBEAT", 0);
+    CHECK(f != NULL, "no HEARTBEAT");
+    if (f) {
+        CHECK(rd32(f->p + off(hb, "custom_mode")) == 1, "HEARTBEAT custom_mode %u", rd32(f->p + off(hb, "custom_mode")));
+        CHECK(f->p[off(hb, "type")] == 2, "HEARTBEAT type %u", f->p[off(hb, "type")]);
+        CHECK(f->p[off(hb, "autopilot")] == 0, "HEARTBEAT autopilot");
+        CHECK(f->p[off(hb, "system_status")] == 3, "HEARTBEAT system_status %u", f->p[off(hb, "system_status")]);
+        CHECK(f->p[off(hb, "mavlink_version")] == 3, "HEARTBEAT mavlink_version");
+    }
+    CHECK(count("HEARTBEAT") == 5, "%d HEARTBEATs in 5.2 s", count("HEARTBEAT"));
+    CHECK(count("MEMINFO") == count("HEARTBEAT"), "MEMINFO should follow each HEARTBEAT");
+    f = find("MEMINFO", 0);
+    if (f) CHECK(rd32(f->p + off(mem, "freemem32")) == StackMon_Free(), "MEMINFO freemem32");
+
+    f = find("ATTITUDE", 0);
+    CHECK(f != NULL, "no ATTITUDE");
+    if (f) {
+        CHECK(fabsf(rdf(f->p + off(att, "roll")) - 0.174533f) < 1e-4f, "ATTITUDE roll %f", rdf(f->p + off(att, "roll")));
+        CHECK(fabsf(rdf(f->p + off(att, "pitch")) + 0.087266f) < 1e-4f, "ATTITUDE pitch %f", rdf(f->p + off(att, "pitch")));
+        CHECK(fabsf(rdf(f->p + off(att, "yaw")) + 1.570796f) < 1e-4f, "ATTITUDE yaw %f", rdf(f->p + off(att, "yaw")));
+        CHECK(rd32(f->p + off(att, "time_boot_ms")) <= HAL_GetTick(), "ATTITUDE time_boot_ms");
+    }
+
+    f = find("DEBUG_FLOAT_ARRAY", 0);
+    CHECK(f != NULL, "no DEBUG_FLOAT_ARRAY");
+    if (f) {
+        CHECK(memcmp(f->p + off(dbg, "name"), "LATENCY\0\0", 10) == 0, "DEBUG_FLOAT_ARRAY name");
+        CHECK(rd16(f->p + off(dbg, "array_id")) == 1, "DEBUG_FLOAT_ARRAY array_id");
+        CHECK(rdf(f->p + off(dbg, "data")) == 1234.0f, "DEBUG_FLOAT_ARRAY data[0] %f", rdf(f->p + off(dbg, "data")));
+        CHECK(rdf(f->p + off(dbg, "data") + 4) == 150.0f, "DEBUG_FLOAT_ARRAY data[1]");
+    }
+    latProbes = 0;
+}
+
+static void checkParams(void)
+{
+    const MsgDef *rr = msgById(MAV_MSG_PARAM_REQUEST_READ), *pv = msgById(MAV_MSG_PARAM_VALUE);
+    const MsgDef *ps = msgById(MAV_MSG_PARAM_SET);
+    uint8_t p[256];
+    const Frame *f;
+    int ok = 1;
+
+    printf("parameters\n");
+    pump(10); // Drain
+
+    memset(p, 0, sizeof(p));
+    p[0] = MAV_SYSID;
+    send("PARAM_REQUEST_LIST", p, 2, 0);
+    pump(PARAM_COUNT + 5);
+    CHECK(count("PARAM_VALUE") == PARAM_COUNT, "%d PARAM_VALUEs for %d parameters", count("PARAM_VALUE"), PARAM_COUNT);
+    for (int k = 0; k < PARAM_COUNT && (f = find("PARAM_VALUE", k)) != NULL; k++) {
+        ok &= rd16(f->p + off(pv, "param_index")) == k;
+        ok &= rd16(f->p + off(pv, "param_count")) == PARAM_COUNT;
+        ok &= f->p[off(pv, "param_type")] == 6;
+        ok &= (int32_t)rd32(f->p + off(pv, "param_value")) == Param_Get((ParamKey)k);
+        ok &= strncmp((const char *)f->p + off(pv, "param_id"), Param_Name((ParamKey)k), 16) == 0;
+    }
+    CHECK(ok, "PARAM_VALUE fields do not match the store");
+
+    // By name (index -1)
+    memset(p, 0, sizeof(p));
+    wr16(p + off(rr, "param_index"), 0xFFFF);
+    p[off(rr, "target_system")] = MAV_SYSID;
+    strncpy((char *)p + off(rr, "param_id"), Param_Name(PARAM_KI_PITCH), 16);
+    send("PARAM_REQUEST_READ", p, rr->wireLen, 0);
+    pump(3);
+    f = find("PARAM_VALUE", 0);
+    CHECK(f && rd16(f->p + off(pv, "param_index")) == PARAM_KI_PITCH, "PARAM_REQUEST_READ by name");
+
+    // By index
+    memset(p, 0, sizeof(p));
+    wr16(p + off(rr, "param_index"), PARAM_KP_ROLL);
+    p[off(rr, "target_system")] = MAV_SYSID;
+    send("PARAM_REQUEST_READ", p, rr->wireLen, 0);
+    pump(3);
+    f = find("PARAM_VALUE", 0);
+    CHECK(f && rd16(f->p + off(pv, "param_index")) == PARAM_KP_ROLL, "PARAM_REQUEST_READ by index");
+
+    // Set as INT32 (bytewise) and as REAL32
+    memset(p, 0, sizeof(p));
+    p[off(ps, "target_system")] = MAV_SYSID;
+    strncpy((char *)p + off(ps, "param_id"), Param_Name(PARAM_KP_ROLL), 16);
+    wr32(p + off(ps, "param_value"), 321);
+    p[off(ps, "param_type")] = 6;
+    send("PARAM_SET", p, ps->wireLen, 0);
+    pump(3);
+    f = find("PARAM_VALUE", 0);
+    CHECK(Param_Get(PARAM_KP_ROLL) == 321, "PARAM_SET INT32: store holds %d", (int)Param_Get(PARAM_KP_ROLL));
+    CHECK(f && (int32_t)rd32(f->p + off(pv, "param_value")) == 321, "PARAM_SET INT32 echo");
+
+    wrf(p + off(ps, "param_value"), 250.0f);
+    p[off(ps, "param_type")] = 9;
+    send("PARAM_SET", p, ps->wireLen, 0);
+    pump(3);
+    CHECK(Param_Get(PARAM_KP_ROLL) == 250, "PARAM_SET REAL32: store holds %d", (int)Param_Get(PARAM_KP_ROLL));
+
+    // Refused whenever the motors can spin: flying, calibrating and arming
+    for (int i = 0; i < 3; i++) {
+        state = (i == 0) ? 2 : (i == 1) ? 4 : 1;
+        escArming = (i == 2);
+        pump(10); // Drain
+        wrf(p + off(ps, "param_value"), 999.0f);
+        send("PARAM_SET", p, ps->wireLen, 0);
+        pump(3);
+        f = find("PARAM_VALUE", 0);
+        CHECK(Param_Get(PARAM_KP_ROLL) == 250, "PARAM_SET in state %d, arming %d: store holds %d",
+              state, escArming, (int)Param_Get(PARAM_KP_ROLL));
+        CHECK(f && (int32_t)rd32(f->p + off(pv, "param_value")) == 250, "PARAM_SET refused: echo of the old value");
+    }
+    state = 1;
+    escArming = 0;
+    Param_Set(PARAM_KP_ROLL, 200);
+}
+
+static void checkControl(void)
+{
+    const MsgDef *rc = msgById(MAV_MSG_RC_CHANNELS_OVERRIDE);
+    uint8_t p[256];
+
+    printf("control\n");
+    memset(p, 0, sizeof(p));
+    p[off(rc, "target_system")] = MAV_SYSID;
+    wr16(p + off(rc, "chan1_raw"), 1750);
+    wr16(p + off(rc, "chan2_raw"), 1250);
+    wr16(p + off(rc, "chan3_raw"), 1500);
+    wr16(p + off(rc, "chan4_raw"), 0xFFFF);
+    wr16(p + off(rc, "chan5_raw"), 1800);
+    dumpFlag = 0;
+    send("RC_CHANNELS_OVERRIDE", p, rc->wireLen, 0); // Extensions all zero: truncated to 18 bytes
+    CHECK(roll_set == 10000 && pitch_set == -10000, "RC roll/pitch %d/%d", (int)roll_set, (int)pitch_set);
+    CHECK(effort_set == 500 && dumpFlag == 1, "RC throttle %d, dump %d", (int)effort_set, dumpFlag);
+
+    wr16(p + off(rc, "chan1_raw"), 1500);
+    wr16(p + off(rc, "chan18_raw"), 77); // Latency stamp in the last extension: full 38 bytes
+    send("RC_CHANNELS_OVERRIDE", p, rc->wireLen, 0);
+    CHECK(roll_set == 0, "RC full-length frame not applied");
+    effort_set = 0;
+    dumpFlag = 0;
+}
+
+static void checkLog(void)
+{
+    const MsgDef *rl = msgById(MAV_MSG_LOG_REQUEST_LIST), *rd = msgById(MAV_MSG_LOG_REQUEST_DATA);
+    const MsgDef *le = msgById(MAV_MSG_LOG_ENTRY);
+    const MsgDef *ld = msgById(MAV_MSG_LOG_DATA);
+    uint8_t p[256];
+    const Frame *f;
+    uint32_t size;
+    int ok = 1;
+
+    printf("blackbox log\n");
+    for (size_t i = 0; i < sizeof(blackbox); i++) ((uint8_t *)blackbox)[i] = (uint8_t)(i * 7 + 3);
+    sample_index = 12;
+    size = sample_index * sizeof(IMUSample);
+
+    memset(p, 0, sizeof(p));
+    p[off(rl, "target_system")] = MAV_SYSID;
+    wr16(p + off(rl, "end"), 0xFFFF);
+    send("LOG_REQUEST_LIST", p, rl->wireLen, 0);
+    pump(3);
+    f = find("LOG_ENTRY", 0);
+    CHECK(f != NULL, "no LOG_ENTRY");
+    if (f) {
+        CHECK(rd32(f->p + off(le, "size")) == size, "LOG_ENTRY size %u, want %u", rd32(f->p + off(le, "size")), size);
+        CHECK(rd16(f->p + off(le, "id")) == MAV_LOG_ID && rd16(f->p + off(le, "num_logs")) == 1 &&
+              rd16(f->p + off(le, "last_log_num")) == MAV_LOG_ID, "LOG_ENTRY id/num_logs/last_log_num");
+    }
+
+    memset(p, 0, sizeof(p));
+    p[off(rd, "target_system")] = MAV_SYSID;
+    wr16(p + off(rd, "id"), MAV_LOG_ID);
+    wr32(p + off(rd, "ofs"), 10);
+    wr32(p + off(rd, "count"), 200);
+    send("LOG_REQUEST_DATA", p, rd->wireLen, 0);
+    pump(10);
+    CHECK(count("LOG_DATA") == 3, "%d LOG_DATA frames for 200 bytes", count("LOG_DATA"));
+    for (int k = 0; (f = find("LOG_DATA", k)) != NULL; k++) {
+        uint32_t ofs = rd32(f->p + off(ld, "ofs"));
+        uint8_t n = f->p[off(ld, "count")];
+        ok &= ofs == 10 + 90u * k && n == (k < 2 ? 90 : 20) && rd16(f->p + off(ld, "id")) == MAV_LOG_ID;
+        ok &= memcmp(f->p + off(ld, "data"), (const uint8_t *)blackbox + ofs, n) == 0;
+    }
+    CHECK(ok, "LOG_DATA offsets, counts or bytes wrong");
+
+    // LOG_REQUEST_END drops what is still queued
+    wr32(p + off(rd, "ofs"), 0);
+    wr32(p + off(rd, "count"), 0xFFFFFFFFu);
+    send("LOG_REQUEST_DATA", p, rd->wireLen, 0);
+    memset(p, 0, sizeof(p));
+    p[0] = MAV_SYSID;
+    send("LOG_REQUEST_END", p, 2, 0);
+    pump(10);
+    CHECK(count("LOG_DATA") == 0, "%d LOG_DATA frames after LOG_REQUEST_END", count("LOG_DATA"));
+    sample_index = 0;
+}
+
+static void checkRejects(void)
+{
+    uint8_t p[256], f[MAV_FRAME_MAX];
+    uint32_t good = mavRxGood, bad = mavRxBad;
+
+    printf("rejects\n");
+    memset(p, 0, sizeof(p));
+    p[0] = MAV_SYSID;
+    send("PARAM_REQUEST_LIST", p, 2, 1); // Bad CRC
+    CHECK(mavRxBad == bad + 1 && mavRxGood == good, "bad CRC accepted");
+
+    // Unknown message 999, and PARAM_REQUEST_LIST one byte longer than its definition
+    memset(f, 0, sizeof(f));
+    f[0] = MAV_STX; f[1] = 1; f[7] = 999 & 0xFF; f[8] = 999 >> 8; f[10] = 1;
+    huart2.RxState = HAL_UART_STATE_READY;
+    MAV_Receive(f, MAV_HEADER_LEN + 1 + 2);
+    f[1] = 3; f[7] = MAV_MSG_PARAM_REQUEST_LIST; f[8] = 0;
+    huart2.RxState = HAL_UART_STATE_READY;
+    MAV_Receive(f, MAV_HEADER_LEN + 3 + 2);
+    CHECK(mavRxBad == bad + 3 && mavRxGood == good, "unknown id or overlong payload accepted");
+    pump(5);
+    CHECK(count("PARAM_VALUE") == 0, "rejected frame was acted on");
+}
+
+int main(void)
+{
+    PlantParams pp;
+
+    Plant_Defaults(&pp);
+    Sim_Init(&pp, 1);
+    Sim_SetUartSink(sink);
+
+    checkDefinitions();
+    checkTelemetry();
+    checkParams();
+    checkControl();
+    checkLog();
+    checkRejects();
+
+    printf("%s: %d failure%s\n", failures ? "FAIL" : "ok", failures, failures == 1 ? "" : "s");
+    return failures != 0;
+}
@@ -0,0 +1,168 @@
+/**
+  ******************************************************************************
+  * @file    ratestep.c
+  * @author  Aaron Lubinsky
+  * @brief   Compares manoeuvre response in angle mode and rate mode
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Flies the simulated airframe at a fixed throttle and slams the
+  *          roll stick to full deflection in each flight mode:
+  *
+  *            angle  roll_set steps to +20° (the stick limit); reports the
+  *                   time to reach 18° and the overshoot
+  *            rate   full stick through the expo curve for stick_ms, then
+  *                   centred; reports how long the gyro rate takes to reach
+  *                   90% of the command, the time to reach 18°, the angle
+  *                   where it stops after the stick is centred, and how far
+  *                   it drifts in the following second
+  *
+  *          Then both modes get the same 1 s roll disturbance torque with
+  *          the sticks centred, to show what rate mode gives up in
+  *          disturbance rejection (it holds attitude only through the
+  *          integrator and never levels).
+  *
+  *          The firmware ships without a thrust curve, so on the quadratic
+  *          plant a count of effort buys more torque the higher the
+  *          throttle. The angle-mode step and both disturbance results
+  *          change with it; compare at the throttle you fly (effort, 500 by
+  *          default). The rate loop's 90% rise stays within 69-77 ms from
+  *          effort 300 to 800.
+  *
+  *          Usage: ratestep [kp ki kd] [rate_max expo] [stick_ms] [effort]
+  *
+  ******************************************************************************
+  */
+
+#include "Sim.h"
+#include "RateMode.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define DT           0.001  ///< Control loop period (s)
+#define REACH_MDEG   18000  ///< 90% of the angle-mode step
+#define DIST_TORQUE  0.01   ///< Roll disturbance (N m)
+
+typedef struct {
+    double reach;     ///< Time for the true roll to reach REACH_MDEG after the stick moved (s)
+    double rateRise;  ///< Time for the gyro to reach 90% of the rate command (s)
+    double peakRate;  ///< Highest roll rate (deg/s)
+    double stop;      ///< Roll when the stick was centred plus 0.3 s (deg)
+    double drift;     ///< Roll change over the next second (deg)
+    double overshoot; ///< Angle mode: largest roll past the 20° setpoint (deg)
+    double distPeak;  ///< Largest roll deviation under the disturbance (deg)
+    double distEnd;   ///< Roll deviation 1 s after the disturbance ends (deg)
+} StepResult;
+
+static void level(int32_t effort)
+{
+    PlantParams pp;
+
+    Plant_Defaults(&pp);
+    Sim_Init(&pp, 3);
+    effort_set = effort;
+    for (int i = 0; i < 1000; i++) Sim_Tick(DT); // Settle before the step
+}
+
+static void disturb(StepResult *res)
+{
+    double start = roll_true / 1000.0;
+
+    Sim_State()->dist[0] = DIST_TORQUE;
+    for (int i = 0; i < 1000; i++) {
+        Sim_Tick(DT);
+        if (fabs(roll_true / 1000.0 - start) > res->distPeak) res->distPeak = fabs(roll_true / 1000.0 - start);
+    }
+    Sim_State()->dist[0] = 0.0;
+    for (int i = 0; i < 1000; i++) Sim_Tick(DT);
+    res->distEnd = roll_true / 1000.0 - start;
+}
+
+static StepResult runAngle(int32_t effort)
+{
+    StepResult res = {0};
+
+    flightMode = FLIGHT_MODE_ANGLE;
+    level(effort);
+
+    roll_set = 20000;
+    for (int i = 0; i < 2000; i++) {
+        Sim_Tick(DT);
+        if (res.reach == 0.0 && Sim_State()->roll * 180000.0 / M_PI >= REACH_MDEG) res.reach = (i + 1) * DT;
+        if (roll_true / 1000.0 - 20.0 > res.overshoot) res.overshoot = roll_true / 1000.0 - 20.0;
+        if (Sim_State()->p * 180.0 / M_PI > res.peakRate) res.peakRate = Sim_State()->p * 180.0 / M_PI;
+    }
+
+    roll_set = 0;
+    for (int i = 0; i < 2000; i++) Sim_Tick(DT);
+    disturb(&res);
+    return res;
+}
+
+static StepResult runRate(int32_t effort, int stickMs)
+{
+    StepResult res = {0};
+    int32_t cmd;
+
+    flightMode = FLIGHT_MODE_RATE;
+    level(effort);
+
+    Rate_Sticks(RATE_STICK_MAX, 0, 0);
+    cmd = roll_rate_set;
+    for (int i = 0; i < stickMs; i++) {
+        Sim_Tick(DT);
+        if (res.reach == 0.0 && Sim_State()->roll * 180000.0 / M_PI >= REACH_MDEG) res.reach = (i + 1) * DT;
+        if (res.rateRise == 0.0 && roll_rate >= cmd * 9 / 10) res.rateRise = (i + 1) * DT;
+        if (Sim_State()->p * 180.0 / M_PI > res.peakRate) res.peakRate = Sim_State()->p * 180.0 / M_PI;
+    }
+
+    Rate_Sticks(0, 0, 0);
+    for (int i = 0; i < 300; i++) {
+        Sim_Tick(DT);
+        if (res.reach == 0.0 && Sim_State()->roll * 180000.0 / M_PI >= REACH_MDEG) res.reach = (stickMs + i + 1) * DT;
+    }
+    res.stop = Sim_State()->roll * 180.0 / M_PI;
+    for (int i = 0; i < 1000; i++) Sim_Tick(DT);
+    res.drift = Sim_State()->roll * 180.0 / M_PI - res.stop;
+
+    disturb(&res);
+    return res;
+}
+
+int main(int argc, char **argv)
+{
+    int32_t effort = 500;
+    int stickMs = 100;
+    StepResult a, r;
+
+    if (argc >= 4) {
+        Kp_rate = atoi(argv[1]);
+        Ki_rate = atoi(argv[2]);
+        Kd_rate = atoi(argv[3]);
+    }
+    if (argc >= 6) {
+        rateMax = atoi(argv[4]);
+        rateExpo = atoi(argv[5]);
+    }
+    if (argc >= 7) stickMs = atoi(argv[6]);
+    if (argc >= 8) effort = atoi(argv[7]);
+
+    a = runAngle(effort);
+    r = runRate(effort, stickMs);
+
+    printf("angle mode (Kp %ld Ki %ld Kd %ld), 20° step:\n", (long)Kp_roll, (long)Ki_roll, (long)Kd_roll);
+    printf("  18° after %.0f ms, overshoot %.1f°, peak rate %.0f deg/s\n",
+           a.reach * 1000.0, a.overshoot, a.peakRate);
+    printf("rate mode (Kp %ld Ki %ld Kd %ld, %d deg/s, expo %d), full stick for %d ms:\n",
+           (long)Kp_rate, (long)Ki_rate, (long)Kd_rate, rateMax, rateExpo, stickMs);
+    if (r.rateRise > 0.0) printf("  rate at 90%% after %.0f ms", r.rateRise * 1000.0);
+    else printf("  rate never reached 90%%");
+    if (r.reach > 0.0) printf(", 18° after %.0f ms", r.reach * 1000.0);
+    printf(", peak rate %.0f deg/s\n", r.peakRate);
+    printf("  stopped at %.1f°, drifted %.2f° in the next second\n", r.stop, r.drift);
+    printf("%.2f N m roll disturbance for 1 s, sticks centred:\n", DIST_TORQUE);
+    printf("  angle mode: peak %.2f°, %.2f° off 1 s after\n", a.distPeak, a.distEnd);
+    printf("  rate mode:  peak %.2f°, %.2f° off 1 s after (holds, does not level)\n", r.distPeak, r.distEnd);
+    return 0;
+}
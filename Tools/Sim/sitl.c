@@ -0,0 +1,291 @@
+/**
+  ******************************************************************************
+  * @file    sitl.c
+  * @author  Aaron Lubinsky
+  * @brief   Software-in-the-loop drone with its UARTs on pseudo-terminals
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Runs the firmware's state machine (MainLoop.c: bring-up,
+  *          disarmed, flying, dump, motor calibration) over the real flight
+  *          code and the plant model at 1 kHz, and opens two PTYs:
+  *
+  *          - USART2, the HC-05 link: CSV control frames in, or MAVLink v2
+  *            both ways with -m; without -m also everything the flight code
+  *            printf()s, which goes through the firmware's __io_putchar() as
+  *            on target
+  *          - USART1, the fast channel: telemetry lines, the trace and the
+  *            blackbox dump (Tools/build/fastrx splits it back up), plus
+  *            the printf() output with -m
+  *
+  *          Point a ground station or a terminal at the printed /dev/pts
+  *          paths (or the -2/-1 symlinks) as if they were the serial ports.
+  *
+  *          Real time (default): the loop is paced by CLOCK_MONOTONIC and
+  *          link bytes are delivered as soon as they arrive.
+  *
+  *          Lockstep (-s N): simulated time only advances N ticks per
+  *          received link frame, and bytes are fed one frame at a time, so
+  *          the same input stream and seed always give the same output no
+  *          matter how fast the host or the ground station runs.
+  *
+  *          -l N drops each byte the drone sends on the link with
+  *          probability N/1000, a crude stand-in for a noisy Bluetooth
+  *          connection when testing downloads (Tools/build/bbget).
+  *
+  *          Usage: sitl [-m] [-s ticks] [-S seed] [-l loss] [-2 link] [-1 console]
+  *
+  ******************************************************************************
+  */
+
+#define _GNU_SOURCE
+#include "Sim.h"
+#include "BNO055.h"
+#include "HC05.h"
+#include "ESC.h"
+#include "Battery.h"
+#include "MAVLink.h"
+#include "MainLoop.h"
+#include "stm32f4xx_hal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <termios.h>
+
+#define DT          0.001  ///< Control loop period (s)
+#define HOST_FIFO   4096   ///< Link bytes read but not yet fed to the UART
+
+extern UART_HandleTypeDef huart2;
+extern int __io_putchar(int ch); ///< MainLoop.c, where printf() output goes on target
+
+/* ===== HOST STATE ===== */
+static uint16_t rxFill = 0;    ///< Bytes in BT_RxBuf for the CSV DMA stand-in
+static int linkFd = -1;        ///< PTY master for USART2
+static int consoleFd = -1;     ///< PTY master for USART1
+static uint8_t fifo[HOST_FIFO];
+static size_t fifoHead = 0, fifoLen = 0;
+static long linkLoss = 0;      ///< Link TX bytes dropped per 1000
+static unsigned lossSeed = 1;
+
+/**
+ * @brief Opens a raw PTY pair, returns the master and optionally symlinks the slave
+ */
+static int openPty(const char *label, const char *link)
+{
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+    const char *name;
+    struct termios tio;
+    int slave;
+
+    if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0 || (name = ptsname(fd)) == NULL) {
+        perror("posix_openpt");
+        exit(1);
+    }
+
+    // Raw mode on the slave side; keep it open so the master never sees EIO
+    // while no client is attached
+    slave = open(name, O_RDWR | O_NOCTTY);
+    if (slave >= 0 && tcgetattr(slave, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(slave, TCSANOW, &tio);
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fprintf(stderr, "%s: %s\n", label, name);
+
+    if (link) {
+        unlink(link);
+        if (symlink(name, link) != 0) perror(link);
+        else fprintf(stderr, "%s: %s -> %s\n", label, link, name);
+    }
+    return fd;
+}
+
+static void writeAll(int fd, const uint8_t *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n > 0) {
+            data += n;
+            len -= (size_t)n;
+        } else if (n < 0 && errno == EAGAIN) {
+            struct pollfd p = {fd, POLLOUT, 0};
+            poll(&p, 1, 100);
+        } else if (n < 0 && errno != EINTR) {
+            return; // Client gone; drop the output like an unpaired HC-05
+        }
+    }
+}
+
+/**
+ * @brief UART sink: USART2 to the link PTY, USART1 to the console PTY
+ */
+static void uartSink(int uart, const uint8_t *data, size_t len)
+{
+    if (uart == 1) {
+        writeAll(consoleFd, data, len);
+    } else if (linkLoss > 0) {
+        for (size_t i = 0; i < len; i++) {
+            if (rand_r(&lossSeed) % 1000 >= linkLoss) writeAll(linkFd, &data[i], 1);
+        }
+    } else {
+        writeAll(linkFd, data, len);
+    }
+}
+
+/**
+ * @brief Reads whatever the ground station has sent into the host FIFO
+ */
+static void pollLink(void)
+{
+    while (fifoLen < HOST_FIFO) {
+        size_t tail = (fifoHead + fifoLen) % HOST_FIFO;
+        size_t room = (tail >= fifoHead) ? HOST_FIFO - tail : fifoHead - tail;
+        ssize_t n = read(linkFd, &fifo[tail], room);
+        if (n <= 0) break;
+        fifoLen += (size_t)n;
+    }
+}
+
+/**
+ * @brief Delivers one byte as USART2 would, returns true when it completed a frame
+ *
+ * @details CSV: fills BT_RxBuf like the fixed-length DMA and runs the
+ *          HAL_UART_RxCpltCallback() body when it is full. MAVLink: hands
+ *          the byte to MAV_Receive() as an idle-line event.
+ */
+static int uartRxByte(uint8_t c)
+{
+    if (linkMavlink) {
+        uint32_t before = mavRxGood + mavRxBad;
+        huart2.RxState = HAL_UART_STATE_READY;
+        MAV_Receive(&c, 1);
+        return mavRxGood + mavRxBad != before;
+    }
+
+    BT_RxBuf[rxFill++] = c;
+    if (rxFill < BT_MSG_LEN - 1) return false;
+    rxFill = 0;
+    BT_RxBuf[BT_MSG_LEN - 1] = '\0';
+    processInput((char *)BT_RxBuf, &roll_set, &pitch_set, &yaw_set, &effort_set, &dumpFlag);
+    return true;
+}
+
+/**
+ * @brief Feeds FIFO bytes to the UART; stops after one frame when oneFrame is set
+ *
+ * @return true if a frame completed
+ */
+static int feedLink(int oneFrame)
+{
+    int done = false;
+
+    while (fifoLen > 0) {
+        uint8_t c = fifo[fifoHead];
+        fifoHead = (fifoHead + 1) % HOST_FIFO;
+        fifoLen--;
+        if (uartRxByte(c)) {
+            done = true;
+            if (oneFrame) break;
+        }
+    }
+    return done;
+}
+
+/**
+ * @brief stdout write hook: printf() bytes go to __io_putchar() one at a
+ *        time, as newlib's _write() sends them on target
+ */
+static ssize_t stdoutWrite(void *cookie, const char *buf, size_t len)
+{
+    (void)cookie;
+    for (size_t i = 0; i < len; i++) {
+        __io_putchar((uint8_t)buf[i]);
+    }
+    return (ssize_t)len;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: sitl [-m] [-s ticks] [-S seed] [-l loss] [-2 link] [-1 console]\n"
+                    "  -m        link speaks MAVLink v2 (LINK_MAVLINK=1)\n"
+                    "  -s ticks  lockstep: advance this many 1 ms ticks per link frame\n"
+                    "  -S seed   sensor noise seed\n"
+                    "  -l loss   drop link TX bytes, per 1000\n"
+                    "  -2 path   symlink to the USART2 (link) PTY\n"
+                    "  -1 path   symlink to the USART1 (console) PTY\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    PlantParams pp;
+    uint64_t seed = 1;
+    long lockstep = 0;
+    const char *linkPath = NULL, *consolePath = NULL;
+    struct timespec next, now;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "ms:S:l:2:1:h")) != -1) {
+        switch (opt) {
+        case 'm': linkMavlink = 1; break;
+        case 's': lockstep = strtol(optarg, NULL, 10); break;
+        case 'S': seed = strtoull(optarg, NULL, 0); break;
+        case 'l': linkLoss = strtol(optarg, NULL, 10); break;
+        case '2': linkPath = optarg; break;
+        case '1': consolePath = optarg; break;
+        default: usage();
+        }
+    }
+
+    linkFd = openPty("USART2 link", linkPath);
+    consoleFd = openPty("USART1 console", consolePath);
+    fprintf(stderr, "%s, %s\n", linkMavlink ? "MAVLink" : "CSV",
+            lockstep > 0 ? "lockstep" : "real time");
+
+    // printf() in the flight code goes wherever the firmware sends it
+    stdout = fopencookie(NULL, "w", (cookie_io_functions_t){NULL, stdoutWrite, NULL, NULL});
+    setvbuf(stdout, NULL, _IONBF, 0);
+    Sim_SetUartSink(uartSink);
+
+    Plant_Defaults(&pp);
+    Sim_Init(&pp, seed);
+    state = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for (;;) {
+        if (lockstep > 0) {
+            struct pollfd p = {linkFd, POLLIN, 0};
+
+            pollLink();
+            while (!feedLink(true)) {
+                poll(&p, 1, -1);
+                pollLink();
+            }
+            for (long i = 0; i < lockstep; i++) {
+                MainLoop_Step();
+                Sim_Advance(DT);
+            }
+        } else {
+            pollLink();
+            feedLink(false);
+            MainLoop_Step();
+            Sim_Advance(DT);
+
+            next.tv_nsec += (long)(DT * 1e9);
+            if (next.tv_nsec >= 1000000000L) {
+                next.tv_nsec -= 1000000000L;
+                next.tv_sec++;
+            }
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+            if (clock_gettime(CLOCK_MONOTONIC, &now) == 0 && now.tv_sec > next.tv_sec + 1) {
+                next = now; // Host stalled (suspend, debugger): resume pacing from here
+            }
+        }
+    }
+}
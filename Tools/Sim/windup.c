@@ -0,0 +1,95 @@
+/**
+  ******************************************************************************
+  * @file    windup.c
+  * @author  Aaron Lubinsky
+  * @brief   Measures integrator windup with and without anti-windup
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Flies the simulated airframe at a fixed throttle, pushes it with a
+  *          roll disturbance large enough to saturate the motors, releases the
+  *          disturbance and records how far the attitude overshoots the other
+  *          way and how long it takes to settle. Runs once with antiWindup off
+  *          and once with it on.
+  *
+  *          Usage: windup [kp ki kd effort torque seconds]
+  *
+  ******************************************************************************
+  */
+
+#include "Sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define DT       0.001  ///< Control loop period (s)
+#define SETTLE_MDEG 1000 ///< Settled when within ±1 degree
+
+typedef struct {
+    double peak;     ///< Largest deviation while the disturbance is applied (deg)
+    double overshoot;///< Largest deviation of opposite sign after release (deg)
+    double settle;   ///< Time from release until it stays within ±1 degree (s)
+    double satTime;  ///< Time any motor spent clipped at the top (s)
+} WindupResult;
+
+extern int satMask;
+
+static WindupResult runCase(int aw, int32_t effort, double torque, double seconds)
+{
+    PlantParams pp;
+    WindupResult res = {0};
+    double lastOutside = 0.0;
+    int ticksHold = (int)(seconds / DT);
+    int ticksAfter = (int)(4.0 / DT);
+
+    Plant_Defaults(&pp);
+    Sim_Init(&pp, 1);
+    antiWindup = aw;
+    gainSched = 0; // Measure the stored gains as they are
+    effort_set = effort;
+
+    // Level off first
+    for (int i = 0; i < 500; i++) Sim_Tick(DT);
+
+    Sim_State()->dist[0] = torque;
+    for (int i = 0; i < ticksHold; i++) {
+        Sim_Tick(DT);
+        if (fabs(roll_true / 1000.0) > res.peak) res.peak = fabs(roll_true / 1000.0);
+        if (satMask) res.satTime += DT;
+    }
+
+    Sim_State()->dist[0] = 0.0;
+    for (int i = 0; i < ticksAfter; i++) {
+        double r;
+        Sim_Tick(DT);
+        r = roll_true / 1000.0;
+        if (torque * r < 0 && fabs(r) > res.overshoot) res.overshoot = fabs(r);
+        if (abs(roll_true) > SETTLE_MDEG) lastOutside = (i + 1) * DT;
+    }
+    res.settle = lastOutside;
+    return res;
+}
+
+int main(int argc, char **argv)
+{
+    // Defaults: a gust that holds the high motors at ESC_CMD_MAX for most of a second
+    // on the shipped build (no thrust curve), with gains that still settle afterwards
+    Kp_roll = (argc > 1) ? atoi(argv[1]) : 3000;
+    Ki_roll = (argc > 2) ? atoi(argv[2]) : 4000;
+    Kd_roll = (argc > 3) ? atoi(argv[3]) : 250000;
+    int32_t effort = (argc > 4) ? atoi(argv[4]) : 900;
+    double torque = (argc > 5) ? atof(argv[5]) : 0.8;
+    double seconds = (argc > 6) ? atof(argv[6]) : 1.0;
+
+    max_integral = 1000000;
+    printf("Kp=%d Ki=%d Kd=%d effort=%d disturbance=%.2f N m for %.1f s\n",
+           Kp_roll, Ki_roll, Kd_roll, effort, torque, seconds);
+    printf("%-12s %10s %12s %10s %10s\n", "antiWindup", "peak(deg)", "overshoot", "settle(s)", "sat(s)");
+
+    for (int aw = 0; aw <= 1; aw++) {
+        WindupResult r = runCase(aw, effort, torque, seconds);
+        printf("%-12s %10.2f %12.2f %10.3f %10.3f%s\n", aw ? "on" : "off", r.peak, r.overshoot,
+               r.settle, r.satTime, (r.settle >= 4.0) ? "  (not settled)" : "");
+    }
+    return 0;
+}
@@ -0,0 +1,156 @@
+/**
+  ******************************************************************************
+  * @file    anglecheck.c
+  * @author  Aaron Lubinsky
+  * @brief   AngleMath against libm over the whole int32_t range, with timing
+  * @version 1.0
+  * @date    2026
+  *
+  * @details angle_Wrap360() is checked for every int32_t input against
+  *          fmod(). angle_Diff() is checked for every a, each paired with a
+  *          pseudo-random b from anywhere in the range, and for every pair
+  *          of a grid of edge values (INT32_MIN/MAX, 0, ±180000, ±360000 and
+  *          their neighbours). The reference is fmod() of the exact double
+  *          difference, moved into (-180000, 180000].
+  *
+  *          Then both functions are timed over the same inputs and the cost
+  *          per call is printed in host cycles (TSC on x86) and ns; the
+  *          Cortex-M4 cost is in ctrlCycles on the target.
+  *
+  *          Usage: anglecheck [stride]   (1 = every input, the default;
+  *          a full sweep takes several minutes, 65537 about a second)
+  *          Exits 1 if either function disagrees with the reference.
+  *
+  ******************************************************************************
+  */
+
+#include "AngleMath.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <math.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#else
+#define HAVE_TSC 0
+#endif
+
+#define TIME_CALLS 100000000L ///< Calls per function in the timing loop
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t cycles(void)
+{
+#if HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Pairs every a with a b spread over the whole range (Knuth multiplicative hash)
+ */
+static int32_t partner(int32_t a)
+{
+    return (int32_t)((uint32_t)a * 2654435761U);
+}
+
+static int32_t refWrap(int32_t a)
+{
+    double r = fmod((double)a, ANGLE_FULL);
+    if (r < 0) r += ANGLE_FULL;
+    return (int32_t)r;
+}
+
+static int32_t refDiff(int32_t a, int32_t b)
+{
+    double r = fmod((double)a - (double)b, ANGLE_FULL); // Exact: |a - b| < 2^33
+    if (r > ANGLE_HALF) r -= ANGLE_FULL;
+    else if (r <= -ANGLE_HALF) r += ANGLE_FULL;
+    return (int32_t)r;
+}
+
+static int report(const char *name, uint64_t checked, uint64_t bad, int32_t a, int32_t b, int32_t got, int32_t want)
+{
+    printf("%-14s %12" PRIu64 " inputs, %" PRIu64 " wrong", name, checked, bad);
+    if (bad) printf(" (first: %" PRId32 ", %" PRId32 " gave %" PRId32 ", want %" PRId32 ")", a, b, got, want);
+    printf("\n");
+    return bad != 0;
+}
+
+int main(int argc, char **argv)
+{
+    static const int32_t edge[] = {
+        INT32_MIN, INT32_MIN + 1, -360001, -360000, -359999, -180001, -180000, -179999,
+        -1, 0, 1, 179999, 180000, 180001, 359999, 360000, 360001, INT32_MAX - 1, INT32_MAX,
+    };
+    const int nEdge = sizeof(edge) / sizeof(edge[0]);
+    uint32_t stride = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 1;
+    uint64_t checked = 0, bad = 0;
+    int32_t fa = 0, fb = 0, fgot = 0, fwant = 0;
+    volatile uint32_t sink = 0;
+    int fail = 0;
+
+    if (stride == 0) stride = 1;
+
+    /* ===== angle_Wrap360 ===== */
+    for (uint64_t u = 0; u <= UINT32_MAX; u += stride) {
+        int32_t a = (int32_t)(uint32_t)u;
+        int32_t got = angle_Wrap360(a), want = refWrap(a);
+        if (got != want && bad++ == 0) { fa = a; fgot = got; fwant = want; }
+        checked++;
+    }
+    fail |= report("angle_Wrap360", checked, bad, fa, 0, fgot, fwant);
+
+    /* ===== angle_Diff ===== */
+    checked = bad = 0;
+    for (uint64_t u = 0; u <= UINT32_MAX; u += stride) {
+        int32_t a = (int32_t)(uint32_t)u, b = partner(a);
+        int32_t got = angle_Diff(a, b), want = refDiff(a, b);
+        if (got != want && bad++ == 0) { fa = a; fb = b; fgot = got; fwant = want; }
+        checked++;
+    }
+    for (int i = 0; i < nEdge; i++) {
+        for (int j = 0; j < nEdge; j++) {
+            int32_t got = angle_Diff(edge[i], edge[j]), want = refDiff(edge[i], edge[j]);
+            if (got != want && bad++ == 0) { fa = edge[i]; fb = edge[j]; fgot = got; fwant = want; }
+            checked++;
+        }
+    }
+    fail |= report("angle_Diff", checked, bad, fa, fb, fgot, fwant);
+
+    /* ===== TIMING ===== */
+    {
+        double t0, tWrap, tDiff;
+        uint64_t c0, cWrap, cDiff;
+
+        t0 = now();
+        c0 = cycles();
+        for (long i = 0; i < TIME_CALLS; i++) sink += (uint32_t)angle_Wrap360((int32_t)(i * 2654435761L));
+        cWrap = cycles() - c0;
+        tWrap = now() - t0;
+
+        t0 = now();
+        c0 = cycles();
+        for (long i = 0; i < TIME_CALLS; i++) sink += (uint32_t)angle_Diff((int32_t)(i * 2654435761L), (int32_t)i);
+        cDiff = cycles() - c0;
+        tDiff = now() - t0;
+
+        printf("angle_Wrap360  %.2f %s, %.2f ns per call\n", HAVE_TSC ? (double)cWrap / TIME_CALLS : 0.0,
+               HAVE_TSC ? "TSC cycles" : "(no cycle counter)", tWrap / TIME_CALLS * 1e9);
+        printf("angle_Diff     %.2f %s, %.2f ns per call\n", HAVE_TSC ? (double)cDiff / TIME_CALLS : 0.0,
+               HAVE_TSC ? "TSC cycles" : "(no cycle counter)", tDiff / TIME_CALLS * 1e9);
+    }
+
+    return fail || sink == 42; // sink keeps the timing loops from being optimised away
+}
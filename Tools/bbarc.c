@@ -0,0 +1,797 @@
+/**
+  ******************************************************************************
+  * @file    bbarc.c
+  * @author  Aaron Lubinsky
+  * @brief   Indexed columnar archive of blackbox dumps, with threshold and range queries
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Ingests blackbox dumps in every form the tools produce:
+  *
+  *            - fastrx captures or console logs: each "# blackbox n first"
+  *              ... "# end" section is one flight (T, lines inside skipped)
+  *            - fastrx blackbox.csv or bbget -c output: the whole file is
+  *              one flight, header line skipped
+  *            - bbget .bin files: the raw IMUSample array
+  *
+  *          and appends them to an archive directory of three files:
+  *
+  *            flights.idx  one FlightRec per flight: source, samples, chunks
+  *            chunks.idx   one ChunkRec per CHUNK samples: for every column
+  *                         its min, max and where its block is in data.col
+  *            data.col     column blocks, delta + zigzag + varint coded
+  *
+  *          Columns are the five dumpBlackbox() fields plus the absolute
+  *          roll and pitch errors, computed at ingest so "pitch error over
+  *          10°" is a plain threshold that the index can answer.
+  *
+  *          Queries map the index and data files and split the chunks over
+  *          -j threads. Each chunk is first checked against its min/max:
+  *          if no sample can match it is skipped, if every sample must
+  *          match it is counted without decoding, and only the rest have
+  *          the queried columns decoded and tested row by row.
+  *
+  *          Usage: bbarc ingest [-a dir] file...
+  *                 bbarc query  [-a dir] [-j threads] [-c | -r [-m max]] cond...
+  *                 bbarc info   [-a dir]
+  *
+  *          cond is <column><op><value> with op one of > >= < <= =, or
+  *          <column>=<lo>..<hi>; all conditions must hold on the same
+  *          sample. Values are in the stored units (millidegrees, mV) or
+  *          carry a deg or V suffix. Examples:
+  *
+  *            bbarc query pitch_err>10deg              flights with >10° pitch error
+  *            bbarc query -r -m 20 vbat<10.5V roll_err>5deg
+  *            bbarc query -c roll=-2deg..2deg           samples within ±2° roll
+  *
+  ******************************************************************************
+  */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define CHUNK        1024        ///< Samples per chunk (the min/max granularity)
+#define N_COLS       7
+#define MAX_CONDS    8
+#define MAX_THREADS  64
+#define LINE_MAX_LEN 256
+#define ARC_VERSION  1
+
+enum { COL_PITCH, COL_PITCH_SET, COL_ROLL, COL_ROLL_SET, COL_VBAT, COL_PITCH_ERR, COL_ROLL_ERR };
+
+static const char *colName[N_COLS] = {
+    "pitch", "pitch_set", "roll", "roll_set", "vbat", "pitch_err", "roll_err"
+};
+
+/**
+ * @brief Start of each index file; the record size doubles as a layout check
+ */
+typedef struct {
+    char magic[8];      ///< "BBARC" and the file kind
+    uint32_t version;
+    uint32_t recSize;
+} FileHeader;
+
+typedef struct {
+    char source[104];   ///< File name, and "#n" for the nth section of a capture
+    uint32_t samples;
+    uint32_t firstChunk;
+    uint32_t chunks;
+    uint32_t pad;
+    uint64_t srcBytes;  ///< CSV bytes (or .bin bytes) the flight came from
+    int64_t ingested;   ///< Unix time
+} FlightRec;
+
+typedef struct {
+    int32_t min, max;
+    uint64_t ofs;       ///< Offset of the block in data.col
+    uint32_t len;       ///< Block bytes
+    uint32_t pad;
+} ColRef;
+
+typedef struct {
+    uint32_t flight;
+    uint32_t first;     ///< Index of the chunk's first sample within the flight
+    uint32_t count;
+    uint32_t pad;
+    ColRef col[N_COLS];
+} ChunkRec;
+
+typedef struct {
+    int col;
+    int32_t lo, hi;     ///< Inclusive
+} Cond;
+
+/**
+ * @brief The archive, mapped read-only for queries
+ */
+typedef struct {
+    const FlightRec *flights;
+    const ChunkRec *chunks;
+    const uint8_t *data;
+    size_t nFlights, nChunks, dataLen;
+} Archive;
+
+static char arcDir[512] = "bbarc";
+
+static void die(const char *what)
+{
+    perror(what);
+    exit(1);
+}
+
+static void arcPath(char *out, size_t n, const char *file)
+{
+    snprintf(out, n, "%s/%s", arcDir, file);
+}
+
+/* ===== COLUMN CODING ===== */
+
+static size_t putVarint(uint8_t *p, uint32_t v)
+{
+    size_t n = 0;
+
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+/**
+ * @brief Delta + zigzag + varint; blackbox columns move little between samples
+ *
+ * @return Bytes written (at most 5 per value)
+ */
+static size_t encodeCol(const int32_t *v, uint32_t n, uint8_t *out)
+{
+    size_t len = 0;
+    int32_t prev = 0;
+
+    for (uint32_t i = 0; i < n; i++) {
+        int32_t d = (int32_t)((uint32_t)v[i] - (uint32_t)prev);
+
+        len += putVarint(out + len, ((uint32_t)d << 1) ^ (uint32_t)(d >> 31));
+        prev = v[i];
+    }
+    return len;
+}
+
+/**
+ * @brief Inverse of encodeCol(); returns -1 on a truncated or corrupt block
+ */
+static int decodeCol(const uint8_t *p, size_t len, uint32_t n, int32_t *v)
+{
+    size_t pos = 0;
+    int32_t prev = 0;
+
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t z = 0;
+        int shift = 0;
+
+        for (;;) {
+            if (pos >= len || shift > 28) return -1;
+            z |= (uint32_t)(p[pos] & 0x7F) << shift;
+            if (!(p[pos++] & 0x80)) break;
+            shift += 7;
+        }
+        prev = (int32_t)((uint32_t)prev + ((z >> 1) ^ (0u - (z & 1))));
+        v[i] = prev;
+    }
+    return 0;
+}
+
+/* ===== INGEST ===== */
+
+/**
+ * @brief Opens an index file for appending, writing its header if it is new
+ */
+static FILE *openIndex(const char *file, const char *magic, uint32_t recSize, size_t *records)
+{
+    char path[600];
+    FileHeader h;
+    FILE *f;
+    long size;
+
+    arcPath(path, sizeof(path), file);
+    f = fopen(path, "a+b");
+    if (!f) die(path);
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    if (size == 0) {
+        memset(&h, 0, sizeof(h));
+        snprintf(h.magic, sizeof(h.magic), "%s", magic);
+        h.version = ARC_VERSION;
+        h.recSize = recSize;
+        fwrite(&h, sizeof(h), 1, f);
+        *records = 0;
+        return f;
+    }
+    fseek(f, 0, SEEK_SET);
+    if (fread(&h, sizeof(h), 1, f) != 1 || strncmp(h.magic, magic, sizeof(h.magic)) != 0 ||
+        h.version != ARC_VERSION || h.recSize != recSize || (size - (long)sizeof(h)) % recSize != 0) {
+        fprintf(stderr, "bbarc: %s is not a version %d archive file\n", path, ARC_VERSION);
+        exit(1);
+    }
+    *records = (size_t)(size - (long)sizeof(h)) / recSize;
+    fseek(f, 0, SEEK_END);
+    return f;
+}
+
+typedef struct {
+    FILE *flights, *chunks, *data;
+    size_t nFlights, nChunks;
+    uint64_t dataLen;
+    unsigned long samples, bytesOut;
+} Writer;
+
+/**
+ * @brief Growing buffer of one flight's samples, five dump columns each
+ */
+typedef struct {
+    int32_t (*s)[5];
+    size_t n, cap;
+} Flight;
+
+static void flightAdd(Flight *fl, const int32_t v[5])
+{
+    if (fl->n == fl->cap) {
+        fl->cap = fl->cap ? fl->cap * 2 : 4096;
+        fl->s = realloc(fl->s, fl->cap * sizeof(*fl->s));
+        if (!fl->s) die("realloc");
+    }
+    memcpy(fl->s[fl->n++], v, sizeof(fl->s[0]));
+}
+
+/**
+ * @brief Splits a flight into chunks, codes every column and appends it
+ */
+static void writeFlight(Writer *w, const Flight *fl, const char *source, uint64_t srcBytes)
+{
+    static int32_t col[N_COLS][CHUNK];
+    static uint8_t block[CHUNK * 5];
+    FlightRec fr;
+
+    if (fl->n == 0) return;
+    memset(&fr, 0, sizeof(fr));
+    snprintf(fr.source, sizeof(fr.source), "%s", source);
+    fr.samples = (uint32_t)fl->n;
+    fr.firstChunk = (uint32_t)w->nChunks;
+    fr.chunks = (uint32_t)((fl->n + CHUNK - 1) / CHUNK);
+    fr.srcBytes = srcBytes;
+    fr.ingested = (int64_t)time(NULL);
+
+    for (size_t first = 0; first < fl->n; first += CHUNK) {
+        uint32_t n = (uint32_t)((fl->n - first < CHUNK) ? fl->n - first : CHUNK);
+        ChunkRec cr;
+
+        memset(&cr, 0, sizeof(cr));
+        cr.flight = (uint32_t)w->nFlights;
+        cr.first = (uint32_t)first;
+        cr.count = n;
+        for (uint32_t i = 0; i < n; i++) {
+            const int32_t *s = fl->s[first + i];
+
+            for (int c = 0; c < 5; c++) col[c][i] = s[c];
+            col[COL_PITCH_ERR][i] = abs(s[COL_PITCH] - s[COL_PITCH_SET]);
+            col[COL_ROLL_ERR][i] = abs(s[COL_ROLL] - s[COL_ROLL_SET]);
+        }
+        for (int c = 0; c < N_COLS; c++) {
+            size_t len = encodeCol(col[c], n, block);
+
+            cr.col[c].min = cr.col[c].max = col[c][0];
+            for (uint32_t i = 1; i < n; i++) {
+                if (col[c][i] < cr.col[c].min) cr.col[c].min = col[c][i];
+                if (col[c][i] > cr.col[c].max) cr.col[c].max = col[c][i];
+            }
+            cr.col[c].ofs = w->dataLen;
+            cr.col[c].len = (uint32_t)len;
+            if (fwrite(block, 1, len, w->data) != len) die("data.col");
+            w->dataLen += len;
+            w->bytesOut += len;
+        }
+        if (fwrite(&cr, sizeof(cr), 1, w->chunks) != 1) die("chunks.idx");
+        w->nChunks++;
+        w->bytesOut += sizeof(cr);
+    }
+    if (fwrite(&fr, sizeof(fr), 1, w->flights) != 1) die("flights.idx");
+    w->nFlights++;
+    w->samples += (unsigned long)fl->n;
+}
+
+/**
+ * @brief Reads "a,b,c,d,e" in dumpBlackbox() order; 0 for anything else
+ */
+static int parseSample(const char *line, int32_t v[5])
+{
+    char *end;
+
+    for (int c = 0; c < 5; c++) {
+        long x = strtol(line, &end, 10);
+
+        if (end == line || (c < 4 && *end != ',')) return 0;
+        v[c] = (int32_t)x;
+        line = end + 1;
+    }
+    return 1;
+}
+
+static void ingestText(Writer *w, const char *path, FILE *f)
+{
+    char line[LINE_MAX_LEN], source[200];
+    Flight fl = {0};
+    const char *base = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+    int inSection = 0, sections = 0, sawMarker = 0;
+    uint64_t bytes = 0;
+
+    while (fgets(line, sizeof(line), f)) {
+        int32_t v[5];
+
+        if (strncmp(line, "# blackbox", 10) == 0) {
+            sawMarker = 1;
+            inSection = 1;
+            fl.n = 0;
+            bytes = 0;
+        } else if (inSection && strncmp(line, "# end", 5) == 0) {
+            snprintf(source, sizeof(source), "%s#%d", base, sections++);
+            writeFlight(w, &fl, source, bytes);
+            inSection = 0;
+        } else if ((inSection || !sawMarker) && parseSample(line, v)) {
+            flightAdd(&fl, v);
+            bytes += strlen(line);
+        }
+    }
+    if (!sawMarker) {
+        writeFlight(w, &fl, base, bytes); // Plain CSV: one flight
+    } else if (inSection) {
+        fprintf(stderr, "bbarc: %s: last section has no \"# end\", skipped\n", path);
+    }
+    free(fl.s);
+}
+
+/**
+ * @brief bbget's raw IMUSample array: pitch, roll, pitchSet, rollSet, vbat
+ */
+static void ingestBin(Writer *w, const char *path, FILE *f)
+{
+    int32_t s[5], v[5];
+    Flight fl = {0};
+    const char *base = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+    uint64_t bytes = 0;
+
+    while (fread(s, sizeof(s), 1, f) == 1) {
+        v[COL_PITCH] = s[0];
+        v[COL_ROLL] = s[1];
+        v[COL_PITCH_SET] = s[2];
+        v[COL_ROLL_SET] = s[3];
+        v[COL_VBAT] = s[4];
+        flightAdd(&fl, v);
+        bytes += sizeof(s);
+    }
+    writeFlight(w, &fl, base, bytes);
+    free(fl.s);
+}
+
+static int cmdIngest(int argc, char **argv)
+{
+    Writer w = {0};
+    char path[600];
+    size_t chunksBefore, flightsBefore;
+    unsigned long files = 0;
+    struct timespec t0, t1;
+
+    if (argc < 1) {
+        fprintf(stderr, "usage: bbarc ingest [-a dir] file...\n");
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (mkdir(arcDir, 0755) != 0 && errno != EEXIST) die(arcDir);
+    w.flights = openIndex("flights.idx", "BBARCFL", sizeof(FlightRec), &w.nFlights);
+    w.chunks = openIndex("chunks.idx", "BBARCCH", sizeof(ChunkRec), &w.nChunks);
+    arcPath(path, sizeof(path), "data.col");
+    w.data = fopen(path, "ab");
+    if (!w.data) die(path);
+    fseek(w.data, 0, SEEK_END);
+    w.dataLen = (uint64_t)ftell(w.data);
+    flightsBefore = w.nFlights;
+    chunksBefore = w.nChunks;
+
+    for (int i = 0; i < argc; i++) {
+        FILE *f = fopen(argv[i], "rb");
+        size_t n = strlen(argv[i]);
+
+        if (!f) {
+            perror(argv[i]);
+            continue;
+        }
+        if (n > 4 && strcmp(argv[i] + n - 4, ".bin") == 0) ingestBin(&w, argv[i], f);
+        else ingestText(&w, argv[i], f);
+        fclose(f);
+        files++;
+    }
+
+    // Data first: an index never points past the end of data.col
+    fclose(w.data);
+    fclose(w.chunks);
+    fclose(w.flights);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    fprintf(stderr, "%lu files: %zu flights, %lu samples in %zu chunks, %lu bytes, %.2f s\n",
+            files, w.nFlights - flightsBefore, w.samples, w.nChunks - chunksBefore, w.bytesOut,
+            (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9);
+    return 0;
+}
+
+/* ===== QUERY ===== */
+
+static const void *mapFile(const char *file, size_t *len, int optional)
+{
+    char path[600];
+    struct stat st;
+    void *p;
+    int fd;
+
+    arcPath(path, sizeof(path), file);
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        if (optional && errno == ENOENT) {
+            *len = 0;
+            return NULL;
+        }
+        die(path);
+    }
+    if (fstat(fd, &st) != 0) die(path);
+    *len = (size_t)st.st_size;
+    if (*len == 0) {
+        close(fd);
+        return NULL;
+    }
+    p = mmap(NULL, *len, PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) die(path);
+    close(fd);
+    return p;
+}
+
+static const void *mapIndex(const char *file, const char *magic, uint32_t recSize, size_t *records)
+{
+    size_t len;
+    const uint8_t *p = mapFile(file, &len, 0);
+    const FileHeader *h = (const FileHeader *)p;
+
+    if (len < sizeof(FileHeader) || strncmp(h->magic, magic, sizeof(h->magic)) != 0 ||
+        h->version != ARC_VERSION || h->recSize != recSize) {
+        fprintf(stderr, "bbarc: %s/%s is not a version %d archive file\n", arcDir, file, ARC_VERSION);
+        exit(1);
+    }
+    *records = (len - sizeof(FileHeader)) / recSize;
+    return p + sizeof(FileHeader);
+}
+
+static void openArchive(Archive *a)
+{
+    a->flights = mapIndex("flights.idx", "BBARCFL", sizeof(FlightRec), &a->nFlights);
+    a->chunks = mapIndex("chunks.idx", "BBARCCH", sizeof(ChunkRec), &a->nChunks);
+    a->data = mapFile("data.col", &a->dataLen, 1);
+    // The columns are read front to back within each thread's share
+    if (a->data) madvise((void *)a->data, a->dataLen, MADV_WILLNEED);
+}
+
+/**
+ * @brief Parses "<col><op><value>" or "<col>=<lo>..<hi>"
+ */
+static int32_t parseValue(const char *s, const char **end)
+{
+    char *e;
+    double v = strtod(s, &e);
+
+    if (strncmp(e, "deg", 3) == 0) {
+        v *= 1000.0;
+        e += 3;
+    } else if (*e == 'V') {
+        v *= 1000.0;
+        e++;
+    }
+    *end = e;
+    return (int32_t)(v < 0 ? v - 0.5 : v + 0.5);
+}
+
+static int parseCond(const char *s, Cond *c)
+{
+    const char *end;
+    size_t n = strcspn(s, "<>=");
+    int c0;
+
+    for (c0 = 0; c0 < N_COLS; c0++) {
+        if (strlen(colName[c0]) == n && strncmp(s, colName[c0], n) == 0) break;
+    }
+    if (c0 == N_COLS || s[n] == '\0') return -1;
+    c->col = c0;
+    c->lo = INT32_MIN;
+    c->hi = INT32_MAX;
+    s += n;
+
+    if (s[0] == '>' && s[1] == '=') c->lo = parseValue(s + 2, &end);
+    else if (s[0] == '<' && s[1] == '=') c->hi = parseValue(s + 2, &end);
+    else if (s[0] == '>') c->lo = parseValue(s + 1, &end) + 1;
+    else if (s[0] == '<') c->hi = parseValue(s + 1, &end) - 1;
+    else {
+        c->lo = c->hi = parseValue(s + 1, &end);
+        if (strncmp(end, "..", 2) == 0) c->hi = parseValue(end + 2, &end);
+    }
+    return (*end == '\0' && c->lo <= c->hi) ? 0 : -1;
+}
+
+/**
+ * @brief One matching sample, for -r
+ */
+typedef struct {
+    uint32_t flight, sample;
+    int32_t v[N_COLS];
+} Row;
+
+/**
+ * @brief One query thread's share of the chunks and its results
+ */
+typedef struct {
+    const Archive *a;
+    const Cond *conds;
+    int nConds;
+    size_t from, to;            ///< Chunk range
+    int wantRows;
+    size_t maxRows;
+
+    uint32_t *matches;          ///< Per flight
+    uint32_t *firstMatch;       ///< Per flight, sample index (UINT32_MAX if none)
+    Row *rows;
+    size_t nRows;
+    unsigned long skipped, whole, decoded, bad;
+} Job;
+
+static void addMatches(Job *j, uint32_t flight, uint32_t count, uint32_t first)
+{
+    j->matches[flight] += count;
+    if (first < j->firstMatch[flight]) j->firstMatch[flight] = first;
+}
+
+static void *runJob(void *arg)
+{
+    Job *j = arg;
+    int32_t col[N_COLS][CHUNK];
+    uint8_t need[N_COLS];
+
+    memset(need, 0, sizeof(need));
+    for (int k = 0; k < j->nConds; k++) need[j->conds[k].col] = 1;
+    if (j->wantRows) memset(need, 1, sizeof(need));
+
+    for (size_t ci = j->from; ci < j->to; ci++) {
+        const ChunkRec *cr = &j->a->chunks[ci];
+        int none = 0, all = 1, ok = 1;
+
+        // Min/max index: can no sample match, or must every sample?
+        for (int k = 0; k < j->nConds; k++) {
+            const Cond *c = &j->conds[k];
+            const ColRef *r = &cr->col[c->col];
+
+            if (r->max < c->lo || r->min > c->hi) none = 1;
+            if (r->min < c->lo || r->max > c->hi) all = 0;
+        }
+        if (none) {
+            j->skipped++;
+            continue;
+        }
+        if (all && !j->wantRows) {
+            j->whole++;
+            addMatches(j, cr->flight, cr->count, cr->first);
+            continue;
+        }
+
+        j->decoded++;
+        for (int c = 0; c < N_COLS && ok; c++) {
+            const ColRef *r = &cr->col[c];
+
+            if (!need[c]) continue;
+            if (r->ofs + r->len > j->a->dataLen || decodeCol(j->a->data + r->ofs, r->len, cr->count, col[c]) != 0) {
+                ok = 0;
+            }
+        }
+        if (!ok) {
+            j->bad++;
+            continue;
+        }
+
+        for (uint32_t i = 0; i < cr->count; i++) {
+            int hit = 1;
+
+            for (int k = 0; k < j->nConds && hit; k++) {
+                int32_t v = col[j->conds[k].col][i];
+
+                hit = v >= j->conds[k].lo && v <= j->conds[k].hi;
+            }
+            if (!hit) continue;
+            addMatches(j, cr->flight, 1, cr->first + i);
+            if (j->wantRows && j->nRows < j->maxRows) {
+                Row *row = &j->rows[j->nRows++];
+
+                row->flight = cr->flight;
+                row->sample = cr->first + i;
+                for (int c = 0; c < N_COLS; c++) row->v[c] = col[c][i];
+            }
+        }
+    }
+    return NULL;
+}
+
+static int cmdQuery(int argc, char **argv, int threads, int countOnly, int wantRows, size_t maxRows)
+{
+    Archive a;
+    Cond conds[MAX_CONDS];
+    Job jobs[MAX_THREADS];
+    pthread_t tid[MAX_THREADS];
+    unsigned long skipped = 0, whole = 0, decoded = 0, bad = 0, samples = 0, flights = 0;
+    size_t printed = 0;
+    struct timespec t0, t1;
+    int nConds = 0;
+
+    for (int i = 0; i < argc; i++) {
+        if (nConds == MAX_CONDS || parseCond(argv[i], &conds[nConds]) != 0) {
+            fprintf(stderr, "bbarc: bad condition \"%s\"\n", argv[i]);
+            return 1;
+        }
+        nConds++;
+    }
+    if (nConds == 0) {
+        fprintf(stderr, "usage: bbarc query [-a dir] [-j threads] [-c | -r [-m max]] cond...\n");
+        return 1;
+    }
+
+    openArchive(&a);
+    if (threads > (int)a.nChunks) threads = a.nChunks ? (int)a.nChunks : 1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    for (int t = 0; t < threads; t++) {
+        Job *j = &jobs[t];
+
+        memset(j, 0, sizeof(*j));
+        j->a = &a;
+        j->conds = conds;
+        j->nConds = nConds;
+        j->from = a.nChunks * (size_t)t / (size_t)threads;
+        j->to = a.nChunks * (size_t)(t + 1) / (size_t)threads;
+        j->wantRows = wantRows;
+        j->maxRows = maxRows;
+        j->matches = calloc(a.nFlights + 1, sizeof(uint32_t));
+        j->firstMatch = malloc((a.nFlights + 1) * sizeof(uint32_t));
+        j->rows = wantRows ? malloc(maxRows * sizeof(Row) + 1) : NULL;
+        if (!j->matches || !j->firstMatch || (wantRows && !j->rows)) die("malloc");
+        memset(j->firstMatch, 0xFF, (a.nFlights + 1) * sizeof(uint32_t));
+        if (pthread_create(&tid[t], NULL, runJob, j) != 0) die("pthread_create");
+    }
+    for (int t = 0; t < threads; t++) {
+        pthread_join(tid[t], NULL);
+        skipped += jobs[t].skipped;
+        whole += jobs[t].whole;
+        decoded += jobs[t].decoded;
+        bad += jobs[t].bad;
+    }
+
+    // Merge per-thread results into thread 0; a flight can straddle two shares
+    for (int t = 1; t < threads; t++) {
+        for (size_t f = 0; f < a.nFlights; f++) {
+            if (jobs[t].matches[f] == 0) continue;
+            addMatches(&jobs[0], (uint32_t)f, jobs[t].matches[f], jobs[t].firstMatch[f]);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    for (size_t f = 0; f < a.nFlights; f++) {
+        if (jobs[0].matches[f] == 0) continue;
+        flights++;
+        samples += jobs[0].matches[f];
+    }
+
+    if (wantRows) {
+        printf("flight,sample");
+        for (int c = 0; c < N_COLS; c++) printf(",%s", colName[c]);
+        printf("\n");
+        // Shares are contiguous chunk ranges, so thread order is archive order
+        for (int t = 0; t < threads && printed < maxRows; t++) {
+            for (size_t r = 0; r < jobs[t].nRows && printed < maxRows; r++, printed++) {
+                const Row *row = &jobs[t].rows[r];
+
+                printf("%u,%u", row->flight, row->sample);
+                for (int c = 0; c < N_COLS; c++) printf(",%d", row->v[c]);
+                printf("\n");
+            }
+        }
+    } else if (!countOnly) {
+        printf("%7s  %-40s %8s %8s %8s\n", "flight", "source", "samples", "matches", "first");
+        for (size_t f = 0; f < a.nFlights; f++) {
+            if (jobs[0].matches[f] == 0) continue;
+            printf("%7zu  %-40s %8u %8u %8u\n", f, a.flights[f].source, a.flights[f].samples,
+                   jobs[0].matches[f], jobs[0].firstMatch[f]);
+        }
+    }
+    printf("%lu of %zu flights, %lu samples matched\n", flights, a.nFlights, samples);
+    fprintf(stderr, "%zu chunks: %lu skipped by the index, %lu taken whole, %lu decoded%s; %.3f s on %d thread%s\n",
+            a.nChunks, skipped, whole, decoded, bad ? " (some corrupt, ignored)" : "",
+            (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9, threads, threads == 1 ? "" : "s");
+    return 0;
+}
+
+static int cmdInfo(void)
+{
+    Archive a;
+    uint64_t samples = 0, srcBytes = 0, colBytes[N_COLS] = {0};
+    int32_t lo[N_COLS], hi[N_COLS];
+
+    openArchive(&a);
+    for (size_t f = 0; f < a.nFlights; f++) {
+        samples += a.flights[f].samples;
+        srcBytes += a.flights[f].srcBytes;
+    }
+    for (int c = 0; c < N_COLS; c++) {
+        lo[c] = INT32_MAX;
+        hi[c] = INT32_MIN;
+    }
+    for (size_t i = 0; i < a.nChunks; i++) {
+        for (int c = 0; c < N_COLS; c++) {
+            colBytes[c] += a.chunks[i].col[c].len;
+            if (a.chunks[i].col[c].min < lo[c]) lo[c] = a.chunks[i].col[c].min;
+            if (a.chunks[i].col[c].max > hi[c]) hi[c] = a.chunks[i].col[c].max;
+        }
+    }
+    printf("%s: %zu flights, %llu samples, %zu chunks of up to %d\n",
+           arcDir, a.nFlights, (unsigned long long)samples, a.nChunks, CHUNK);
+    printf("source %llu bytes, archive %zu bytes (%.1fx); index %zu bytes\n",
+           (unsigned long long)srcBytes, a.dataLen + (a.nChunks * sizeof(ChunkRec)) + a.nFlights * sizeof(FlightRec),
+           (double)srcBytes / (double)(a.dataLen + a.nChunks * sizeof(ChunkRec) + a.nFlights * sizeof(FlightRec) + 1),
+           a.nChunks * sizeof(ChunkRec));
+    printf("%-10s %12s %8s %12s %12s\n", "column", "bytes", "B/sample", "min", "max");
+    for (int c = 0; c < N_COLS; c++) {
+        printf("%-10s %12llu %8.2f %12d %12d\n", colName[c], (unsigned long long)colBytes[c],
+               samples ? (double)colBytes[c] / (double)samples : 0.0, a.nChunks ? lo[c] : 0, a.nChunks ? hi[c] : 0);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *cmd;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN), countOnly = 0, wantRows = 0, opt;
+    size_t maxRows = 100;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: bbarc ingest|query|info [options] ...\n");
+        return 1;
+    }
+    cmd = argv[1];
+    optind = 2;
+    while ((opt = getopt(argc, argv, "+a:j:crm:")) != -1) {
+        switch (opt) {
+        case 'a': snprintf(arcDir, sizeof(arcDir), "%s", optarg); break;
+        case 'j': threads = atoi(optarg); break;
+        case 'c': countOnly = 1; break;
+        case 'r': wantRows = 1; break;
+        case 'm': maxRows = (size_t)atol(optarg); break;
+        default: return 1;
+        }
+    }
+    if (threads < 1) threads = 1;
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+
+    if (strcmp(cmd, "ingest") == 0) return cmdIngest(argc - optind, argv + optind);
+    if (strcmp(cmd, "query") == 0) return cmdQuery(argc - optind, argv + optind, threads, countOnly, wantRows, maxRows);
+    if (strcmp(cmd, "info") == 0) return cmdInfo();
+    fprintf(stderr, "bbarc: unknown command \"%s\"\n", cmd);
+    return 1;
+}
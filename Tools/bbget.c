@@ -0,0 +1,501 @@
+/**
+  ******************************************************************************
+  * @file    bbget.c
+  * @author  Aaron Lubinsky
+  * @brief   Resumable blackbox download over the MAVLink link
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Talks to the drone's LOG_* handler (MAVLink.c, LINK_MAVLINK=1)
+  *          on the HC-05 serial port or the sitl link PTY and fetches the
+  *          blackbox as the raw IMUSample array.
+  *
+  *          The log is split into 90-byte chunks, one per LOG_DATA frame.
+  *          Every frame carries its offset and a CRC, so a frame damaged or
+  *          cut short on the link is simply a missing chunk. Up to -w
+  *          requests of up to -r chunks each are kept outstanding (the
+  *          drone queues MAV_LOG_QUEUE), which keeps the link busy while
+  *          requests and replies cross. The drone serves requests in order,
+  *          so as soon as data from a later request arrives, the holes left
+  *          in the earlier ones are known to be lost and go back into the
+  *          pool to be asked for again; a stall timeout covers lost
+  *          requests. Only the missing chunks are ever sent twice.
+  *
+  *          Progress is kept in <out>.map (one byte per chunk) next to the
+  *          output, so an interrupted download picks up where it stopped.
+  *          When complete the map is removed and, with -c, the samples are
+  *          also written as CSV in the dumpBlackbox() column order.
+  *
+  *          Usage: bbget [-b baud] [-w window] [-r chunks] [-c csv] [-o out] port
+  *
+  ******************************************************************************
+  */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <termios.h>
+
+#define MAV_STX          0xFD
+#define MAV_HEADER_LEN   10
+#define GCS_SYSID        255
+#define GCS_COMPID       190
+#define DRONE_SYSID      1
+#define LOG_ID           1      ///< MAV_LOG_ID
+#define CHUNK            90     ///< MAV_LOG_CHUNK
+#define MAX_WINDOW       4      ///< MAV_LOG_QUEUE
+#define LIST_RETRY_MS    1000
+#define STALL_MS         1500   ///< No LOG_DATA for this long: every outstanding request is lost
+
+#define MSG_LOG_REQUEST_LIST 117
+#define MSG_LOG_ENTRY        118
+#define MSG_LOG_REQUEST_DATA 119
+#define MSG_LOG_DATA         120
+#define MSG_LOG_REQUEST_END  122
+
+/**
+ * @brief Layout of IMUSample (BNO055.h)
+ */
+typedef struct {
+    int32_t pitch, roll, pitchSet, rollSet, vbat;
+} Sample;
+
+/**
+ * @brief One LOG_REQUEST_DATA in flight
+ */
+typedef struct {
+    uint32_t first;   ///< First chunk
+    uint32_t count;   ///< Chunks
+} Request;
+
+static volatile sig_atomic_t stop = 0;
+
+static int fd = -1;
+static uint8_t txSeq = 0;
+static uint32_t logSize = 0, chunks = 0;
+static uint8_t *have = NULL;        ///< Per chunk: received
+static uint8_t *pending = NULL;     ///< Per chunk: inside an outstanding request
+static Request window[MAX_WINDOW];
+static int outstanding = 0;
+static FILE *outFile = NULL;
+
+static unsigned long framesBad, chunksDup, chunksResent, requestsSent;
+
+static void onSignal(int sig)
+{
+    (void)sig;
+    stop = 1;
+}
+
+static uint64_t nowMs(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000u + (uint64_t)t.tv_nsec / 1000000u;
+}
+
+static inline void put_u16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static inline void put_u32(uint8_t *p, uint32_t v) { put_u16(p, (uint16_t)v); put_u16(p + 2, (uint16_t)(v >> 16)); }
+static inline uint16_t get_u16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline uint32_t get_u32(const uint8_t *p) { return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16); }
+
+static uint16_t crcByte(uint16_t crc, uint8_t b)
+{
+    uint8_t t = b ^ (uint8_t)crc;
+    t ^= (uint8_t)(t << 4);
+    return (crc >> 8) ^ ((uint16_t)t << 8) ^ ((uint16_t)t << 3) ^ (t >> 4);
+}
+
+/**
+ * @brief Full payload length and CRC_EXTRA; returns 0 for messages we do not check
+ */
+static int msgInfo(uint32_t msgid, uint8_t *len, uint8_t *extra)
+{
+    switch (msgid) {
+    case MSG_LOG_REQUEST_LIST: *len = 6;  *extra = 128; return 1;
+    case MSG_LOG_ENTRY:        *len = 14; *extra = 56;  return 1;
+    case MSG_LOG_REQUEST_DATA: *len = 12; *extra = 116; return 1;
+    case MSG_LOG_DATA:         *len = 97; *extra = 134; return 1;
+    case MSG_LOG_REQUEST_END:  *len = 2;  *extra = 203; return 1;
+    default: return 0;
+    }
+}
+
+static void sendMsg(uint32_t msgid, const uint8_t *payload)
+{
+    uint8_t frame[MAV_HEADER_LEN + 255 + 2];
+    uint8_t len = 0, extra = 0;
+    uint16_t crc = 0xFFFF;
+
+    msgInfo(msgid, &len, &extra);
+    frame[0] = MAV_STX;
+    frame[1] = len;
+    frame[2] = 0;
+    frame[3] = 0;
+    frame[4] = txSeq++;
+    frame[5] = GCS_SYSID;
+    frame[6] = GCS_COMPID;
+    frame[7] = (uint8_t)msgid;
+    frame[8] = (uint8_t)(msgid >> 8);
+    frame[9] = (uint8_t)(msgid >> 16);
+    memcpy(&frame[MAV_HEADER_LEN], payload, len);
+    for (int i = 1; i < MAV_HEADER_LEN + len; i++) crc = crcByte(crc, frame[i]);
+    crc = crcByte(crc, extra);
+    put_u16(&frame[MAV_HEADER_LEN + len], crc);
+
+    if (write(fd, frame, MAV_HEADER_LEN + len + 2) < 0) {
+        perror("write");
+    }
+}
+
+static void requestList(void)
+{
+    uint8_t p[6] = {0};
+
+    put_u16(p, 0);
+    put_u16(p + 2, 0xFFFF);
+    p[4] = DRONE_SYSID;
+    sendMsg(MSG_LOG_REQUEST_LIST, p);
+}
+
+static void requestEnd(void)
+{
+    uint8_t p[2] = {DRONE_SYSID, 0};
+
+    sendMsg(MSG_LOG_REQUEST_END, p);
+}
+
+/**
+ * @brief Returns the chunks of the oldest outstanding request to the pool
+ */
+static void retireOldest(void)
+{
+    Request *r = &window[0];
+
+    for (uint32_t c = r->first; c < r->first + r->count; c++) {
+        if (!have[c]) chunksResent++;
+        pending[c] = 0;
+    }
+    memmove(&window[0], &window[1], sizeof(window[0]) * (size_t)(outstanding - 1));
+    outstanding--;
+}
+
+/**
+ * @brief Tops the window up with requests for runs of chunks nobody has asked for
+ */
+static void fillWindow(uint32_t rangeChunks, int maxWindow)
+{
+    static uint32_t cursor = 0;
+    uint32_t scanned = 0;
+
+    while (outstanding < maxWindow && scanned < chunks) {
+        uint32_t first, n = 0;
+        uint8_t p[12] = {0};
+
+        while (scanned < chunks && (have[cursor] || pending[cursor])) {
+            cursor = (cursor + 1) % chunks;
+            scanned++;
+        }
+        if (scanned >= chunks) break;
+
+        first = cursor;
+        while (first + n < chunks && n < rangeChunks && !have[first + n] && !pending[first + n]) {
+            pending[first + n] = 1;
+            n++;
+        }
+        cursor = (first + n) % chunks;
+        scanned += n;
+
+        put_u32(p, first * CHUNK);
+        put_u32(p + 4, n * CHUNK);
+        put_u16(p + 8, LOG_ID);
+        p[10] = DRONE_SYSID;
+        sendMsg(MSG_LOG_REQUEST_DATA, p);
+        window[outstanding].first = first;
+        window[outstanding].count = n;
+        outstanding++;
+        requestsSent++;
+    }
+}
+
+/**
+ * @brief Stores one LOG_DATA chunk and retires requests the drone has moved past
+ */
+static void onLogData(const uint8_t *p)
+{
+    uint32_t ofs = get_u32(p);
+    uint8_t count = p[6];
+    uint32_t c = ofs / CHUNK;
+
+    if (get_u16(p + 4) != LOG_ID || ofs % CHUNK != 0 || c >= chunks || count > CHUNK) {
+        return;
+    }
+
+    // Served in order: everything queued before the request holding this chunk is over
+    for (int i = 0; i < outstanding; i++) {
+        if (c >= window[i].first && c < window[i].first + window[i].count) {
+            while (i-- > 0) retireOldest();
+            break;
+        }
+    }
+
+    if (have[c]) {
+        chunksDup++;
+    } else {
+        fseek(outFile, (long)ofs, SEEK_SET);
+        fwrite(p + 7, 1, count, outFile);
+        have[c] = 1;
+    }
+
+    if (outstanding > 0 && c == window[0].first + window[0].count - 1) {
+        retireOldest();
+    }
+}
+
+/**
+ * @brief Frame parser; returns the message ID of a good frame, -1 otherwise
+ */
+static int parseByte(uint8_t b, uint8_t *frame, int *pos, int *need)
+{
+    uint8_t len, extra;
+    uint32_t msgid;
+    uint16_t crc = 0xFFFF;
+
+    if (*pos == 0 && b != MAV_STX) return -1;
+    frame[(*pos)++] = b;
+    if (*pos == 3) *need = MAV_HEADER_LEN + frame[1] + 2 + ((frame[2] & 1) ? 13 : 0);
+    if (*pos < 3 || *pos < *need) return -1;
+    *pos = 0;
+
+    msgid = frame[7] | ((uint32_t)frame[8] << 8) | ((uint32_t)frame[9] << 16);
+    if (!msgInfo(msgid, &len, &extra)) return -1; // Telemetry we do not read
+    if (frame[1] > len || frame[5] != DRONE_SYSID) {
+        framesBad++;
+        return -1;
+    }
+    for (int i = 1; i < MAV_HEADER_LEN + frame[1]; i++) crc = crcByte(crc, frame[i]);
+    crc = crcByte(crc, extra);
+    if (crc != get_u16(&frame[MAV_HEADER_LEN + frame[1]])) {
+        framesBad++;
+        return -1;
+    }
+    memset(&frame[MAV_HEADER_LEN + frame[1]], 0, (size_t)(len - frame[1])); // Truncated zeros
+    return (int)msgid;
+}
+
+static void setRaw(int baud)
+{
+    struct termios tio;
+    speed_t sp;
+
+    if (!isatty(fd) || tcgetattr(fd, &tio) != 0) return;
+    switch (baud) {
+    case 9600:   sp = B9600; break;
+    case 19200:  sp = B19200; break;
+    case 38400:  sp = B38400; break;
+    case 57600:  sp = B57600; break;
+    case 115200: sp = B115200; break;
+    case 230400: sp = B230400; break;
+    case 460800: sp = B460800; break;
+    case 921600: sp = B921600; break;
+    default:
+        fprintf(stderr, "unsupported baud %d\n", baud);
+        exit(2);
+    }
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, sp);
+    cfsetospeed(&tio, sp);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tcsetattr(fd, TCSANOW, &tio);
+}
+
+static void saveMap(const char *mapPath)
+{
+    FILE *f = fopen(mapPath, "wb");
+
+    if (!f) return;
+    fwrite(&logSize, sizeof(logSize), 1, f);
+    fwrite(have, 1, chunks, f);
+    fclose(f);
+}
+
+/**
+ * @brief Loads the chunk map of an interrupted download of a log of this size
+ */
+static uint32_t loadMap(const char *mapPath)
+{
+    FILE *f = fopen(mapPath, "rb");
+    uint32_t size = 0, got = 0, n = 0;
+
+    if (!f) return 0;
+    if (fread(&size, sizeof(size), 1, f) == 1 && size <= logSize) {
+        // A log only grows, so chunks below the old size stay valid (the last one may have been short)
+        n = (uint32_t)fread(have, 1, (size + CHUNK - 1) / CHUNK, f);
+        if (n > 0 && size % CHUNK != 0) have[n - 1] = 0;
+        for (uint32_t c = 0; c < n; c++) got += have[c];
+    }
+    fclose(f);
+    return got;
+}
+
+static void writeCsv(const char *binPath, const char *csvPath)
+{
+    FILE *in = fopen(binPath, "rb"), *out = fopen(csvPath, "w");
+    Sample s;
+    unsigned long n = 0;
+
+    if (!in || !out) {
+        perror(in ? csvPath : binPath);
+        exit(1);
+    }
+    fprintf(out, "pitch,pitch_set,roll,roll_set,vbat\n");
+    while (fread(&s, sizeof(s), 1, in) == 1) {
+        fprintf(out, "%d,%d,%d,%d,%d\n", s.pitch, s.pitchSet, s.roll, s.rollSet, s.vbat);
+        n++;
+    }
+    fclose(in);
+    fclose(out);
+    fprintf(stderr, "%lu samples written to %s\n", n, csvPath);
+}
+
+int main(int argc, char **argv)
+{
+    const char *outPath = "blackbox.bin", *csvPath = NULL;
+    char mapPath[1024];
+    int baud = 9600, maxWindow = MAX_WINDOW, opt;
+    uint32_t rangeChunks = 32, done, resumed = 0;
+    uint8_t buf[1024], frame[MAV_HEADER_LEN + 255 + 2 + 13];
+    int pos = 0, need = 0;
+    uint64_t start, lastData, lastList = 0, lastSave;
+
+    while ((opt = getopt(argc, argv, "b:w:r:c:o:")) != -1) {
+        switch (opt) {
+        case 'b': baud = atoi(optarg); break;
+        case 'w': maxWindow = atoi(optarg); break;
+        case 'r': rangeChunks = (uint32_t)atoi(optarg); break;
+        case 'c': csvPath = optarg; break;
+        case 'o': outPath = optarg; break;
+        default: optind = argc + 1;
+        }
+    }
+    if (optind != argc - 1 || maxWindow < 1 || maxWindow > MAX_WINDOW || rangeChunks < 1) {
+        fprintf(stderr, "usage: bbget [-b baud] [-w window 1-%d] [-r chunks] [-c csv] [-o out] port\n", MAX_WINDOW);
+        return 2;
+    }
+
+    fd = open(argv[optind], O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        perror(argv[optind]);
+        return 1;
+    }
+    setRaw(baud);
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    /* ===== LOG LIST ===== */
+    while (!stop && chunks == 0) {
+        struct pollfd pf = {fd, POLLIN, 0};
+        uint64_t now = nowMs();
+
+        if (now - lastList >= LIST_RETRY_MS) {
+            lastList = now;
+            requestList();
+        }
+        if (poll(&pf, 1, 100) > 0) {
+            ssize_t n = read(fd, buf, sizeof(buf));
+            for (ssize_t i = 0; i < n; i++) {
+                if (parseByte(buf[i], frame, &pos, &need) == MSG_LOG_ENTRY) {
+                    const uint8_t *p = &frame[MAV_HEADER_LEN];
+                    if (get_u16(p + 10) == 0) {
+                        fprintf(stderr, "blackbox is empty\n");
+                        return 0;
+                    }
+                    logSize = get_u32(p + 4);
+                    chunks = (logSize + CHUNK - 1) / CHUNK;
+                    break;
+                }
+            }
+        }
+    }
+    if (stop) return 1;
+
+    snprintf(mapPath, sizeof(mapPath), "%s.map", outPath);
+    have = calloc(chunks, 1);
+    pending = calloc(chunks, 1);
+    if (access(mapPath, F_OK) == 0) {
+        resumed = loadMap(mapPath);
+    }
+    outFile = fopen(outPath, resumed ? "r+b" : "w+b");
+    if (!outFile || !have || !pending) {
+        perror(outPath);
+        return 1;
+    }
+    fprintf(stderr, "log %u bytes, %u chunks, %u already here\n", logSize, chunks, resumed);
+
+    /* ===== TRANSFER ===== */
+    start = lastData = lastSave = nowMs();
+    done = resumed;
+    while (!stop && done < chunks) {
+        struct pollfd pf = {fd, POLLIN, 0};
+        uint64_t now;
+
+        fillWindow(rangeChunks, maxWindow);
+        if (poll(&pf, 1, 50) > 0) {
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n <= 0 && errno != EINTR) break;
+            for (ssize_t i = 0; i < n; i++) {
+                if (parseByte(buf[i], frame, &pos, &need) == MSG_LOG_DATA) {
+                    uint32_t c = get_u32(&frame[MAV_HEADER_LEN]) / CHUNK;
+                    int fresh = c < chunks && !have[c];
+                    onLogData(&frame[MAV_HEADER_LEN]);
+                    done += fresh && have[c];
+                    lastData = nowMs();
+                }
+            }
+        }
+
+        now = nowMs();
+        if (outstanding > 0 && now - lastData >= STALL_MS) {
+            while (outstanding > 0) retireOldest(); // Requests or their replies went missing
+            lastData = now;
+        }
+        if (now - lastSave >= 1000) {
+            lastSave = now;
+            fflush(outFile);
+            saveMap(mapPath);
+            fprintf(stderr, "\r%u/%u chunks", done, chunks);
+        }
+    }
+
+    requestEnd();
+    fclose(outFile);
+    if (done < chunks) {
+        saveMap(mapPath);
+        fprintf(stderr, "\ninterrupted at %u/%u chunks; run again to resume\n", done, chunks);
+        return 1;
+    }
+    unlink(mapPath);
+
+    {
+        double secs = (double)(nowMs() - start) / 1000.0;
+        double rate = secs > 0 ? (double)(done - resumed) * CHUNK / secs : 0.0;
+
+        fprintf(stderr, "\r%u bytes in %.1f s: %.0f B/s payload (%.0f%% of %d baud), "
+                "%lu requests, %lu chunks asked for again, %lu duplicates, %lu bad frames\n",
+                logSize, secs, rate, 100.0 * rate / (baud / 10.0), baud,
+                requestsSent, chunksResent, chunksDup, framesBad);
+    }
+    if (csvPath) {
+        writeCsv(outPath, csvPath);
+    }
+    return 0;
+}
@@ -0,0 +1,200 @@
+/**
+  ******************************************************************************
+  * @file    fastrx.c
+  * @author  Aaron Lubinsky
+  * @brief   Splits the USART1 fast channel into telemetry, blackbox and trace files
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Reads the FastLink.c stream from a serial port (set to raw
+  *          921600 baud), the sitl USART1 PTY or a saved capture, and
+  *          sorts it by line:
+  *
+  *            T,...                  appended to telemetry.csv, also in
+  *                                   the middle of a dump section
+  *            # blackbox n ... # end body appended to blackbox.csv
+  *            # trace n hz ... # end whole section appended to trace.txt,
+  *                                   ready for trace2json
+  *            anything else          console output, copied to stdout
+  *
+  *          Files are truncated at start so one run is one flight. On end of
+  *          input or Ctrl-C it prints line counts, bytes and the mean rate.
+  *
+  *          Usage: fastrx [-d dir] [port|capture|-]
+  *
+  ******************************************************************************
+  */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <termios.h>
+
+#define LINE_MAX_LEN 512
+
+typedef enum { SEC_NONE, SEC_BLACKBOX, SEC_TRACE } Section;
+
+static volatile sig_atomic_t stop = 0;
+
+static FILE *telemFile, *boxFile, *traceFile;
+static unsigned long telemLines, boxLines, traceLines, otherLines, longLines, bytesIn;
+
+static void onSignal(int sig)
+{
+    (void)sig;
+    stop = 1;
+}
+
+static FILE *openOut(const char *dir, const char *name)
+{
+    char path[1024];
+    FILE *f;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+    return f;
+}
+
+/**
+ * @brief Raw 8N1 at 921600 if the input is a terminal; files and pipes are left alone
+ */
+static void setRaw(int fd)
+{
+    struct termios tio;
+
+    if (!isatty(fd) || tcgetattr(fd, &tio) != 0) {
+        return;
+    }
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, B921600);
+    cfsetospeed(&tio, B921600);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+        perror("tcsetattr");
+    }
+}
+
+/**
+ * @brief Routes one complete line (without its line ending)
+ */
+static void handleLine(const char *line, Section *sec)
+{
+    if (strncmp(line, "T,", 2) == 0) { // Telemetry keeps flowing during background dumps
+        fprintf(telemFile, "%s\n", line + 2);
+        telemLines++;
+    } else if (*sec != SEC_NONE) {
+        int end = strcmp(line, "# end") == 0;
+
+        if (*sec == SEC_TRACE) {
+            fprintf(traceFile, "%s\n", line);
+            traceLines += !end;
+        } else if (!end) {
+            fprintf(boxFile, "%s\n", line);
+            boxLines++;
+        }
+        if (end) {
+            fflush(*sec == SEC_TRACE ? traceFile : boxFile);
+            *sec = SEC_NONE;
+        }
+    } else if (strncmp(line, "# blackbox", 10) == 0) {
+        *sec = SEC_BLACKBOX;
+        fprintf(stderr, "blackbox: %s\n", line + 10);
+    } else if (strncmp(line, "# trace", 7) == 0) {
+        *sec = SEC_TRACE;
+        fprintf(traceFile, "%s\n", line);
+    } else if (line[0] != '\0') {
+        printf("%s\n", line);
+        fflush(stdout);
+        otherLines++;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *dir = ".";
+    const char *port = "-";
+    char buf[4096], line[LINE_MAX_LEN];
+    size_t lineLen = 0;
+    Section sec = SEC_NONE;
+    struct timespec t0, t1;
+    double secs;
+    int fd, opt;
+
+    while ((opt = getopt(argc, argv, "d:")) != -1) {
+        switch (opt) {
+        case 'd': dir = optarg; break;
+        default:
+            fprintf(stderr, "usage: fastrx [-d dir] [port|capture|-]\n");
+            return 1;
+        }
+    }
+    if (optind < argc) {
+        port = argv[optind];
+    }
+
+    fd = strcmp(port, "-") == 0 ? STDIN_FILENO : open(port, O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        perror(port);
+        return 1;
+    }
+    setRaw(fd);
+
+    telemFile = openOut(dir, "telemetry.csv");
+    boxFile = openOut(dir, "blackbox.csv");
+    traceFile = openOut(dir, "trace.txt");
+    fprintf(telemFile, "ms,roll,pitch,yaw,roll_set,pitch_set,effort_set,batt_mV,A,B,C,D\n");
+    fprintf(boxFile, "pitch,pitch_set,roll,roll_set,vbat\n");
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    while (!stop) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        bytesIn += (unsigned long)n;
+
+        for (ssize_t i = 0; i < n; i++) {
+            char c = buf[i];
+
+            if (c == '\r') continue;
+            if (c == '\n') {
+                line[lineLen] = '\0';
+                handleLine(line, &sec);
+                lineLen = 0;
+            } else if (lineLen < sizeof(line) - 1) {
+                line[lineLen++] = c;
+            } else {
+                longLines++; // Noise or a lost line ending; keep the truncated head
+            }
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    secs = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    fclose(telemFile);
+    fclose(boxFile);
+    fclose(traceFile);
+
+    fprintf(stderr, "%lu bytes in %.1f s (%.0f B/s): %lu telemetry, %lu blackbox, %lu trace, %lu console lines",
+            bytesIn, secs, secs > 0 ? bytesIn / secs : 0.0, telemLines, boxLines, traceLines, otherLines);
+    if (longLines) {
+        fprintf(stderr, ", %lu overlong bytes dropped", longLines);
+    }
+    fprintf(stderr, "%s\n", sec != SEC_NONE ? " (capture ended inside a dump)" : "");
+    return 0;
+}
@@ -0,0 +1,835 @@
+/**
+  ******************************************************************************
+  * @file    gcsd.c
+  * @author  Aaron Lubinsky
+  * @brief   Fleet ground-station daemon: many drone links, many subscribers
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Opens one serial port or PTY per drone and serves them all from
+  *          a single epoll loop, so a fleet needs one laptop and one
+  *          process instead of a terminal per drone. Two kinds of link:
+  *
+  *            mav:path   HC-05 link with LINK_MAVLINK=1 (or sitl -m): MAVLink
+  *                       v2 frames, CRC-checked against the same CRC_EXTRA
+  *                       table as MAVLink.c
+  *            fast:path  USART1 fast channel (FastLink.c): "T," telemetry
+  *                       lines; console and dump lines are only counted
+  *
+  *          A bare path is a MAVLink link. Links are numbered from 0 in the
+  *          order given (arguments first, then -L list file lines).
+  *
+  *          Subscribers connect over TCP (-p, loopback only) and get one
+  *          text record per decoded frame:
+  *
+  *            <link> HB <state> <armed>
+  *            <link> ATT <time_boot_ms> <roll> <pitch> <yaw>   (millidegrees)
+  *            <link> MEM <free_bytes>
+  *            <link> T <ms>,<roll>,<pitch>,...                 (FastLink line)
+  *            <link> UP | <link> DOWN
+  *
+  *          and may send commands, one per line:
+  *
+  *            sub <list>       only links in list, e.g. "sub 0,4,10-19" or "sub *"
+  *            rc <link|*> <roll> <pitch> <throttle> <yaw> [ch5]
+  *                             RC_CHANNELS_OVERRIDE to one or all MAVLink links
+  *                             (µs, 1000-2000, as MAV_HandleRC() reads them)
+  *            stat             one "# ..." line per link, then "# end"
+  *
+  *          Nothing blocks. Each record is formatted once and copied into
+  *          every interested subscriber's buffer, and all buffers are
+  *          flushed with one write() each after the whole batch of epoll
+  *          events, so a busy fleet costs a syscall per subscriber per
+  *          wakeup rather than per frame. A subscriber that falls more than
+  *          CLIENT_BUF behind loses whole records (counted in stat) instead
+  *          of stalling the links. A link that hangs up is reopened every
+  *          REOPEN_MS, so drones and sitl instances can come and go.
+  *
+  *          Tools/build/gcsload generates hundreds of simulated links and a
+  *          subscriber to measure throughput, loss and latency.
+  *
+  *          Usage: gcsd [-p port] [-b baud] [-s stat_s] [-L list] [link...]
+  *
+  ******************************************************************************
+  */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <termios.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+
+#define MAX_LINKS      1024
+#define MAX_CLIENTS    64
+#define MAX_EVENTS     256
+#define CLIENT_BUF     (256 * 1024)  ///< Subscriber output backlog before records are dropped
+#define CMD_MAX_LEN    256
+#define LINE_MAX_LEN   512           ///< Longest fast-channel line kept
+#define LINK_TX_BUF    4096          ///< Control frames waiting for a busy link
+#define RECORD_MAX     (LINE_MAX_LEN + 32)
+#define REOPEN_MS      1000
+#define TICK_MS        250           ///< Housekeeping timer
+
+#define MAV_STX          0xFD
+#define MAV_HEADER_LEN   10
+#define MAV_FRAME_MAX    (MAV_HEADER_LEN + 255 + 2 + 13)
+#define GCS_SYSID        255
+#define GCS_COMPID       190
+#define MAV_RC_IGNORE    0xFFFF
+
+#define MSG_HEARTBEAT            0
+#define MSG_PARAM_VALUE          22
+#define MSG_ATTITUDE             30
+#define MSG_RC_CHANNELS_OVERRIDE 70
+#define MSG_LOG_ENTRY            118
+#define MSG_LOG_DATA             120
+#define MSG_MEMINFO              152
+#define MSG_DEBUG_FLOAT_ARRAY    350
+
+/* epoll tags: kind in the top 32 bits, index in the bottom */
+#define TAG_LISTEN  1ULL
+#define TAG_TIMER   2ULL
+#define TAG_LINK    3ULL
+#define TAG_CLIENT  4ULL
+#define TAG(kind, i) (((kind) << 32) | (uint32_t)(i))
+
+typedef enum { LINK_MAV, LINK_FAST } LinkKind;
+
+/**
+ * @brief One drone link
+ */
+typedef struct {
+    char path[256];
+    LinkKind kind;
+    int fd;                        ///< -1 while down
+    uint64_t downSince;            ///< When it went down (ms), for the reopen timer
+
+    uint8_t frame[MAV_FRAME_MAX];  ///< MAVLink frame being parsed
+    int pos, need;
+    char line[LINE_MAX_LEN];       ///< Fast-channel line being assembled
+    size_t lineLen;
+
+    uint8_t tx[LINK_TX_BUF];       ///< Control frames not yet written
+    size_t txLen;
+    uint8_t txSeq;
+    int wantOut;                   ///< EPOLLOUT registered
+
+    unsigned long bytesIn, frames, framesBad, framesOther, lines, txFrames, txDropped, reopens;
+    int state, armed;              ///< From the last HEARTBEAT, -1 before one
+    uint64_t lastHeard;            ///< ms
+} Link;
+
+/**
+ * @brief One TCP subscriber
+ */
+typedef struct {
+    int fd;                        ///< -1 when the slot is free
+    uint64_t sub[MAX_LINKS / 64];  ///< Subscribed links, one bit each
+    char *out;                     ///< CLIENT_BUF bytes; pending output is out[outHead..outLen)
+    size_t outHead, outLen;
+    int wantOut, dirty;
+    char cmd[CMD_MAX_LEN];
+    size_t cmdLen;
+    unsigned long records, dropped;
+} Client;
+
+static volatile sig_atomic_t stop = 0;
+
+static int ep = -1;
+static Link *links = NULL;
+static int nLinks = 0;
+static Client clients[MAX_CLIENTS];
+static int baud = 9600;
+
+static unsigned long totFrames, totRecords, totDropped;
+
+/**
+ * @brief Full payload length and CRC_EXTRA of everything the drone sends (MAVLink.c mavMsgs)
+ */
+static int msgInfo(uint32_t msgid, uint8_t *len, uint8_t *extra)
+{
+    switch (msgid) {
+    case MSG_HEARTBEAT:            *len = 9;   *extra = 50;  return 1;
+    case MSG_PARAM_VALUE:          *len = 25;  *extra = 220; return 1;
+    case MSG_ATTITUDE:             *len = 28;  *extra = 39;  return 1;
+    case MSG_RC_CHANNELS_OVERRIDE: *len = 38;  *extra = 124; return 1;
+    case MSG_LOG_ENTRY:            *len = 14;  *extra = 56;  return 1;
+    case MSG_LOG_DATA:             *len = 97;  *extra = 134; return 1;
+    case MSG_MEMINFO:              *len = 8;   *extra = 208; return 1;
+    case MSG_DEBUG_FLOAT_ARRAY:    *len = 252; *extra = 232; return 1;
+    default: return 0;
+    }
+}
+
+static void onSignal(int sig)
+{
+    (void)sig;
+    stop = 1;
+}
+
+static uint64_t nowMs(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000u + (uint64_t)t.tv_nsec / 1000000u;
+}
+
+static inline void put_u16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static inline uint16_t get_u16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline uint32_t get_u32(const uint8_t *p) { return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16); }
+static inline float get_f32(const uint8_t *p) { uint32_t v = get_u32(p); float f; memcpy(&f, &v, 4); return f; }
+
+static uint16_t crcByte(uint16_t crc, uint8_t b)
+{
+    uint8_t t = b ^ (uint8_t)crc;
+    t ^= (uint8_t)(t << 4);
+    return (crc >> 8) ^ ((uint16_t)t << 8) ^ ((uint16_t)t << 3) ^ (t >> 4);
+}
+
+static void epollSet(int op, int fd, uint32_t events, uint64_t tag)
+{
+    struct epoll_event ev = {.events = events, .data.u64 = tag};
+
+    if (epoll_ctl(ep, op, fd, &ev) != 0 && op != EPOLL_CTL_DEL) {
+        perror("epoll_ctl");
+    }
+}
+
+/* ===== FAN-OUT ===== */
+
+/**
+ * @brief Appends to a subscriber's output, or counts a drop when it is too far behind
+ */
+static int queueOut(Client *cl, const char *rec, size_t len)
+{
+    if (cl->outLen + len > CLIENT_BUF && cl->outHead > 0) {
+        memmove(cl->out, cl->out + cl->outHead, cl->outLen - cl->outHead);
+        cl->outLen -= cl->outHead;
+        cl->outHead = 0;
+    }
+    if (cl->outLen + len > CLIENT_BUF) {
+        cl->dropped++;
+        return -1;
+    }
+    memcpy(cl->out + cl->outLen, rec, len);
+    cl->outLen += len;
+    cl->dirty = 1;
+    return 0;
+}
+
+/**
+ * @brief Queues one record for every subscriber of link l (-1: everyone)
+ */
+static void publish(int l, const char *rec, size_t len)
+{
+    totRecords++;
+    for (int c = 0; c < MAX_CLIENTS; c++) {
+        Client *cl = &clients[c];
+
+        if (cl->fd < 0 || (l >= 0 && !(cl->sub[l / 64] & (1ULL << (l % 64))))) continue;
+        if (queueOut(cl, rec, len) == 0) cl->records++;
+        else totDropped++;
+    }
+}
+
+static void publishf(int l, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static void publishf(int l, const char *fmt, ...)
+{
+    char rec[RECORD_MAX];
+    va_list ap;
+    int n;
+
+    va_start(ap, fmt);
+    n = vsnprintf(rec, sizeof(rec), fmt, ap);
+    va_end(ap);
+    if (n > 0) publish(l, rec, (n < (int)sizeof(rec)) ? (size_t)n : sizeof(rec) - 1);
+}
+
+/**
+ * @brief Direct reply to one subscriber (stat output); same drop rule as publish()
+ */
+static void reply(Client *cl, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static void reply(Client *cl, const char *fmt, ...)
+{
+    char rec[RECORD_MAX];
+    va_list ap;
+    int n;
+
+    va_start(ap, fmt);
+    n = vsnprintf(rec, sizeof(rec), fmt, ap);
+    va_end(ap);
+    if (n > 0 && n < (int)sizeof(rec)) queueOut(cl, rec, (size_t)n);
+}
+
+static void closeClient(Client *cl)
+{
+    epollSet(EPOLL_CTL_DEL, cl->fd, 0, 0);
+    close(cl->fd);
+    cl->fd = -1;
+    free(cl->out);
+    cl->out = NULL;
+}
+
+/**
+ * @brief Writes as much pending output as the socket takes; EPOLLOUT covers the rest
+ */
+static void flushClient(Client *cl, int c)
+{
+    while (cl->outHead < cl->outLen) {
+        ssize_t n = write(cl->fd, cl->out + cl->outHead, cl->outLen - cl->outHead);
+
+        if (n > 0) {
+            cl->outHead += (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && errno == EAGAIN) {
+            break;
+        } else {
+            closeClient(cl);
+            return;
+        }
+    }
+    cl->dirty = 0;
+    if (cl->outHead == cl->outLen) cl->outHead = cl->outLen = 0;
+    if ((cl->outLen > 0) != cl->wantOut) {
+        cl->wantOut = cl->outLen > 0;
+        epollSet(EPOLL_CTL_MOD, cl->fd, EPOLLIN | (cl->wantOut ? EPOLLOUT : 0), TAG(TAG_CLIENT, c));
+    }
+}
+
+/* ===== LINKS ===== */
+
+static void setRaw(int fd)
+{
+    struct termios tio;
+    speed_t sp;
+
+    if (!isatty(fd) || tcgetattr(fd, &tio) != 0) return;
+    switch (baud) {
+    case 9600:   sp = B9600; break;
+    case 19200:  sp = B19200; break;
+    case 38400:  sp = B38400; break;
+    case 57600:  sp = B57600; break;
+    case 115200: sp = B115200; break;
+    case 230400: sp = B230400; break;
+    case 460800: sp = B460800; break;
+    default:     sp = B921600; break;
+    }
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, sp);
+    cfsetospeed(&tio, sp);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tcsetattr(fd, TCSANOW, &tio);
+}
+
+static void linkUp(int l)
+{
+    Link *k = &links[l];
+
+    k->fd = open(k->path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (k->fd < 0) return;
+    setRaw(k->fd);
+    k->pos = 0;
+    k->lineLen = 0;
+    k->txLen = 0;
+    k->wantOut = 0;
+    epollSet(EPOLL_CTL_ADD, k->fd, EPOLLIN, TAG(TAG_LINK, l));
+    publishf(l, "%d UP\n", l);
+}
+
+static void linkDown(int l)
+{
+    Link *k = &links[l];
+
+    epollSet(EPOLL_CTL_DEL, k->fd, 0, 0);
+    close(k->fd);
+    k->fd = -1;
+    k->downSince = nowMs();
+    k->reopens++;
+    k->state = k->armed = -1;
+    publishf(l, "%d DOWN\n", l);
+}
+
+/**
+ * @brief Acts on one complete, CRC-checked MAVLink frame from link l
+ */
+static void onFrame(int l, uint32_t msgid, const uint8_t *p)
+{
+    Link *k = &links[l];
+    const float radToMdeg = 180000.0f / 3.14159265f;
+
+    k->frames++;
+    totFrames++;
+    switch (msgid) {
+    case MSG_HEARTBEAT:
+        k->state = (int)get_u32(p);
+        k->armed = (p[6] & 0x80) != 0;
+        publishf(l, "%d HB %d %d\n", l, k->state, k->armed);
+        break;
+    case MSG_ATTITUDE:
+        publishf(l, "%d ATT %lu %ld %ld %ld\n", l, (unsigned long)get_u32(p),
+                 (long)(get_f32(p + 4) * radToMdeg), (long)(get_f32(p + 8) * radToMdeg),
+                 (long)(get_f32(p + 12) * radToMdeg));
+        break;
+    case MSG_MEMINFO:
+        publishf(l, "%d MEM %lu\n", l, (unsigned long)get_u32(p + 4));
+        break;
+    default:
+        k->framesOther++; // Parameters and log data belong to a point-to-point tool (bbget)
+        break;
+    }
+}
+
+/**
+ * @brief MAVLink v2 byte parser (same framing rules as bbget.c)
+ */
+static void parseMav(int l, const uint8_t *buf, size_t n)
+{
+    Link *k = &links[l];
+
+    for (size_t i = 0; i < n; i++) {
+        uint8_t len, extra;
+        uint32_t msgid;
+        uint16_t crc = 0xFFFF;
+
+        if (k->pos == 0 && buf[i] != MAV_STX) continue;
+        k->frame[k->pos++] = buf[i];
+        if (k->pos == 3) k->need = MAV_HEADER_LEN + k->frame[1] + 2 + ((k->frame[2] & 1) ? 13 : 0);
+        if (k->pos < 3 || k->pos < k->need) continue;
+        k->pos = 0;
+
+        msgid = k->frame[7] | ((uint32_t)k->frame[8] << 8) | ((uint32_t)k->frame[9] << 16);
+        if (!msgInfo(msgid, &len, &extra) || k->frame[1] > len) {
+            k->framesBad++;
+            continue;
+        }
+        for (int j = 1; j < MAV_HEADER_LEN + k->frame[1]; j++) crc = crcByte(crc, k->frame[j]);
+        crc = crcByte(crc, extra);
+        if (crc != get_u16(&k->frame[MAV_HEADER_LEN + k->frame[1]])) {
+            k->framesBad++;
+            continue;
+        }
+        memset(&k->frame[MAV_HEADER_LEN + k->frame[1]], 0, (size_t)(len - k->frame[1])); // Truncated zeros
+        k->lastHeard = nowMs();
+        onFrame(l, msgid, &k->frame[MAV_HEADER_LEN]);
+    }
+}
+
+/**
+ * @brief Fast-channel line splitter; telemetry lines become T records
+ */
+static void parseFast(int l, const uint8_t *buf, size_t n)
+{
+    Link *k = &links[l];
+
+    for (size_t i = 0; i < n; i++) {
+        char ch = (char)buf[i];
+
+        if (ch == '\r') continue;
+        if (ch != '\n') {
+            if (k->lineLen < sizeof(k->line) - 1) k->line[k->lineLen++] = ch;
+            continue;
+        }
+        k->line[k->lineLen] = '\0';
+        k->lines++;
+        if (k->lineLen > 2 && k->line[0] == 'T' && k->line[1] == ',') {
+            k->frames++;
+            totFrames++;
+            k->lastHeard = nowMs();
+            publishf(l, "%d T %s\n", l, k->line + 2);
+        }
+        k->lineLen = 0;
+    }
+}
+
+static void onLinkReadable(int l)
+{
+    Link *k = &links[l];
+    uint8_t buf[4096];
+    ssize_t n = read(k->fd, buf, sizeof(buf));
+
+    if (n > 0) {
+        k->bytesIn += (unsigned long)n;
+        if (k->kind == LINK_MAV) parseMav(l, buf, (size_t)n);
+        else parseFast(l, buf, (size_t)n);
+    } else if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+        linkDown(l); // Cable pulled, or the PTY's other side went away
+    }
+}
+
+static void flushLink(int l)
+{
+    Link *k = &links[l];
+
+    while (k->txLen > 0) {
+        ssize_t n = write(k->fd, k->tx, k->txLen);
+
+        if (n > 0) {
+            memmove(k->tx, k->tx + n, k->txLen - (size_t)n);
+            k->txLen -= (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            break; // EAGAIN, or an error the read side will report
+        }
+    }
+    if ((k->txLen > 0) != k->wantOut) {
+        k->wantOut = k->txLen > 0;
+        epollSet(EPOLL_CTL_MOD, k->fd, EPOLLIN | (k->wantOut ? EPOLLOUT : 0), TAG(TAG_LINK, l));
+    }
+}
+
+/**
+ * @brief Queues an RC_CHANNELS_OVERRIDE on link l; a full queue drops the frame
+ */
+static void sendRC(int l, const uint16_t ch[5])
+{
+    Link *k = &links[l];
+    uint8_t frame[MAV_HEADER_LEN + 38 + 2];
+    uint8_t *p = &frame[MAV_HEADER_LEN];
+    uint8_t len = 38;
+    uint16_t crc = 0xFFFF;
+
+    if (k->fd < 0 || k->kind != LINK_MAV) return;
+
+    memset(p, 0, len);
+    for (int i = 0; i < 8; i++) put_u16(p + 2 * i, (i < 5) ? ch[i] : MAV_RC_IGNORE);
+    p[16] = 0; // target_system: any, so every drone can keep the default sysid
+    p[17] = 0;
+    while (len > 1 && p[len - 1] == 0) len--;
+
+    frame[0] = MAV_STX;
+    frame[1] = len;
+    frame[2] = 0;
+    frame[3] = 0;
+    frame[4] = k->txSeq++;
+    frame[5] = GCS_SYSID;
+    frame[6] = GCS_COMPID;
+    frame[7] = MSG_RC_CHANNELS_OVERRIDE;
+    frame[8] = 0;
+    frame[9] = 0;
+    for (int i = 1; i < MAV_HEADER_LEN + len; i++) crc = crcByte(crc, frame[i]);
+    crc = crcByte(crc, 124);
+    put_u16(&frame[MAV_HEADER_LEN + len], crc);
+
+    if (k->txLen + MAV_HEADER_LEN + len + 2u > sizeof(k->tx)) {
+        k->txDropped++;
+        return;
+    }
+    memcpy(k->tx + k->txLen, frame, MAV_HEADER_LEN + len + 2u);
+    k->txLen += MAV_HEADER_LEN + len + 2u;
+    k->txFrames++;
+    flushLink(l);
+}
+
+/* ===== SUBSCRIBER COMMANDS ===== */
+
+/**
+ * @brief Parses "*" or "0,4,10-19" into the subscription bitmap
+ */
+static int parseSub(Client *cl, const char *s)
+{
+    uint64_t sub[MAX_LINKS / 64] = {0};
+
+    while (*s == ' ') s++;
+    if (*s == '*' || *s == '\0') {
+        memset(cl->sub, 0xFF, sizeof(cl->sub));
+        return 0;
+    }
+    while (*s) {
+        char *end;
+        long a = strtol(s, &end, 10), b = a;
+
+        if (end == s) return -1;
+        s = end;
+        if (*s == '-') {
+            b = strtol(s + 1, &end, 10);
+            if (end == s + 1) return -1;
+            s = end;
+        }
+        if (a < 0 || b >= MAX_LINKS || a > b) return -1;
+        for (long i = a; i <= b; i++) sub[i / 64] |= 1ULL << (i % 64);
+        if (*s == ',') s++;
+        else if (*s && *s != ' ') return -1;
+        else break;
+    }
+    memcpy(cl->sub, sub, sizeof(sub));
+    return 0;
+}
+
+static void onCommand(Client *cl, char *cmd)
+{
+    if (strncmp(cmd, "sub", 3) == 0) {
+        if (parseSub(cl, cmd + 3) != 0) reply(cl, "# error bad link list\n");
+    } else if (strncmp(cmd, "rc ", 3) == 0) {
+        char target[16];
+        unsigned v[5] = {MAV_RC_IGNORE, MAV_RC_IGNORE, MAV_RC_IGNORE, MAV_RC_IGNORE, MAV_RC_IGNORE};
+        uint16_t ch[5];
+        int n = sscanf(cmd + 3, "%15s %u %u %u %u %u", target, &v[0], &v[1], &v[2], &v[3], &v[4]);
+
+        if (n < 5) {
+            reply(cl, "# error rc <link|*> <roll> <pitch> <throttle> <yaw> [ch5]\n");
+            return;
+        }
+        for (int i = 0; i < 5; i++) ch[i] = (uint16_t)v[i];
+        if (strcmp(target, "*") == 0) {
+            for (int l = 0; l < nLinks; l++) sendRC(l, ch);
+        } else {
+            int l = atoi(target);
+
+            if (l >= 0 && l < nLinks) sendRC(l, ch);
+            else reply(cl, "# error no link %s\n", target);
+        }
+    } else if (strcmp(cmd, "stat") == 0) {
+        uint64_t now = nowMs();
+
+        for (int l = 0; l < nLinks; l++) {
+            const Link *k = &links[l];
+
+            reply(cl, "# %d %s %s %s bytes=%lu frames=%lu bad=%lu other=%lu tx=%lu txdrop=%lu state=%d armed=%d age_ms=%ld\n",
+                  l, k->kind == LINK_MAV ? "mav" : "fast", k->path, k->fd >= 0 ? "up" : "down",
+                  k->bytesIn, k->frames, k->framesBad, k->framesOther, k->txFrames, k->txDropped,
+                  k->state, k->armed, k->lastHeard ? (long)(now - k->lastHeard) : -1L);
+        }
+        reply(cl, "# end records=%lu dropped=%lu\n", cl->records, cl->dropped);
+    } else if (cmd[0] != '\0') {
+        reply(cl, "# error unknown command\n");
+    }
+}
+
+static void onClientReadable(Client *cl)
+{
+    char buf[1024];
+    ssize_t n = read(cl->fd, buf, sizeof(buf));
+
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+        closeClient(cl);
+        return;
+    }
+    for (ssize_t i = 0; i < n; i++) {
+        if (buf[i] == '\r') continue;
+        if (buf[i] != '\n') {
+            if (cl->cmdLen < sizeof(cl->cmd) - 1) cl->cmd[cl->cmdLen++] = buf[i];
+            continue;
+        }
+        cl->cmd[cl->cmdLen] = '\0';
+        cl->cmdLen = 0;
+        onCommand(cl, cl->cmd);
+        if (cl->fd < 0) return;
+    }
+}
+
+static void onAccept(int lfd)
+{
+    for (;;) {
+        int fd = accept4(lfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        int one = 1, c;
+
+        if (fd < 0) return;
+        for (c = 0; c < MAX_CLIENTS && clients[c].fd >= 0; c++) {
+        }
+        if (c == MAX_CLIENTS || (clients[c].out = malloc(CLIENT_BUF)) == NULL) {
+            close(fd);
+            continue;
+        }
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        clients[c].fd = fd;
+        clients[c].outHead = clients[c].outLen = 0;
+        clients[c].cmdLen = 0;
+        clients[c].wantOut = 0;
+        clients[c].dirty = 0;
+        clients[c].records = clients[c].dropped = 0;
+        memset(clients[c].sub, 0xFF, sizeof(clients[c].sub)); // Everything until told otherwise
+        epollSet(EPOLL_CTL_ADD, fd, EPOLLIN, TAG(TAG_CLIENT, c));
+    }
+}
+
+/* ===== SETUP ===== */
+
+static void addLink(const char *arg)
+{
+    Link *k;
+
+    if (nLinks >= MAX_LINKS) {
+        fprintf(stderr, "gcsd: more than %d links\n", MAX_LINKS);
+        exit(1);
+    }
+    k = &links[nLinks++];
+    memset(k, 0, sizeof(*k));
+    k->fd = -1;
+    k->state = k->armed = -1;
+    if (strncmp(arg, "fast:", 5) == 0) {
+        k->kind = LINK_FAST;
+        arg += 5;
+    } else if (strncmp(arg, "mav:", 4) == 0) {
+        arg += 4;
+    }
+    snprintf(k->path, sizeof(k->path), "%s", arg);
+}
+
+static void loadList(const char *file)
+{
+    char line[300];
+    FILE *f = fopen(file, "r");
+
+    if (!f) {
+        perror(file);
+        exit(1);
+    }
+    while (fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] != '\0' && line[0] != '#') addLink(line);
+    }
+    fclose(f);
+}
+
+static int listenOn(int port)
+{
+    struct sockaddr_in a = {.sin_family = AF_INET, .sin_port = htons((uint16_t)port),
+                            .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    int one = 1;
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (fd < 0 || setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 || bind(fd, (struct sockaddr *)&a, sizeof(a)) != 0 || listen(fd, 16) != 0) {
+        perror("listen");
+        exit(1);
+    }
+    return fd;
+}
+
+/**
+ * @brief Every link holds a descriptor; raise the soft limit to the hard one
+ */
+static void raiseFdLimit(void)
+{
+    struct rlimit r;
+
+    if (getrlimit(RLIMIT_NOFILE, &r) == 0 && r.rlim_cur < r.rlim_max) {
+        r.rlim_cur = r.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &r);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    struct epoll_event events[MAX_EVENTS];
+    struct itimerspec tick = {{0, TICK_MS * 1000000L}, {0, TICK_MS * 1000000L}};
+    int port = 5770, statSec = 0, opt, lfd, tfd, up;
+    uint64_t lastStat, statFrames = 0, statRecords = 0;
+
+    links = calloc(MAX_LINKS, sizeof(Link));
+    if (!links) return 1;
+    while ((opt = getopt(argc, argv, "p:b:s:L:")) != -1) {
+        switch (opt) {
+        case 'p': port = atoi(optarg); break;
+        case 'b': baud = atoi(optarg); break;
+        case 's': statSec = atoi(optarg); break;
+        case 'L': loadList(optarg); break;
+        default:
+            fprintf(stderr, "usage: gcsd [-p port] [-b baud] [-s stat_s] [-L list] [[mav:|fast:]path...]\n");
+            return 1;
+        }
+    }
+    for (int i = optind; i < argc; i++) addLink(argv[i]);
+    if (nLinks == 0) {
+        fprintf(stderr, "gcsd: no links\n");
+        return 1;
+    }
+
+    raiseFdLimit();
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    signal(SIGPIPE, SIG_IGN);
+    for (int c = 0; c < MAX_CLIENTS; c++) clients[c].fd = -1;
+
+    ep = epoll_create1(EPOLL_CLOEXEC);
+    lfd = listenOn(port);
+    tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    timerfd_settime(tfd, 0, &tick, NULL);
+    epollSet(EPOLL_CTL_ADD, lfd, EPOLLIN, TAG(TAG_LISTEN, 0));
+    epollSet(EPOLL_CTL_ADD, tfd, EPOLLIN, TAG(TAG_TIMER, 0));
+
+    up = 0;
+    for (int l = 0; l < nLinks; l++) {
+        linkUp(l);
+        if (links[l].fd >= 0) up++;
+        else links[l].downSince = nowMs();
+    }
+    fprintf(stderr, "gcsd: %d of %d links up, subscribers on 127.0.0.1:%d\n", up, nLinks, port);
+    lastStat = nowMs();
+
+    while (!stop) {
+        int n = epoll_wait(ep, events, MAX_EVENTS, -1);
+
+        if (n < 0 && errno != EINTR) {
+            perror("epoll_wait");
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            uint64_t kind = events[i].data.u64 >> 32;
+            int idx = (int)(uint32_t)events[i].data.u64;
+            uint32_t e = events[i].events;
+
+            if (kind == TAG_LINK) {
+                if (links[idx].fd < 0) continue; // Closed earlier in this batch
+                if (e & EPOLLOUT) flushLink(idx);
+                if (e & (EPOLLIN | EPOLLHUP | EPOLLERR)) onLinkReadable(idx);
+            } else if (kind == TAG_CLIENT) {
+                if (clients[idx].fd < 0) continue;
+                if (e & (EPOLLIN | EPOLLHUP | EPOLLERR)) onClientReadable(&clients[idx]);
+                if (clients[idx].fd >= 0 && (e & EPOLLOUT)) clients[idx].dirty = 1;
+            } else if (kind == TAG_LISTEN) {
+                onAccept(lfd);
+            } else if (kind == TAG_TIMER) {
+                uint64_t expirations, now = nowMs();
+
+                if (read(tfd, &expirations, sizeof(expirations)) < 0) {
+                    // Nothing to do; the next tick comes anyway
+                }
+                for (int l = 0; l < nLinks; l++) {
+                    if (links[l].fd < 0 && now - links[l].downSince >= REOPEN_MS) {
+                        linkUp(l);
+                        if (links[l].fd < 0) links[l].downSince = now;
+                    }
+                }
+                if (statSec > 0 && now - lastStat >= (uint64_t)statSec * 1000u) {
+                    double s = (now - lastStat) / 1000.0;
+
+                    up = 0;
+                    for (int l = 0; l < nLinks; l++) up += links[l].fd >= 0;
+                    fprintf(stderr, "gcsd: %d/%d up, %.0f frames/s in, %.0f records/s out, %lu dropped\n",
+                            up, nLinks, (totFrames - statFrames) / s, (totRecords - statRecords) / s, totDropped);
+                    statFrames = totFrames;
+                    statRecords = totRecords;
+                    lastStat = now;
+                }
+            }
+        }
+
+        // One write per subscriber for the whole batch
+        for (int c = 0; c < MAX_CLIENTS; c++) {
+            if (clients[c].fd >= 0 && clients[c].dirty) flushClient(&clients[c], c);
+        }
+    }
+
+    for (int c = 0; c < MAX_CLIENTS; c++) {
+        if (clients[c].fd >= 0) closeClient(&clients[c]);
+    }
+    fprintf(stderr, "gcsd: %lu frames in, %lu records out, %lu dropped\n", totFrames, totRecords, totDropped);
+    return 0;
+}
@@ -0,0 +1,491 @@
+/**
+  ******************************************************************************
+  * @file    gcsload.c
+  * @author  Aaron Lubinsky
+  * @brief   Load test for gcsd: hundreds of simulated drone links and a subscriber
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Opens -n PTY pairs and plays a drone on each master: MAVLink
+  *          HEARTBEAT at 1 Hz and ATTITUDE at -r Hz, or on every -f'th link
+  *          FastLink "T," lines at the same rate instead. Phases are staggered
+  *          so the links do not all fire in the same millisecond. The slave
+  *          paths go to a list file for gcsd -L; with -g, gcsload starts
+  *          gcsd itself and reports its CPU use at the end.
+  *
+  *          It also connects to gcsd as a subscriber and sends "rc *" at -c
+  *          Hz, then checks the traffic both ways:
+  *
+  *            - every ATTITUDE/T record that comes back is matched to its
+  *              link; the first field carries the send time in µs, so the
+  *              record's age is the latency through the PTY, gcsd and TCP
+  *            - every RC_CHANNELS_OVERRIDE arriving on a PTY master is CRC
+  *              checked and counted per link
+  *
+  *          A frame the PTY would not take (gcsd not keeping up) is counted
+  *          as dropped at the source, like a UART overrun.
+  *
+  *          Usage: gcsload [-n links] [-r hz] [-c rc_hz] [-d seconds] [-f n]
+  *                         [-p port] [-o list] [-g gcsd]
+  *
+  ******************************************************************************
+  */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <termios.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+
+#define MAX_LINKS      1024
+#define MAX_EVENTS     256
+#define TICK_US        1000     ///< Generator tick
+#define LAT_BIN_US     50       ///< Latency histogram resolution
+#define LAT_BINS       4000     ///< Up to 200 ms; later records land in the last bin
+#define CONNECT_MS     10000    ///< How long to wait for gcsd to listen
+
+#define MAV_STX          0xFD
+#define MAV_HEADER_LEN   10
+#define MSG_HEARTBEAT    0
+#define MSG_ATTITUDE     30
+#define MSG_RC_CHANNELS_OVERRIDE 70
+
+#define TAG_TIMER   (1ULL << 32)
+#define TAG_SUB     (2ULL << 32)
+#define TAG_LINK    (3ULL << 32)
+
+/**
+ * @brief One simulated drone
+ */
+typedef struct {
+    int master, slave;
+    int fast;                    ///< FastLink text instead of MAVLink
+    uint8_t txSeq;
+    uint8_t frame[300];          ///< RC frame being parsed
+    int pos, need;
+    unsigned long sent, dropped, received, rcIn, rcBad;
+} SimLink;
+
+static volatile sig_atomic_t stop = 0;
+
+static SimLink *links;
+static int nLinks = 100;
+static unsigned long latHist[LAT_BINS];
+static unsigned long latCount, latMaxUs;
+static unsigned long junkRecords;
+
+static void onSignal(int sig)
+{
+    (void)sig;
+    stop = 1;
+}
+
+static uint64_t nowUs(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000u + (uint64_t)t.tv_nsec / 1000u;
+}
+
+static inline void put_u16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static inline void put_u32(uint8_t *p, uint32_t v) { put_u16(p, (uint16_t)v); put_u16(p + 2, (uint16_t)(v >> 16)); }
+static inline void put_f32(uint8_t *p, float f) { uint32_t v; memcpy(&v, &f, 4); put_u32(p, v); }
+static inline uint16_t get_u16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+static uint16_t crcByte(uint16_t crc, uint8_t b)
+{
+    uint8_t t = b ^ (uint8_t)crc;
+    t ^= (uint8_t)(t << 4);
+    return (crc >> 8) ^ ((uint16_t)t << 8) ^ ((uint16_t)t << 3) ^ (t >> 4);
+}
+
+/* ===== DRONE SIDE ===== */
+
+static int openPty(SimLink *k)
+{
+    struct termios tio;
+    const char *name;
+
+    k->master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (k->master < 0 || grantpt(k->master) != 0 || unlockpt(k->master) != 0 ||
+        (name = ptsname(k->master)) == NULL) {
+        return -1;
+    }
+    // Held open so the master never sees EIO between gcsd reopens, as sitl does
+    k->slave = open(name, O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (k->slave >= 0 && tcgetattr(k->slave, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(k->slave, TCSANOW, &tio);
+    }
+    return 0;
+}
+
+/**
+ * @brief Frames and writes one drone message; a full PTY drops it whole
+ */
+static void sendMav(SimLink *k, uint32_t msgid, uint8_t len, uint8_t extra, const uint8_t *payload)
+{
+    uint8_t frame[MAV_HEADER_LEN + 255 + 2];
+    uint16_t crc = 0xFFFF;
+    ssize_t n;
+
+    frame[0] = MAV_STX;
+    frame[1] = len;
+    frame[2] = 0;
+    frame[3] = 0;
+    frame[4] = k->txSeq++;
+    frame[5] = 1;
+    frame[6] = 1;
+    frame[7] = (uint8_t)msgid;
+    frame[8] = (uint8_t)(msgid >> 8);
+    frame[9] = (uint8_t)(msgid >> 16);
+    memcpy(&frame[MAV_HEADER_LEN], payload, len);
+    for (int i = 1; i < MAV_HEADER_LEN + len; i++) crc = crcByte(crc, frame[i]);
+    crc = crcByte(crc, extra);
+    put_u16(&frame[MAV_HEADER_LEN + len], crc);
+
+    n = write(k->master, frame, MAV_HEADER_LEN + len + 2u);
+    if (n != MAV_HEADER_LEN + len + 2) k->dropped++;
+    else if (msgid == MSG_ATTITUDE) k->sent++;
+}
+
+static void sendHeartbeat(SimLink *k)
+{
+    uint8_t p[9] = {0};
+
+    put_u32(p, 2);        // custom_mode: state 2, flying
+    p[4] = 2;             // MAV_TYPE_QUADROTOR
+    p[6] = 0x80 | 0x01;   // Armed, custom mode
+    p[7] = 4;             // MAV_STATE_ACTIVE
+    p[8] = 3;
+    sendMav(k, MSG_HEARTBEAT, 9, 50, p);
+}
+
+static void sendTelemetry(SimLink *k, int l, uint64_t t)
+{
+    if (k->fast) {
+        char line[128];
+        int n = snprintf(line, sizeof(line), "T,%lu,%d,-500,90000,0,0,500,11100,1350,1350,1350,1350\r\n",
+                         (unsigned long)(uint32_t)t, l);
+
+        if (write(k->master, line, (size_t)n) != n) k->dropped++;
+        else k->sent++;
+    } else {
+        uint8_t p[28] = {0};
+
+        put_u32(p, (uint32_t)t);                 // time_boot_ms carries the send time in µs
+        put_f32(p + 4, l * 3.14159265f / 180000.0f);
+        put_f32(p + 8, -0.0087f);
+        put_f32(p + 12, 1.5708f);
+        sendMav(k, MSG_ATTITUDE, 28, 39, p);
+    }
+}
+
+/**
+ * @brief Counts CRC-good RC overrides arriving from gcsd
+ */
+static void onLinkReadable(SimLink *k)
+{
+    uint8_t buf[1024];
+    ssize_t n = read(k->master, buf, sizeof(buf));
+
+    for (ssize_t i = 0; i < n; i++) {
+        uint16_t crc = 0xFFFF;
+
+        if (k->pos == 0 && buf[i] != MAV_STX) continue;
+        k->frame[k->pos++] = buf[i];
+        if (k->pos == 3) k->need = MAV_HEADER_LEN + k->frame[1] + 2;
+        if (k->pos < 3 || k->pos < k->need) continue;
+        k->pos = 0;
+
+        for (int j = 1; j < MAV_HEADER_LEN + k->frame[1]; j++) crc = crcByte(crc, k->frame[j]);
+        crc = crcByte(crc, 124);
+        if (k->frame[7] == MSG_RC_CHANNELS_OVERRIDE && crc == get_u16(&k->frame[MAV_HEADER_LEN + k->frame[1]])) {
+            k->rcIn++;
+        } else {
+            k->rcBad++;
+        }
+    }
+}
+
+/* ===== SUBSCRIBER SIDE ===== */
+
+static void onRecord(char *rec, int *synced)
+{
+    char *end;
+    long l = strtol(rec, &end, 10);
+    unsigned long stamp, lat;
+
+    if (rec[0] == '#') {
+        if (strncmp(rec, "# end", 5) == 0) *synced = 1;
+        return;
+    }
+    if (end == rec || l < 0 || l >= nLinks) {
+        junkRecords++;
+        return;
+    }
+    if (strncmp(end, " ATT ", 5) == 0) stamp = strtoul(end + 5, NULL, 10);
+    else if (strncmp(end, " T ", 3) == 0) stamp = strtoul(end + 3, NULL, 10);
+    else return; // HB, UP, DOWN
+
+    links[l].received++;
+    lat = (uint32_t)((uint32_t)nowUs() - (uint32_t)stamp);
+    latHist[(lat / LAT_BIN_US < LAT_BINS) ? lat / LAT_BIN_US : LAT_BINS - 1]++;
+    if (lat > latMaxUs) latMaxUs = lat;
+    latCount++;
+}
+
+static void onSubReadable(int fd, int *synced)
+{
+    static char line[1024];
+    static size_t len = 0;
+    char buf[65536];
+    ssize_t n = read(fd, buf, sizeof(buf));
+
+    if (n == 0) {
+        fprintf(stderr, "gcsload: gcsd closed the connection\n");
+        stop = 1;
+    }
+    for (ssize_t i = 0; i < n; i++) {
+        if (buf[i] != '\n') {
+            if (len < sizeof(line) - 1) line[len++] = buf[i];
+            continue;
+        }
+        line[len] = '\0';
+        len = 0;
+        onRecord(line, synced);
+    }
+}
+
+static int connectTo(int port)
+{
+    struct sockaddr_in a = {.sin_family = AF_INET, .sin_port = htons((uint16_t)port),
+                            .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    uint64_t give = nowUs() + CONNECT_MS * 1000u;
+
+    while (!stop && nowUs() < give) {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+        if (fd >= 0 && connect(fd, (struct sockaddr *)&a, sizeof(a)) == 0) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            return fd;
+        }
+        if (fd >= 0) close(fd);
+        usleep(100000);
+    }
+    return -1;
+}
+
+static void sendCmd(int fd, const char *cmd)
+{
+    if (write(fd, cmd, strlen(cmd)) < 0) {
+        perror("subscriber write");
+    }
+}
+
+static double latPercentile(double p)
+{
+    unsigned long want = (unsigned long)(p * latCount), seen = 0;
+
+    for (int b = 0; b < LAT_BINS; b++) {
+        seen += latHist[b];
+        if (seen > want) return (b + 0.5) * LAT_BIN_US / 1000.0;
+    }
+    return LAT_BINS * LAT_BIN_US / 1000.0;
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = 10.0;
+    int rateHz = 10, rcHz = 5, fastEvery = 0, port = 5770, opt, synced = 0;
+    const char *listFile = "gcsload.links";
+    const char *gcsd = NULL;
+    pid_t child = -1;
+    struct rlimit rl;
+    struct epoll_event events[MAX_EVENTS];
+    struct itimerspec tick = {{0, TICK_US * 1000L}, {0, TICK_US * 1000L}};
+    int ep, tfd, sub, periodTicks, mavLinks = 0;
+    unsigned long ticks = 0, runTicks, rcSent = 0;
+    FILE *f;
+
+    while ((opt = getopt(argc, argv, "n:r:c:d:f:p:o:g:")) != -1) {
+        switch (opt) {
+        case 'n': nLinks = atoi(optarg); break;
+        case 'r': rateHz = atoi(optarg); break;
+        case 'c': rcHz = atoi(optarg); break;
+        case 'd': seconds = atof(optarg); break;
+        case 'f': fastEvery = atoi(optarg); break;
+        case 'p': port = atoi(optarg); break;
+        case 'o': listFile = optarg; break;
+        case 'g': gcsd = optarg; break;
+        default:
+            fprintf(stderr, "usage: gcsload [-n links] [-r hz] [-c rc_hz] [-d seconds] [-f n] [-p port] [-o list] [-g gcsd]\n");
+            return 1;
+        }
+    }
+    if (nLinks < 1 || nLinks > MAX_LINKS || rateHz < 1 || rateHz > 1000) {
+        fprintf(stderr, "gcsload: 1-%d links at 1-1000 Hz\n", MAX_LINKS);
+        return 1;
+    }
+    periodTicks = 1000000 / TICK_US / rateHz;
+    runTicks = (unsigned long)(seconds * 1000000.0 / TICK_US);
+
+    // Two descriptors per link here, one in gcsd
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    signal(SIGPIPE, SIG_IGN);
+
+    /* ===== LINKS ===== */
+    links = calloc((size_t)nLinks, sizeof(SimLink));
+    f = fopen(listFile, "w");
+    if (!links || !f) {
+        perror(listFile);
+        return 1;
+    }
+    for (int l = 0; l < nLinks; l++) {
+        if (openPty(&links[l]) != 0) {
+            fprintf(stderr, "gcsload: PTY %d: %s\n", l, strerror(errno));
+            return 1;
+        }
+        links[l].fast = fastEvery > 0 && l % fastEvery == fastEvery - 1;
+        mavLinks += !links[l].fast;
+        fprintf(f, "%s%s\n", links[l].fast ? "fast:" : "", ptsname(links[l].master));
+    }
+    fclose(f);
+
+    /* ===== DAEMON ===== */
+    if (gcsd) {
+        char portArg[16];
+
+        snprintf(portArg, sizeof(portArg), "%d", port);
+        child = fork();
+        if (child == 0) {
+            execl(gcsd, gcsd, "-p", portArg, "-L", listFile, (char *)NULL);
+            perror(gcsd);
+            _exit(127);
+        }
+    } else {
+        fprintf(stderr, "gcsload: %d links in %s; start gcsd -p %d -L %s\n", nLinks, listFile, port, listFile);
+    }
+    sub = connectTo(port);
+    if (sub < 0) {
+        fprintf(stderr, "gcsload: no gcsd on port %d\n", port);
+        if (child > 0) kill(child, SIGTERM);
+        return 1;
+    }
+    sendCmd(sub, "sub *\nstat\n"); // "# end" of the stat reply marks the start
+
+    ep = epoll_create1(EPOLL_CLOEXEC);
+    tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    timerfd_settime(tfd, 0, &tick, NULL);
+    {
+        struct epoll_event ev = {.events = EPOLLIN};
+
+        ev.data.u64 = TAG_TIMER;
+        epoll_ctl(ep, EPOLL_CTL_ADD, tfd, &ev);
+        ev.data.u64 = TAG_SUB;
+        epoll_ctl(ep, EPOLL_CTL_ADD, sub, &ev);
+        for (int l = 0; l < nLinks; l++) {
+            ev.data.u64 = TAG_LINK | (uint32_t)l;
+            epoll_ctl(ep, EPOLL_CTL_ADD, links[l].master, &ev);
+        }
+    }
+
+    /* ===== RUN ===== */
+    while (!stop && ticks < runTicks + 500) { // Half a second to drain at the end
+        int n = epoll_wait(ep, events, MAX_EVENTS, 100);
+
+        for (int i = 0; i < n; i++) {
+            uint64_t tag = events[i].data.u64;
+
+            if (tag == TAG_SUB) {
+                onSubReadable(sub, &synced);
+            } else if ((tag >> 32) == (TAG_LINK >> 32)) {
+                onLinkReadable(&links[(uint32_t)tag]);
+            } else if (tag == TAG_TIMER) {
+                uint64_t expired = 0;
+
+                if (read(tfd, &expired, sizeof(expired)) != sizeof(expired) || !synced) continue;
+                for (uint64_t e = 0; e < expired; e++, ticks++) {
+                    uint64_t t = nowUs();
+
+                    if (ticks >= runTicks) continue;
+                    for (int l = 0; l < nLinks; l++) {
+                        unsigned long phase = ticks + (unsigned long)l * 7919u; // Spread across the period
+                        SimLink *k = &links[l];
+
+                        if (phase % (unsigned long)periodTicks == 0) sendTelemetry(k, l, t);
+                        if (!k->fast && phase % (1000000u / TICK_US) == 0) sendHeartbeat(k);
+                    }
+                    if (rcHz > 0 && ticks % (1000000u / TICK_US / (unsigned long)rcHz) == 0) {
+                        sendCmd(sub, "rc * 1500 1500 1200 1500\n");
+                        rcSent++;
+                    }
+                }
+            }
+        }
+    }
+
+    /* ===== REPORT ===== */
+    {
+        unsigned long sent = 0, dropped = 0, received = 0, rcIn = 0, rcBad = 0, worst = 0;
+        int worstLink = 0;
+        double runS = (ticks < runTicks ? ticks : runTicks) * TICK_US / 1e6;
+        struct rusage ru;
+
+        for (int l = 0; l < nLinks; l++) {
+            const SimLink *k = &links[l];
+
+            sent += k->sent;
+            dropped += k->dropped;
+            received += k->received;
+            rcIn += k->rcIn;
+            rcBad += k->rcBad;
+            if (k->sent - k->received > worst) {
+                worst = k->sent - k->received;
+                worstLink = l;
+            }
+        }
+        printf("%d links (%d MAVLink, %d fast channel), %d Hz telemetry each, %.1f s\n",
+               nLinks, mavLinks, nLinks - mavLinks, rateHz, runS);
+        printf("telemetry: %lu sent (%.0f/s), %lu received, %lu lost, %lu dropped at the PTY\n",
+               sent, sent / runS, received, sent - received, dropped);
+        if (worst > 0) printf("           worst link %d lost %lu\n", worstLink, worst);
+        if (latCount > 0) {
+            printf("latency:   p50 %.2f ms, p99 %.2f ms, p99.9 %.2f ms, max %.2f ms\n",
+                   latPercentile(0.5), latPercentile(0.99), latPercentile(0.999), latMaxUs / 1000.0);
+        }
+        printf("rc:        %lu broadcasts, %lu of %lu frames arrived, %lu bad\n",
+               rcSent, rcIn, rcSent * (unsigned long)mavLinks, rcBad);
+        if (junkRecords > 0) printf("           %lu unparseable records\n", junkRecords);
+
+        if (child > 0) {
+            kill(child, SIGTERM);
+            waitpid(child, NULL, 0);
+            if (getrusage(RUSAGE_CHILDREN, &ru) == 0) {
+                double cpu = ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+
+                printf("gcsd:      %.2f s CPU (%.1f%% of one core over the run)\n", cpu, 100.0 * cpu / runS);
+            }
+        }
+    }
+    return 0;
+}
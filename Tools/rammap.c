@@ -0,0 +1,228 @@
+/**
+  ******************************************************************************
+  * @file    rammap.c
+  * @author  Aaron Lubinsky
+  * @brief   RAM budget report from the GNU ld map file
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Reads Debug/ME507_Drone.map and prints, for the RAM region:
+  *
+  *          - each output section (.data, .bss, ._user_heap_stack) and what
+  *            is left over for the stack to grow into
+  *          - the largest variables (input sections, one per variable with
+  *            -fdata-sections)
+  *          - totals per object file
+  *
+  *          The unreserved figure is what StackMon_Free() can at most report
+  *          on target, minus whatever the heap takes at run time.
+  *
+  *          Usage: rammap [-n top] [map file]
+  *
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_ENTRIES 4096
+#define MAX_OBJS    256
+
+typedef struct {
+    char name[96];     ///< Input section, e.g. .bss.blackbox
+    char obj[64];      ///< Object file (basename)
+    char out[32];      ///< Output section it landed in
+    unsigned long addr;
+    unsigned long size;
+} Entry;
+
+typedef struct {
+    char name[64];
+    unsigned long size;
+} Total;
+
+static Entry entries[MAX_ENTRIES];
+static int nEntries = 0;
+static Total outs[32], objs[MAX_OBJS];
+static int nOuts = 0, nObjs = 0;
+static unsigned long ramOrigin = 0x20000000UL, ramLength = 0;
+
+static void addTotal(Total *t, int *n, int max, const char *name, unsigned long size)
+{
+    for (int i = 0; i < *n; i++) {
+        if (strcmp(t[i].name, name) == 0) {
+            t[i].size += size;
+            return;
+        }
+    }
+    if (*n < max) {
+        snprintf(t[*n].name, sizeof(t[*n].name), "%s", name);
+        t[(*n)++].size = size;
+    }
+}
+
+static int inRam(unsigned long addr)
+{
+    return addr >= ramOrigin && addr < ramOrigin + ramLength;
+}
+
+static const char *baseName(const char *path)
+{
+    const char *b = path;
+    for (const char *p = path; *p; p++) {
+        if (*p == '/' || *p == '\\') b = p + 1;
+    }
+    return b;
+}
+
+static int bySize(const void *a, const void *b)
+{
+    unsigned long x = ((const Entry *)a)->size, y = ((const Entry *)b)->size;
+    return (x < y) - (x > y);
+}
+
+static int totalBySize(const void *a, const void *b)
+{
+    unsigned long x = ((const Total *)a)->size, y = ((const Total *)b)->size;
+    return (x < y) - (x > y);
+}
+
+/**
+ * @brief Parses the map; input section lines may wrap after a long name
+ */
+static int parseMap(FILE *f)
+{
+    char line[1024], pending[96] = "", out[32] = "";
+    int inMemConfig = 0, inLayout = 0;
+
+    while (fgets(line, sizeof(line), f)) {
+        char name[96], obj[512];
+        unsigned long addr, size;
+
+        if (strncmp(line, "Memory Configuration", 20) == 0) { inMemConfig = 1; continue; }
+        if (strncmp(line, "Linker script and memory map", 28) == 0) { inMemConfig = 0; inLayout = 1; continue; }
+
+        if (inMemConfig) {
+            unsigned long o, l;
+            if (sscanf(line, "RAM %lx %lx", &o, &l) == 2) {
+                ramOrigin = o;
+                ramLength = l;
+            }
+            continue;
+        }
+        if (!inLayout) continue;
+
+        // Output section: starts in column 0
+        if (line[0] == '.') {
+            int n = sscanf(line, "%95s %lx %lx", name, &addr, &size);
+            snprintf(out, sizeof(out), "%.31s", name);
+            if (n == 3 && size > 0 && inRam(addr)) addTotal(outs, &nOuts, 32, name, size);
+            else if (n == 1) snprintf(pending, sizeof(pending), "@%.94s", name);
+            continue;
+        }
+
+        // Wrapped output section: address and size on the following line
+        if (pending[0] == '@') {
+            if (sscanf(line, " %lx %lx", &addr, &size) == 2 && inRam(addr)) {
+                addTotal(outs, &nOuts, 32, pending + 1, size);
+            }
+            pending[0] = '\0';
+            continue;
+        }
+
+        // Input section: one leading space
+        if (line[0] == ' ' && line[1] == '.') {
+            int n = sscanf(line, " %95s %lx %lx %511s", name, &addr, &size, obj);
+            if (n == 1) {
+                snprintf(pending, sizeof(pending), "%s", name);
+                continue;
+            }
+            if (n == 4 && size > 0 && inRam(addr) && nEntries < MAX_ENTRIES) {
+                Entry *e = &entries[nEntries++];
+                snprintf(e->name, sizeof(e->name), "%s", name);
+                snprintf(e->obj, sizeof(e->obj), "%s", baseName(obj));
+                snprintf(e->out, sizeof(e->out), "%s", out);
+                e->addr = addr;
+                e->size = size;
+            }
+            pending[0] = '\0';
+            continue;
+        }
+
+        // Continuation of a wrapped input section name
+        if (pending[0] && pending[0] != '@') {
+            if (sscanf(line, " %lx %lx %511s", &addr, &size, obj) == 3 && size > 0 && inRam(addr) &&
+                nEntries < MAX_ENTRIES) {
+                Entry *e = &entries[nEntries++];
+                snprintf(e->name, sizeof(e->name), "%s", pending);
+                snprintf(e->obj, sizeof(e->obj), "%s", baseName(obj));
+                snprintf(e->out, sizeof(e->out), "%s", out);
+                e->addr = addr;
+                e->size = size;
+            }
+            pending[0] = '\0';
+        }
+    }
+    return ramLength > 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = "../Debug/ME507_Drone.map";
+    int top = 15, opt;
+    unsigned long used = 0, heapStack = 0;
+    FILE *f;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        if (opt == 'n') top = atoi(optarg);
+        else {
+            fprintf(stderr, "usage: rammap [-n top] [map file]\n");
+            return 2;
+        }
+    }
+    if (optind < argc) path = argv[optind];
+
+    f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+    if (!parseMap(f)) {
+        fprintf(stderr, "%s: no RAM region in Memory Configuration\n", path);
+        return 1;
+    }
+    fclose(f);
+
+    printf("RAM 0x%08lx, %lu bytes (%s)\n\n", ramOrigin, ramLength, path);
+    printf("%-20s %10s\n", "Output section", "bytes");
+    for (int i = 0; i < nOuts; i++) {
+        printf("%-20s %10lu\n", outs[i].name, outs[i].size);
+        used += outs[i].size;
+        if (strcmp(outs[i].name, "._user_heap_stack") == 0) heapStack = outs[i].size;
+    }
+    printf("%-20s %10lu  (%.1f%%)\n", "total", used, 100.0 * used / ramLength);
+    printf("%-20s %10lu  (stack can grow into this plus the %lu B heap/stack reserve)\n\n",
+           "unreserved", ramLength - used, heapStack);
+
+    for (int i = 0; i < nEntries; i++) {
+        if (strcmp(entries[i].out, "._user_heap_stack") == 0) continue;
+        addTotal(objs, &nObjs, MAX_OBJS, entries[i].obj, entries[i].size);
+    }
+    qsort(entries, (size_t)nEntries, sizeof(Entry), bySize);
+    qsort(objs, (size_t)nObjs, sizeof(Total), totalBySize);
+
+    printf("Largest variables\n%10s  %-32s %s\n", "bytes", "section", "object");
+    for (int i = 0, shown = 0; i < nEntries && shown < top; i++) {
+        if (strcmp(entries[i].out, "._user_heap_stack") == 0) continue;
+        printf("%10lu  %-32s %s\n", entries[i].size, entries[i].name, entries[i].obj);
+        shown++;
+    }
+
+    printf("\nPer object\n%10s  %s\n", "bytes", "object");
+    for (int i = 0; i < nObjs && i < top; i++) {
+        printf("%10lu  %s\n", objs[i].size, objs[i].name);
+    }
+    return 0;
+}
@@ -0,0 +1,177 @@
+/**
+  ******************************************************************************
+  * @file    trace2json.c
+  * @author  Aaron Lubinsky
+  * @brief   Converts a Trace_Dump() console capture to Chrome trace JSON
+  * @version 1.0
+  * @date    2026
+  *
+  * @details Reads the text Trace_Dump() prints on USART1 (any other console
+  *          output around it is skipped; with several dumps in one capture
+  *          the last is used) and writes the Chrome trace event format,
+  *          which chrome://tracing and ui.perfetto.dev both open.
+  *
+  *          Each execution context gets its own track: the main loop and one
+  *          per interrupt handler, so preemption shows up as overlapping
+  *          spans. Cycle stamps are unwrapped across the 32-bit counter
+  *          rollover and converted to microseconds from the first event.
+  *          Spans whose begin fell off the oldest end of the ring are dropped;
+  *          spans still open at the end are closed at the last event.
+  *
+  *          Usage: trace2json [capture.txt] > trace.json
+  *
+  ******************************************************************************
+  */
+
+#include "Trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define MAX_CTX   256 ///< IPSR values
+#define MAX_DEPTH 16  ///< Nesting tracked per context
+
+static const char *spanNames[] = {
+#define TRACE_NAME(id, name) name,
+    TRACE_IDS(TRACE_NAME)
+#undef TRACE_NAME
+};
+
+typedef struct {
+    uint8_t open[MAX_DEPTH]; ///< Span IDs begun and not yet ended
+    int depth;
+    int seen;
+} Track;
+
+static Track tracks[MAX_CTX];
+static int firstEvent = 1;
+
+/**
+ * @brief Track name for an IPSR value (16 + IRQn for peripheral interrupts)
+ */
+static const char *ctxName(int ctx, char *buf, size_t len)
+{
+    switch (ctx) {
+    case 0:  return "main loop";
+    case 15: return "SysTick";
+    case 16 + 16: return "DMA1_Stream5";
+    case 16 + 37: return "USART1";
+    case 16 + 38: return "USART2";
+    default:
+        snprintf(buf, len, "exception %d", ctx);
+        return buf;
+    }
+}
+
+static void emit(const char *name, char ph, double us, int ctx)
+{
+    printf("%s\n  {\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}",
+           firstEvent ? "" : ",", name, ph, us, ctx);
+    firstEvent = 0;
+}
+
+int main(int argc, char **argv)
+{
+    FILE *f = stdin;
+    char line[256];
+    long start = -1;
+    unsigned long hz = 0;
+    uint32_t prev = 0;
+    uint64_t now = 0;
+    double us = 0.0;
+    int n = 0, dropped = 0;
+
+    if (argc > 2 || (argc == 2 && argv[1][0] == '-' && argv[1][1] != '\0')) {
+        fprintf(stderr, "usage: trace2json [capture.txt] > trace.json\n");
+        return 2;
+    }
+    if (argc == 2 && strcmp(argv[1], "-") != 0) {
+        f = fopen(argv[1], "r");
+        if (!f) {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+
+    // Find the last dump header; stdin may not be seekable, so buffer it
+    {
+        FILE *tmp = tmpfile();
+        long pos = 0;
+        if (!tmp) {
+            perror("tmpfile");
+            return 1;
+        }
+        while (fgets(line, sizeof(line), f)) {
+            unsigned long count, h;
+            if (sscanf(line, "# trace %lu %lu", &count, &h) == 2) {
+                start = pos + (long)strlen(line);
+                hz = h;
+            }
+            fputs(line, tmp);
+            pos += (long)strlen(line);
+        }
+        if (f != stdin) fclose(f);
+        if (start < 0 || hz == 0) {
+            fprintf(stderr, "no \"# trace\" header in the capture\n");
+            return 1;
+        }
+        f = tmp;
+        fseek(f, start, SEEK_SET);
+    }
+
+    printf("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long cycles;
+        unsigned id, ctx;
+        char ph;
+        Track *t;
+
+        if (strncmp(line, "# end", 5) == 0) break;
+        if (sscanf(line, "%lu,%u,%c,%u", &cycles, &id, &ph, &ctx) != 4 || id >= TRACE_ID_COUNT ||
+            ctx >= MAX_CTX || (ph != 'B' && ph != 'E')) {
+            dropped++;
+            continue;
+        }
+
+        // Slots are claimed before they are stamped, so a preempted event
+        // can land a few cycles behind its neighbour: signed difference
+        if (n > 0) now += (uint64_t)(int64_t)(int32_t)((uint32_t)cycles - prev);
+        prev = (uint32_t)cycles;
+        us = (double)now * 1e6 / (double)hz;
+        n++;
+
+        t = &tracks[ctx];
+        if (!t->seen) {
+            char buf[32];
+            printf("%s\n  {\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                   firstEvent ? "" : ",", ctx, ctxName((int)ctx, buf, sizeof(buf)));
+            firstEvent = 0;
+            t->seen = 1;
+        }
+
+        if (ph == 'B') {
+            if (t->depth < MAX_DEPTH) {
+                t->open[t->depth++] = (uint8_t)id;
+                emit(spanNames[id], 'B', us, (int)ctx);
+            }
+        } else if (t->depth > 0 && t->open[t->depth - 1] == id) {
+            t->depth--;
+            emit(spanNames[id], 'E', us, (int)ctx);
+        } else {
+            dropped++; // Begin was overwritten in the ring
+        }
+    }
+
+    for (int c = 0; c < MAX_CTX; c++) {
+        while (tracks[c].depth > 0) {
+            emit(spanNames[tracks[c].open[--tracks[c].depth]], 'E', us, c);
+        }
+    }
+    printf("\n]}\n");
+
+    fprintf(stderr, "%d events, %.3f ms at %lu Hz, %d dropped\n", n, us / 1000.0, hz, dropped);
+    fclose(f);
+    return 0;
+}